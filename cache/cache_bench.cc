@@ -48,6 +48,15 @@ DEFINE_int32(erase_percent, 10,
 
 DEFINE_bool(use_clock_cache, false, "");
 
+DEFINE_bool(auto_tune_shards, false,
+            "Move capacity between shards by their misses, and suggest a "
+            "shard count from how often shard mutexes are contended.");
+DEFINE_bool(print_shard_stats, false,
+            "Print the hits, misses, lock waits and usage of each shard.");
+DEFINE_bool(lock_free_hits, false,
+            "Let lookups of LRU cache entries that are already referenced "
+            "skip the shard mutex.");
+
 namespace rocksdb {
 
 class CacheBench;
@@ -139,8 +148,11 @@ class CacheBench {
         exit(1);
       }
     } else {
-      cache_ = NewLRUCache(FLAGS_cache_size, FLAGS_num_shard_bits);
+      cache_ = NewLRUCache(FLAGS_cache_size, FLAGS_num_shard_bits, false, 0.0,
+                           0, nullptr, FLAGS_lock_free_hits);
     }
+    cache_->SetShardStatsTracking(FLAGS_print_shard_stats);
+    cache_->SetShardAutoTuning(FLAGS_auto_tune_shards);
   }
 
   ~CacheBench() {}
@@ -190,6 +202,9 @@ class CacheBench {
           static_cast<double>(FLAGS_threads * FLAGS_ops_per_thread) / elapsed);
       fprintf(stdout, "Complete in %.3f s; QPS = %u\n", elapsed, qps);
     }
+    if (FLAGS_print_shard_stats) {
+      PrintShardStats();
+    }
     return true;
   }
 
@@ -197,6 +212,23 @@ class CacheBench {
   std::shared_ptr<Cache> cache_;
   uint32_t num_threads_;
 
+  void PrintShardStats() {
+    std::vector<CacheShardStats> stats;
+    cache_->GetShardStats(&stats);
+    fprintf(stdout, "%5s %12s %12s %12s %14s %12s %12s\n", "shard", "hits",
+            "misses", "lock waits", "wait micros", "usage", "capacity");
+    for (size_t s = 0; s < stats.size(); s++) {
+      fprintf(stdout,
+              "%5" ROCKSDB_PRIszt " %12" PRIu64 " %12" PRIu64 " %12" PRIu64
+              " %14" PRIu64 " %12" ROCKSDB_PRIszt " %12" ROCKSDB_PRIszt "\n",
+              s, stats[s].hits, stats[s].misses, stats[s].lock_waits,
+              stats[s].lock_wait_nanos / 1000, stats[s].usage,
+              stats[s].capacity);
+    }
+    fprintf(stdout, "Suggested num shard bits: %d\n",
+            cache_->GetSuggestedNumShardBits());
+  }
+
   static void ThreadBody(void* v) {
     ThreadState* thread = reinterpret_cast<ThreadState*>(v);
     SharedState* shared = thread->shared;
@@ -257,6 +289,7 @@ class CacheBench {
     printf("Insert percentage   : %d%%\n", FLAGS_insert_percent);
     printf("Lookup percentage   : %d%%\n", FLAGS_lookup_percent);
     printf("Erase percentage    : %d%%\n", FLAGS_erase_percent);
+    printf("Auto tune shards    : %d\n", FLAGS_auto_tune_shards);
     printf("----------------------------\n");
   }
 };
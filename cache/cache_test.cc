@@ -13,10 +13,13 @@
 #include <functional>
 #include <iostream>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <vector>
 #include "cache/clock_cache.h"
 #include "cache/lru_cache.h"
 #include "util/coding.h"
+#include "util/hash.h"
 #include "util/string_util.h"
 #include "util/testharness.h"
 
@@ -32,12 +35,19 @@ static int DecodeKey(const Slice& k) {
   assert(k.size() == 4);
   return DecodeFixed32(k.data());
 }
+// The shard of a cache with 2^num_shard_bits shards that `k` goes to.
+static int ShardOfKey(int k, int num_shard_bits) {
+  std::string key = EncodeKey(k);
+  return static_cast<int>(Hash(key.data(), key.size(), 0) >>
+                          (32 - num_shard_bits));
+}
 static void* EncodeValue(uintptr_t v) { return reinterpret_cast<void*>(v); }
 static int DecodeValue(void* v) {
   return static_cast<int>(reinterpret_cast<uintptr_t>(v));
 }
 
 const std::string kLRU = "lru";
+const std::string kLRULockFreeHits = "lru_lock_free_hits";
 const std::string kClock = "clock";
 
 void dumbDeleter(const Slice& key, void* value) {}
@@ -81,6 +91,9 @@ class CacheTest : public testing::TestWithParam<std::string> {
     if (type == kLRU) {
       return NewLRUCache(capacity);
     }
+    if (type == kLRULockFreeHits) {
+      return NewLRUCache(capacity, -1, false, 0.0, 0, nullptr, true);
+    }
     if (type == kClock) {
       return NewClockCache(capacity);
     }
@@ -93,6 +106,10 @@ class CacheTest : public testing::TestWithParam<std::string> {
     if (type == kLRU) {
       return NewLRUCache(capacity, num_shard_bits, strict_capacity_limit);
     }
+    if (type == kLRULockFreeHits) {
+      return NewLRUCache(capacity, num_shard_bits, strict_capacity_limit, 0.0,
+                         0, nullptr, true);
+    }
     if (type == kClock) {
       return NewClockCache(capacity, num_shard_bits, strict_capacity_limit);
     }
@@ -640,6 +657,237 @@ TEST_P(CacheTest, ApplyToAllCacheEntiresTest) {
   ASSERT_TRUE(inserted == callback_state);
 }
 
+TEST_P(CacheTest, ApplyToAllCacheEntriesWithKey) {
+  std::vector<std::tuple<int, int, int>> inserted;
+  for (int i = 0; i < 10; ++i) {
+    Insert(i, i * 2, i + 1);
+    inserted.emplace_back(i, i * 2, i + 1);
+  }
+  std::vector<std::tuple<int, int, int>> seen;
+  cache_->ApplyToAllCacheEntriesWithKey(
+      [&seen](const Slice& key, void* value, size_t charge) {
+        seen.emplace_back(DecodeKey(key), DecodeValue(value),
+                          static_cast<int>(charge));
+      });
+
+  std::sort(inserted.begin(), inserted.end());
+  std::sort(seen.begin(), seen.end());
+  ASSERT_TRUE(inserted == seen);
+}
+
+TEST_P(CacheTest, ConcurrentLookupInsertErase) {
+  // One small shard, so that threads keep evicting each other's entries and
+  // reusing the same handles.
+  std::shared_ptr<Cache> cache = NewCache(100, 0, false);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&cache, t]() {
+      for (int i = 0; i < 20000; i++) {
+        int key = (i * 7 + t * 13) % 500;
+        // Every thread stores the same value for a key.
+        int value = key + 1;
+        switch ((i + t) % 4) {
+          case 0:
+            cache->Insert(EncodeKey(key), EncodeValue(value), 1, &dumbDeleter);
+            break;
+          case 1:
+            cache->Erase(EncodeKey(key));
+            break;
+          default: {
+            Cache::Handle* handle = cache->Lookup(EncodeKey(key));
+            if (handle != nullptr) {
+              ASSERT_EQ(value, DecodeValue(cache->Value(handle)));
+              cache->Release(handle);
+            }
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_LE(cache->GetUsage(), 100);
+  ASSERT_EQ(0, cache->GetPinnedUsage());
+}
+
+TEST_P(CacheTest, ConcurrentLookupOfPinnedEntries) {
+  std::shared_ptr<Cache> cache = NewCache(100, 0, false);
+  // Half of the keys stay referenced while the threads run.
+  std::vector<Cache::Handle*> pinned;
+  for (int key = 0; key < 20; key += 2) {
+    Cache::Handle* handle = nullptr;
+    ASSERT_OK(cache->Insert(EncodeKey(key), EncodeValue(key + 1), 1,
+                            &dumbDeleter, &handle));
+    pinned.push_back(handle);
+  }
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&cache, t]() {
+      for (int i = 0; i < 20000; i++) {
+        int key = (i * 7 + t * 13) % 20;
+        if (t == 0 && i % 16 == 0) {
+          // Replace the entry, pinned or not, with one of the same value.
+          cache->Insert(EncodeKey(key), EncodeValue(key + 1), 1,
+                        &dumbDeleter);
+          continue;
+        }
+        Cache::Handle* handle = cache->Lookup(EncodeKey(key));
+        if (handle != nullptr) {
+          ASSERT_EQ(key + 1, DecodeValue(cache->Value(handle)));
+          cache->Release(handle);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto handle : pinned) {
+    cache->Release(handle);
+  }
+  ASSERT_EQ(0, cache->GetPinnedUsage());
+  ASSERT_LE(cache->GetUsage(), 100);
+}
+
+TEST_P(CacheTest, ShardStats) {
+  const int kBits = 2;
+  std::shared_ptr<Cache> cache = NewCache(1000, kBits, false);
+  std::vector<uint64_t> expected_hits(1 << kBits);
+  std::vector<uint64_t> expected_misses(1 << kBits);
+  for (int i = 0; i < 100; i++) {
+    Insert(cache, i, i + 1);
+  }
+  // Lookups are not counted until tracking is turned on.
+  for (int i = 0; i < 100; i++) {
+    Lookup(cache, i);
+  }
+  cache->SetShardStatsTracking(true);
+  for (int i = 0; i < 200; i++) {
+    if (Lookup(cache, i) == i + 1) {
+      expected_hits[ShardOfKey(i, kBits)]++;
+    } else {
+      expected_misses[ShardOfKey(i, kBits)]++;
+    }
+  }
+  Cache::Handle* pinned = cache->Lookup(EncodeKey(0));
+  ASSERT_TRUE(pinned != nullptr);
+  expected_hits[ShardOfKey(0, kBits)]++;
+
+  std::vector<CacheShardStats> stats;
+  cache->GetShardStats(&stats);
+  ASSERT_EQ(1U << kBits, stats.size());
+  size_t usage = 0;
+  size_t pinned_usage = 0;
+  size_t capacity = 0;
+  for (size_t s = 0; s < stats.size(); s++) {
+    ASSERT_EQ(expected_hits[s], stats[s].hits);
+    ASSERT_EQ(expected_misses[s], stats[s].misses);
+    ASSERT_EQ(250U, stats[s].capacity);
+    usage += stats[s].usage;
+    pinned_usage += stats[s].pinned_usage;
+    capacity += stats[s].capacity;
+  }
+  ASSERT_EQ(cache->GetUsage(), usage);
+  ASSERT_EQ(cache->GetPinnedUsage(), pinned_usage);
+  ASSERT_EQ(1U, pinned_usage);
+  ASSERT_EQ(1000U, capacity);
+  cache->Release(pinned);
+}
+
+TEST_P(CacheTest, ShardAutoTuning) {
+  const int kBits = 2;
+  std::shared_ptr<Cache> cache = NewCache(1000, kBits, false);
+  std::vector<int> shard0_keys;
+  for (int k = 0; shard0_keys.size() < 1000; k++) {
+    if (ShardOfKey(k, kBits) == 0) {
+      shard0_keys.push_back(k);
+    }
+  }
+  cache->SetShardAutoTuning(true);
+  // All lookups land in shard 0, whose target is the half of the capacity
+  // that follows lookups on top of its even share of the other half, 625.
+  // Each tuning moves a quarter of the way there.
+  for (uint64_t i = 0; i < ShardedCache::kAutoTunePeriod; i++) {
+    ASSERT_EQ(-1, Lookup(cache, shard0_keys[i % shard0_keys.size()]));
+  }
+  std::vector<CacheShardStats> stats;
+  cache->GetShardStats(&stats);
+  ASSERT_EQ(250U + (625U - 250U) / 4, stats[0].capacity);
+  for (size_t s = 1; s < stats.size(); s++) {
+    ASSERT_EQ(250U - (250U - 125U) / 4, stats[s].capacity);
+  }
+  // One thread never waits for a shard mutex.
+  ASSERT_EQ(kBits, cache->GetSuggestedNumShardBits());
+
+  // Further tunings converge on the target without overshooting it.
+  size_t last_capacity = stats[0].capacity;
+  for (int period = 0; period < 20; period++) {
+    for (uint64_t i = 0; i < ShardedCache::kAutoTunePeriod; i++) {
+      ASSERT_EQ(-1, Lookup(cache, shard0_keys[i % shard0_keys.size()]));
+    }
+    cache->GetShardStats(&stats);
+    ASSERT_GE(stats[0].capacity, last_capacity);
+    ASSERT_LE(stats[0].capacity, 625U);
+    last_capacity = stats[0].capacity;
+  }
+  ASSERT_GE(last_capacity, 600U);
+
+  for (int i = 0; i < 600; i++) {
+    Insert(cache, shard0_keys[i], i + 1);
+  }
+  cache->GetShardStats(&stats);
+  ASSERT_EQ(600U, stats[0].usage);
+
+  // Turning tuning off splits the capacity evenly again.
+  cache->SetShardAutoTuning(false);
+  cache->GetShardStats(&stats);
+  for (size_t s = 0; s < stats.size(); s++) {
+    ASSERT_EQ(250U, stats[s].capacity);
+  }
+  ASSERT_LE(stats[0].usage, 250U);
+}
+
+TEST_P(CacheTest, ShardAutoTuningKeepsHitEntries) {
+  const int kBits = 2;
+  std::shared_ptr<Cache> cache = NewCache(1000, kBits, false);
+  std::vector<int> shard0_keys;
+  std::vector<int> shard1_keys;
+  for (int k = 0; shard0_keys.size() < 1000 || shard1_keys.size() < 200;
+       k++) {
+    if (ShardOfKey(k, kBits) == 0) {
+      shard0_keys.push_back(k);
+    } else if (ShardOfKey(k, kBits) == 1 && shard1_keys.size() < 200) {
+      shard1_keys.push_back(k);
+    }
+  }
+  // The working set of shard 1 fits in it and has all been hit.
+  for (size_t i = 0; i < shard1_keys.size(); i++) {
+    Insert(cache, shard1_keys[i], static_cast<int>(i));
+    ASSERT_EQ(static_cast<int>(i), Lookup(cache, shard1_keys[i]));
+  }
+  cache->SetShardAutoTuning(true);
+  // Then only shard 0 is looked up, so the lookups would have shard 1
+  // shrink to 125.
+  for (int period = 0; period < 20; period++) {
+    for (uint64_t i = 0; i < ShardedCache::kAutoTunePeriod; i++) {
+      ASSERT_EQ(-1, Lookup(cache, shard0_keys[i % shard0_keys.size()]));
+    }
+  }
+  std::vector<CacheShardStats> stats;
+  cache->GetShardStats(&stats);
+  ASSERT_EQ(200U, stats[1].capacity);
+  ASSERT_EQ(200U, stats[1].usage);
+  size_t capacity = 0;
+  for (size_t s = 0; s < stats.size(); s++) {
+    capacity += stats[s].capacity;
+  }
+  ASSERT_LE(capacity, 1000U);
+  for (size_t i = 0; i < shard1_keys.size(); i++) {
+    ASSERT_EQ(static_cast<int>(i), Lookup(cache, shard1_keys[i]));
+  }
+}
+
 TEST_P(CacheTest, DefaultShardBits) {
   // test1: set the flag to false. Insert more keys than capacity. See if they
   // all go through.
@@ -659,9 +907,10 @@ TEST_P(CacheTest, DefaultShardBits) {
 #ifdef SUPPORT_CLOCK_CACHE
 shared_ptr<Cache> (*new_clock_cache_func)(size_t, int, bool) = NewClockCache;
 INSTANTIATE_TEST_CASE_P(CacheTestInstance, CacheTest,
-                        testing::Values(kLRU, kClock));
+                        testing::Values(kLRU, kLRULockFreeHits, kClock));
 #else
-INSTANTIATE_TEST_CASE_P(CacheTestInstance, CacheTest, testing::Values(kLRU));
+INSTANTIATE_TEST_CASE_P(CacheTestInstance, CacheTest,
+                        testing::Values(kLRU, kLRULockFreeHits));
 #endif  // SUPPORT_CLOCK_CACHE
 
 }  // namespace rocksdb
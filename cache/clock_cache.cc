@@ -27,13 +27,12 @@ std::shared_ptr<Cache> NewClockCache(size_t capacity, int num_shard_bits,
 #include <atomic>
 #include <deque>
 #include <limits>
-
-#include "tbb/concurrent_hash_map.h"
+#include <memory>
+#include <vector>
 
 #include "cache/sharded_cache.h"
 #include "port/port.h"
 #include "util/autovector.h"
-#include "util/mutexlock.h"
 
 namespace rocksdb {
 
@@ -55,9 +54,9 @@ namespace {
 // to be re-use. This is to avoid memory dealocation, which is hard to deal
 // with in concurrent environment.
 //
-// The cache also maintains a concurrent hash map for lookup. Any concurrent
-// hash map implementation should do the work. We currently use
-// tbb::concurrent_hash_map because it supports concurrent erase.
+// The cache also maintains a concurrent hash map for lookup. It is the
+// open-addressing ClockHandleTable below, which lets Lookup() find a handle
+// without taking any lock.
 //
 // Each cache handle has the following flags and counters, which are squeeze
 // in an atomic interger, to make sure the handle always be in a consistent
@@ -200,25 +199,160 @@ struct CacheHandle {
   }
 };
 
-// Key of hash map. We store hash value with the key for convenience.
-struct CacheKey {
-  Slice key;
-  uint32_t hash_value;
+// Hash map from the key of each in-cache entry to its handle. It is an
+// open-addressing table with linear probing, built so that readers need no
+// lock:
+//
+//   * Find() only loads slots. It may pass over or return a handle that is
+//     concurrently being removed, moved or reused for another key, so callers
+//     have to pin the handle (see ClockCacheShard::Ref()) and check its key
+//     before using it. A reader racing with a writer can miss an entry, which
+//     for a cache is just a miss.
+//   * Insert(), Remove() and Clear() have to hold the shard mutex, so there is
+//     a single writer at a time, and see exactly the in-cache entries.
+//
+// Remove() shifts later entries of the probe sequence back instead of leaving
+// tombstones, so the table never has to be rebuilt to clean them up. It grows
+// by doubling once half full. Readers may still be probing the array it grew
+// from, so retired arrays are kept until the table is destroyed; as sizes
+// double, they add up to less than the current array. Since handles are
+// recycled, the table holds no more entries than the shard has handles.
+class ClockHandleTable {
+ public:
+  ClockHandleTable() : count_(0) {
+    arrays_.emplace_back(new Array(kInitialSize));
+    current_.store(arrays_.back().get(), std::memory_order_relaxed);
+  }
+
+  // Returns the first handle stored under `hash`, in probe order, for which
+  // `match` returns true, or nullptr if there is none.
+  template <typename Match>
+  CacheHandle* Find(uint32_t hash, const Match& match) const {
+    const Array* array = current_.load(std::memory_order_acquire);
+    for (size_t i = hash & array->mask;; i = (i + 1) & array->mask) {
+      const Slot& slot = array->slots[i];
+      CacheHandle* handle = slot.handle.load(std::memory_order_acquire);
+      if (handle == nullptr) {
+        return nullptr;
+      }
+      if (slot.hash.load(std::memory_order_relaxed) == hash && match(handle)) {
+        return handle;
+      }
+    }
+  }
 
-  CacheKey() = default;
+  // Adds `handle`, whose hash and key are set and not yet in the table.
+  //
+  // Has to hold mutex_ of the shard before being called.
+  void Insert(CacheHandle* handle) {
+    Array* array = current_.load(std::memory_order_relaxed);
+    if (2 * (count_ + 1) > array->mask + 1) {
+      array = Grow(array);
+    }
+    Put(array, handle);
+    count_++;
+  }
 
-  CacheKey(const Slice& k, uint32_t h) {
-    key = k;
-    hash_value = h;
+  // Removes `handle` if it is in the table. Returns whether it was.
+  //
+  // Has to hold mutex_ of the shard before being called.
+  bool Remove(CacheHandle* handle) {
+    Array* array = current_.load(std::memory_order_relaxed);
+    size_t mask = array->mask;
+    size_t hole = handle->hash & mask;
+    while (true) {
+      CacheHandle* h =
+          array->slots[hole].handle.load(std::memory_order_relaxed);
+      if (h == nullptr) {
+        return false;
+      }
+      if (h == handle) {
+        break;
+      }
+      hole = (hole + 1) & mask;
+    }
+    // Move back each later entry of the cluster whose home slot does not
+    // lie cyclically in (hole, i], so that every entry stays reachable from
+    // its home slot. The hole is only emptied at the end, and readers see
+    // each moved entry in its new slot before its old one is overwritten.
+    for (size_t i = (hole + 1) & mask;; i = (i + 1) & mask) {
+      Slot& slot = array->slots[i];
+      CacheHandle* h = slot.handle.load(std::memory_order_relaxed);
+      if (h == nullptr) {
+        break;
+      }
+      uint32_t hash = slot.hash.load(std::memory_order_relaxed);
+      size_t home = hash & mask;
+      bool stays = (hole < i) ? (hole < home && home <= i)
+                              : (hole < home || home <= i);
+      if (!stays) {
+        array->slots[hole].hash.store(hash, std::memory_order_relaxed);
+        array->slots[hole].handle.store(h, std::memory_order_release);
+        hole = i;
+      }
+    }
+    array->slots[hole].handle.store(nullptr, std::memory_order_release);
+    count_--;
+    return true;
   }
 
-  static bool equal(const CacheKey& a, const CacheKey& b) {
-    return a.hash_value == b.hash_value && a.key == b.key;
+  // Removes every entry.
+  //
+  // Has to hold mutex_ of the shard before being called.
+  void Clear() {
+    Array* array = current_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i <= array->mask; i++) {
+      array->slots[i].handle.store(nullptr, std::memory_order_release);
+    }
+    count_ = 0;
   }
 
-  static size_t hash(const CacheKey& a) {
-    return static_cast<size_t>(a.hash_value);
+ private:
+  static const size_t kInitialSize = 64;
+
+  struct Slot {
+    std::atomic<CacheHandle*> handle;
+    // Hash of the key of handle, so probes can skip other keys without
+    // touching their handles.
+    std::atomic<uint32_t> hash;
+
+    Slot() : handle(nullptr), hash(0) {}
+  };
+
+  struct Array {
+    explicit Array(size_t size) : mask(size - 1), slots(new Slot[size]) {}
+
+    const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+  };
+
+  static void Put(Array* array, CacheHandle* handle) {
+    size_t i = handle->hash & array->mask;
+    while (array->slots[i].handle.load(std::memory_order_relaxed) != nullptr) {
+      i = (i + 1) & array->mask;
+    }
+    array->slots[i].hash.store(handle->hash, std::memory_order_relaxed);
+    array->slots[i].handle.store(handle, std::memory_order_release);
   }
+
+  Array* Grow(Array* array) {
+    Array* bigger = new Array(2 * (array->mask + 1));
+    for (size_t i = 0; i <= array->mask; i++) {
+      CacheHandle* h = array->slots[i].handle.load(std::memory_order_relaxed);
+      if (h != nullptr) {
+        Put(bigger, h);
+      }
+    }
+    arrays_.emplace_back(bigger);
+    current_.store(bigger, std::memory_order_release);
+    return bigger;
+  }
+
+  // The array readers probe, always arrays_.back().
+  std::atomic<Array*> current_;
+  // Every array the table has used, oldest first.
+  std::vector<std::unique_ptr<Array>> arrays_;
+  size_t count_;
 };
 
 struct CleanupContext {
@@ -232,9 +366,6 @@ struct CleanupContext {
 // A cache shard which maintains its own CLOCK cache.
 class ClockCacheShard : public CacheShard {
  public:
-  // Hash map type.
-  typedef tbb::concurrent_hash_map<CacheKey, CacheHandle*, CacheKey> HashTable;
-
   ClockCacheShard();
   ~ClockCacheShard();
 
@@ -259,6 +390,13 @@ class ClockCacheShard : public CacheShard {
   virtual void EraseUnRefEntries() override;
   virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
                                       bool thread_safe) override;
+  virtual void ApplyToAllCacheEntriesWithKey(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+          callback) override;
+  virtual uint64_t GetLockWaits() const override { return mutex_.waits(); }
+  virtual uint64_t GetLockWaitNanos() const override {
+    return mutex_.wait_nanos();
+  }
 
  private:
   static const uint32_t kInCacheBit = 1;
@@ -312,9 +450,14 @@ class ClockCacheShard : public CacheShard {
                       void (*deleter)(const Slice& key, void* value),
                       bool hold_reference, CleanupContext* context);
 
+  // Returns the in-cache handle of `key`, or nullptr.
+  //
+  // Has to hold mutex_ before being called.
+  CacheHandle* FindInCache(const Slice& key, uint32_t hash) const;
+
   // Guards list_, head_, and recycle_. In addition, updating table_ also has
   // to hold the mutex, to avoid the cache being in inconsistent state.
-  mutable port::Mutex mutex_;
+  mutable ShardMutex mutex_;
 
   // The circular list of cache handles. Initially the list is empty. Once a
   // handle is needed by insertion, and no more handles are available in
@@ -345,8 +488,8 @@ class ClockCacheShard : public CacheShard {
   // Whether allow insert into cache if cache is full.
   std::atomic<bool> strict_capacity_limit_;
 
-  // Hash table (tbb::concurrent_hash_map) for lookup.
-  HashTable table_;
+  // Hash table for lookup.
+  ClockHandleTable table_;
 };
 
 ClockCacheShard::ClockCacheShard()
@@ -388,6 +531,18 @@ void ClockCacheShard::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
   }
 }
 
+void ClockCacheShard::ApplyToAllCacheEntriesWithKey(
+    const std::function<void(const Slice& key, void* value, size_t charge)>&
+        callback) {
+  ShardMutexLock l(&mutex_);
+  for (auto& handle : list_) {
+    uint32_t flags = handle.flags.load(std::memory_order_relaxed);
+    if (InCache(flags)) {
+      callback(handle.key, handle.value, handle.charge);
+    }
+  }
+}
+
 void ClockCacheShard::RecycleHandle(CacheHandle* handle,
                                     CleanupContext* context) {
   mutex_.AssertHeld();
@@ -437,6 +592,9 @@ void ClockCacheShard::Unref(CacheHandle* handle, bool set_usage,
   if (set_usage) {
     handle->flags.fetch_or(kUsageBit, std::memory_order_relaxed);
   }
+  // Read the charge while still holding a reference: once the count drops,
+  // the handle can be evicted and reused for another entry.
+  size_t charge = handle->charge;
   // Use acquire-release semantics as previous operations on the cache entry
   // has to be order before reference count is decreased, and potential cleanup
   // of the entry has to be order after.
@@ -444,10 +602,10 @@ void ClockCacheShard::Unref(CacheHandle* handle, bool set_usage,
   assert(CountRefs(flags) > 0);
   if (CountRefs(flags) == 1) {
     // this is the last reference.
-    pinned_usage_.fetch_sub(handle->charge, std::memory_order_relaxed);
+    pinned_usage_.fetch_sub(charge, std::memory_order_relaxed);
     // Cleanup if it is the last reference.
     if (!InCache(flags)) {
-      MutexLock l(&mutex_);
+      ShardMutexLock l(&mutex_);
       RecycleHandle(handle, context);
     }
   }
@@ -472,8 +630,7 @@ bool ClockCacheShard::TryEvict(CacheHandle* handle, CleanupContext* context) {
   uint32_t flags = kInCacheBit;
   if (handle->flags.compare_exchange_strong(flags, 0, std::memory_order_acquire,
                                             std::memory_order_relaxed)) {
-    bool erased __attribute__((__unused__)) =
-        table_.erase(CacheKey(handle->key, handle->hash));
+    bool erased __attribute__((__unused__)) = table_.Remove(handle);
     assert(erased);
     RecycleHandle(handle, context);
     return true;
@@ -511,7 +668,7 @@ bool ClockCacheShard::EvictFromCache(size_t charge, CleanupContext* context) {
 void ClockCacheShard::SetCapacity(size_t capacity) {
   CleanupContext context;
   {
-    MutexLock l(&mutex_);
+    ShardMutexLock l(&mutex_);
     capacity_.store(capacity, std::memory_order_relaxed);
     EvictFromCache(0, &context);
   }
@@ -527,7 +684,7 @@ CacheHandle* ClockCacheShard::Insert(
     const Slice& key, uint32_t hash, void* value, size_t charge,
     void (*deleter)(const Slice& key, void* value), bool hold_reference,
     CleanupContext* context) {
-  MutexLock l(&mutex_);
+  ShardMutexLock l(&mutex_);
   bool success = EvictFromCache(charge, context);
   bool strict = strict_capacity_limit_.load(std::memory_order_relaxed);
   if (!success && (strict || !hold_reference)) {
@@ -553,15 +710,16 @@ CacheHandle* ClockCacheShard::Insert(
   handle->value = value;
   handle->charge = charge;
   handle->deleter = deleter;
-  uint32_t flags = hold_reference ? kInCacheBit + kOneRef : kInCacheBit;
-  handle->flags.store(flags, std::memory_order_relaxed);
-  HashTable::accessor accessor;
-  if (table_.find(accessor, CacheKey(key, hash))) {
-    CacheHandle* existing_handle = accessor->second;
-    table_.erase(accessor);
+  CacheHandle* existing_handle = FindInCache(key, hash);
+  if (existing_handle != nullptr) {
+    table_.Remove(existing_handle);
     UnsetInCache(existing_handle, context);
   }
-  table_.insert(HashTable::value_type(CacheKey(key, hash), handle));
+  // Use release semantics, so that a reader which finds this handle through
+  // a stale table slot and manages to Ref() it sees the fields set above.
+  uint32_t flags = hold_reference ? kInCacheBit + kOneRef : kInCacheBit;
+  handle->flags.store(flags, std::memory_order_release);
+  table_.Insert(handle);
   if (hold_reference) {
     pinned_usage_.fetch_add(charge, std::memory_order_relaxed);
   }
@@ -575,7 +733,6 @@ Status ClockCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
                                Cache::Handle** out_handle,
                                Cache::Priority priority) {
   CleanupContext context;
-  HashTable::accessor accessor;
   char* key_data = new char[key.size()];
   memcpy(key_data, key.data(), key.size());
   Slice key_copy(key_data, key.size());
@@ -593,28 +750,33 @@ Status ClockCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
   return s;
 }
 
+CacheHandle* ClockCacheShard::FindInCache(const Slice& key,
+                                          uint32_t hash) const {
+  mutex_.AssertHeld();
+  return table_.Find(hash, [&key](CacheHandle* handle) {
+    return key == handle->key;
+  });
+}
+
 Cache::Handle* ClockCacheShard::Lookup(const Slice& key, uint32_t hash) {
-  HashTable::const_accessor accessor;
-  if (!table_.find(accessor, CacheKey(key, hash))) {
-    return nullptr;
-  }
-  CacheHandle* handle = accessor->second;
-  accessor.release();
-  // Ref() could fail if another thread sneak in and evict/erase the cache
-  // entry before we are able to hold reference.
-  if (!Ref(reinterpret_cast<Cache::Handle*>(handle))) {
-    return nullptr;
-  }
-  // Double check the key since the handle may now representing another key
-  // if other threads sneak in, evict/erase the entry and re-used the handle
-  // for another cache entry.
-  if (hash != handle->hash || key != handle->key) {
-    CleanupContext context;
-    Unref(handle, false, &context);
-    // It is possible Unref() delete the entry, so we need to cleanup.
-    Cleanup(context);
-    return nullptr;
-  }
+  CacheHandle* handle = table_.Find(hash, [&](CacheHandle* candidate) {
+    // Ref() could fail if another thread sneak in and evict/erase the cache
+    // entry before we are able to hold reference.
+    if (!Ref(reinterpret_cast<Cache::Handle*>(candidate))) {
+      return false;
+    }
+    // Double check the key since the handle may now representing another key
+    // if other threads sneak in, evict/erase the entry and re-used the handle
+    // for another cache entry.
+    if (hash != candidate->hash || key != candidate->key) {
+      CleanupContext context;
+      Unref(candidate, false, &context);
+      // It is possible Unref() delete the entry, so we need to cleanup.
+      Cleanup(context);
+      return false;
+    }
+    return true;
+  });
   return reinterpret_cast<Cache::Handle*>(handle);
 }
 
@@ -628,11 +790,10 @@ void ClockCacheShard::Release(Cache::Handle* h) {
 void ClockCacheShard::Erase(const Slice& key, uint32_t hash) {
   CleanupContext context;
   {
-    MutexLock l(&mutex_);
-    HashTable::accessor accessor;
-    if (table_.find(accessor, CacheKey(key, hash))) {
-      CacheHandle* handle = accessor->second;
-      table_.erase(accessor);
+    ShardMutexLock l(&mutex_);
+    CacheHandle* handle = FindInCache(key, hash);
+    if (handle != nullptr) {
+      table_.Remove(handle);
       UnsetInCache(handle, &context);
     }
   }
@@ -642,8 +803,8 @@ void ClockCacheShard::Erase(const Slice& key, uint32_t hash) {
 void ClockCacheShard::EraseUnRefEntries() {
   CleanupContext context;
   {
-    MutexLock l(&mutex_);
-    table_.clear();
+    ShardMutexLock l(&mutex_);
+    table_.Clear();
     for (auto& handle : list_) {
       UnsetInCache(&handle, &context);
     }
@@ -16,12 +16,67 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <string>
 
-#include "util/mutexlock.h"
+#include "util/sync_point.h"
 
 namespace rocksdb {
 
+namespace {
+
+// Smallest share of capacity of the protected segment of the segmented LRU
+// used with a frequency sketch.
+const double kProtectedPoolRatio = 0.8;
+
+// Lookup slots each thread keeps per shard with lock-free hits.
+const uint32_t kNumLocalSlots = 16;
+
+struct LocalSlots {
+  LRUHandle* slots[kNumLocalSlots];
+
+  LocalSlots() { memset(slots, 0, sizeof(slots)); }
+};
+
+void ReleaseLocalSlots(void* ptr) {
+  LocalSlots* local = static_cast<LocalSlots*>(ptr);
+  for (LRUHandle* e : local->slots) {
+    if (e != nullptr) {
+      e->ReleaseSlot();
+    }
+  }
+  delete local;
+}
+
+// Takes a reference to `e` if it is cached and already referenced, without
+// the shard mutex. Such an entry is not on the LRU list, and one more
+// reference keeps it off.
+bool RefIfReferenced(LRUHandle* e) {
+  uint32_t refs = e->refs.load(std::memory_order_relaxed);
+  while (refs >= 2 && e->InCache()) {
+    if (e->refs.compare_exchange_weak(refs, refs + 1,
+                                      std::memory_order_acquire)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Drops a reference to `e` without the shard mutex if at least one other
+// reference than the cache's is left, so that `e` stays off the LRU list.
+bool UnrefIfReferenced(LRUHandle* e) {
+  uint32_t refs = e->refs.load(std::memory_order_relaxed);
+  while (refs > 2) {
+    if (e->refs.compare_exchange_weak(refs, refs - 1,
+                                      std::memory_order_release)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
 LRUHandleTable::LRUHandleTable() : length_(0), elems_(0), list_(nullptr) {
   Resize();
 }
@@ -99,20 +154,84 @@ void LRUHandleTable::Resize() {
   length_ = new_length;
 }
 
+LRUFrequencySketch::LRUFrequencySketch(size_t num_counters)
+    : additions_(0) {
+  size_t row_size = kCountersPerWord;
+  while (row_size * kDepth < num_counters) {
+    row_size <<= 1;
+  }
+  row_mask_ = row_size - 1;
+  table_.resize(row_size * kDepth / kCountersPerWord, 0);
+  sample_size_ = 10 * row_size * kDepth;
+}
+
+size_t LRUFrequencySketch::CounterIndex(uint32_t hash, int row) const {
+  // Cache shards are picked by the top bits of hash, so spread all of its
+  // bits before double hashing.
+  uint64_t h = hash * 0x9E3779B97F4A7C15ULL;
+  uint32_t h1 = static_cast<uint32_t>(h >> 32);
+  uint32_t h2 = static_cast<uint32_t>(h) | 1;
+  return row * (row_mask_ + 1) + ((h1 + row * h2) & row_mask_);
+}
+
+void LRUFrequencySketch::Increment(uint32_t hash) {
+  for (int row = 0; row < kDepth; row++) {
+    size_t index = CounterIndex(hash, row);
+    uint64_t& word = table_[index / kCountersPerWord];
+    int shift = static_cast<int>(index % kCountersPerWord) * 4;
+    if (((word >> shift) & 0xf) != 0xf) {
+      word += uint64_t{1} << shift;
+    }
+  }
+  if (++additions_ >= sample_size_) {
+    Age();
+  }
+}
+
+uint32_t LRUFrequencySketch::Estimate(uint32_t hash) const {
+  uint32_t result = 0xf;
+  for (int row = 0; row < kDepth; row++) {
+    size_t index = CounterIndex(hash, row);
+    uint64_t word = table_[index / kCountersPerWord];
+    int shift = static_cast<int>(index % kCountersPerWord) * 4;
+    result = std::min(result, static_cast<uint32_t>((word >> shift) & 0xf));
+  }
+  return result;
+}
+
+void LRUFrequencySketch::Age() {
+  for (auto& word : table_) {
+    word = (word >> 1) & 0x7777777777777777ULL;
+  }
+  additions_ /= 2;
+}
+
 LRUCacheShard::LRUCacheShard()
-    : usage_(0), lru_usage_(0), high_pri_pool_usage_(0) {
+    : usage_(0), hit_usage_(0), lru_usage_(0), high_pri_pool_usage_(0) {
   // Make empty circular linked list
   lru_.next = &lru_;
   lru_.prev = &lru_;
   lru_low_pri_ = &lru_;
 }
 
-LRUCacheShard::~LRUCacheShard() {}
+LRUCacheShard::~LRUCacheShard() {
+  // Drop the slots of every thread while the entries are still alive.
+  local_slots_.reset();
+}
 
 bool LRUCacheShard::Unref(LRUHandle* e) {
   assert(e->refs > 0);
-  e->refs--;
-  return e->refs == 0;
+  return e->refs.fetch_sub(1) == 1;
+}
+
+LRUHandle** LRUCacheShard::GetLocalSlot(uint32_t hash) {
+  LocalSlots* local = static_cast<LocalSlots*>(local_slots_->Get());
+  if (local == nullptr) {
+    local = new LocalSlots();
+    local_slots_->Reset(local);
+  }
+  // The shard was picked by the top bits of the hash.
+  return &local->slots[hash % kNumLocalSlots];
 }
 
 // Call deleter and free
@@ -120,7 +239,7 @@ bool LRUCacheShard::Unref(LRUHandle* e) {
 void LRUCacheShard::EraseUnRefEntries() {
   autovector<LRUHandle*> last_reference_list;
   {
-    MutexLock l(&mutex_);
+    ShardMutexLock l(&mutex_);
     while (lru_.next != &lru_) {
       LRUHandle* old = lru_.next;
       assert(old->InCache());
@@ -130,7 +249,7 @@ void LRUCacheShard::EraseUnRefEntries() {
       table_.Remove(old->key(), old->hash);
       old->SetInCache(false);
       Unref(old);
-      usage_ -= old->charge;
+      RemoveUsage(old);
       last_reference_list.push_back(old);
     }
   }
@@ -152,11 +271,38 @@ void LRUCacheShard::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
   }
 }
 
+void LRUCacheShard::ApplyToAllCacheEntriesWithKey(
+    const std::function<void(const Slice& key, void* value, size_t charge)>&
+        callback) {
+  ShardMutexLock l(&mutex_);
+  table_.ApplyToAllCacheEntries([&callback](LRUHandle* h) {
+    callback(h->key(), h->value, h->charge);
+  });
+}
+
 void LRUCacheShard::TEST_GetLRUList(LRUHandle** lru, LRUHandle** lru_low_pri) {
   *lru = &lru_;
   *lru_low_pri = lru_low_pri_;
 }
 
+void LRUCacheShard::SetHit(LRUHandle* e, bool is_hit) {
+  if (e->IsHit() != is_hit) {
+    if (is_hit) {
+      hit_usage_ += e->charge;
+    } else {
+      hit_usage_ -= e->charge;
+    }
+    e->SetHit(is_hit);
+  }
+}
+
+void LRUCacheShard::RemoveUsage(LRUHandle* e) {
+  usage_ -= e->charge;
+  if (e->IsHit()) {
+    hit_usage_ -= e->charge;
+  }
+}
+
 void LRUCacheShard::LRU_Remove(LRUHandle* e) {
   assert(e->next != nullptr);
   assert(e->prev != nullptr);
@@ -176,7 +322,10 @@ void LRUCacheShard::LRU_Remove(LRUHandle* e) {
 void LRUCacheShard::LRU_Insert(LRUHandle* e) {
   assert(e->next == nullptr);
   assert(e->prev == nullptr);
-  if (high_pri_pool_ratio_ > 0 && e->IsHighPri()) {
+  // With a frequency sketch, entries that were hit while in the cache move
+  // up to the protected segment.
+  if ((high_pri_pool_ratio_ > 0 && e->IsHighPri()) ||
+      (sketch_ != nullptr && e->IsHit())) {
     // Inset "e" to head of LRU list.
     e->next = &lru_;
     e->prev = lru_.prev;
@@ -204,10 +353,34 @@ void LRUCacheShard::MaintainPoolSize() {
     lru_low_pri_ = lru_low_pri_->next;
     assert(lru_low_pri_ != &lru_);
     lru_low_pri_->SetInHighPriPool(false);
+    // Back in probation, it has to be hit again to be protected again.
+    SetHit(lru_low_pri_, false);
     high_pri_pool_usage_ -= lru_low_pri_->charge;
   }
 }
 
+double LRUCacheShard::PoolRatio() const {
+  if (sketch_ != nullptr) {
+    return std::max(high_pri_pool_ratio_, kProtectedPoolRatio);
+  }
+  return high_pri_pool_ratio_;
+}
+
+bool LRUCacheShard::Admit(const Slice& key, uint32_t hash, size_t charge,
+                          Cache::Priority priority) {
+  if (sketch_ == nullptr || priority == Cache::Priority::HIGH ||
+      usage_ + charge <= capacity_ || lru_.next == &lru_) {
+    return true;
+  }
+  // Replacing the value of a cached key does not add a key.
+  if (table_.Lookup(key, hash) != nullptr) {
+    return true;
+  }
+  // Ties are rejected, as in TinyLFU, so that keys looked up once, such as
+  // those of a scan, do not replace each other in a full cache.
+  return sketch_->Estimate(hash) > sketch_->Estimate(lru_.next->hash);
+}
+
 void LRUCacheShard::EvictFromLRU(size_t charge,
                                  autovector<LRUHandle*>* deleted) {
   while (usage_ + charge > capacity_ && lru_.next != &lru_) {
@@ -218,7 +391,7 @@ void LRUCacheShard::EvictFromLRU(size_t charge,
     table_.Remove(old->key(), old->hash);
     old->SetInCache(false);
     Unref(old);
-    usage_ -= old->charge;
+    RemoveUsage(old);
     deleted->push_back(old);
   }
 }
@@ -226,9 +399,9 @@ void LRUCacheShard::EvictFromLRU(size_t charge,
 void LRUCacheShard::SetCapacity(size_t capacity) {
   autovector<LRUHandle*> last_reference_list;
   {
-    MutexLock l(&mutex_);
+    ShardMutexLock l(&mutex_);
     capacity_ = capacity;
-    high_pri_pool_capacity_ = capacity_ * high_pri_pool_ratio_;
+    high_pri_pool_capacity_ = capacity_ * PoolRatio();
     EvictFromLRU(0, &last_reference_list);
   }
   // we free the entries here outside of mutex for
@@ -239,26 +412,57 @@ void LRUCacheShard::SetCapacity(size_t capacity) {
 }
 
 void LRUCacheShard::SetStrictCapacityLimit(bool strict_capacity_limit) {
-  MutexLock l(&mutex_);
+  ShardMutexLock l(&mutex_);
   strict_capacity_limit_ = strict_capacity_limit;
 }
 
 Cache::Handle* LRUCacheShard::Lookup(const Slice& key, uint32_t hash) {
-  MutexLock l(&mutex_);
-  LRUHandle* e = table_.Lookup(key, hash);
-  if (e != nullptr) {
-    assert(e->InCache());
-    if (e->refs == 1) {
-      LRU_Remove(e);
+  LRUHandle** slot = nullptr;
+  if (local_slots_ != nullptr) {
+    // An entry this thread found referenced by others before is usually
+    // still referenced, e.g. a pinned index or filter block. If so, take a
+    // reference without the mutex. The entry stays where it is, off the LRU
+    // list, and is not counted by the frequency sketch.
+    slot = GetLocalSlot(hash);
+    LRUHandle* e = *slot;
+    if (e != nullptr && e->hash == hash &&
+        Slice(e->key_data, e->key_length) == key && RefIfReferenced(e)) {
+      TEST_SYNC_POINT("LRUCacheShard::Lookup:LockFreeHit");
+      return reinterpret_cast<Cache::Handle*>(e);
     }
-    e->refs++;
+  }
+
+  LRUHandle* e;
+  LRUHandle* replaced = nullptr;
+  {
+    ShardMutexLock l(&mutex_);
+    if (sketch_ != nullptr) {
+      sketch_->Increment(hash);
+    }
+    e = table_.Lookup(key, hash);
+    if (e != nullptr) {
+      assert(e->InCache());
+      if (e->refs == 1) {
+        LRU_Remove(e);
+      }
+      e->refs++;
+      SetHit(e, true);
+      if (slot != nullptr && *slot != e && e->refs > 2) {
+        replaced = *slot;
+        e->slot_refs++;
+        *slot = e;
+      }
+    }
+  }
+  if (replaced != nullptr) {
+    replaced->ReleaseSlot();
   }
   return reinterpret_cast<Cache::Handle*>(e);
 }
 
 bool LRUCacheShard::Ref(Cache::Handle* h) {
   LRUHandle* handle = reinterpret_cast<LRUHandle*>(h);
-  MutexLock l(&mutex_);
+  ShardMutexLock l(&mutex_);
   if (handle->InCache() && handle->refs == 1) {
     LRU_Remove(handle);
   }
@@ -267,9 +471,24 @@ bool LRUCacheShard::Ref(Cache::Handle* h) {
 }
 
 void LRUCacheShard::SetHighPriorityPoolRatio(double high_pri_pool_ratio) {
-  MutexLock l(&mutex_);
+  ShardMutexLock l(&mutex_);
   high_pri_pool_ratio_ = high_pri_pool_ratio;
-  high_pri_pool_capacity_ = capacity_ * high_pri_pool_ratio_;
+  high_pri_pool_capacity_ = capacity_ * PoolRatio();
+  MaintainPoolSize();
+}
+
+void LRUCacheShard::EnableLockFreeHits() {
+  local_slots_.reset(new ThreadLocalPtr(&ReleaseLocalSlots));
+}
+
+void LRUCacheShard::SetFrequencySketchSize(size_t num_counters) {
+  ShardMutexLock l(&mutex_);
+  if (num_counters == 0) {
+    sketch_.reset();
+  } else {
+    sketch_.reset(new LRUFrequencySketch(num_counters));
+  }
+  high_pri_pool_capacity_ = capacity_ * PoolRatio();
   MaintainPoolSize();
 }
 
@@ -278,12 +497,15 @@ void LRUCacheShard::Release(Cache::Handle* handle) {
     return;
   }
   LRUHandle* e = reinterpret_cast<LRUHandle*>(handle);
+  if (local_slots_ != nullptr && UnrefIfReferenced(e)) {
+    return;
+  }
   bool last_reference = false;
   {
-    MutexLock l(&mutex_);
+    ShardMutexLock l(&mutex_);
     last_reference = Unref(e);
     if (last_reference) {
-      usage_ -= e->charge;
+      RemoveUsage(e);
     }
     if (e->refs == 1 && e->InCache()) {
       // The item is still in cache, and nobody else holds a reference to it
@@ -295,7 +517,7 @@ void LRUCacheShard::Release(Cache::Handle* handle) {
         table_.Remove(e->key(), e->hash);
         e->SetInCache(false);
         Unref(e);
-        usage_ -= e->charge;
+        RemoveUsage(e);
         last_reference = true;
       } else {
         // put the item on the list to be potentially freed
@@ -330,19 +552,37 @@ Status LRUCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
   e->refs = (handle == nullptr
                  ? 1
                  : 2);  // One from LRUCache, one for the returned handle
+  e->slot_refs = 0;
+  e->flags = 0;
   e->next = e->prev = nullptr;
   e->SetInCache(true);
   e->SetPriority(priority);
+  e->SetHit(false);
   memcpy(e->key_data, key.data(), key.size());
 
   {
-    MutexLock l(&mutex_);
+    ShardMutexLock l(&mutex_);
 
-    // Free the space following strict LRU policy until enough space
-    // is freed or the lru list is empty
-    EvictFromLRU(charge, &last_reference_list);
+    bool admitted = Admit(key, hash, charge, priority);
+    if (admitted) {
+      // Free the space following strict LRU policy until enough space
+      // is freed or the lru list is empty
+      EvictFromLRU(charge, &last_reference_list);
+    }
 
-    if (usage_ - lru_usage_ + charge > capacity_ &&
+    if (!admitted) {
+      if (handle == nullptr) {
+        last_reference_list.push_back(e);
+      } else {
+        // Hand the entry to the caller without caching it, as if it were
+        // inserted and evicted right away. It is freed once released.
+        e->SetInCache(false);
+        e->refs = 1;
+        usage_ += e->charge;
+        *handle = reinterpret_cast<Cache::Handle*>(e);
+      }
+      s = Status::OK();
+    } else if (usage_ - lru_usage_ + charge > capacity_ &&
         (strict_capacity_limit_ || handle == nullptr)) {
       if (handle == nullptr) {
         // Don't insert the entry but still return ok, as if the entry inserted
@@ -362,7 +602,7 @@ Status LRUCacheShard::Insert(const Slice& key, uint32_t hash, void* value,
       if (old != nullptr) {
         old->SetInCache(false);
         if (Unref(old)) {
-          usage_ -= old->charge;
+          RemoveUsage(old);
           // old is on LRU because it's in cache and its reference count
           // was just 1 (Unref returned 0)
           LRU_Remove(old);
@@ -391,12 +631,12 @@ void LRUCacheShard::Erase(const Slice& key, uint32_t hash) {
   LRUHandle* e;
   bool last_reference = false;
   {
-    MutexLock l(&mutex_);
+    ShardMutexLock l(&mutex_);
     e = table_.Remove(key, hash);
     if (e != nullptr) {
       last_reference = Unref(e);
       if (last_reference) {
-        usage_ -= e->charge;
+        RemoveUsage(e);
       }
       if (last_reference && e->InCache()) {
         LRU_Remove(e);
@@ -413,12 +653,17 @@ void LRUCacheShard::Erase(const Slice& key, uint32_t hash) {
 }
 
 size_t LRUCacheShard::GetUsage() const {
-  MutexLock l(&mutex_);
+  ShardMutexLock l(&mutex_);
   return usage_;
 }
 
+size_t LRUCacheShard::GetHitUsage() const {
+  ShardMutexLock l(&mutex_);
+  return hit_usage_;
+}
+
 size_t LRUCacheShard::GetPinnedUsage() const {
-  MutexLock l(&mutex_);
+  ShardMutexLock l(&mutex_);
   assert(usage_ >= lru_usage_);
   return usage_ - lru_usage_;
 }
@@ -427,22 +672,37 @@ std::string LRUCacheShard::GetPrintableOptions() const {
   const int kBufferSize = 200;
   char buffer[kBufferSize];
   {
-    MutexLock l(&mutex_);
-    snprintf(buffer, kBufferSize, "    high_pri_pool_ratio: %.3lf\n",
-             high_pri_pool_ratio_);
+    ShardMutexLock l(&mutex_);
+    snprintf(buffer, kBufferSize,
+             "    high_pri_pool_ratio: %.3lf\n"
+             "    frequency_sketch_size: %" ROCKSDB_PRIszt "\n"
+             "    lock_free_hits: %d\n",
+             high_pri_pool_ratio_,
+             sketch_ != nullptr ? sketch_->num_counters() : 0,
+             local_slots_ != nullptr);
   }
   return std::string(buffer);
 }
 
 LRUCache::LRUCache(size_t capacity, int num_shard_bits,
-                   bool strict_capacity_limit, double high_pri_pool_ratio)
-    : ShardedCache(capacity, num_shard_bits, strict_capacity_limit) {
+                   bool strict_capacity_limit, double high_pri_pool_ratio,
+                   size_t frequency_sketch_size,
+                   std::shared_ptr<MemoryAllocator> memory_allocator,
+                   bool lock_free_hits)
+    : ShardedCache(capacity, num_shard_bits, strict_capacity_limit,
+                   std::move(memory_allocator)) {
   int num_shards = 1 << num_shard_bits;
   shards_ = new LRUCacheShard[num_shards];
   SetCapacity(capacity);
   SetStrictCapacityLimit(strict_capacity_limit);
+  size_t per_shard_sketch_size =
+      (frequency_sketch_size + num_shards - 1) / num_shards;
   for (int i = 0; i < num_shards; i++) {
     shards_[i].SetHighPriorityPoolRatio(high_pri_pool_ratio);
+    shards_[i].SetFrequencySketchSize(per_shard_sketch_size);
+    if (lock_free_hits) {
+      shards_[i].EnableLockFreeHits();
+    }
   }
 }
 
@@ -470,9 +730,10 @@ uint32_t LRUCache::GetHash(Handle* handle) const {
 
 void LRUCache::DisownData() { shards_ = nullptr; }
 
-std::shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits,
-                                   bool strict_capacity_limit,
-                                   double high_pri_pool_ratio) {
+std::shared_ptr<Cache> NewLRUCache(
+    size_t capacity, int num_shard_bits, bool strict_capacity_limit,
+    double high_pri_pool_ratio, size_t frequency_sketch_size,
+    std::shared_ptr<MemoryAllocator> memory_allocator, bool lock_free_hits) {
   if (num_shard_bits >= 20) {
     return nullptr;  // the cache cannot be sharded into too many fine pieces
   }
@@ -483,8 +744,9 @@ std::shared_ptr<Cache> NewLRUCache(size_t capacity, int num_shard_bits,
   if (num_shard_bits < 0) {
     num_shard_bits = GetDefaultCacheShardBits(capacity);
   }
-  return std::make_shared<LRUCache>(capacity, num_shard_bits,
-                                    strict_capacity_limit, high_pri_pool_ratio);
+  return std::make_shared<LRUCache>(
+      capacity, num_shard_bits, strict_capacity_limit, high_pri_pool_ratio,
+      frequency_sketch_size, std::move(memory_allocator), lock_free_hits);
 }
 
 }  // namespace rocksdb
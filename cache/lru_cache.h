@@ -8,12 +8,16 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "cache/sharded_cache.h"
 
 #include "port/port.h"
 #include "util/autovector.h"
+#include "util/thread_local.h"
 
 namespace rocksdb {
 
@@ -42,6 +46,9 @@ namespace rocksdb {
 // that any successful LRUCacheShard::Lookup/LRUCacheShard::Insert have a
 // matching
 // RUCache::Release (to move into state 2) or LRUCacheShard::Erase (for state 3)
+//
+// refs is only changed without the shard mutex while it is at least 2, which
+// moves no entry on or off the LRU list. See LRUCacheShard::Lookup().
 
 struct LRUHandle {
   void* value;
@@ -51,13 +58,20 @@ struct LRUHandle {
   LRUHandle* prev;
   size_t charge;  // TODO(opt): Only allow uint32_t?
   size_t key_length;
-  uint32_t refs;     // a number of refs to this entry
-                     // cache itself is counted as 1
+  std::atomic<uint32_t> refs;  // a number of refs to this entry
+                               // cache itself is counted as 1
+
+  // Number of per-thread lookup slots pointing to this entry, plus
+  // kFreedSlotRefs once Free() ran. The memory goes when both are done.
+  std::atomic<uint32_t> slot_refs;
+
+  // Whether this entry is referenced by the hash table.
+  std::atomic<bool> in_cache;
 
   // Include the following flags:
-  //   in_cache:    whether this entry is referenced by the hash table.
   //   is_high_pri: whether this entry is high priority entry.
   //   in_high_pro_pool: whether this entry is in high-pri pool.
+  //   is_hit:      whether this entry was looked up since it was inserted.
   char flags;
 
   uint32_t hash;     // Hash of key(); used for fast sharding and comparisons
@@ -74,16 +88,15 @@ struct LRUHandle {
     }
   }
 
-  bool InCache() { return flags & 1; }
+  static const uint32_t kFreedSlotRefs = 1u << 31;
+
+  bool InCache() { return in_cache.load(std::memory_order_acquire); }
   bool IsHighPri() { return flags & 2; }
   bool InHighPriPool() { return flags & 4; }
+  bool IsHit() { return flags & 8; }
 
-  void SetInCache(bool in_cache) {
-    if (in_cache) {
-      flags |= 1;
-    } else {
-      flags &= ~1;
-    }
+  void SetInCache(bool cached) {
+    in_cache.store(cached, std::memory_order_release);
   }
 
   void SetPriority(Cache::Priority priority) {
@@ -102,12 +115,30 @@ struct LRUHandle {
     }
   }
 
+  void SetHit(bool is_hit) {
+    if (is_hit) {
+      flags |= 8;
+    } else {
+      flags &= ~8;
+    }
+  }
+
   void Free() {
     assert((refs == 1 && InCache()) || (refs == 0 && !InCache()));
     if (deleter) {
       (*deleter)(key(), value);
     }
-    delete[] reinterpret_cast<char*>(this);
+    // Lookup slots of other threads may still point here.
+    if (slot_refs.fetch_or(kFreedSlotRefs) == 0) {
+      delete[] reinterpret_cast<char*>(this);
+    }
+  }
+
+  // Drops the reference of a lookup slot.
+  void ReleaseSlot() {
+    if (slot_refs.fetch_sub(1) == kFreedSlotRefs + 1) {
+      delete[] reinterpret_cast<char*>(this);
+    }
   }
 };
 
@@ -153,6 +184,37 @@ class LRUHandleTable {
   LRUHandle** list_;
 };
 
+// A count-min sketch of 4-bit counters that estimates how often each key
+// hash was looked up recently, for TinyLFU admission. Once there have been
+// ten increments per counter, every counter is halved, so that estimates
+// follow the recent workload rather than all of history.
+class LRUFrequencySketch {
+ public:
+  // `num_counters` is rounded up to a power of two, and to at least 64.
+  explicit LRUFrequencySketch(size_t num_counters);
+
+  void Increment(uint32_t hash);
+  uint32_t Estimate(uint32_t hash) const;
+
+  size_t num_counters() const { return table_.size() * kCountersPerWord; }
+
+ private:
+  static const int kDepth = 4;
+  static const size_t kCountersPerWord = 16;
+
+  // Index of the counter of `hash` in row `row`, over the whole table.
+  size_t CounterIndex(uint32_t hash, int row) const;
+
+  // Halves every counter.
+  void Age();
+
+  // kDepth rows of row_mask_ + 1 counters each, packed 16 to a word.
+  std::vector<uint64_t> table_;
+  size_t row_mask_;
+  size_t additions_;
+  size_t sample_size_;
+};
+
 // A single shard of sharded cache.
 class LRUCacheShard : public CacheShard {
  public:
@@ -170,6 +232,15 @@ class LRUCacheShard : public CacheShard {
   // Set percentage of capacity reserved for high-pri cache entries.
   void SetHighPriorityPoolRatio(double high_pri_pool_ratio);
 
+  // Set the number of counters in the frequency sketch of this shard, or
+  // 0 to turn off frequency-aware admission. See NewLRUCache().
+  void SetFrequencySketchSize(size_t num_counters);
+
+  // Let lookups of entries that are already referenced, and releases that
+  // leave them referenced, run without the mutex. Must be called before the
+  // shard is used. See NewLRUCache().
+  void EnableLockFreeHits();
+
   // Like Cache methods, but with an extra "hash" parameter.
   virtual Status Insert(const Slice& key, uint32_t hash, void* value,
                         size_t charge,
@@ -187,28 +258,59 @@ class LRUCacheShard : public CacheShard {
 
   virtual size_t GetUsage() const override;
   virtual size_t GetPinnedUsage() const override;
+  virtual size_t GetHitUsage() const override;
 
   virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
                                       bool thread_safe) override;
 
+  virtual void ApplyToAllCacheEntriesWithKey(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+          callback) override;
+
   virtual void EraseUnRefEntries() override;
 
   virtual std::string GetPrintableOptions() const override;
 
+  virtual uint64_t GetLockWaits() const override { return mutex_.waits(); }
+  virtual uint64_t GetLockWaitNanos() const override {
+    return mutex_.wait_nanos();
+  }
+
   void TEST_GetLRUList(LRUHandle** lru, LRUHandle** lru_low_pri);
 
  private:
   void LRU_Remove(LRUHandle* e);
   void LRU_Insert(LRUHandle* e);
 
+  // Sets the hit flag of `e`, which is counted in usage_, keeping
+  // hit_usage_ in step.
+  void SetHit(LRUHandle* e, bool is_hit);
+
+  // Takes `e` out of usage_, and out of hit_usage_ if it was hit.
+  void RemoveUsage(LRUHandle* e);
+
   // Overflow the last entry in high-pri pool to low-pri pool until size of
   // high-pri pool is no larger than the size specify by high_pri_pool_pct.
   void MaintainPoolSize();
 
+  // Fraction of capacity the high-pri pool may take. With a frequency
+  // sketch the pool is also the protected segment of a segmented LRU, and
+  // may take at least 80% of capacity.
+  double PoolRatio() const;
+
+  // Whether to cache a new entry for `key`, which would have to evict the
+  // oldest entry of the LRU list to fit. With a frequency sketch, TinyLFU
+  // admits it only if it was looked up more often than that entry.
+  bool Admit(const Slice& key, uint32_t hash, size_t charge,
+             Cache::Priority priority);
+
   // Just reduce the reference count by 1.
   // Return true if last reference
   bool Unref(LRUHandle* e);
 
+  // The lookup slot of the calling thread for `hash`.
+  LRUHandle** GetLocalSlot(uint32_t hash);
+
   // Free some space following strict LRU policy until enough space
   // to hold (usage_ + charge) is freed or the lru list is empty
   // This function is not thread safe - it needs to be executed while
@@ -221,6 +323,10 @@ class LRUCacheShard : public CacheShard {
   // Memory size for entries residing in the cache
   size_t usage_;
 
+  // Memory size for entries in usage_ that were hit since they were
+  // inserted, or since they last left the high-pri pool
+  size_t hit_usage_;
+
   // Memory size for entries residing only in the LRU list
   size_t lru_usage_;
 
@@ -233,14 +339,14 @@ class LRUCacheShard : public CacheShard {
   // Ratio of capacity reserved for high priority cache entries.
   double high_pri_pool_ratio_;
 
-  // High-pri pool size, equals to capacity * high_pri_pool_ratio.
+  // High-pri pool size, equals to capacity * PoolRatio().
   // Remember the value to avoid recomputing each time.
   double high_pri_pool_capacity_;
 
   // mutex_ protects the following state.
   // We don't count mutex_ as the cache's internal state so semantically we
   // don't mind mutex_ invoking the non-const actions.
-  mutable port::Mutex mutex_;
+  mutable ShardMutex mutex_;
 
   // Dummy head of LRU list.
   // lru.prev is newest entry, lru.next is oldest entry.
@@ -251,12 +357,21 @@ class LRUCacheShard : public CacheShard {
   LRUHandle* lru_low_pri_;
 
   LRUHandleTable table_;
+
+  // Lookup frequencies for admission, or null if every entry is admitted.
+  std::unique_ptr<LRUFrequencySketch> sketch_;
+
+  // With lock-free hits, each thread's table of kNumLocalSlots entries it
+  // recently found referenced by others, indexed by hash. Null otherwise.
+  std::unique_ptr<ThreadLocalPtr> local_slots_;
 };
 
 class LRUCache : public ShardedCache {
  public:
   LRUCache(size_t capacity, int num_shard_bits, bool strict_capacity_limit,
-           double high_pri_pool_ratio);
+           double high_pri_pool_ratio, size_t frequency_sketch_size = 0,
+           std::shared_ptr<MemoryAllocator> memory_allocator = nullptr,
+           bool lock_free_hits = false);
   virtual ~LRUCache();
   virtual const char* Name() const override { return "LRUCache"; }
   virtual CacheShard* GetShard(int shard) override;
@@ -7,6 +7,9 @@
 
 #include <string>
 #include <vector>
+#include "util/hash.h"
+#include "util/string_util.h"
+#include "util/sync_point.h"
 #include "util/testharness.h"
 
 namespace rocksdb {
@@ -16,16 +19,27 @@ class LRUCacheTest : public testing::Test {
   LRUCacheTest() {}
   ~LRUCacheTest() {}
 
-  void NewCache(size_t capacity, double high_pri_pool_ratio = 0.0) {
+  void NewCache(size_t capacity, double high_pri_pool_ratio = 0.0,
+                size_t frequency_sketch_size = 0,
+                bool lock_free_hits = false) {
     cache_.reset(new LRUCacheShard());
+    if (lock_free_hits) {
+      cache_->EnableLockFreeHits();
+    }
     cache_->SetCapacity(capacity);
     cache_->SetStrictCapacityLimit(false);
     cache_->SetHighPriorityPoolRatio(high_pri_pool_ratio);
+    cache_->SetFrequencySketchSize(frequency_sketch_size);
+  }
+
+  // The frequency sketch tells keys apart by hash.
+  static uint32_t HashOf(const std::string& key) {
+    return Hash(key.data(), key.size(), 0);
   }
 
   void Insert(const std::string& key,
               Cache::Priority priority = Cache::Priority::LOW) {
-    cache_->Insert(key, 0 /*hash*/, nullptr /*value*/, 1 /*charge*/,
+    cache_->Insert(key, HashOf(key), nullptr /*value*/, 1 /*charge*/,
                    nullptr /*deleter*/, nullptr /*handle*/, priority);
   }
 
@@ -34,7 +48,7 @@ class LRUCacheTest : public testing::Test {
   }
 
   bool Lookup(const std::string& key) {
-    auto handle = cache_->Lookup(key, 0 /*hash*/);
+    auto handle = cache_->Lookup(key, HashOf(key));
     if (handle) {
       cache_->Release(handle);
       return true;
@@ -44,7 +58,14 @@ class LRUCacheTest : public testing::Test {
 
   bool Lookup(char key) { return Lookup(std::string(1, key)); }
 
-  void Erase(const std::string& key) { cache_->Erase(key, 0 /*hash*/); }
+  void Erase(const std::string& key) { cache_->Erase(key, HashOf(key)); }
+
+  // Reads `key` the way a block cache user does: inserts it on a miss.
+  void Read(const std::string& key) {
+    if (!Lookup(key)) {
+      Insert(key);
+    }
+  }
 
   void ValidateLRUList(std::vector<std::string> keys,
                        size_t num_high_pri_pool_keys = 0) {
@@ -75,7 +96,7 @@ class LRUCacheTest : public testing::Test {
     ASSERT_EQ(num_high_pri_pool_keys, high_pri_pool_keys);
   }
 
- private:
+ protected:
   std::unique_ptr<LRUCacheShard> cache_;
 };
 
@@ -155,6 +176,188 @@ TEST_F(LRUCacheTest, MidPointInsertion) {
   ValidateLRUList({"e", "f", "g", "d", "Z"}, 1);
 }
 
+TEST_F(LRUCacheTest, ScanFlushesHotEntriesWithoutSketch) {
+  NewCache(5);
+  for (char ch = 'a'; ch <= 'e'; ch++) {
+    Read(std::string(1, ch));
+    Read(std::string(1, ch));
+  }
+  for (int i = 0; i < 20; i++) {
+    Read("scan" + ToString(i));
+  }
+  for (char ch = 'a'; ch <= 'e'; ch++) {
+    ASSERT_FALSE(Lookup(ch));
+  }
+}
+
+TEST_F(LRUCacheTest, FrequencySketchResistsScans) {
+  NewCache(5, 0.0, 1024);
+  // a to d are hit once cached and move to the protected segment, which
+  // takes 80% of the capacity. e stays in probation.
+  for (char ch = 'a'; ch <= 'e'; ch++) {
+    Read(std::string(1, ch));
+    if (ch != 'e') {
+      Read(std::string(1, ch));
+    }
+  }
+  ValidateLRUList({"e", "a", "b", "c", "d"}, 4);
+
+  // Keys read once are looked up no more often than e, and are not even
+  // admitted to probation.
+  for (int i = 0; i < 20; i++) {
+    Read("scan" + ToString(i));
+  }
+  ValidateLRUList({"e", "a", "b", "c", "d"}, 4);
+  for (char ch = 'a'; ch <= 'e'; ch++) {
+    ASSERT_TRUE(Lookup(ch));
+  }
+  ASSERT_EQ(5U, cache_->GetUsage());
+}
+
+TEST_F(LRUCacheTest, FrequencySketchRejectsTies) {
+  NewCache(2, 0.0, 1024);
+  Read("x");
+  Read("y");
+  ASSERT_EQ(2U, cache_->GetUsage());
+
+  // z is looked up as often as x, the oldest entry, so it is not cached.
+  Read("z");
+  ValidateLRUList({"x", "y"});
+  // Once looked up more often, it replaces x.
+  Read("z");
+  ValidateLRUList({"y", "z"});
+  ASSERT_FALSE(Lookup("x"));
+}
+
+TEST_F(LRUCacheTest, FrequencySketchRejectsColdEntries) {
+  NewCache(2, 0.0, 1024);
+  // Both entries are looked up often. The protected segment only holds one
+  // of them, so the other is the oldest entry, in probation.
+  for (int i = 0; i < 4; i++) {
+    Read("x");
+    Read("y");
+  }
+  ASSERT_EQ(2U, cache_->GetUsage());
+
+  // A key looked up once less often than the oldest entry is not cached,
+  // but the caller still gets a handle to it.
+  ASSERT_TRUE(cache_->Lookup("z", HashOf("z")) == nullptr);
+  Cache::Handle* handle = nullptr;
+  ASSERT_OK(cache_->Insert("z", HashOf("z"), nullptr /*value*/, 1 /*charge*/,
+                           nullptr /*deleter*/, &handle,
+                           Cache::Priority::LOW));
+  ASSERT_TRUE(handle != nullptr);
+  ASSERT_EQ(3U, cache_->GetUsage());
+  ASSERT_EQ(1U, cache_->GetPinnedUsage());
+  cache_->Release(handle);
+  ASSERT_EQ(2U, cache_->GetUsage());
+  ASSERT_FALSE(Lookup("z"));
+  ASSERT_TRUE(Lookup("x"));
+  ASSERT_TRUE(Lookup("y"));
+
+  // High-priority entries are always admitted.
+  Insert("w", Cache::Priority::HIGH);
+  ASSERT_TRUE(Lookup("w"));
+}
+
+TEST_F(LRUCacheTest, HitUsage) {
+  NewCache(5);
+  for (char ch = 'a'; ch <= 'd'; ch++) {
+    Insert(ch);
+  }
+  ASSERT_EQ(0U, cache_->GetHitUsage());
+  ASSERT_TRUE(Lookup('a'));
+  ASSERT_TRUE(Lookup('b'));
+  ASSERT_TRUE(Lookup('b'));
+  ASSERT_EQ(2U, cache_->GetHitUsage());
+
+  // Hit entries leave it when erased or evicted, and replaced ones with
+  // the old value.
+  Erase("a");
+  ASSERT_EQ(1U, cache_->GetHitUsage());
+  Insert('b');
+  ASSERT_EQ(0U, cache_->GetHitUsage());
+  ASSERT_TRUE(Lookup('c'));
+  ASSERT_EQ(1U, cache_->GetHitUsage());
+  // "c" was used last, so it is what remains.
+  cache_->SetCapacity(1);
+  ASSERT_EQ(1U, cache_->GetUsage());
+  ASSERT_EQ(1U, cache_->GetHitUsage());
+  Insert('e');
+  ASSERT_EQ(1U, cache_->GetUsage());
+  ASSERT_EQ(0U, cache_->GetHitUsage());
+}
+
+namespace {
+int num_deleted = 0;
+
+void CountingDeleter(const Slice& /*key*/, void* /*value*/) {
+  num_deleted++;
+}
+}  // namespace
+
+TEST_F(LRUCacheTest, LockFreeHits) {
+  NewCache(5, 0.0, 0, true /*lock_free_hits*/);
+  int lock_free_hits = 0;
+#ifndef NDEBUG
+  SyncPoint::GetInstance()->SetCallBack(
+      "LRUCacheShard::Lookup:LockFreeHit",
+      [&](void* /*arg*/) { lock_free_hits++; });
+  SyncPoint::GetInstance()->EnableProcessing();
+#endif  // NDEBUG
+  num_deleted = 0;
+
+  // "a" stays referenced, like a pinned index block.
+  Cache::Handle* pinned = nullptr;
+  ASSERT_OK(cache_->Insert("a", HashOf("a"), nullptr /*value*/, 1 /*charge*/,
+                           &CountingDeleter, &pinned, Cache::Priority::LOW));
+  Insert('b');
+  // The first lookup takes the mutex and remembers "a" for this thread;
+  // the next ones do not. Lookups of unreferenced entries always lock.
+  for (int i = 0; i < 3; i++) {
+    ASSERT_TRUE(Lookup('a'));
+    ASSERT_TRUE(Lookup('b'));
+  }
+#ifndef NDEBUG
+  ASSERT_EQ(2, lock_free_hits);
+#endif  // NDEBUG
+  ASSERT_EQ(1U, cache_->GetPinnedUsage());
+  ValidateLRUList({"b"});
+
+  // Once "a" is erased it is not found, although this thread still points
+  // to it.
+  Erase("a");
+  ASSERT_FALSE(Lookup('a'));
+  ASSERT_EQ(0, num_deleted);
+  cache_->Release(pinned);
+  ASSERT_EQ(1, num_deleted);
+  ASSERT_EQ(0U, cache_->GetPinnedUsage());
+
+  // A new "a" is found in place of the freed one.
+  Insert('a');
+  ASSERT_TRUE(Lookup('a'));
+  ValidateLRUList({"b", "a"});
+
+  // Releasing the last external reference puts an entry back on the LRU
+  // list even if it was found without the mutex.
+  ASSERT_OK(cache_->Insert("c", HashOf("c"), nullptr /*value*/, 1 /*charge*/,
+                           nullptr /*deleter*/, &pinned,
+                           Cache::Priority::LOW));
+  ASSERT_TRUE(Lookup('c'));
+  Cache::Handle* handle = cache_->Lookup("c", HashOf("c"));
+  ASSERT_TRUE(handle != nullptr);
+  cache_->Release(pinned);
+  ValidateLRUList({"b", "a"});
+  cache_->Release(handle);
+  ValidateLRUList({"b", "a", "c"});
+#ifndef NDEBUG
+  ASSERT_EQ(3, lock_free_hits);
+  SyncPoint::GetInstance()->DisableProcessing();
+  SyncPoint::GetInstance()->ClearAllCallBacks();
+#endif  // NDEBUG
+  cache_.reset();
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
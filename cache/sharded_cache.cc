@@ -13,27 +13,139 @@
 
 #include "cache/sharded_cache.h"
 
+#include <algorithm>
 #include <string>
 
 #include "util/mutexlock.h"
 
 namespace rocksdb {
 
+namespace {
+
+// Auto tuning suggests more shards while more than one in this many lookups
+// finds a shard mutex held.
+const uint64_t kContendedLookupRatio = 32;
+const int kMaxSuggestedNumShardBits = 16;
+
+}  // namespace
+
+const uint64_t ShardedCache::kAutoTunePeriod;
+const int64_t ShardedCache::kAutoTuneStepDivisor;
+
 ShardedCache::ShardedCache(size_t capacity, int num_shard_bits,
-                           bool strict_capacity_limit)
+                           bool strict_capacity_limit,
+                           std::shared_ptr<MemoryAllocator> memory_allocator)
     : num_shard_bits_(num_shard_bits),
       capacity_(capacity),
       strict_capacity_limit_(strict_capacity_limit),
-      last_id_(1) {}
+      last_id_(1),
+      counters_(new ShardCounters[1 << num_shard_bits]),
+      auto_tune_(false),
+      count_lookups_(false),
+      suggested_num_shard_bits_(num_shard_bits),
+      track_shard_stats_(false),
+      memory_allocator_(std::move(memory_allocator)) {
+  int num_shards = 1 << num_shard_bits_;
+  shard_capacities_.assign(num_shards,
+                           (capacity + (num_shards - 1)) / num_shards);
+  tuned_lookups_.assign(num_shards, 0);
+  tuned_lock_waits_.assign(num_shards, 0);
+}
 
 void ShardedCache::SetCapacity(size_t capacity) {
-  int num_shards = 1 << num_shard_bits_;
-  const size_t per_shard = (capacity + (num_shards - 1)) / num_shards;
   MutexLock l(&capacity_mutex_);
+  capacity_ = capacity;
+  SplitCapacityEvenly();
+}
+
+void ShardedCache::SplitCapacityEvenly() {
+  capacity_mutex_.AssertHeld();
+  int num_shards = 1 << num_shard_bits_;
+  const size_t per_shard = (capacity_ + (num_shards - 1)) / num_shards;
   for (int s = 0; s < num_shards; s++) {
     GetShard(s)->SetCapacity(per_shard);
+    shard_capacities_[s] = per_shard;
+  }
+}
+
+void ShardedCache::AutoTuneShards() {
+  capacity_mutex_.AssertHeld();
+  int num_shards = 1 << num_shard_bits_;
+  std::vector<uint64_t> lookups(num_shards);
+  uint64_t total_lookups = 0;
+  uint64_t total_lock_waits = 0;
+  for (int s = 0; s < num_shards; s++) {
+    uint64_t shard_lookups =
+        counters_[s].hits.load(std::memory_order_relaxed) +
+        counters_[s].misses.load(std::memory_order_relaxed);
+    uint64_t shard_lock_waits = GetShard(s)->GetLockWaits();
+    lookups[s] = shard_lookups - tuned_lookups_[s];
+    total_lookups += lookups[s];
+    total_lock_waits += shard_lock_waits - tuned_lock_waits_[s];
+    tuned_lookups_[s] = shard_lookups;
+    tuned_lock_waits_[s] = shard_lock_waits;
+  }
+
+  // Every doubling of the shards roughly halves how often lookups wait.
+  int bits = num_shard_bits_;
+  uint64_t contended = total_lock_waits * kContendedLookupRatio;
+  while (contended > total_lookups && bits < kMaxSuggestedNumShardBits) {
+    contended /= 2;
+    bits++;
+  }
+  suggested_num_shard_bits_.store(bits, std::memory_order_relaxed);
+
+  if (total_lookups == 0) {
+    return;
+  }
+  // Half the capacity is split evenly so no shard is starved, and the rest
+  // follows the lookups, which count the hits a smaller shard would lose as
+  // well as the misses a larger one could save. Misses alone would shrink a
+  // shard whose working set fits until it no longer does.
+  const size_t even_share = capacity_ / num_shards / 2;
+  const double lookup_share =
+      static_cast<double>(capacity_ - even_share * num_shards) /
+      total_lookups;
+  // Capacities only move part of the way to their targets, and a shard is
+  // never shrunk below the usage of its entries that were hit, so one noisy
+  // period neither evicts a working set nor makes capacities oscillate.
+  std::vector<size_t> growths(num_shards, 0);
+  size_t total_capacity = 0;
+  size_t freed = 0;
+  size_t total_growth = 0;
+  for (int s = 0; s < num_shards; s++) {
+    const size_t current = shard_capacities_[s];
+    const size_t target =
+        even_share + static_cast<size_t>(lookup_share * lookups[s]);
+    total_capacity += current;
+    if (target > current) {
+      growths[s] = (target - current) / kAutoTuneStepDivisor;
+      total_growth += growths[s];
+    } else if (target < current) {
+      size_t shrunk = current - (current - target) / kAutoTuneStepDivisor;
+      shrunk = std::max(shrunk,
+                        std::min(current, GetShard(s)->GetHitUsage()));
+      if (shrunk != current) {
+        GetShard(s)->SetCapacity(shrunk);
+        shard_capacities_[s] = shrunk;
+        freed += current - shrunk;
+      }
+    }
+  }
+  // Shards only grow into what the others gave up.
+  size_t available =
+      freed + (capacity_ > total_capacity ? capacity_ - total_capacity : 0);
+  for (int s = 0; s < num_shards; s++) {
+    size_t growth = growths[s];
+    if (total_growth > available) {
+      growth = static_cast<size_t>(static_cast<double>(growth) * available /
+                                   total_growth);
+    }
+    if (growth > 0) {
+      shard_capacities_[s] += growth;
+      GetShard(s)->SetCapacity(shard_capacities_[s]);
+    }
   }
-  capacity_ = capacity;
 }
 
 void ShardedCache::SetStrictCapacityLimit(bool strict_capacity_limit) {
@@ -55,7 +167,27 @@ Status ShardedCache::Insert(const Slice& key, void* value, size_t charge,
 
 Cache::Handle* ShardedCache::Lookup(const Slice& key, Statistics* stats) {
   uint32_t hash = HashSlice(key);
-  return GetShard(Shard(hash))->Lookup(key, hash);
+  uint32_t shard = Shard(hash);
+  Handle* handle = GetShard(shard)->Lookup(key, hash);
+  // The counters are shared by all threads, so lookups only pay for them
+  // while someone needs them.
+  if (!count_lookups_.load(std::memory_order_relaxed)) {
+    return handle;
+  }
+  std::atomic<uint64_t>& counter =
+      handle != nullptr ? counters_[shard].hits : counters_[shard].misses;
+  uint64_t count = counter.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (count % kAutoTunePeriod == 0 &&
+      auto_tune_.load(std::memory_order_relaxed)) {
+    // Tuning is skipped rather than waited for when it is already running.
+    if (capacity_mutex_.TryLock()) {
+      if (auto_tune_.load(std::memory_order_relaxed)) {
+        AutoTuneShards();
+      }
+      capacity_mutex_.Unlock();
+    }
+  }
+  return handle;
 }
 
 bool ShardedCache::Ref(Handle* handle) {
@@ -119,6 +251,15 @@ void ShardedCache::ApplyToAllCacheEntries(void (*callback)(void*, size_t),
   }
 }
 
+void ShardedCache::ApplyToAllCacheEntriesWithKey(
+    const std::function<void(const Slice& key, void* value, size_t charge)>&
+        callback) {
+  int num_shards = 1 << num_shard_bits_;
+  for (int s = 0; s < num_shards; s++) {
+    GetShard(s)->ApplyToAllCacheEntriesWithKey(callback);
+  }
+}
+
 void ShardedCache::EraseUnRefEntries() {
   int num_shards = 1 << num_shard_bits_;
   for (int s = 0; s < num_shards; s++) {
@@ -141,10 +282,68 @@ std::string ShardedCache::GetPrintableOptions() const {
     snprintf(buffer, kBufferSize, "    strict_capacity_limit : %d\n",
              strict_capacity_limit_);
     ret.append(buffer);
+    snprintf(buffer, kBufferSize, "    shard_auto_tuning : %d\n",
+             auto_tune_.load(std::memory_order_relaxed));
+    ret.append(buffer);
+    snprintf(buffer, kBufferSize, "    memory_allocator : %s\n",
+             memory_allocator_ ? memory_allocator_->Name() : "None");
+    ret.append(buffer);
   }
   ret.append(GetShard(0)->GetPrintableOptions());
   return ret;
 }
+
+void ShardedCache::GetShardStats(std::vector<CacheShardStats>* stats) const {
+  int num_shards = 1 << num_shard_bits_;
+  stats->assign(num_shards, CacheShardStats());
+  MutexLock l(&capacity_mutex_);
+  for (int s = 0; s < num_shards; s++) {
+    const CacheShard* shard = GetShard(s);
+    CacheShardStats& shard_stats = (*stats)[s];
+    shard_stats.hits = counters_[s].hits.load(std::memory_order_relaxed);
+    shard_stats.misses = counters_[s].misses.load(std::memory_order_relaxed);
+    shard_stats.lock_waits = shard->GetLockWaits();
+    shard_stats.lock_wait_nanos = shard->GetLockWaitNanos();
+    shard_stats.usage = shard->GetUsage();
+    shard_stats.pinned_usage = shard->GetPinnedUsage();
+    shard_stats.capacity = shard_capacities_[s];
+  }
+}
+
+void ShardedCache::SetShardStatsTracking(bool track) {
+  MutexLock l(&capacity_mutex_);
+  track_shard_stats_ = track;
+  count_lookups_.store(track || auto_tune_.load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+}
+
+void ShardedCache::SetShardAutoTuning(bool auto_tune) {
+  int num_shards = 1 << num_shard_bits_;
+  MutexLock l(&capacity_mutex_);
+  if (auto_tune == auto_tune_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  if (auto_tune) {
+    // Tune by what happens from now on.
+    for (int s = 0; s < num_shards; s++) {
+      tuned_lookups_[s] = counters_[s].hits.load(std::memory_order_relaxed) +
+                          counters_[s].misses.load(std::memory_order_relaxed);
+      tuned_lock_waits_[s] = GetShard(s)->GetLockWaits();
+    }
+  } else {
+    SplitCapacityEvenly();
+    suggested_num_shard_bits_.store(num_shard_bits_,
+                                    std::memory_order_relaxed);
+  }
+  auto_tune_.store(auto_tune, std::memory_order_relaxed);
+  count_lookups_.store(auto_tune || track_shard_stats_,
+                       std::memory_order_relaxed);
+}
+
+int ShardedCache::GetSuggestedNumShardBits() const {
+  return suggested_num_shard_bits_.load(std::memory_order_relaxed);
+}
+
 int GetDefaultCacheShardBits(size_t capacity) {
   int num_shard_bits = 0;
   size_t min_shard_size = 512L * 1024L;  // Every shard is at least 512KB.
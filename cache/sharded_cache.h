@@ -10,14 +10,69 @@
 #pragma once
 
 #include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "port/port.h"
 #include "rocksdb/cache.h"
+#include "rocksdb/env.h"
 #include "util/hash.h"
 
 namespace rocksdb {
 
+// Mutex of a cache shard. Counts the acquisitions that find it held and the
+// time they wait for it. Only those are timed, so an uncontended Lock()
+// costs one try-lock.
+class ShardMutex {
+ public:
+  ShardMutex() : waits_(0), wait_nanos_(0) {}
+
+  void Lock() {
+    if (mutex_.TryLock()) {
+      return;
+    }
+    Env* env = Env::Default();
+    uint64_t start = env->NowNanos();
+    mutex_.Lock();
+    waits_.fetch_add(1, std::memory_order_relaxed);
+    wait_nanos_.fetch_add(env->NowNanos() - start, std::memory_order_relaxed);
+  }
+
+  void Unlock() { mutex_.Unlock(); }
+
+  void AssertHeld() { mutex_.AssertHeld(); }
+
+  uint64_t waits() const { return waits_.load(std::memory_order_relaxed); }
+
+  uint64_t wait_nanos() const {
+    return wait_nanos_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  port::Mutex mutex_;
+  std::atomic<uint64_t> waits_;
+  std::atomic<uint64_t> wait_nanos_;
+
+  // No copying
+  ShardMutex(const ShardMutex&);
+  void operator=(const ShardMutex&);
+};
+
+// Helper class that locks a ShardMutex on construction and unlocks it when
+// destructed, like MutexLock.
+class ShardMutexLock {
+ public:
+  explicit ShardMutexLock(ShardMutex* mu) : mu_(mu) { mu_->Lock(); }
+  ~ShardMutexLock() { mu_->Unlock(); }
+
+ private:
+  ShardMutex* const mu_;
+  // No copying allowed
+  ShardMutexLock(const ShardMutexLock&);
+  void operator=(const ShardMutexLock&);
+};
+
 // Single cache shard interface.
 class CacheShard {
  public:
@@ -36,18 +91,35 @@ class CacheShard {
   virtual void SetStrictCapacityLimit(bool strict_capacity_limit) = 0;
   virtual size_t GetUsage() const = 0;
   virtual size_t GetPinnedUsage() const = 0;
+  // Usage of the entries that were hit while cached. Shards that do not
+  // track hits count every entry as hit.
+  virtual size_t GetHitUsage() const { return GetUsage(); }
   virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
                                       bool thread_safe) = 0;
+  virtual void ApplyToAllCacheEntriesWithKey(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+          callback) = 0;
   virtual void EraseUnRefEntries() = 0;
   virtual std::string GetPrintableOptions() const { return ""; }
+  // Acquisitions of the shard mutex that found it held, and the nanoseconds
+  // they waited.
+  virtual uint64_t GetLockWaits() const { return 0; }
+  virtual uint64_t GetLockWaitNanos() const { return 0; }
 };
 
 // Generic cache interface which shards cache by hash of keys. 2^num_shard_bits
 // shards will be created, with capacity split evenly to each of the shards.
 // Keys are sharded by the highest num_shard_bits bits of hash value.
+//
+// While shard stats tracking or shard auto tuning is on, lookup hits and
+// misses are counted per shard. With auto tuning, every kAutoTunePeriod hits
+// or misses of a shard each shard capacity moves part of the way toward the
+// share of the lookups of the shard since the last tuning, and the shard
+// count to suggest is derived from how many shard mutex acquisitions waited.
 class ShardedCache : public Cache {
  public:
-  ShardedCache(size_t capacity, int num_shard_bits, bool strict_capacity_limit);
+  ShardedCache(size_t capacity, int num_shard_bits, bool strict_capacity_limit,
+               std::shared_ptr<MemoryAllocator> memory_allocator = nullptr);
   virtual ~ShardedCache() = default;
   virtual const char* Name() const override = 0;
   virtual CacheShard* GetShard(int shard) = 0;
@@ -75,12 +147,42 @@ class ShardedCache : public Cache {
   virtual size_t GetPinnedUsage() const override;
   virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
                                       bool thread_safe) override;
+  virtual void ApplyToAllCacheEntriesWithKey(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+          callback) override;
   virtual void EraseUnRefEntries() override;
   virtual std::string GetPrintableOptions() const override;
+  virtual void GetShardStats(
+      std::vector<CacheShardStats>* stats) const override;
+  virtual void SetShardStatsTracking(bool track) override;
+  virtual void SetShardAutoTuning(bool auto_tune) override;
+  virtual int GetSuggestedNumShardBits() const override;
+  virtual MemoryAllocator* memory_allocator() const override {
+    return memory_allocator_.get();
+  }
 
   int GetNumShardBits() const { return num_shard_bits_; }
 
+  static const uint64_t kAutoTunePeriod = 4096;
+  // Each tuning moves a shard capacity by this fraction of the way to its
+  // target.
+  static const int64_t kAutoTuneStepDivisor = 4;
+
  private:
+  // Lookup counters of one shard, padded to a cache line of their own.
+  struct ShardCounters {
+    ShardCounters() : hits(0), misses(0) {}
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    char padding[CACHE_LINE_SIZE - 2 * sizeof(std::atomic<uint64_t>)];
+  };
+
+  // Splits capacity_ evenly among the shards. Requires capacity_mutex_.
+  void SplitCapacityEvenly();
+  // Moves capacity between shards by their recent lookups and updates the
+  // suggested shard bits. Requires capacity_mutex_.
+  void AutoTuneShards();
+
   static inline uint32_t HashSlice(const Slice& s) {
     return Hash(s.data(), s.size(), 0);
   }
@@ -95,6 +197,19 @@ class ShardedCache : public Cache {
   size_t capacity_;
   bool strict_capacity_limit_;
   std::atomic<uint64_t> last_id_;
+  std::unique_ptr<ShardCounters[]> counters_;
+  std::atomic<bool> auto_tune_;
+  // Whether lookups are counted: auto_tune_ or track_shard_stats_.
+  std::atomic<bool> count_lookups_;
+  std::atomic<int> suggested_num_shard_bits_;
+  // Protected by capacity_mutex_: whether shard stats are tracked, the
+  // capacity given to each shard, and the counters of each shard when it was
+  // last auto tuned.
+  bool track_shard_stats_;
+  std::vector<size_t> shard_capacities_;
+  std::vector<uint64_t> tuned_lookups_;
+  std::vector<uint64_t> tuned_lock_waits_;
+  std::shared_ptr<MemoryAllocator> memory_allocator_;
 };
 
 extern int GetDefaultCacheShardBits(size_t capacity);
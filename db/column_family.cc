@@ -374,6 +374,15 @@ ColumnFamilyData::ColumnFamilyData(
     internal_stats_.reset(
         new InternalStats(ioptions_.num_levels, db_options.env, this));
     table_cache_.reset(new TableCache(ioptions_, env_options, _table_cache));
+    // Compaction filters and FIFO compaction change what a key reads as
+    // without a write to it, which the cache would not notice.
+    if (db_options.lookup_result_cache != nullptr &&
+        ioptions_.compaction_filter == nullptr &&
+        ioptions_.compaction_filter_factory == nullptr &&
+        ioptions_.compaction_style != kCompactionStyleFIFO) {
+      lookup_result_cache_.reset(
+          new LookupResultCache(db_options.lookup_result_cache));
+    }
     if (ioptions_.compaction_style == kCompactionStyleLevel) {
       compaction_picker_.reset(
           new LevelCompactionPicker(ioptions_, &internal_comparator_));
@@ -14,6 +14,7 @@
 #include <vector>
 #include <atomic>
 
+#include "db/lookup_result_cache.h"
 #include "db/memtable_list.h"
 #include "db/table_cache.h"
 #include "db/table_properties_collector.h"
@@ -250,6 +251,12 @@ class ColumnFamilyData {
 
   TableCache* table_cache() const { return table_cache_.get(); }
 
+  // nullptr if DBOptions::lookup_result_cache is not set, or this column
+  // family cannot use it.
+  LookupResultCache* lookup_result_cache() const {
+    return lookup_result_cache_.get();
+  }
+
   // See documentation in compaction_picker.h
   // REQUIRES: DB mutex held
   bool NeedsCompaction() const;
@@ -363,6 +370,8 @@ class ColumnFamilyData {
 
   std::unique_ptr<TableCache> table_cache_;
 
+  std::unique_ptr<LookupResultCache> lookup_result_cache_;
+
   std::unique_ptr<InternalStats> internal_stats_;
 
   WriteBufferManager* write_buffer_manager_;
@@ -28,6 +28,7 @@
 #include "db/db_iter.h"
 #include "db/dbformat.h"
 #include "db/event_helpers.h"
+#include "db/linear_segment_tracker.h"
 #include "db/log_reader.h"
 #include "db/log_writer.h"
 #include "db/memtable.h"
@@ -47,6 +48,7 @@
 #include "rocksdb/table.h"
 #include "table/block.h"
 #include "table/block_based_table_factory.h"
+#include "table/block_based_table_reader.h"
 #include "table/merging_iterator.h"
 #include "table/table_builder.h"
 #include "util/coding.h"
@@ -115,6 +117,8 @@ struct CompactionJob::SubcompactionState {
   uint64_t overlapped_bytes = 0;
   // A flag determine whether the key has been seen in ShouldStopBefore()
   bool seen_key = false;
+  // Entries of the current output, used by ShouldStopBeforeForModel()
+  LinearSegmentTracker model_segment;
   std::string compression_dict;
 
   SubcompactionState(Compaction* c, Slice* _start, Slice* _end,
@@ -132,6 +136,8 @@ struct CompactionJob::SubcompactionState {
         grandparent_index(0),
         overlapped_bytes(0),
         seen_key(false),
+        model_segment(
+            c->mutable_cf_options()->model_output_split_error),
         compression_dict() {
     assert(compaction != nullptr);
   }
@@ -155,6 +161,7 @@ struct CompactionJob::SubcompactionState {
     grandparent_index = std::move(o.grandparent_index);
     overlapped_bytes = std::move(o.overlapped_bytes);
     seen_key = std::move(o.seen_key);
+    model_segment = std::move(o.model_segment);
     compression_dict = std::move(o.compression_dict);
     return *this;
   }
@@ -196,6 +203,26 @@ struct CompactionJob::SubcompactionState {
 
     return false;
   }
+
+  // Returns true iff the current output should end before "internal_key"
+  // because adding it would bend the output's key distribution away from a
+  // straight line (see model_output_split_error).
+  bool ShouldStopBeforeForModel(const Slice& internal_key,
+                                const Slice& value) {
+    if (model_segment.max_error() == 0 ||
+        model_segment.bytes() < compaction->max_output_file_size() / 8) {
+      return false;
+    }
+    if (model_segment.Fits(internal_key.Touint64_t(),
+                           internal_key.size() + value.size())) {
+      return false;
+    }
+    // Never split the versions of one user key across output files.
+    const Comparator* ucmp =
+        compaction->column_family_data()->user_comparator();
+    return !ucmp->Equal(ExtractUserKey(internal_key),
+                        current_output()->meta.largest.user_key());
+  }
 };
 
 // Maintains state for the entire compaction
@@ -662,6 +689,7 @@ Status CompactionJob::Install(const MutableCFOptions& mutable_cf_options) {
 
 void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
   assert(sub_compact != nullptr);
+  ScopedBlockCacheTraceCaller trace_caller(BlockCacheTraceCaller::kCompaction);
   ColumnFamilyData* cfd = sub_compact->compaction->column_family_data();
   std::unique_ptr<RangeDelAggregator> range_del_agg(
       new RangeDelAggregator(cfd->internal_comparator(), existing_snapshots_));
@@ -803,6 +831,7 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
     assert(sub_compact->builder != nullptr);
     assert(sub_compact->current_output() != nullptr);
     sub_compact->builder->Add(key, value);
+    sub_compact->model_segment.Add(key.Touint64_t(), key.size() + value.size());
     sub_compact->current_output_file_size = sub_compact->builder->FileSize();
     sub_compact->current_output()->meta.UpdateBoundaries(
         key, c_iter->ikey().sequence);
@@ -878,8 +907,10 @@ void CompactionJob::ProcessKeyValueCompaction(SubcompactionState* sub_compact) {
     c_iter->Next();
     if (!output_file_ended && c_iter->Valid() &&
         sub_compact->compaction->output_level() != 0 &&
-        sub_compact->ShouldStopBefore(
-          c_iter->key(), sub_compact->current_output_file_size) &&
+        (sub_compact->ShouldStopBefore(
+             c_iter->key(), sub_compact->current_output_file_size) ||
+         sub_compact->ShouldStopBeforeForModel(c_iter->key(),
+                                               c_iter->value())) &&
         sub_compact->builder != nullptr) {
       // (2) this key belongs to the next file. For historical reasons, the
       // iterator status after advancing will be given to
@@ -1240,6 +1271,7 @@ Status CompactionJob::OpenCompactionOutputFile(
   out.finished = false;
 
   sub_compact->outputs.push_back(out);
+  sub_compact->model_segment.Reset();
   writable_file->SetIOPriority(Env::IO_LOW);
   writable_file->SetPreallocationBlockSize(static_cast<size_t>(
       sub_compact->compaction->OutputFilePreallocationSize()));
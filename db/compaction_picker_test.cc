@@ -596,6 +596,33 @@ TEST_F(CompactionPickerTest, ParentIndexResetBug) {
       cf_name_, mutable_cf_options_, vstorage_.get(), &log_buffer_));
 }
 
+TEST_F(CompactionPickerTest, ModelErrorTriggersCompaction) {
+  NewVersionStorage(6, kCompactionStyleLevel);
+  Add(1, 1U, "100", "150");
+  Add(1, 2U, "200", "250");  // <- learned model mispredicts half the keys
+  Add(2, 3U, "100", "300");
+  for (auto* f : vstorage_->LevelFiles(1)) {
+    f->num_entries = 100;
+    f->num_model_mispredictions = 2;
+  }
+  vstorage_->LevelFiles(1)[1]->num_model_mispredictions = 50;
+
+  // Disabled by default: nothing to compact.
+  UpdateVersionStorageInfo();
+  ASSERT_FALSE(level_compaction_picker.NeedsCompaction(vstorage_.get()));
+
+  mutable_cf_options_.model_error_compaction_trigger = 0.3;
+  UpdateVersionStorageInfo();
+  ASSERT_TRUE(level_compaction_picker.NeedsCompaction(vstorage_.get()));
+  std::unique_ptr<Compaction> compaction(level_compaction_picker.PickCompaction(
+      cf_name_, mutable_cf_options_, vstorage_.get(), &log_buffer_));
+  ASSERT_TRUE(compaction.get() != nullptr);
+  ASSERT_EQ(CompactionReason::kFilesMarkedForCompaction,
+            compaction->compaction_reason());
+  ASSERT_EQ(1U, compaction->num_input_files(0));
+  ASSERT_EQ(2U, compaction->input(0, 0)->fd.GetNumber());
+}
+
 // This test checks ExpandWhileOverlapping() by having overlapping user keys
 // ranges (with different sequence numbers) in the input files.
 TEST_F(CompactionPickerTest, OverlappingUserKeys) {
@@ -10,6 +10,7 @@
 #include "cache/lru_cache.h"
 #include "db/db_test_util.h"
 #include "port/stack_trace.h"
+#include "util/compression.h"
 
 namespace rocksdb {
 
@@ -225,6 +226,192 @@ TEST_F(DBBlockCacheTest, TestWithCompressedBlockCache) {
 }
 #endif  // SNAPPY
 
+// Blocks are demoted as they are evicted from the block cache, but not when
+// they are freed because their table was closed.
+TEST_F(DBBlockCacheTest, DemoteEvictedBlocksNotOnClose) {
+  CompressionType type = kNoCompression;
+  for (CompressionType t :
+       {kLZ4Compression, kSnappyCompression, kZlibCompression, kZSTD}) {
+    if (CompressionTypeSupported(t)) {
+      type = t;
+      break;
+    }
+  }
+  if (type == kNoCompression) {
+    fprintf(stderr, "skipping test, compression disabled\n");
+    return;
+  }
+
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.compression = kNoCompression;
+  BlockBasedTableOptions table_options;
+  std::shared_ptr<Cache> cache = NewLRUCache(1 << 20, 0, false);
+  std::shared_ptr<Cache> compressed_cache = NewLRUCache(1 << 20, 0, false);
+  table_options.block_cache = cache;
+  table_options.block_cache_compressed = compressed_cache;
+  table_options.demote_evicted_blocks = true;
+  table_options.demoted_block_compression = type;
+  options.table_factory.reset(new BlockBasedTableFactory(table_options));
+  DestroyAndReopen(options);
+
+  const int kNumKeys = 100;
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_OK(Put(Key(i), std::string(1000, 'a' + i % 26)));
+  }
+  ASSERT_OK(Flush());
+  for (int i = 0; i < kNumKeys; i++) {
+    ASSERT_EQ(std::string(1000, 'a' + i % 26), Get(Key(i)));
+  }
+  ASSERT_EQ(0, compressed_cache->GetUsage());
+
+  // Evict the least recently used block, which is demoted.
+  size_t usage = cache->GetUsage();
+  cache->SetCapacity(usage - 1);
+  ASSERT_LT(0, cache->GetUsage());
+  size_t compressed_usage = compressed_cache->GetUsage();
+  ASSERT_LT(0, compressed_usage);
+
+  // Neither closing the DB nor freeing the blocks of its tables left in the
+  // block cache demotes any more of them.
+  Close();
+  ASSERT_EQ(compressed_usage, compressed_cache->GetUsage());
+  cache->EraseUnRefEntries();
+  ASSERT_EQ(0, cache->GetUsage());
+  ASSERT_EQ(compressed_usage, compressed_cache->GetUsage());
+}
+
+namespace {
+// Counts the blocks allocated from a slab allocator.
+class CountingAllocator : public MemoryAllocator {
+ public:
+  CountingAllocator() : base_(NewSlabAllocator()), allocs_(0), frees_(0) {}
+
+  const char* Name() const override { return "CountingAllocator"; }
+
+  void* Allocate(size_t size) override {
+    allocs_++;
+    return base_->Allocate(size);
+  }
+
+  void Deallocate(void* p) override {
+    frees_++;
+    base_->Deallocate(p);
+  }
+
+  size_t UsableSize(void* p, size_t allocation_size) const override {
+    return base_->UsableSize(p, allocation_size);
+  }
+
+  int allocs() const { return allocs_.load(); }
+  int frees() const { return frees_.load(); }
+
+ private:
+  std::shared_ptr<MemoryAllocator> base_;
+  std::atomic<int> allocs_;
+  std::atomic<int> frees_;
+};
+}  // namespace
+
+TEST_F(DBBlockCacheTest, TestWithMemoryAllocator) {
+  ReadOptions read_options;
+  auto table_options = GetTableOptions();
+  auto options = GetOptions(table_options);
+  InitTable(options);
+
+  auto allocator = std::make_shared<CountingAllocator>();
+  std::shared_ptr<Cache> cache =
+      NewLRUCache(1 << 20, 0, false, 0.0, 0, allocator);
+  ASSERT_EQ(allocator.get(), cache->memory_allocator());
+  table_options.block_cache = cache;
+  options.table_factory.reset(new BlockBasedTableFactory(table_options));
+  Reopen(options);
+
+  int allocs = allocator->allocs();
+  for (size_t i = 0; i < kNumBlocks; i++) {
+    std::unique_ptr<Iterator> iter(db_->NewIterator(read_options));
+    iter->Seek(ToString(i));
+    ASSERT_OK(iter->status());
+  }
+  // The blocks inserted were allocated from the cache's allocator.
+  ASSERT_GT(TestGetTickerCount(options, BLOCK_CACHE_ADD), 0);
+  ASSERT_GT(allocator->allocs(), allocs);
+
+  Close();
+  cache->EraseUnRefEntries();
+  ASSERT_EQ(0U, cache->GetUsage());
+  ASSERT_EQ(allocator->allocs(), allocator->frees());
+}
+
+TEST_F(DBBlockCacheTest, WarmUpFromHotBlocks) {
+  auto table_options = GetTableOptions();
+  table_options.cache_index_and_filter_blocks = true;
+  table_options.block_cache = NewLRUCache(1 << 20);
+  auto options = GetOptions(table_options);
+  options.block_cache_warmup_persist_period_sec = 1;
+  options.block_cache_warmup_threads = 2;
+  options.block_cache_warmup_rate_bytes_per_sec = 1 << 20;
+  DestroyAndReopen(options);
+  InitTable(options);
+  ASSERT_OK(Flush());
+
+  const std::string hot_blocks_file = dbname_ + "/HOT_BLOCKS";
+  dbfull()->TEST_WaitForBlockCacheWarmUp();
+  for (size_t i = 0; i < kNumBlocks; i += 2) {
+    ASSERT_EQ(std::string(kValueSize, 'a'), Get(ToString(i)));
+  }
+  // The file is written periodically even though no compaction runs.
+  rocksdb::SyncPoint::GetInstance()->LoadDependency(
+      {{"DBImpl::PersistHotBlocksPeriodically:Persisted",
+        "DBBlockCacheTest::WarmUpFromHotBlocks:Persisted"}});
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+  TEST_SYNC_POINT("DBBlockCacheTest::WarmUpFromHotBlocks:Persisted");
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  ASSERT_OK(env_->FileExists(hot_blocks_file));
+  Close();
+
+  // A new cache is filled from the file without any lookups.
+  table_options.block_cache = NewLRUCache(1 << 20);
+  options.table_factory.reset(new BlockBasedTableFactory(table_options));
+  Reopen(options);
+  dbfull()->TEST_WaitForBlockCacheWarmUp();
+  ASSERT_GT(table_options.block_cache->GetUsage(), 0U);
+  uint64_t data_misses = TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS);
+  for (size_t i = 0; i < kNumBlocks; i += 2) {
+    ASSERT_EQ(std::string(kValueSize, 'a'), Get(ToString(i)));
+  }
+  ASSERT_EQ(data_misses, TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS));
+  Close();
+
+  // A DB closed before its warm-up has finished leaves the file alone,
+  // although its cache holds fewer blocks.
+  std::string hot_blocks;
+  ASSERT_OK(ReadFileToString(env_, hot_blocks_file, &hot_blocks));
+  table_options.block_cache = NewLRUCache(1 << 20);
+  options.table_factory.reset(new BlockBasedTableFactory(table_options));
+  rocksdb::SyncPoint::GetInstance()->LoadDependency(
+      {{"DBImpl::~DBImpl:StopBlockCacheWarmUp",
+        "DBImpl::BlockCacheWarmUp:Start"}});
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+  Reopen(options);
+  Close();
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  std::string new_hot_blocks;
+  ASSERT_OK(ReadFileToString(env_, hot_blocks_file, &new_hot_blocks));
+  ASSERT_EQ(hot_blocks, new_hot_blocks);
+
+  // A corrupted file is ignored.
+  ASSERT_OK(WriteStringToFile(env_, "garbage", hot_blocks_file));
+  table_options.block_cache = NewLRUCache(1 << 20);
+  options.table_factory.reset(new BlockBasedTableFactory(table_options));
+  Reopen(options);
+  dbfull()->TEST_WaitForBlockCacheWarmUp();
+  data_misses = TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS);
+  ASSERT_EQ(std::string(kValueSize, 'a'), Get("0"));
+  ASSERT_EQ(data_misses + 1,
+            TestGetTickerCount(options, BLOCK_CACHE_DATA_MISS));
+}
+
 #ifndef ROCKSDB_LITE
 
 // Make sure that when options.block_cache is set, after a new table is
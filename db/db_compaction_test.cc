@@ -813,6 +813,66 @@ TEST_F(DBCompactionTest, ManualCompactionUnknownOutputSize) {
   dbfull()->CompactFiles(compact_opt, input_filenames, 1);
 }
 
+TEST_F(DBCompactionTest, ModelOutputSplit) {
+  // Keys are read as big-endian integers by their first 8 bytes.
+  auto key = [](uint64_t n) {
+    std::string result;
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      result.push_back(static_cast<char>(n >> shift));
+    }
+    return result;
+  };
+  // Two key ranges of equal-sized entries, each linear on its own: dense
+  // keys, then keys spread far apart.
+  const int kNumKeys = 400;
+  std::vector<std::string> keys;
+  for (int i = 0; i < kNumKeys; i++) {
+    keys.push_back(key(i));
+  }
+  for (int i = 0; i < kNumKeys; i++) {
+    keys.push_back(key((uint64_t{1} << 40) + (uint64_t{i} << 24)));
+  }
+
+  for (uint64_t split_error : {uint64_t{0}, uint64_t{4096}}) {
+    Options options = CurrentOptions();
+    options.disable_auto_compactions = true;
+    options.compression = kNoCompression;
+    // Large enough for all keys in one file.
+    options.target_file_size_base = 1 << 20;
+    options.model_output_split_error = split_error;
+    DestroyAndReopen(options);
+
+    // Overlapping L0 files, so that compaction rewrites them.
+    for (int parity = 0; parity < 2; parity++) {
+      for (size_t i = parity; i < keys.size(); i += 2) {
+        ASSERT_OK(Put(keys[i], std::string(1000, 'v')));
+      }
+      ASSERT_OK(Flush());
+    }
+    ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+
+    ColumnFamilyMetaData cf_meta;
+    db_->GetColumnFamilyMetaData(&cf_meta);
+    ASSERT_EQ(0U, cf_meta.levels[0].files.size());
+    const auto& files = cf_meta.levels[1].files;
+    if (split_error == 0) {
+      ASSERT_EQ(1U, files.size());
+      ASSERT_EQ(keys.front(), files[0].smallestkey);
+      ASSERT_EQ(keys.back(), files[0].largestkey);
+    } else {
+      // The output ends where the second range bends the distribution.
+      ASSERT_EQ(2U, files.size());
+      ASSERT_EQ(keys[0], files[0].smallestkey);
+      ASSERT_EQ(keys[kNumKeys - 1], files[0].largestkey);
+      ASSERT_EQ(keys[kNumKeys], files[1].smallestkey);
+      ASSERT_EQ(keys.back(), files[1].largestkey);
+    }
+    for (const auto& k : keys) {
+      ASSERT_EQ(std::string(1000, 'v'), Get(k));
+    }
+  }
+}
+
 // Check that writes done during a memtable compaction are recovered
 // if the database is shutdown during the memtable compaction.
 TEST_F(DBCompactionTest, RecoverDuringMemtableCompaction) {
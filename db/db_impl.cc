@@ -41,6 +41,7 @@
 #include "db/external_sst_file_ingestion_job.h"
 #include "db/flush_job.h"
 #include "db/forward_iterator.h"
+#include "db/hot_blocks.h"
 #include "db/job_context.h"
 #include "db/log_reader.h"
 #include "db/log_writer.h"
@@ -72,6 +73,7 @@
 #include "rocksdb/db.h"
 #include "rocksdb/env.h"
 #include "rocksdb/merge_operator.h"
+#include "rocksdb/rate_limiter.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/status.h"
 #include "rocksdb/table.h"
@@ -170,9 +172,12 @@ DBImpl::DBImpl(const DBOptions& options, const std::string& dbname)
       bg_flush_scheduled_(0),
       num_running_flushes_(0),
       bg_purge_scheduled_(0),
+      bg_memtable_convert_scheduled_(0),
       disable_delete_obsolete_files_(0),
       delete_obsolete_files_last_run_(env_->NowMicros()),
       last_stats_dump_time_microsec_(0),
+      block_cache_warmup_running_(false),
+      block_cache_warmed_up_(false),
       next_job_id_(1),
       has_unpersisted_data_(false),
       unable_to_flush_oldest_log_(false),
@@ -247,6 +252,19 @@ DBImpl::~DBImpl() {
   // marker. After this we do a variant of the waiting and unschedule work
   // (to consider: moving all the waiting into CancelAllBackgroundWork(true))
   CancelAllBackgroundWork(false);
+  TEST_SYNC_POINT("DBImpl::~DBImpl:StopBlockCacheWarmUp");
+  // The warm-up and the periodic writes of HOT_BLOCKS stop once
+  // shutting_down_ is set.
+  if (block_cache_warmup_thread_.joinable()) {
+    block_cache_warmup_thread_.join();
+  }
+  if (block_cache_warmed_up_.load(std::memory_order_acquire)) {
+    Status s = PersistHotBlocks();
+    if (!s.ok()) {
+      ROCKS_LOG_WARN(immutable_db_options_.info_log,
+                     "Failed to persist hot blocks: %s", s.ToString().c_str());
+    }
+  }
   int compactions_unscheduled = env_->UnSchedule(this, Env::Priority::LOW);
   int flushes_unscheduled = env_->UnSchedule(this, Env::Priority::HIGH);
   mutex_.Lock();
@@ -255,7 +273,7 @@ DBImpl::~DBImpl() {
 
   // Wait for background work to finish
   while (bg_compaction_scheduled_ || bg_flush_scheduled_ ||
-         bg_purge_scheduled_) {
+         bg_purge_scheduled_ || bg_memtable_convert_scheduled_) {
     TEST_SYNC_POINT("DBImpl::~DBImpl:WaitJob");
     bg_cv_.Wait();
   }
@@ -461,6 +479,229 @@ void DBImpl::MaybeDumpStats() {
   }
 }
 
+namespace {
+// Refs the current version of each live column family, and the family.
+// REQUIRES: mutex held
+std::vector<Version*> RefCurrentVersions(ColumnFamilySet* column_families) {
+  std::vector<Version*> versions;
+  for (auto cfd : *column_families) {
+    if (cfd->IsDropped()) {
+      continue;
+    }
+    cfd->Ref();
+    cfd->current()->Ref();
+    versions.push_back(cfd->current());
+  }
+  return versions;
+}
+
+// REQUIRES: mutex held
+void UnrefVersions(const std::vector<Version*>& versions) {
+  for (Version* version : versions) {
+    ColumnFamilyData* cfd = version->cfd();
+    version->Unref();
+    if (cfd->Unref()) {
+      delete cfd;
+    }
+  }
+}
+}  // namespace
+
+Status DBImpl::PersistHotBlocks() {
+  MutexLock hot_blocks_lock(&hot_blocks_mutex_);
+  std::vector<Version*> versions;
+  {
+    InstrumentedMutexLock l(&mutex_);
+    versions = RefCurrentVersions(versions_->GetColumnFamilySet());
+  }
+
+  // Only tables already open can have blocks in a block cache.
+  HotBlocksCollector collector;
+  for (Version* version : versions) {
+    ColumnFamilyData* cfd = version->cfd();
+    auto* vstorage = version->storage_info();
+    for (int level = 0; level < vstorage->num_levels(); level++) {
+      for (const FileMetaData* file : vstorage->LevelFiles(level)) {
+        std::string key_prefix;
+        Cache* block_cache = cfd->table_cache()->GetBlockCacheKeyPrefix(
+            env_options_, cfd->internal_comparator(), file->fd, &key_prefix);
+        if (block_cache != nullptr) {
+          collector.AddTable(block_cache, key_prefix, file->fd.GetNumber());
+        }
+      }
+    }
+  }
+  HotBlockMap hot_blocks;
+  collector.Collect(&hot_blocks);
+  {
+    InstrumentedMutexLock l(&mutex_);
+    UnrefVersions(versions);
+  }
+
+  std::string contents;
+  EncodeHotBlocks(hot_blocks, &contents);
+  const std::string temp_fname = TempHotBlocksFileName(dbname_);
+  Status s = WriteStringToFile(env_, contents, temp_fname,
+                               true /* should_sync */);
+  if (s.ok()) {
+    s = env_->RenameFile(temp_fname, HotBlocksFileName(dbname_));
+  } else {
+    env_->DeleteFile(temp_fname);
+  }
+  if (s.ok()) {
+    size_t num_blocks = 0;
+    for (const auto& table : hot_blocks) {
+      num_blocks += table.second.size();
+    }
+    ROCKS_LOG_INFO(immutable_db_options_.info_log,
+                   "Persisted %" ROCKSDB_PRIszt " hot blocks of %"
+                   ROCKSDB_PRIszt " tables",
+                   num_blocks, hot_blocks.size());
+  }
+  return s;
+}
+
+void DBImpl::StartBlockCacheWarmUp() {
+  mutex_.AssertHeld();
+  if (immutable_db_options_.block_cache_warmup_persist_period_sec == 0) {
+    return;
+  }
+  // The versions keep the tables to load from being deleted meanwhile.
+  std::vector<Version*> versions =
+      RefCurrentVersions(versions_->GetColumnFamilySet());
+  block_cache_warmup_running_ = true;
+  block_cache_warmup_thread_ =
+      port::Thread([this, versions]() { BlockCacheWarmUp(versions); });
+}
+
+void DBImpl::BlockCacheWarmUp(const std::vector<Version*>& versions) {
+  TEST_SYNC_POINT("DBImpl::BlockCacheWarmUp:Start");
+  HotBlockMap hot_blocks;
+  const std::string fname = HotBlocksFileName(dbname_);
+  if (env_->FileExists(fname).ok()) {
+    std::string contents;
+    Status s = ReadFileToString(env_, fname, &contents);
+    if (s.ok()) {
+      s = DecodeHotBlocks(contents, &hot_blocks);
+    }
+    if (!s.ok()) {
+      hot_blocks.clear();
+      ROCKS_LOG_WARN(immutable_db_options_.info_log,
+                     "Not warming up the block cache from %s: %s",
+                     fname.c_str(), s.ToString().c_str());
+    }
+  }
+
+  struct Table {
+    ColumnFamilyData* cfd;
+    const FileMetaData* file;
+    int level;
+    const std::vector<uint64_t>* offsets;
+  };
+  std::vector<Table> tables;
+  for (Version* version : versions) {
+    auto* vstorage = version->storage_info();
+    for (int level = 0; level < vstorage->num_levels(); level++) {
+      for (const FileMetaData* file : vstorage->LevelFiles(level)) {
+        auto it = hot_blocks.find(file->fd.GetNumber());
+        if (it != hot_blocks.end()) {
+          tables.push_back({version->cfd(), file, level, &it->second});
+        }
+      }
+    }
+  }
+  // Lower levels are read first by lookups, and are smaller.
+  std::stable_sort(tables.begin(), tables.end(),
+                   [](const Table& a, const Table& b) {
+                     return a.level < b.level;
+                   });
+
+  std::unique_ptr<RateLimiter> rate_limiter;
+  if (immutable_db_options_.block_cache_warmup_rate_bytes_per_sec > 0) {
+    rate_limiter.reset(NewGenericRateLimiter(static_cast<int64_t>(
+        immutable_db_options_.block_cache_warmup_rate_bytes_per_sec)));
+  }
+  // Set once a cache is full, or on shutdown.
+  std::atomic<bool> stop(false);
+  // First the meta blocks of all tables, then their data blocks, each phase
+  // spread over the warm-up threads.
+  for (bool data_blocks : {false, true}) {
+    std::atomic<size_t> next_table(0);
+    auto load_tables = [&]() {
+      for (size_t i = next_table.fetch_add(1); i < tables.size();
+           i = next_table.fetch_add(1)) {
+        if (stop.load(std::memory_order_relaxed) ||
+            shutting_down_.load(std::memory_order_acquire)) {
+          return;
+        }
+        const Table& table = tables[i];
+        Status s = table.cfd->table_cache()->WarmUpBlockCache(
+            env_options_, table.cfd->internal_comparator(), table.file->fd,
+            table.level, data_blocks ? table.offsets : nullptr,
+            rate_limiter.get(), &shutting_down_);
+        if (s.IsIncomplete()) {
+          stop.store(true, std::memory_order_relaxed);
+        } else if (!s.ok()) {
+          ROCKS_LOG_WARN(immutable_db_options_.info_log,
+                         "Failed to warm up the block cache from table "
+                         "#%" PRIu64 ": %s",
+                         table.file->fd.GetNumber(), s.ToString().c_str());
+        }
+      }
+    };
+    std::vector<port::Thread> threads;
+    for (int i = 1; i < immutable_db_options_.block_cache_warmup_threads;
+         i++) {
+      threads.emplace_back(load_tables);
+    }
+    load_tables();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  const bool stopped = shutting_down_.load(std::memory_order_acquire);
+  ROCKS_LOG_INFO(immutable_db_options_.info_log,
+                 "Block cache warm-up from %" ROCKSDB_PRIszt " tables %s",
+                 tables.size(), stopped ? "stopped by shutdown" : "finished");
+  if (!stopped) {
+    block_cache_warmed_up_.store(true, std::memory_order_release);
+  }
+  {
+    InstrumentedMutexLock l(&mutex_);
+    UnrefVersions(versions);
+    block_cache_warmup_running_ = false;
+    bg_cv_.SignalAll();
+  }
+  TEST_SYNC_POINT("DBImpl::BlockCacheWarmUp:Done");
+  if (!stopped) {
+    PersistHotBlocksPeriodically();
+  }
+}
+
+void DBImpl::PersistHotBlocksPeriodically() {
+  const uint64_t period_micros =
+      immutable_db_options_.block_cache_warmup_persist_period_sec * 1000000ULL;
+  uint64_t next_persist_micros = env_->NowMicros() + period_micros;
+  InstrumentedMutexLock l(&mutex_);
+  // bg_cv_ is signalled when shutting_down_ is set.
+  while (!shutting_down_.load(std::memory_order_acquire)) {
+    if (env_->NowMicros() < next_persist_micros) {
+      bg_cv_.TimedWait(next_persist_micros);
+      continue;
+    }
+    mutex_.Unlock();
+    Status s = PersistHotBlocks();
+    if (!s.ok()) {
+      ROCKS_LOG_WARN(immutable_db_options_.info_log,
+                     "Failed to persist hot blocks: %s", s.ToString().c_str());
+    }
+    TEST_SYNC_POINT("DBImpl::PersistHotBlocksPeriodically:Persisted");
+    mutex_.Lock();
+    next_persist_micros = env_->NowMicros() + period_micros;
+  }
+}
+
 void DBImpl::ScheduleBgLogWriterClose(JobContext* job_context) {
   if (!job_context->logs_to_free.empty()) {
     for (auto l : job_context->logs_to_free) {
@@ -908,6 +1149,19 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
   auto cfh = reinterpret_cast<ColumnFamilyHandleImpl*>(column_family);
   auto cfd = cfh->cfd();
 
+  // Only reads of the latest state that would see every level use the
+  // lookup result cache. Reads at an explicit snapshot include the ones
+  // write batches make before their sequence is published.
+  LookupResultCache* result_cache = nullptr;
+  uint64_t result_cache_epoch = 0;
+  if (cfd->lookup_result_cache() != nullptr &&
+      read_options.snapshot == nullptr &&
+      read_options.read_tier == kReadAllTier &&
+      !read_options.ignore_range_deletions && value_found == nullptr) {
+    result_cache = cfd->lookup_result_cache();
+    result_cache_epoch = result_cache->epoch();
+  }
+
   // Acquire SuperVersion
   SuperVersion* sv = GetAndRefSuperVersion(cfd);
 
@@ -934,11 +1188,33 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
   TEST_SYNC_POINT("DBImpl::GetImpl:3");
   TEST_SYNC_POINT("DBImpl::GetImpl:4");
 
+  Status s;
+  if (result_cache != nullptr) {
+    if (result_cache->Lookup(key, snapshot, result_cache_epoch, pinnable_val,
+                             &s)) {
+      RecordTick(stats_, LOOKUP_RESULT_CACHE_HIT);
+      PERF_TIMER_STOP(get_snapshot_time);
+      PERF_TIMER_GUARD(get_post_process_time);
+      ReturnAndCleanupSuperVersion(cfd, sv);
+      RecordTick(stats_, NUMBER_KEYS_READ);
+      size_t size = pinnable_val->size();
+      RecordTick(stats_, BYTES_READ, size);
+      MeasureTime(stats_, BYTES_PER_READ, size);
+      return s;
+    }
+    RecordTick(stats_, LOOKUP_RESULT_CACHE_MISS);
+    // A memtable switch after we referenced the SuperVersion may have put
+    // writes up to `snapshot` in a memtable it does not have. Such a read is
+    // still valid, but not the state at `snapshot`, so it is not cached.
+    if (cfd->GetSuperVersionNumber() != sv->version_number) {
+      result_cache = nullptr;
+    }
+  }
+
   // Prepare to store a list of merge operations if merge occurs.
   MergeContext merge_context;
   RangeDelAggregator range_del_agg(cfd->internal_comparator(), snapshot);
 
-  Status s;
   // First look in the memtable, then in the immutable memtable (if any).
   // s is both in/out. When in, s could either be OK or MergeInProgress.
   // merge_operands will contain the sequence of merges in the latter case.
@@ -975,6 +1251,10 @@ Status DBImpl::GetImpl(const ReadOptions& read_options,
   {
     PERF_TIMER_GUARD(get_post_process_time);
 
+    if (result_cache != nullptr && (s.ok() || s.IsNotFound())) {
+      result_cache->Insert(key, snapshot, result_cache_epoch, s,
+                           *pinnable_val);
+    }
     ReturnAndCleanupSuperVersion(cfd, sv);
 
     RecordTick(stats_, NUMBER_KEYS_READ);
@@ -2001,6 +2281,9 @@ Status DBImpl::DeleteFile(std::string name) {
     if (status.ok()) {
       InstallSuperVersionAndScheduleWorkWrapper(
           cfd, &job_context, *cfd->GetLatestMutableCFOptions());
+      if (cfd->lookup_result_cache() != nullptr) {
+        cfd->lookup_result_cache()->InvalidateAll();
+      }
     }
     FindObsoleteFiles(&job_context, false);
   }  // lock released here
@@ -2079,6 +2362,9 @@ Status DBImpl::DeleteFilesInRange(ColumnFamilyHandle* column_family,
     if (status.ok()) {
       InstallSuperVersionAndScheduleWorkWrapper(
           cfd, &job_context, *cfd->GetLatestMutableCFOptions());
+      if (cfd->lookup_result_cache() != nullptr) {
+        cfd->lookup_result_cache()->InvalidateAll();
+      }
     }
     for (auto* deleted_file : deleted_files) {
       deleted_file->being_compacted = false;
@@ -2675,6 +2961,9 @@ Status DBImpl::IngestExternalFile(
     if (status.ok()) {
       delete InstallSuperVersionAndScheduleWork(cfd, nullptr,
                                                 *mutable_cf_options);
+      if (cfd->lookup_result_cache() != nullptr) {
+        cfd->lookup_result_cache()->InvalidateAll();
+      }
     }
 
     // Resume writes to the DB
@@ -348,6 +348,10 @@ class DBImpl : public DB {
   // Wait for any compaction
   Status TEST_WaitForCompact();
 
+  // Wait until all queued immutable memtables have been converted into
+  // learned sorted arrays
+  void TEST_WaitForMemTableConversion();
+
   // Return the maximum overlapping data (in bytes) at next level for any
   // file at a level >= 1.
   int64_t TEST_MaxNextLevelOverlappingBytes(ColumnFamilyHandle* column_family =
@@ -400,6 +404,9 @@ class DBImpl : public DB {
 
   int TEST_BGCompactionsAllowed() const;
 
+  // Wait for the block cache warm-up started by DB::Open() to finish.
+  void TEST_WaitForBlockCacheWarmUp();
+
 #endif  // NDEBUG
 
   // Return maximum background compaction allowed to be scheduled based on
@@ -756,13 +763,18 @@ class DBImpl : public DB {
   void SchedulePendingCompaction(ColumnFamilyData* cfd);
   void SchedulePendingPurge(std::string fname, FileType type, uint64_t number,
                             uint32_t path_id, int job_id);
+  // Queues an immutable memtable to be rebuilt as a learned sorted array on
+  // the flush thread pool.
+  void ScheduleMemTableConversion(MemTable* mem);
   static void BGWorkCompaction(void* arg);
   static void BGWorkFlush(void* db);
   static void BGWorkPurge(void* arg);
+  static void BGWorkConvertMemTable(void* db);
   static void UnscheduleCallback(void* arg);
   void BackgroundCallCompaction(void* arg);
   void BackgroundCallFlush();
   void BackgroundCallPurge();
+  void BackgroundCallConvertMemTable();
   Status BackgroundCompaction(bool* madeProgress, JobContext* job_context,
                               LogBuffer* log_buffer, void* m = 0);
   Status BackgroundFlush(bool* madeProgress, JobContext* job_context,
@@ -773,6 +785,25 @@ class DBImpl : public DB {
   // dump rocksdb.stats to LOG
   void MaybeDumpStats();
 
+  // Write the offsets of the blocks of the current tables found in their
+  // block caches to the HOT_BLOCKS file.
+  Status PersistHotBlocks();
+
+  // Start loading the blocks listed in the HOT_BLOCKS file into the block
+  // caches of the current tables on block_cache_warmup_thread_.
+  // REQUIRES: mutex_ held
+  void StartBlockCacheWarmUp();
+
+  // Body of block_cache_warmup_thread_. Unrefs `versions` once the blocks
+  // are loaded, then calls PersistHotBlocksPeriodically() unless the DB is
+  // shutting down.
+  void BlockCacheWarmUp(const std::vector<Version*>& versions);
+
+  // Call PersistHotBlocks() every block_cache_warmup_persist_period_sec
+  // until the DB is shutting down, whether or not flushes and compactions
+  // run.
+  void PersistHotBlocksPeriodically();
+
   // Return the minimum empty level that could hold the total data in the
   // input level. Return the input level, if such level could not be found.
   int FindMinimumEmptyLevelFitting(ColumnFamilyData* cfd,
@@ -981,6 +1012,10 @@ class DBImpl : public DB {
 
   // A queue to store log writers to close
   std::deque<log::Writer*> logs_to_free_queue_;
+
+  // Immutable memtables waiting to be converted into learned sorted arrays.
+  // Each one holds a reference that the conversion job releases.
+  std::deque<MemTable*> memtables_to_convert_;
   int unscheduled_flushes_;
   int unscheduled_compactions_;
 
@@ -999,6 +1034,9 @@ class DBImpl : public DB {
   // number of background obsolete file purge jobs, submitted to the HIGH pool
   int bg_purge_scheduled_;
 
+  // number of background memtable conversion jobs, submitted to the HIGH pool
+  int bg_memtable_convert_scheduled_;
+
   // Information for a manual compaction
   struct ManualCompaction {
     ColumnFamilyData* cfd;
@@ -1043,6 +1081,19 @@ class DBImpl : public DB {
   // last time stats were dumped to LOG
   std::atomic<uint64_t> last_stats_dump_time_microsec_;
 
+  // Loads the blocks listed in the HOT_BLOCKS file after DB::Open(), then
+  // writes the file periodically.
+  port::Thread block_cache_warmup_thread_;
+  // Whether block_cache_warmup_thread_ is still loading blocks. Guarded by
+  // mutex_, and bg_cv_ is signalled when it is cleared.
+  bool block_cache_warmup_running_;
+  // Set once that warm-up has finished. The HOT_BLOCKS file is only written
+  // after it, so that a warm-up cut short does not make it list fewer
+  // blocks. Never set for DBs opened without it, such as read only ones.
+  std::atomic<bool> block_cache_warmed_up_;
+  // Held while writing the HOT_BLOCKS file.
+  port::Mutex hot_blocks_mutex_;
+
   // Each flush or compaction gets its own job id. this counter makes sure
   // they're unique
   std::atomic<int> next_job_id_;
@@ -1085,6 +1085,50 @@ void DBImpl::SchedulePendingPurge(std::string fname, FileType type,
   purge_queue_.push_back(std::move(file_info));
 }
 
+void DBImpl::ScheduleMemTableConversion(MemTable* mem) {
+  mutex_.AssertHeld();
+  if (mem->num_entries() == 0) {
+    return;
+  }
+  mem->Ref();
+  memtables_to_convert_.push_back(mem);
+  bg_memtable_convert_scheduled_++;
+  env_->Schedule(&DBImpl::BGWorkConvertMemTable, this, Env::Priority::HIGH,
+                 nullptr);
+}
+
+void DBImpl::BackgroundCallConvertMemTable() {
+  autovector<MemTable*> to_delete;
+  mutex_.Lock();
+  while (!memtables_to_convert_.empty()) {
+    MemTable* mem = memtables_to_convert_.front();
+    memtables_to_convert_.pop_front();
+    // A memtable that finished flushing is only kept alive by our reference.
+    if (!shutting_down_.load(std::memory_order_acquire) &&
+        !mem->flush_completed()) {
+      mutex_.Unlock();
+      mem->ConvertToSortedArray();
+      TEST_SYNC_POINT_CALLBACK(
+          "DBImpl::BackgroundCallConvertMemTable:Converted", mem);
+      mutex_.Lock();
+    }
+    if (mem->Unref() != nullptr) {
+      to_delete.push_back(mem);
+    }
+  }
+  mutex_.Unlock();
+  for (MemTable* mem : to_delete) {
+    delete mem;
+  }
+  mutex_.Lock();
+  bg_memtable_convert_scheduled_--;
+
+  bg_cv_.SignalAll();
+  // IMPORTANT: there should be no code after calling SignalAll. This call may
+  // signal the DB destructor that it's OK to proceed with destruction.
+  mutex_.Unlock();
+}
+
 void DBImpl::BGWorkFlush(void* db) {
   IOSTATS_SET_THREAD_POOL_ID(Env::Priority::HIGH);
   TEST_SYNC_POINT("DBImpl::BGWorkFlush");
@@ -1092,6 +1136,13 @@ void DBImpl::BGWorkFlush(void* db) {
   TEST_SYNC_POINT("DBImpl::BGWorkFlush:done");
 }
 
+void DBImpl::BGWorkConvertMemTable(void* db) {
+  IOSTATS_SET_THREAD_POOL_ID(Env::Priority::HIGH);
+  TEST_SYNC_POINT("DBImpl::BGWorkConvertMemTable:start");
+  reinterpret_cast<DBImpl*>(db)->BackgroundCallConvertMemTable();
+  TEST_SYNC_POINT("DBImpl::BGWorkConvertMemTable:end");
+}
+
 void DBImpl::BGWorkCompaction(void* arg) {
   CompactionArg ca = *(reinterpret_cast<CompactionArg*>(arg));
   delete reinterpret_cast<CompactionArg*>(arg);
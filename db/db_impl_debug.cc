@@ -118,6 +118,13 @@ Status DBImpl::TEST_WaitForCompact() {
   return bg_error_;
 }
 
+void DBImpl::TEST_WaitForMemTableConversion() {
+  InstrumentedMutexLock l(&mutex_);
+  while (bg_memtable_convert_scheduled_) {
+    bg_cv_.Wait();
+  }
+}
+
 void DBImpl::TEST_LockMutex() {
   mutex_.Lock();
 }
@@ -189,5 +196,12 @@ int DBImpl::TEST_BGCompactionsAllowed() const {
   return BGCompactionsAllowed();
 }
 
+void DBImpl::TEST_WaitForBlockCacheWarmUp() {
+  InstrumentedMutexLock l(&mutex_);
+  while (block_cache_warmup_running_) {
+    bg_cv_.Wait();
+  }
+}
+
 }  // namespace rocksdb
 #endif  // NDEBUG
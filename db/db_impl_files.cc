@@ -445,6 +445,7 @@ void DBImpl::PurgeObsoleteFiles(const JobContext& state, bool schedule_only) {
       case kMetaDatabase:
       case kOptionsFile:
       case kBlobFile:
+      case kHotBlocksFile:
         keep = true;
         break;
     }
@@ -64,6 +64,10 @@ DBOptions SanitizeOptions(const std::string& dbname, const DBOptions& src) {
   result.env->IncBackgroundThreadsIfNeeded(src.max_background_flushes,
                                            Env::Priority::HIGH);
 
+  if (result.block_cache_warmup_threads < 1) {
+    result.block_cache_warmup_threads = 1;
+  }
+
   if (result.rate_limiter.get() != nullptr) {
     if (result.bytes_per_sync == 0) {
       result.bytes_per_sync = 1024 * 1024;
@@ -1038,6 +1042,7 @@ Status DB::Open(const DBOptions& db_options, const std::string& dbname,
     *dbptr = impl;
     impl->opened_successfully_ = true;
     impl->MaybeScheduleFlushOrCompaction();
+    impl->StartBlockCacheWarmUp();
   }
   impl->mutex_.Unlock();
 
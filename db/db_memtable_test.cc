@@ -3,6 +3,8 @@
 //  COPYING file in the root directory) and Apache 2.0 License
 //  (found in the LICENSE.Apache file in the root directory).
 
+#include <atomic>
+#include <map>
 #include <memory>
 #include <string>
 
@@ -155,6 +157,66 @@ TEST_F(DBMemTableTest, InsertWithHint) {
   ASSERT_EQ("vvv", Get("whitelisted"));
 }
 
+TEST_F(DBMemTableTest, LearnedImmutableMemTable) {
+  Options options = CurrentOptions();
+  options.create_if_missing = true;
+  options.memtable_factory.reset(new SpecialSkipListFactory(1000));
+  // Keep the immutable memtables around instead of flushing them.
+  options.min_write_buffer_number_to_merge = 4;
+  options.max_write_buffer_number = 6;
+  options.learned_immutable_memtable = true;
+  Reopen(options);
+
+  std::atomic<int> converted(0);
+  rocksdb::SyncPoint::GetInstance()->SetCallBack(
+      "DBImpl::BackgroundCallConvertMemTable:Converted", [&](void* arg) {
+        ASSERT_TRUE(reinterpret_cast<MemTable*>(arg)->IsSortedArray());
+        converted++;
+      });
+  rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+
+  Random rnd(301);
+  std::map<std::string, std::string> expected;
+  for (int i = 0; i < 3500; i++) {
+    std::string key = Key(rnd.Uniform(2500));
+    std::string value = RandomString(&rnd, 10);
+    if (rnd.OneIn(10)) {
+      ASSERT_OK(Delete(key));
+      expected.erase(key);
+    } else {
+      ASSERT_OK(Put(key, value));
+      expected[key] = value;
+    }
+  }
+  dbfull()->TEST_WaitForMemTableConversion();
+  ASSERT_EQ(3, converted.load());
+  uint64_t num_imm = 0;
+  ASSERT_TRUE(dbfull()->GetIntProperty("rocksdb.num-immutable-mem-table",
+                                       &num_imm));
+  ASSERT_EQ(3U, num_imm);
+
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < 2500; i++) {
+      auto it = expected.find(Key(i));
+      ASSERT_EQ(it == expected.end() ? "NOT_FOUND" : it->second, Get(Key(i)));
+    }
+    std::unique_ptr<Iterator> iter(db_->NewIterator(ReadOptions()));
+    auto it = expected.begin();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), ++it) {
+      ASSERT_TRUE(it != expected.end());
+      ASSERT_EQ(it->first, iter->key().ToString());
+      ASSERT_EQ(it->second, iter->value().ToString());
+    }
+    ASSERT_TRUE(it == expected.end());
+    ASSERT_OK(iter->status());
+    iter.reset();
+    // The second pass reads what the converted memtables flushed.
+    ASSERT_OK(Flush());
+  }
+  rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+  rocksdb::SyncPoint::GetInstance()->ClearAllCallBacks();
+}
+
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
@@ -2100,6 +2100,227 @@ TEST_F(DBTest2, MemtableOnlyIterator) {
   ASSERT_EQ(1, count);
   delete it;
 }
+
+TEST_F(DBTest2, LevelHintCache) {
+  Options options = CurrentOptions();
+  options.level_hint_cache_size = 1 << 16;
+  options.disable_auto_compactions = true;
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  options.statistics = rocksdb::CreateDBStatistics();
+  DestroyAndReopen(options);
+
+  const int kNumKeys = 300;
+  std::map<std::string, std::string> expected;
+  auto put = [&](int i, const std::string& value) {
+    ASSERT_OK(Put(Key(i), value));
+    expected[Key(i)] = value;
+  };
+  // Every key starts in L3. Some are overwritten in L2, deleted or merged
+  // into in L1 and overwritten again in L0.
+  for (int i = 0; i < kNumKeys; i++) {
+    put(i, "v3_" + ToString(i));
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(3);
+  for (int i = 0; i < kNumKeys; i += 3) {
+    put(i, "v2_" + ToString(i));
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(2);
+  for (int i = 0; i < kNumKeys; i++) {
+    if (i % 5 == 0) {
+      ASSERT_OK(Delete(Key(i)));
+      expected.erase(Key(i));
+    }
+    if (i % 7 == 0) {
+      ASSERT_OK(Merge(Key(i), "m1"));
+      auto it = expected.find(Key(i));
+      expected[Key(i)] = it == expected.end() ? "m1" : it->second + ",m1";
+    }
+  }
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(1);
+  ASSERT_EQ("0,1,1,1", FilesPerLevel());
+
+  const Snapshot* snapshot = db_->GetSnapshot();
+  std::map<std::string, std::string> expected_at_snapshot = expected;
+  for (int i = 0; i < kNumKeys; i += 11) {
+    put(i, "v0_" + ToString(i));
+  }
+  ASSERT_OK(Flush());
+  // A range tombstone in its own L0 file. Lookups that probe it never
+  // learn a hint.
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), db_->DefaultColumnFamily(),
+                             Key(200), Key(220)));
+  for (int i = 200; i < 220; i++) {
+    expected.erase(Key(i));
+  }
+  ASSERT_OK(Flush());
+  ASSERT_EQ("2,1,1,1", FilesPerLevel());
+
+  auto check = [&]() {
+    for (int i = 0; i < kNumKeys; i++) {
+      auto it = expected.find(Key(i));
+      ASSERT_EQ(it == expected.end() ? "NOT_FOUND" : it->second, Get(Key(i)));
+      it = expected_at_snapshot.find(Key(i));
+      ASSERT_EQ(it == expected_at_snapshot.end() ? "NOT_FOUND" : it->second,
+                Get(Key(i), snapshot));
+    }
+  };
+  // The first pass learns where keys live, the second starts from there,
+  // except for keys in the deleted range and the odd slot collision.
+  check();
+  uint64_t hits = TestGetTickerCount(options, LEVEL_HINT_HIT);
+  check();
+  ASSERT_GE(TestGetTickerCount(options, LEVEL_HINT_HIT) - hits,
+            2U * (kNumKeys - 30));
+
+  // Hints are dropped with the Version they were learned in.
+  put(42, "new");
+  ASSERT_OK(Flush());
+  hits = TestGetTickerCount(options, LEVEL_HINT_HIT);
+  check();
+  ASSERT_LE(TestGetTickerCount(options, LEVEL_HINT_HIT) - hits,
+            uint64_t{kNumKeys});
+
+  // Lookups from several threads learn and use the hints of one Version
+  // at the same time.
+  put(43, "newer");
+  ASSERT_OK(Flush());
+  std::atomic<int> mismatches(0);
+  std::vector<port::Thread> readers;
+  for (int t = 0; t < 4; t++) {
+    readers.emplace_back([&, t]() {
+      for (int i = 0; i < 2 * kNumKeys; i++) {
+        const std::string key = Key((i + t * 37) % kNumKeys);
+        std::string value;
+        Status s = db_->Get(ReadOptions(), key, &value);
+        auto it = expected.find(key);
+        if (it == expected.end() ? !s.IsNotFound()
+                                 : !s.ok() || value != it->second) {
+          mismatches++;
+        }
+      }
+    });
+  }
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  ASSERT_EQ(0, mismatches.load());
+  db_->ReleaseSnapshot(snapshot);
+}
+
+TEST_F(DBTest2, LookupResultCache) {
+  Options options = CurrentOptions();
+  options.lookup_result_cache = NewLRUCache(1 << 20);
+  options.disable_auto_compactions = true;
+  options.merge_operator = MergeOperators::CreateStringAppendOperator();
+  options.statistics = rocksdb::CreateDBStatistics();
+  DestroyAndReopen(options);
+
+  auto hits = [&]() {
+    return TestGetTickerCount(options, LOOKUP_RESULT_CACHE_HIT);
+  };
+  auto misses = [&]() {
+    return TestGetTickerCount(options, LOOKUP_RESULT_CACHE_MISS);
+  };
+
+  ASSERT_OK(Put("a", "v1"));
+  ASSERT_OK(Merge("b", "m1"));
+  ASSERT_OK(Flush());
+  ASSERT_OK(Merge("b", "m2"));
+
+  // Values, merge results and missing keys are all cached.
+  ASSERT_EQ("v1", Get("a"));
+  ASSERT_EQ("m1,m2", Get("b"));
+  ASSERT_EQ("NOT_FOUND", Get("c"));
+  ASSERT_EQ(0U, hits());
+  ASSERT_EQ(3U, misses());
+  ASSERT_EQ("v1", Get("a"));
+  ASSERT_EQ("m1,m2", Get("b"));
+  ASSERT_EQ("NOT_FOUND", Get("c"));
+  ASSERT_EQ(3U, hits());
+  ASSERT_EQ(3U, misses());
+
+  // Reads at a snapshot neither use nor fill the cache.
+  const Snapshot* snapshot = db_->GetSnapshot();
+  ASSERT_EQ("v1", Get("a", snapshot));
+  ASSERT_EQ(3U, hits());
+  ASSERT_EQ(3U, misses());
+
+  // Every kind of write drops the result for its key.
+  ASSERT_OK(Put("a", "v2"));
+  ASSERT_OK(Merge("b", "m3"));
+  ASSERT_OK(Put("c", "v3"));
+  ASSERT_EQ("v2", Get("a"));
+  ASSERT_EQ("m1,m2,m3", Get("b"));
+  ASSERT_EQ("v3", Get("c"));
+  ASSERT_EQ(3U, hits());
+  ASSERT_OK(Delete("a"));
+  ASSERT_OK(SingleDelete("c"));
+  ASSERT_EQ("NOT_FOUND", Get("a"));
+  ASSERT_EQ("m1,m2,m3", Get("b"));
+  ASSERT_EQ("NOT_FOUND", Get("c"));
+  ASSERT_EQ(4U, hits());
+  ASSERT_EQ("v1", Get("a", snapshot));
+  db_->ReleaseSnapshot(snapshot);
+
+  // Flushes and compactions keep the results.
+  ASSERT_OK(Flush());
+  ASSERT_OK(db_->CompactRange(CompactRangeOptions(), nullptr, nullptr));
+  uint64_t prev_hits = hits();
+  ASSERT_EQ("NOT_FOUND", Get("a"));
+  ASSERT_EQ("m1,m2,m3", Get("b"));
+  ASSERT_EQ(prev_hits + 2, hits());
+
+  // Range deletions drop every result.
+  ASSERT_OK(db_->DeleteRange(WriteOptions(), db_->DefaultColumnFamily(), "b",
+                             "c"));
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+  ASSERT_EQ(prev_hits + 2, hits());
+  ASSERT_EQ("NOT_FOUND", Get("b"));
+  ASSERT_EQ(prev_hits + 3, hits());
+
+  // Column families with a compaction filter do not use the cache.
+  test::FilterNumber filter(0);
+  Options filter_options = options;
+  filter_options.compaction_filter = &filter;
+  CreateAndReopenWithCF({"filtered"}, filter_options);
+  ASSERT_OK(Put(1, "a", "v1"));
+  ASSERT_EQ("v1", Get(1, "a"));
+  ASSERT_EQ("v1", Get(1, "a"));
+  ASSERT_EQ(prev_hits + 3, hits());
+}
+
+#ifndef ROCKSDB_LITE
+TEST_F(DBTest2, LookupResultCacheExternalChanges) {
+  Options options = CurrentOptions();
+  options.lookup_result_cache = NewLRUCache(1 << 20);
+  options.disable_auto_compactions = true;
+  DestroyAndReopen(options);
+
+  ASSERT_OK(Put("k1", "v1"));
+  ASSERT_OK(Flush());
+  MoveFilesToLevel(1);
+  ASSERT_EQ("v1", Get("k1"));
+  ASSERT_EQ("NOT_FOUND", Get("k2"));
+
+  // Files deleted outside of compactions.
+  Slice begin("k0");
+  Slice end("k9");
+  ASSERT_OK(DeleteFilesInRange(db_, db_->DefaultColumnFamily(), &begin, &end));
+  ASSERT_EQ("NOT_FOUND", Get("k1"));
+
+  // Ingested files.
+  std::string file = dbname_ + "/ingested.sst";
+  SstFileWriter writer(EnvOptions(), options);
+  ASSERT_OK(writer.Open(file));
+  ASSERT_OK(writer.Add("k2", "v2"));
+  ASSERT_OK(writer.Finish());
+  ASSERT_OK(db_->IngestExternalFile({file}, IngestExternalFileOptions()));
+  ASSERT_EQ("v2", Get("k2"));
+}
+#endif  // ROCKSDB_LITE
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
@@ -311,6 +311,83 @@ TEST_F(ExternalSSTFileBasicTest, FadviseTrigger) {
   rocksdb::SyncPoint::GetInstance()->DisableProcessing();
 }
 
+TEST_F(ExternalSSTFileBasicTest, ParallelSstFileWriter) {
+  Options options = CurrentOptions();
+  const int kNumKeys = 20000;
+  ParallelSstFileWriterOptions parallel_options;
+  parallel_options.num_threads = 3;
+  parallel_options.file_size = 64 << 10;
+
+  std::vector<std::string> children;
+  {
+    // Keys out of order are rejected once files have been built from the
+    // keys before them, and nothing is left behind.
+    rocksdb::SyncPoint::GetInstance()->LoadDependency(
+        {{"ParallelSstFileWriter::BuildFile:Done",
+          "ExternalSSTFileBasicTest::ParallelSstFileWriter:BadKey"}});
+    rocksdb::SyncPoint::GetInstance()->EnableProcessing();
+    ParallelSstFileWriter writer(EnvOptions(), options, nullptr,
+                                 parallel_options);
+    ASSERT_OK(writer.Open(sst_files_dir_ + "bad_"));
+    int k = 0;
+    for (; k < kNumKeys / 4; k++) {
+      ASSERT_OK(writer.Add(Key(k), Key(k) + "_val"));
+    }
+    TEST_SYNC_POINT("ExternalSSTFileBasicTest::ParallelSstFileWriter:BadKey");
+    rocksdb::SyncPoint::GetInstance()->DisableProcessing();
+    ASSERT_OK(env_->GetChildren(sst_files_dir_, &children));
+    int num_built = 0;
+    for (const auto& child : children) {
+      if (child.compare(0, 4, "bad_") == 0) {
+        num_built++;
+      }
+    }
+    ASSERT_GT(num_built, 0);
+    ASSERT_TRUE(writer.Add(Key(k - 1), "val").IsInvalidArgument());
+    ASSERT_TRUE(writer.Add(Key(0), "val").IsInvalidArgument());
+  }
+  ASSERT_OK(env_->GetChildren(sst_files_dir_, &children));
+  for (const auto& child : children) {
+    ASSERT_TRUE(child == "." || child == "..") << child;
+  }
+
+  ParallelSstFileWriter writer(EnvOptions(), options, nullptr,
+                               parallel_options);
+  ASSERT_OK(writer.Open(sst_files_dir_ + "bulk_"));
+  for (int k = 0; k < kNumKeys; k++) {
+    ASSERT_OK(writer.Add(Key(k), Key(k) + "_val"));
+  }
+  std::vector<ExternalSstFileInfo> file_infos;
+  ASSERT_OK(writer.Finish(&file_infos));
+  ASSERT_TRUE(writer.Add(Key(kNumKeys), "bad_val").IsInvalidArgument());
+
+  // Files follow each other in key order and cover every key once.
+  ASSERT_GT(file_infos.size(), 5U);
+  std::vector<std::string> files;
+  uint64_t num_entries = 0;
+  for (size_t i = 0; i < file_infos.size(); i++) {
+    ASSERT_EQ(sst_files_dir_ + "bulk_" + (i < 9 ? "00000" : "0000") +
+                  ToString(i + 1) + ".sst",
+              file_infos[i].file_path);
+    if (i > 0) {
+      ASSERT_LT(file_infos[i - 1].largest_key, file_infos[i].smallest_key);
+    }
+    num_entries += file_infos[i].num_entries;
+    files.push_back(file_infos[i].file_path);
+  }
+  ASSERT_EQ(Key(0), file_infos.front().smallest_key);
+  ASSERT_EQ(Key(kNumKeys - 1), file_infos.back().largest_key);
+  ASSERT_EQ(static_cast<uint64_t>(kNumKeys), num_entries);
+
+  DestroyAndReopen(options);
+  ASSERT_OK(DeprecatedAddFile(files));
+  for (int k = 0; k < kNumKeys; k++) {
+    ASSERT_EQ(Key(k) + "_val", Get(Key(k)));
+  }
+
+  DestroyAndRecreateExternalSSTFilesDir();
+}
+
 #endif  // ROCKSDB_LITE
 
 }  // namespace rocksdb
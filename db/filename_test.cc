@@ -44,6 +44,8 @@ TEST_F(FileNameTest, Parse) {
         {"MANIFEST-7", 7, kDescriptorFile, kAllMode},
         {"METADB-2", 2, kMetaDatabase, kAllMode},
         {"METADB-7", 7, kMetaDatabase, kAllMode},
+        {"HOT_BLOCKS", 0, kHotBlocksFile, kAllMode},
+        {"HOT_BLOCKS.dbtmp", 0, kHotBlocksFile, kAllMode},
         {"LOG", 0, kInfoLogFile, kDefautInfoLogDir},
         {"LOG.old", 0, kInfoLogFile, kDefautInfoLogDir},
         {"LOG.old.6688", 6688, kInfoLogFile, kDefautInfoLogDir},
@@ -89,6 +91,8 @@ TEST_F(FileNameTest, Parse) {
     "METADB-",
     "XMETADB-3",
     "METADB-3x",
+    "HOT_BLOCK",
+    "HOT_BLOCKSx",
     "LOC",
     "LOCKx",
     "LO",
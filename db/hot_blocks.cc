@@ -0,0 +1,123 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/hot_blocks.h"
+
+#include <algorithm>
+
+#include "rocksdb/cache.h"
+#include "util/coding.h"
+#include "util/crc32c.h"
+
+namespace rocksdb {
+
+namespace {
+const uint32_t kHotBlocksFormatVersion = 1;
+}  // namespace
+
+void EncodeHotBlocks(const HotBlockMap& hot_blocks, std::string* dst) {
+  size_t start = dst->size();
+  PutVarint32(dst, kHotBlocksFormatVersion);
+  PutVarint64(dst, hot_blocks.size());
+  for (const auto& table : hot_blocks) {
+    PutVarint64(dst, table.first);
+    PutVarint64(dst, table.second.size());
+    uint64_t prev = 0;
+    for (uint64_t offset : table.second) {
+      assert(offset >= prev);
+      PutVarint64(dst, offset - prev);
+      prev = offset;
+    }
+  }
+  PutFixed32(dst, crc32c::Mask(crc32c::Value(dst->data() + start,
+                                             dst->size() - start)));
+}
+
+Status DecodeHotBlocks(const Slice& src, HotBlockMap* hot_blocks) {
+  if (src.size() < sizeof(uint32_t)) {
+    return Status::Corruption("hot blocks file too short");
+  }
+  Slice input(src.data(), src.size() - sizeof(uint32_t));
+  Slice checksum(input.data() + input.size(), sizeof(uint32_t));
+  uint32_t masked_crc;
+  GetFixed32(&checksum, &masked_crc);
+  if (crc32c::Unmask(masked_crc) !=
+      crc32c::Value(input.data(), input.size())) {
+    return Status::Corruption("hot blocks file checksum mismatch");
+  }
+
+  uint32_t version;
+  uint64_t num_tables;
+  if (!GetVarint32(&input, &version) || !GetVarint64(&input, &num_tables)) {
+    return Status::Corruption("bad hot blocks file header");
+  }
+  if (version != kHotBlocksFormatVersion) {
+    return Status::NotSupported("unknown hot blocks file format version");
+  }
+  for (uint64_t i = 0; i < num_tables; i++) {
+    uint64_t file_number;
+    uint64_t num_offsets;
+    if (!GetVarint64(&input, &file_number) ||
+        !GetVarint64(&input, &num_offsets) || num_offsets > input.size()) {
+      return Status::Corruption("bad hot blocks table entry");
+    }
+    auto& offsets = (*hot_blocks)[file_number];
+    offsets.reserve(offsets.size() + num_offsets);
+    uint64_t offset = 0;
+    for (uint64_t j = 0; j < num_offsets; j++) {
+      uint64_t delta;
+      if (!GetVarint64(&input, &delta)) {
+        return Status::Corruption("bad hot blocks offset");
+      }
+      offset += delta;
+      offsets.push_back(offset);
+    }
+  }
+  if (!input.empty()) {
+    return Status::Corruption("trailing bytes in hot blocks file");
+  }
+  return Status::OK();
+}
+
+void HotBlocksCollector::AddTable(Cache* block_cache, const Slice& key_prefix,
+                                  uint64_t file_number) {
+  CacheTables& tables = caches_[block_cache];
+  tables.file_numbers[key_prefix.ToString()] = file_number;
+  tables.prefix_sizes.insert(key_prefix.size());
+}
+
+void HotBlocksCollector::Collect(HotBlockMap* hot_blocks) const {
+  for (const auto& cache : caches_) {
+    const CacheTables& tables = cache.second;
+    std::string prefix;
+    // Called with the shard mutex held, so it only records the offset.
+    cache.first->ApplyToAllCacheEntriesWithKey(
+        [&](const Slice& key, void* /*value*/, size_t /*charge*/) {
+          for (size_t prefix_size : tables.prefix_sizes) {
+            if (key.size() <= prefix_size) {
+              break;
+            }
+            prefix.assign(key.data(), prefix_size);
+            auto table = tables.file_numbers.find(prefix);
+            if (table == tables.file_numbers.end()) {
+              continue;
+            }
+            Slice rest(key.data() + prefix_size, key.size() - prefix_size);
+            uint64_t offset;
+            if (GetVarint64(&rest, &offset) && rest.empty()) {
+              (*hot_blocks)[table->second].push_back(offset);
+              break;
+            }
+          }
+        });
+  }
+  for (auto& table : *hot_blocks) {
+    std::sort(table.second.begin(), table.second.end());
+    table.second.erase(std::unique(table.second.begin(), table.second.end()),
+                       table.second.end());
+  }
+}
+
+}  // namespace rocksdb
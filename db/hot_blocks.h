@@ -0,0 +1,60 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+class Cache;
+
+// The file offsets of the blocks of each table found in its block cache, in
+// ascending order, by table file number. The offsets include those of
+// blocks other than data blocks, such as filters.
+typedef std::map<uint64_t, std::vector<uint64_t>> HotBlockMap;
+
+// Encodes `hot_blocks` as the contents of a HOT_BLOCKS file: the offsets of
+// each table delta encoded, followed by a checksum of it all.
+void EncodeHotBlocks(const HotBlockMap& hot_blocks, std::string* dst);
+
+// Decodes the contents of a HOT_BLOCKS file into *hot_blocks. Returns
+// Corruption if they do not check out.
+Status DecodeHotBlocks(const Slice& src, HotBlockMap* hot_blocks);
+
+// Finds the blocks of a set of tables in their block caches. Block based
+// tables key their blocks in the cache with a per table prefix followed by
+// the varint64 offset of the block, so one pass over each cache finds the
+// blocks of all tables using it.
+class HotBlocksCollector {
+ public:
+  // Adds table `file_number`, whose blocks are cached in `block_cache` under
+  // keys starting with `key_prefix`.
+  void AddTable(Cache* block_cache, const Slice& key_prefix,
+                uint64_t file_number);
+
+  // Adds the offsets of the blocks of the added tables found in their
+  // caches to *hot_blocks. Tables with no block cached are left out.
+  void Collect(HotBlockMap* hot_blocks) const;
+
+ private:
+  struct CacheTables {
+    // File number of the table with each key prefix.
+    std::unordered_map<std::string, uint64_t> file_numbers;
+    std::set<size_t> prefix_sizes;
+  };
+
+  std::map<Cache*, CacheTables> caches_;
+};
+
+}  // namespace rocksdb
@@ -0,0 +1,79 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "rocksdb/slice.h"
+#include "util/hash.h"
+#include "util/mutexlock.h"
+
+namespace rocksdb {
+
+// LevelHintCache remembers, for user keys recently read from one Version,
+// the first file in probe order that holds any entry for the key: its level
+// and its index in that level. Every file probed before it is known to hold
+// neither a point entry nor a range tombstone for the key, so later point
+// lookups in the same Version can start at the hinted file and still return
+// exactly what the full L0 -> Ln probe would, for any snapshot.
+//
+// A Version never changes, so a hint stays correct for as long as the
+// Version lives. The cache is direct-mapped: a key hashes to one slot and
+// evicts whatever was there. Slots hold the full user key, so a lookup never
+// returns another key's hint.
+class LevelHintCache {
+ public:
+  // `capacity` is rounded up to a power of two.
+  explicit LevelHintCache(size_t capacity) {
+    size_t num_slots = 1;
+    while (num_slots < capacity) {
+      num_slots <<= 1;
+    }
+    mask_ = num_slots - 1;
+    slots_.reset(new Slot[num_slots]);
+  }
+
+  // Returns true and sets *level and *index if `user_key` has a hint.
+  bool Lookup(const Slice& user_key, int* level, uint32_t* index) {
+    Slot& slot = slots_[GetSliceHash(user_key) & mask_];
+    std::lock_guard<SpinMutex> lock(slot.mutex);
+    if (slot.level < 0 || Slice(slot.key) != user_key) {
+      return false;
+    }
+    *level = slot.level;
+    *index = slot.index;
+    return true;
+  }
+
+  // Records that the first entry for `user_key` lives in file `index` of
+  // `level`.
+  void Insert(const Slice& user_key, int level, uint32_t index) {
+    Slot& slot = slots_[GetSliceHash(user_key) & mask_];
+    std::lock_guard<SpinMutex> lock(slot.mutex);
+    slot.key.assign(user_key.data(), user_key.size());
+    slot.level = level;
+    slot.index = index;
+  }
+
+  size_t num_slots() const { return mask_ + 1; }
+
+ private:
+  struct Slot {
+    SpinMutex mutex;
+    std::string key;
+    // -1 while empty.
+    int level = -1;
+    uint32_t index = 0;
+  };
+
+  size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+};
+
+}  // namespace rocksdb
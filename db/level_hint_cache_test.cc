@@ -0,0 +1,88 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/level_hint_cache.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "port/stack_trace.h"
+#include "util/string_util.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class LevelHintCacheTest : public testing::Test {};
+
+TEST_F(LevelHintCacheTest, LookupAfterInsert) {
+  LevelHintCache cache(100);
+  ASSERT_EQ(128U, cache.num_slots());
+
+  int level = -1;
+  uint32_t index = 0;
+  ASSERT_FALSE(cache.Lookup("foo", &level, &index));
+  cache.Insert("foo", 3, 17);
+  ASSERT_TRUE(cache.Lookup("foo", &level, &index));
+  ASSERT_EQ(3, level);
+  ASSERT_EQ(17U, index);
+
+  // A newer hint for the same key replaces the old one.
+  cache.Insert("foo", 0, 2);
+  ASSERT_TRUE(cache.Lookup("foo", &level, &index));
+  ASSERT_EQ(0, level);
+  ASSERT_EQ(2U, index);
+}
+
+TEST_F(LevelHintCacheTest, NeverReturnsAnotherKeysHint) {
+  // With a single slot every key collides.
+  LevelHintCache cache(1);
+  ASSERT_EQ(1U, cache.num_slots());
+  cache.Insert("a", 1, 1);
+  int level = -1;
+  uint32_t index = 0;
+  ASSERT_FALSE(cache.Lookup("b", &level, &index));
+  ASSERT_FALSE(cache.Lookup("aa", &level, &index));
+  ASSERT_FALSE(cache.Lookup("", &level, &index));
+  cache.Insert("b", 2, 5);
+  ASSERT_FALSE(cache.Lookup("a", &level, &index));
+  ASSERT_TRUE(cache.Lookup("b", &level, &index));
+  ASSERT_EQ(2, level);
+  ASSERT_EQ(5U, index);
+}
+
+TEST_F(LevelHintCacheTest, ConcurrentReadersAndWriters) {
+  LevelHintCache cache(64);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&cache, t]() {
+      for (int i = 0; i < 10000; i++) {
+        std::string key = "key" + ToString(i % 500);
+        // Every writer records the same hint for a key, derived from it.
+        int expected = (i % 500) % 7;
+        if ((i + t) % 2 == 0) {
+          cache.Insert(key, expected, static_cast<uint32_t>(i % 500));
+        }
+        int level = -1;
+        uint32_t index = 0;
+        if (cache.Lookup(key, &level, &index)) {
+          ASSERT_EQ(expected, level);
+          ASSERT_EQ(static_cast<uint32_t>(i % 500), index);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  rocksdb::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,97 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+
+namespace rocksdb {
+
+// LinearSegmentTracker follows a stream of (key, entry size) pairs in key
+// order and tells whether all of them, placed at their cumulative byte
+// offsets, still lie within `max_error` bytes of a single straight line.
+// It keeps the cone of feasible slopes through the first point and shrinks
+// it with every point, so each check is O(1).
+//
+// Compaction uses it to end an output file where the key distribution bends,
+// which keeps the learned model of every output file close to linear.
+class LinearSegmentTracker {
+ public:
+  explicit LinearSegmentTracker(uint64_t max_error = 0)
+      : max_error_(max_error) {
+    Reset();
+  }
+
+  // Start a new, empty segment.
+  void Reset() {
+    num_points_ = 0;
+    first_key_ = 0;
+    first_offset_ = 0;
+    bytes_ = 0;
+    slope_low_ = 0;
+    slope_high_ = std::numeric_limits<double>::max();
+  }
+
+  // Returns true if the entry of `entry_size` bytes with `key` can be
+  // appended without pushing any point more than max_error bytes off the
+  // line. Always true for an empty segment.
+  bool Fits(uint64_t key, uint64_t entry_size) const {
+    if (num_points_ == 0) {
+      return true;
+    }
+    double low, high;
+    return Narrow(key, bytes_ + entry_size, &low, &high);
+  }
+
+  // Append an entry. Entries that do not fit are still accepted; the segment
+  // then stops narrowing until the next Reset().
+  void Add(uint64_t key, uint64_t entry_size) {
+    bytes_ += entry_size;
+    if (num_points_++ == 0) {
+      first_key_ = key;
+      first_offset_ = bytes_;
+      return;
+    }
+    double low, high;
+    if (Narrow(key, bytes_, &low, &high)) {
+      slope_low_ = low;
+      slope_high_ = high;
+    }
+  }
+
+  uint64_t num_points() const { return num_points_; }
+  uint64_t bytes() const { return bytes_; }
+  uint64_t max_error() const { return max_error_; }
+
+ private:
+  bool Narrow(uint64_t key, uint64_t offset, double* low,
+              double* high) const {
+    double error = static_cast<double>(max_error_);
+    double off = static_cast<double>(offset - first_offset_);
+    if (key <= first_key_) {
+      // Same (or reordered) 8-byte key prefix: any line through the first
+      // point predicts the first point's offset.
+      *low = slope_low_;
+      *high = slope_high_;
+      return off <= error;
+    }
+    double dx = static_cast<double>(key - first_key_);
+    *low = std::max(slope_low_, (off - error) / dx);
+    *high = std::min(slope_high_, (off + error) / dx);
+    return *low <= *high;
+  }
+
+  uint64_t max_error_;
+  uint64_t num_points_;
+  uint64_t first_key_;
+  uint64_t first_offset_;
+  uint64_t bytes_;
+  double slope_low_;
+  double slope_high_;
+};
+
+}  // namespace rocksdb
@@ -0,0 +1,75 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/linear_segment_tracker.h"
+#include "port/stack_trace.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class LinearSegmentTrackerTest : public testing::Test {};
+
+TEST_F(LinearSegmentTrackerTest, EmptySegmentAcceptsAnything) {
+  LinearSegmentTracker tracker(0);
+  ASSERT_TRUE(tracker.Fits(12345, 100));
+  tracker.Add(12345, 100);
+  ASSERT_EQ(1U, tracker.num_points());
+  ASSERT_EQ(100U, tracker.bytes());
+}
+
+TEST_F(LinearSegmentTrackerTest, EvenlySpacedKeysStayLinear) {
+  LinearSegmentTracker tracker(16);
+  for (uint64_t i = 0; i < 10000; i++) {
+    ASSERT_TRUE(tracker.Fits(1000 + i * 7, 100));
+    tracker.Add(1000 + i * 7, 100);
+  }
+  ASSERT_EQ(10000U, tracker.num_points());
+  ASSERT_EQ(1000000U, tracker.bytes());
+}
+
+TEST_F(LinearSegmentTrackerTest, DetectsDensityChange) {
+  const uint64_t kError = 4096;
+  LinearSegmentTracker tracker(kError);
+  uint64_t key = 0;
+  for (int i = 0; i < 1000; i++) {
+    key += 10;
+    ASSERT_TRUE(tracker.Fits(key, 100));
+    tracker.Add(key, 100);
+  }
+  // Keys become 1000x sparser: the bytes/key slope collapses and soon no
+  // line through the first point covers both parts.
+  bool split = false;
+  for (int i = 0; i < 1000 && !split; i++) {
+    key += 10000;
+    split = !tracker.Fits(key, 100);
+    if (!split) {
+      tracker.Add(key, 100);
+    }
+  }
+  ASSERT_TRUE(split);
+
+  tracker.Reset();
+  ASSERT_EQ(0U, tracker.num_points());
+  ASSERT_TRUE(tracker.Fits(key, 100));
+}
+
+TEST_F(LinearSegmentTrackerTest, RepeatedKeysBoundedByError) {
+  LinearSegmentTracker tracker(250);
+  tracker.Add(42, 100);
+  ASSERT_TRUE(tracker.Fits(42, 100));
+  tracker.Add(42, 100);
+  ASSERT_TRUE(tracker.Fits(42, 100));
+  tracker.Add(42, 100);
+  // Third repeat would sit 300 bytes past the first point.
+  ASSERT_FALSE(tracker.Fits(42, 100));
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  rocksdb::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,110 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "db/lookup_result_cache.h"
+
+#include <algorithm>
+
+#include "util/coding.h"
+#include "util/hash.h"
+
+namespace rocksdb {
+
+LookupResultCache::LookupResultCache(const std::shared_ptr<Cache>& cache)
+    : cache_(cache),
+      epoch_(0),
+      last_range_deletion_(0),
+      last_write_(new std::atomic<SequenceNumber>[kNumWriteSlots]) {
+  assert(cache_ != nullptr);
+  PutVarint64(&cache_id_, cache_->NewId());
+  for (size_t i = 0; i < kNumWriteSlots; i++) {
+    last_write_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void LookupResultCache::DeleteEntry(const Slice& /*key*/, void* value) {
+  delete static_cast<Entry*>(value);
+}
+
+void LookupResultCache::ReleaseHandle(void* cache, void* handle) {
+  static_cast<Cache*>(cache)->Release(static_cast<Cache::Handle*>(handle));
+}
+
+size_t LookupResultCache::GetSlot(const Slice& user_key) {
+  return GetSliceHash(user_key) & (kNumWriteSlots - 1);
+}
+
+bool LookupResultCache::IsValid(const Slice& user_key, const Entry& entry,
+                                SequenceNumber snapshot,
+                                uint64_t epoch) const {
+  if (entry.epoch != epoch) {
+    return false;
+  }
+  SequenceNumber bound = std::min(snapshot, entry.sequence);
+  return last_write_[GetSlot(user_key)].load(std::memory_order_relaxed) <=
+             bound &&
+         last_range_deletion_.load(std::memory_order_relaxed) <= bound;
+}
+
+void LookupResultCache::BuildKey(const Slice& user_key,
+                                 std::string* key) const {
+  key->reserve(cache_id_.size() + user_key.size());
+  key->assign(cache_id_);
+  key->append(user_key.data(), user_key.size());
+}
+
+bool LookupResultCache::Lookup(const Slice& user_key, SequenceNumber snapshot,
+                               uint64_t epoch, PinnableSlice* value,
+                               Status* status) {
+  std::string key;
+  BuildKey(user_key, &key);
+  Cache::Handle* handle = cache_->Lookup(key);
+  if (handle == nullptr) {
+    return false;
+  }
+  const Entry* entry = static_cast<const Entry*>(cache_->Value(handle));
+  if (!IsValid(user_key, *entry, snapshot, epoch)) {
+    bool stale = !IsValid(user_key, *entry, kMaxSequenceNumber, this->epoch());
+    cache_->Release(handle);
+    if (stale) {
+      // No reader can use it any more.
+      cache_->Erase(key);
+    }
+    return false;
+  }
+  if (entry->found) {
+    *status = Status::OK();
+    value->PinSlice(entry->value, &ReleaseHandle, cache_.get(), handle);
+  } else {
+    *status = Status::NotFound();
+    cache_->Release(handle);
+  }
+  return true;
+}
+
+void LookupResultCache::Insert(const Slice& user_key, SequenceNumber snapshot,
+                               uint64_t epoch, const Status& status,
+                               const Slice& value) {
+  assert(status.ok() || status.IsNotFound());
+  if (epoch != this->epoch() ||
+      last_write_[GetSlot(user_key)].load(std::memory_order_relaxed) >
+          snapshot) {
+    // Already stale.
+    return;
+  }
+  Entry* entry = new Entry();
+  entry->sequence = snapshot;
+  entry->epoch = epoch;
+  entry->found = status.ok();
+  if (entry->found) {
+    entry->value.assign(value.data(), value.size());
+  }
+  std::string key;
+  BuildKey(user_key, &key);
+  size_t charge = key.size() + sizeof(Entry) + entry->value.size();
+  cache_->Insert(key, entry, charge, &DeleteEntry);
+}
+
+}  // namespace rocksdb
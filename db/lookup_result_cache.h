@@ -0,0 +1,111 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "db/dbformat.h"
+#include "rocksdb/cache.h"
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+// LookupResultCache holds the final results of point lookups in one column
+// family: the value of a key, or the fact that it does not exist. It is a
+// view over DBOptions::lookup_result_cache, which column families share;
+// each one prefixes its keys with its own cache id.
+//
+// A result read at sequence S stays correct until a later write touches the
+// key. Writers record the sequence of every key they write in a small table
+// of slots indexed by the hash of the key, before the sequence is
+// published. A result is served to a reader at sequence R only if the
+// key's slot has seen no write past min(S, R); a hash collision only makes
+// results expire early. Range deletions are tracked by one sequence for
+// the whole column family, and changes that bypass the memtable, such as
+// file ingestion, bump an epoch that every entry must match.
+//
+// Thread safe.
+class LookupResultCache {
+ public:
+  explicit LookupResultCache(const std::shared_ptr<Cache>& cache);
+
+  // Records that a write at `seq` touched `user_key`. Must be called before
+  // `seq` becomes visible to readers.
+  void RecordWrite(const Slice& user_key, SequenceNumber seq) {
+    UpdateMax(&last_write_[GetSlot(user_key)], seq);
+  }
+
+  // Records a range deletion at `seq`. Same requirement as RecordWrite().
+  void RecordRangeDeletion(SequenceNumber seq) {
+    UpdateMax(&last_range_deletion_, seq);
+  }
+
+  // Drops every result, for changes that are not writes through the
+  // memtable. Call after the change is visible to new reads.
+  void InvalidateAll() { epoch_.fetch_add(1, std::memory_order_acq_rel); }
+
+  // Readers load the epoch before they pick the data to read, and pass it
+  // to Lookup() and Insert().
+  uint64_t epoch() const { return epoch_.load(std::memory_order_acquire); }
+
+  // Returns true if the result for `user_key` at `snapshot` is cached. Sets
+  // *status to OK and pins the value in *value if the key exists, or sets
+  // *status to NotFound if it does not.
+  bool Lookup(const Slice& user_key, SequenceNumber snapshot, uint64_t epoch,
+              PinnableSlice* value, Status* status);
+
+  // Caches the result of a lookup of `user_key` at `snapshot`. `status` must
+  // be OK, with the value in `value`, or NotFound.
+  void Insert(const Slice& user_key, SequenceNumber snapshot, uint64_t epoch,
+              const Status& status, const Slice& value);
+
+ private:
+  static const size_t kNumWriteSlots = 1 << 14;
+
+  struct Entry {
+    SequenceNumber sequence;
+    uint64_t epoch;
+    bool found;
+    std::string value;
+  };
+
+  static void DeleteEntry(const Slice& key, void* value);
+  static void ReleaseHandle(void* cache, void* handle);
+
+  static size_t GetSlot(const Slice& user_key);
+
+  // Publishing the sequence with release order makes these relaxed updates
+  // visible to readers that load it.
+  static void UpdateMax(std::atomic<SequenceNumber>* target,
+                        SequenceNumber seq) {
+    SequenceNumber cur = target->load(std::memory_order_relaxed);
+    while (cur < seq && !target->compare_exchange_weak(
+                            cur, seq, std::memory_order_relaxed)) {
+    }
+  }
+
+  // Whether no write the entry missed reached `user_key` by `snapshot`.
+  bool IsValid(const Slice& user_key, const Entry& entry,
+               SequenceNumber snapshot, uint64_t epoch) const;
+
+  void BuildKey(const Slice& user_key, std::string* key) const;
+
+  std::shared_ptr<Cache> cache_;
+  std::string cache_id_;
+  std::atomic<uint64_t> epoch_;
+  std::atomic<SequenceNumber> last_range_deletion_;
+  std::unique_ptr<std::atomic<SequenceNumber>[]> last_write_;
+
+  // No copying allowed
+  LookupResultCache(const LookupResultCache&);
+  void operator=(const LookupResultCache&);
+};
+
+}  // namespace rocksdb
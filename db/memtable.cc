@@ -17,6 +17,7 @@
 #include "db/merge_context.h"
 #include "db/merge_helper.h"
 #include "db/pinned_iterators_manager.h"
+#include "memtable/learned_sorted_array_rep.h"
 #include "monitoring/perf_context_imp.h"
 #include "monitoring/statistics.h"
 #include "port/port.h"
@@ -75,6 +76,7 @@ MemTable::MemTable(const InternalKeyComparator& cmp,
       range_del_table_(SkipListFactory().CreateMemTableRep(
           comparator_, &allocator_, nullptr /* transform */,
           ioptions.info_log)),
+      sorted_table_(nullptr),
       is_range_del_table_empty_(true),
       data_size_(0),
       num_entries_(0),
@@ -107,7 +109,10 @@ MemTable::MemTable(const InternalKeyComparator& cmp,
   }
 }
 
-MemTable::~MemTable() { assert(refs_ == 0); }
+MemTable::~MemTable() {
+  assert(refs_ == 0);
+  delete sorted_table_.load(std::memory_order_relaxed);
+}
 
 size_t MemTable::ApproximateMemoryUsage() {
   autovector<size_t> usages = {arena_.ApproximateMemoryUsage(),
@@ -247,9 +252,9 @@ class MemTableIterator : public InternalIterator {
       iter_ = mem.range_del_table_->GetIterator(arena);
     } else if (prefix_extractor_ != nullptr && !read_options.total_order_seek) {
       bloom_ = mem.prefix_bloom_.get();
-      iter_ = mem.table_->GetDynamicPrefixIterator(arena);
+      iter_ = mem.ReadTable()->GetDynamicPrefixIterator(arena);
     } else {
-      iter_ = mem.table_->GetIterator(arena);
+      iter_ = mem.ReadTable()->GetIterator(arena);
     }
   }
 
@@ -386,6 +391,21 @@ InternalIterator* MemTable::NewRangeTombstoneIterator(
                               true /* use_range_del_table */);
 }
 
+void MemTable::ConvertToSortedArray() {
+  if (IsSortedArray()) {
+    return;
+  }
+  MemTableRep* sorted =
+      NewLearnedSortedArrayRep(comparator_,
+                               comparator_.comparator.user_comparator(),
+                               &allocator_, table_.get());
+  MemTableRep* expected = nullptr;
+  if (!sorted_table_.compare_exchange_strong(expected, sorted,
+                                             std::memory_order_acq_rel)) {
+    delete sorted;
+  }
+}
+
 port::RWMutex* MemTable::GetLock(const Slice& key) {
   static murmur_hash hash;
   return &locks_[hash(key) % locks_.size()];
@@ -393,7 +413,8 @@ port::RWMutex* MemTable::GetLock(const Slice& key) {
 
 MemTable::MemTableStats MemTable::ApproximateStats(const Slice& start_ikey,
                                                    const Slice& end_ikey) {
-  uint64_t entry_count = table_->ApproximateNumEntries(start_ikey, end_ikey);
+  uint64_t entry_count =
+      ReadTable()->ApproximateNumEntries(start_ikey, end_ikey);
   entry_count += range_del_table_->ApproximateNumEntries(start_ikey, end_ikey);
   if (entry_count == 0) {
     return {0, 0};
@@ -675,7 +696,7 @@ bool MemTable::Get(const LookupKey& key, std::string* value, Status* s,
     saver.inplace_update_support = moptions_.inplace_update_support;
     saver.statistics = moptions_.statistics;
     saver.env_ = env_;
-    table_->Get(key, &saver, SaveValue);
+    ReadTable()->Get(key, &saver, SaveValue);
 
     *seq = saver.seq;
   }
@@ -258,6 +258,11 @@ class MemTable {
     return num_deletes_.load(std::memory_order_relaxed);
   }
 
+  // Returns true once the memtable has been written to storage.
+  // REQUIRES: external synchronization to prevent simultaneous
+  // operations on the same MemTable.
+  bool flush_completed() const { return flush_completed_; }
+
   // Returns the edits area that is needed for flushing the memtable
   VersionEdit* GetEdits() { return &edit_; }
 
@@ -320,6 +325,20 @@ class MemTable {
     allocator_.DoneAllocating();
   }
 
+  // Rebuilds the entries of this memtable into a learned sorted array (see
+  // memtable/learned_sorted_array_rep.h) and switches Get() and new
+  // iterators over to it. Existing iterators keep using the original rep,
+  // which stays alive with the memtable. Safe to run concurrently with
+  // readers; does nothing if the memtable was already converted.
+  // REQUIRES: MarkImmutable() was called and no writer can still add to this
+  // memtable.
+  void ConvertToSortedArray();
+
+  // Returns true once ConvertToSortedArray() has completed.
+  bool IsSortedArray() const {
+    return sorted_table_.load(std::memory_order_acquire) != nullptr;
+  }
+
   // return true if the current MemTableRep supports merge operator.
   bool IsMergeOperatorSupported() const {
     return table_->IsMergeOperatorSupported();
@@ -363,6 +382,9 @@ class MemTable {
   MemTableAllocator allocator_;
   unique_ptr<MemTableRep> table_;
   unique_ptr<MemTableRep> range_del_table_;
+  // Set by ConvertToSortedArray() and owned by this memtable. Takes over
+  // from table_ for readers.
+  std::atomic<MemTableRep*> sorted_table_;
   bool is_range_del_table_empty_;
 
   // Total data size of all data inserted
@@ -411,6 +433,12 @@ class MemTable {
   // Insert hints for each prefix.
   std::unordered_map<Slice, void*, SliceHasher> insert_hints_;
 
+  // Returns the rep that reads should use.
+  MemTableRep* ReadTable() const {
+    MemTableRep* sorted = sorted_table_.load(std::memory_order_acquire);
+    return sorted != nullptr ? sorted : table_.get();
+  }
+
   // Returns a heuristic flush decision
   bool ShouldFlushNow() const;
 
@@ -416,6 +416,83 @@ size_t TableCache::GetMemoryUsageByTableReader(
   return ret;
 }
 
+Cache* TableCache::GetBlockCacheKeyPrefix(
+    const EnvOptions& env_options,
+    const InternalKeyComparator& internal_comparator, const FileDescriptor& fd,
+    std::string* key_prefix) {
+  Cache::Handle* table_handle = nullptr;
+  auto table_reader = fd.table_reader;
+  if (table_reader == nullptr) {
+    Status s = FindTable(env_options, internal_comparator, fd, &table_handle,
+                         true /* no_io */);
+    if (!s.ok()) {
+      return nullptr;
+    }
+    table_reader = GetTableReaderFromHandle(table_handle);
+  }
+  Slice prefix;
+  Cache* block_cache = table_reader->GetBlockCacheKeyPrefix(&prefix);
+  if (block_cache != nullptr) {
+    key_prefix->assign(prefix.data(), prefix.size());
+  }
+  if (table_handle != nullptr) {
+    ReleaseHandle(table_handle);
+  }
+  return block_cache;
+}
+
+Status TableCache::WarmUpBlockCache(
+    const EnvOptions& env_options,
+    const InternalKeyComparator& internal_comparator, const FileDescriptor& fd,
+    int level, const std::vector<uint64_t>* data_block_offsets,
+    RateLimiter* rate_limiter, const std::atomic<bool>* stop) {
+  Cache::Handle* table_handle = nullptr;
+  auto table_reader = fd.table_reader;
+  if (table_reader == nullptr) {
+    Status s = FindTable(env_options, internal_comparator, fd, &table_handle,
+                         false /* no_io */, true /* record_read_stats */,
+                         nullptr /* file_read_hist */, false /* skip_filters */,
+                         level);
+    if (!s.ok()) {
+      return s;
+    }
+    table_reader = GetTableReaderFromHandle(table_handle);
+  }
+  Status s;
+  if (data_block_offsets == nullptr) {
+    s = table_reader->WarmUpMetaBlocks();
+  } else {
+    s = table_reader->WarmUpDataBlocks(*data_block_offsets, rate_limiter,
+                                       stop);
+  }
+  if (table_handle != nullptr) {
+    ReleaseHandle(table_handle);
+  }
+  return s;
+}
+
+uint64_t TableCache::ApproximateOffsetOf(
+    const EnvOptions& env_options,
+    const InternalKeyComparator& internal_comparator, const FileDescriptor& fd,
+    const Slice& key) {
+  auto table_reader = fd.table_reader;
+  // table already been pre-loaded?
+  if (table_reader) {
+    return table_reader->ApproximateOffsetOf(key);
+  }
+
+  Cache::Handle* table_handle = nullptr;
+  Status s = FindTable(env_options, internal_comparator, fd, &table_handle);
+  if (!s.ok()) {
+    return 0;
+  }
+  assert(table_handle);
+  auto table = GetTableReaderFromHandle(table_handle);
+  auto ret = table->ApproximateOffsetOf(key);
+  ReleaseHandle(table_handle);
+  return ret;
+}
+
 void TableCache::Evict(Cache* cache, uint64_t file_number) {
   cache->Erase(GetSliceForFileNumber(&file_number));
 }
@@ -10,6 +10,7 @@
 // Thread-safe (provides internal synchronization)
 
 #pragma once
+#include <atomic>
 #include <string>
 #include <vector>
 #include <stdint.h>
@@ -112,6 +113,33 @@ class TableCache {
       const InternalKeyComparator& internal_comparator,
       const FileDescriptor& fd);
 
+  // Return the approximate offset of `key` in the file, opening the table
+  // reader if needed but without creating an iterator over the table.
+  // 0 if the table cannot be opened.
+  uint64_t ApproximateOffsetOf(const EnvOptions& toptions,
+                               const InternalKeyComparator& internal_comparator,
+                               const FileDescriptor& fd, const Slice& key);
+
+  // Return the block cache of the table of the file and set *key_prefix to
+  // the prefix of its blocks' keys there, as
+  // TableReader::GetBlockCacheKeyPrefix(). nullptr if the table reader of the
+  // file is not loaded.
+  Cache* GetBlockCacheKeyPrefix(
+      const EnvOptions& toptions,
+      const InternalKeyComparator& internal_comparator,
+      const FileDescriptor& fd, std::string* key_prefix);
+
+  // Load the meta blocks of the file into its block cache, or with
+  // `data_block_offsets` set the data blocks at those offsets. Opens the
+  // table reader if needed. See TableReader::WarmUpMetaBlocks() and
+  // TableReader::WarmUpDataBlocks().
+  Status WarmUpBlockCache(const EnvOptions& toptions,
+                          const InternalKeyComparator& internal_comparator,
+                          const FileDescriptor& fd, int level,
+                          const std::vector<uint64_t>* data_block_offsets,
+                          RateLimiter* rate_limiter,
+                          const std::atomic<bool>* stop);
+
   // Release the handle from a cache
   void ReleaseHandle(Cache::Handle* handle);
 
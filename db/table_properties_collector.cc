@@ -6,6 +6,7 @@
 #include "db/table_properties_collector.h"
 
 #include "db/dbformat.h"
+#include "rocksdb/table.h"
 #include "util/coding.h"
 #include "util/string_util.h"
 
@@ -131,4 +132,38 @@ uint64_t GetMergeOperands(const UserCollectedProperties& props,
       props, InternalKeyTablePropertiesNames::kMergeOperands, property_present);
 }
 
+uint64_t GetModelMispredictedKeys(const UserCollectedProperties& props,
+                                  bool* property_present) {
+  return GetUint64Property(props,
+                           BlockBasedTablePropertyNames::kModelMispredictedKeys,
+                           property_present);
+}
+
+uint64_t GetModelMaxBlockError(const UserCollectedProperties& props,
+                               bool* property_present) {
+  return GetUint64Property(props,
+                           BlockBasedTablePropertyNames::kModelMaxBlockError,
+                           property_present);
+}
+
+uint64_t GetModelSize(const UserCollectedProperties& props,
+                      bool* property_present) {
+  return GetUint64Property(props, BlockBasedTablePropertyNames::kModelSize,
+                           property_present);
+}
+
+uint64_t GetModelTrainMicros(const UserCollectedProperties& props,
+                             bool* property_present) {
+  return GetUint64Property(props,
+                           BlockBasedTablePropertyNames::kModelTrainMicros,
+                           property_present);
+}
+
+uint64_t GetModelMaxOffsetError(const UserCollectedProperties& props,
+                                bool* property_present) {
+  return GetUint64Property(props,
+                           BlockBasedTablePropertyNames::kModelMaxOffsetError,
+                           property_present);
+}
+
 }  // namespace rocksdb
@@ -85,6 +85,8 @@ struct FileMetaData {
   uint64_t num_deletions;          // the number of deletion entries.
   uint64_t raw_key_size;           // total uncompressed key size.
   uint64_t raw_value_size;         // total uncompressed value size.
+  uint64_t num_model_mispredictions;  // entries the learned model does not
+                                      // map to their own data block.
   bool init_stats_from_file;   // true if the data-entry stats of this file
                                // has initialized from file.
 
@@ -102,6 +104,7 @@ struct FileMetaData {
         num_deletions(0),
         raw_key_size(0),
         raw_value_size(0),
+        num_model_mispredictions(0),
         init_stats_from_file(false),
         marked_for_compaction(false) {}
 
@@ -90,13 +90,15 @@ class FilePicker {
              const Slice& ikey, autovector<LevelFilesBrief>* file_levels,
              unsigned int num_levels, FileIndexer* file_indexer,
              const Comparator* user_comparator,
-             const InternalKeyComparator* internal_comparator)
+             const InternalKeyComparator* internal_comparator,
+             unsigned int start_level = 0, uint32_t start_index = 0)
       : num_levels_(num_levels),
-        curr_level_(static_cast<unsigned int>(-1)),
+        curr_level_(start_level - 1),
         returned_file_level_(static_cast<unsigned int>(-1)),
         hit_file_level_(static_cast<unsigned int>(-1)),
         search_left_bound_(0),
         search_right_bound_(FileIndexer::kLevelMaxIndex),
+        level0_start_index_(0),
 #ifndef NDEBUG
         files_(files),
 #endif
@@ -107,11 +109,20 @@ class FilePicker {
         file_indexer_(file_indexer),
         user_comparator_(user_comparator),
         internal_comparator_(internal_comparator) {
+    // A search may start at a file known to hold the first entry for the
+    // key; files before it are skipped.
+    if (start_level == 0) {
+      level0_start_index_ = start_index;
+    } else {
+      search_left_bound_ = static_cast<int32_t>(start_index);
+      search_right_bound_ = static_cast<int32_t>(start_index);
+    }
     // Setup member variables to search first level.
     search_ended_ = !PrepareNextLevel();
-    if (!search_ended_) {
+    if (!search_ended_ && curr_level_ == 0) {
       // Prefetch Level 0 table data to avoid cache miss if possible.
-      for (unsigned int i = 0; i < (*level_files_brief_)[0].num_files; ++i) {
+      for (unsigned int i = level0_start_index_;
+           i < (*level_files_brief_)[0].num_files; ++i) {
         auto* r = (*level_files_brief_)[0].files[i].fd.table_reader;
         if (r) {
           r->Prepare(ikey);
@@ -225,6 +236,7 @@ class FilePicker {
   unsigned int hit_file_level_;
   int32_t search_left_bound_;
   int32_t search_right_bound_;
+  uint32_t level0_start_index_;
 #ifndef NDEBUG
   std::vector<FileMetaData*>* files_;
 #endif
@@ -272,7 +284,7 @@ class FilePicker {
       int32_t start_index;
       if (curr_level_ == 0) {
         // On Level-0, we read through all files to check for overlap.
-        start_index = 0;
+        start_index = static_cast<int32_t>(level0_start_index_);
       } else {
         // On Level-n (n>=1), files are sorted. Binary search to find the
         // earliest file whose largest key >= ikey. Search left bound and
@@ -880,6 +892,7 @@ VersionStorageInfo::VersionStorageInfo(
       files_by_compaction_pri_(num_levels_),
       level0_non_overlapping_(false),
       next_file_to_compact_by_size_(num_levels_),
+      model_error_compaction_trigger_(0),
       compaction_score_(num_levels_),
       compaction_level_(num_levels_),
       l0_delay_trigger_count_(0),
@@ -960,10 +973,29 @@ void Version::Get(const ReadOptions& read_options, const LookupKey& k,
     pinned_iters_mgr.StartPinning();
   }
 
+  int hint_level = 0;
+  uint32_t hint_index = 0;
+  // A hint is only learned from a lookup that sees every entry of this
+  // Version and every range tombstone of the files it probes, and that
+  // starts from scratch, so the first file that changes its state is the
+  // first one holding anything for the key.
+  bool learn_hint = false;
+  if (level_hints_ != nullptr) {
+    if (level_hints_->Lookup(user_key, &hint_level, &hint_index)) {
+      RecordTick(db_statistics_, LEVEL_HINT_HIT);
+    } else {
+      RecordTick(db_statistics_, LEVEL_HINT_MISS);
+      learn_hint = status->ok() && range_del_agg != nullptr &&
+                   !read_options.ignore_range_deletions &&
+                   read_options.read_tier != kBlockCacheTier &&
+                   GetInternalKeySeqno(ikey) >= level_hints_max_seqno_;
+    }
+  }
+
   FilePicker fp(
       storage_info_.files_, user_key, ikey, &storage_info_.level_files_brief_,
       storage_info_.num_non_empty_levels_, &storage_info_.file_indexer_,
-      user_comparator(), internal_comparator());
+      user_comparator(), internal_comparator(), hint_level, hint_index);
   FdWithKeyRange* f = fp.GetNextFile();
   while (f != nullptr) {
     *status = table_cache_->Get(
@@ -977,6 +1009,18 @@ void Version::Get(const ReadOptions& read_options, const LookupKey& k,
       return;
     }
 
+    if (learn_hint && get_context.State() != GetContext::kNotFound) {
+      learn_hint = false;
+      if (get_context.State() != GetContext::kCorrupt &&
+          range_del_agg->IsEmpty()) {
+        level_hints_->Insert(
+            user_key, fp.GetCurrentLevel(),
+            static_cast<uint32_t>(
+                f - storage_info_.level_files_brief_[fp.GetCurrentLevel()]
+                        .files));
+      }
+    }
+
     switch (get_context.State()) {
       case GetContext::kNotFound:
         // Keep searching in other files
@@ -1052,6 +1096,19 @@ void Version::PrepareApply(
   storage_info_.GenerateFileIndexer();
   storage_info_.GenerateLevelFilesBrief();
   storage_info_.GenerateLevel0NonOverlapping();
+  if (mutable_cf_options.level_hint_cache_size > 0) {
+    level_hints_.reset(
+        new LevelHintCache(mutable_cf_options.level_hint_cache_size));
+    level_hints_max_seqno_ = 0;
+    for (int level = 0; level < storage_info_.num_levels(); level++) {
+      for (const FileMetaData* file : storage_info_.LevelFiles(level)) {
+        level_hints_max_seqno_ =
+            std::max(level_hints_max_seqno_, file->largest_seqno);
+      }
+    }
+  } else {
+    level_hints_.reset();
+  }
 }
 
 bool Version::MaybeInitializeFileMetaData(FileMetaData* file_meta) {
@@ -1074,6 +1131,9 @@ bool Version::MaybeInitializeFileMetaData(FileMetaData* file_meta) {
   file_meta->num_deletions = GetDeletedKeys(tp->user_collected_properties);
   file_meta->raw_value_size = tp->raw_value_size;
   file_meta->raw_key_size = tp->raw_key_size;
+  bool property_present_ignored;
+  file_meta->num_model_mispredictions = GetModelMispredictedKeys(
+      tp->user_collected_properties, &property_present_ignored);
 
   return true;
 }
@@ -1355,6 +1415,8 @@ void VersionStorageInfo::ComputeCompactionScore(
       }
     }
   }
+  model_error_compaction_trigger_ =
+      mutable_cf_options.model_error_compaction_trigger;
   ComputeFilesMarkedForCompaction();
   EstimateCompactionBytesNeeded(mutable_cf_options);
 }
@@ -1375,7 +1437,16 @@ void VersionStorageInfo::ComputeFilesMarkedForCompaction() {
 
   for (int level = 0; level <= last_qualify_level; level++) {
     for (auto* f : files_[level]) {
-      if (!f->being_compacted && f->marked_for_compaction) {
+      if (f->being_compacted) {
+        continue;
+      }
+      // A file whose learned model points many lookups at the wrong data
+      // block gets a freshly trained model when compaction rewrites it.
+      bool model_too_inaccurate =
+          model_error_compaction_trigger_ > 0 && f->num_entries > 0 &&
+          f->num_model_mispredictions >=
+              model_error_compaction_trigger_ * f->num_entries;
+      if (f->marked_for_compaction || model_too_inaccurate) {
         files_marked_for_compaction_.emplace_back(level, f);
       }
     }
@@ -3402,14 +3473,8 @@ uint64_t VersionSet::ApproximateSize(Version* v, const FdWithKeyRange& f,
   } else {
     // "key" falls in the range for this table.  Add the
     // approximate offset of "key" within the table.
-    TableReader* table_reader_ptr;
-    InternalIterator* iter = v->cfd_->table_cache()->NewIterator(
-        ReadOptions(), env_options_, v->cfd_->internal_comparator(), f.fd,
-        nullptr /* range_del_agg */, &table_reader_ptr);
-    if (table_reader_ptr != nullptr) {
-      result = table_reader_ptr->ApproximateOffsetOf(key);
-    }
-    delete iter;
+    result = v->cfd_->table_cache()->ApproximateOffsetOf(
+        env_options_, v->cfd_->internal_comparator(), f.fd, key);
   }
   return result;
 }
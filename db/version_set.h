@@ -33,6 +33,7 @@
 #include "db/compaction_picker.h"
 #include "db/dbformat.h"
 #include "db/file_indexer.h"
+#include "db/level_hint_cache.h"
 #include "db/log_reader.h"
 #include "db/range_del_aggregator.h"
 #include "db/table_cache.h"
@@ -131,7 +132,9 @@ class VersionStorageInfo {
       const MutableCFOptions& mutable_cf_options);
 
   // This computes files_marked_for_compaction_ and is called by
-  // ComputeCompactionScore()
+  // ComputeCompactionScore(). Besides files marked by their table
+  // properties collectors, it includes files whose learned model mispredicts
+  // more than model_error_compaction_trigger of their entries.
   void ComputeFilesMarkedForCompaction();
 
   // Generate level_files_brief_ from files_
@@ -404,6 +407,10 @@ class VersionStorageInfo {
   // ComputeCompactionScore()
   autovector<std::pair<int, FileMetaData*>> files_marked_for_compaction_;
 
+  // Copy of MutableCFOptions::model_error_compaction_trigger, refreshed by
+  // ComputeCompactionScore(). 0 disables model-error driven compactions.
+  double model_error_compaction_trigger_;
+
   // Level that should be compacted next and its compaction score.
   // Score < 1 means compaction is not strictly needed.  These fields
   // are initialized by Finalize().
@@ -599,6 +606,13 @@ class Version {
   // used for debugging and logging purposes only.
   uint64_t version_number_;
 
+  // Where recent Gets found their keys. Null unless level_hint_cache_size
+  // was set when this Version was prepared.
+  std::unique_ptr<LevelHintCache> level_hints_;
+  // Largest sequence number in this Version. Only lookups at or above it
+  // see every entry, so only those add hints.
+  SequenceNumber level_hints_max_seqno_ = 0;
+
   Version(ColumnFamilyData* cfd, VersionSet* vset, uint64_t version_number = 0);
 
   ~Version();
@@ -936,6 +936,7 @@ public:
       ++sequence_;
       return seek_status;
     }
+    RecordWrite(key);
 
     MemTable* mem = cf_mems_->GetMemTable();
     auto* moptions = mem->GetMemTableOptions();
@@ -992,8 +993,24 @@ public:
     return Status::OK();
   }
 
+  // Lets the lookup result cache of the column family, if any, drop its
+  // results for `key` (or for all keys, after a range deletion) before the
+  // write becomes visible.
+  void RecordWrite(const Slice& key, ValueType type = kTypeValue) {
+    auto* cfd = cf_mems_->current();
+    if (cfd == nullptr || cfd->lookup_result_cache() == nullptr) {
+      return;
+    }
+    if (type == kTypeRangeDeletion) {
+      cfd->lookup_result_cache()->RecordRangeDeletion(sequence_);
+    } else {
+      cfd->lookup_result_cache()->RecordWrite(key, sequence_);
+    }
+  }
+
   Status DeleteImpl(uint32_t column_family_id, const Slice& key,
                     const Slice& value, ValueType delete_type) {
+    RecordWrite(key, delete_type);
     MemTable* mem = cf_mems_->GetMemTable();
     mem->Add(sequence_, delete_type, key, value, concurrent_memtable_writes_,
              get_post_process_info(mem));
@@ -1078,6 +1095,7 @@ public:
       ++sequence_;
       return seek_status;
     }
+    RecordWrite(key);
 
     MemTable* mem = cf_mems_->GetMemTable();
     auto* moptions = mem->GetMemTableOptions();
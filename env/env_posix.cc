@@ -415,9 +415,19 @@ class PosixEnv : public Env {
                                  unique_ptr<RandomRWFile>* result,
                                  const EnvOptions& options) override {
     int fd = -1;
+    int flags = O_CREAT | O_RDWR;
+    // Direct IO mode with O_DIRECT flag or F_NOCAHCE (MAC OSX)
+    if (options.use_direct_writes) {
+#ifdef ROCKSDB_LITE
+      return Status::IOError(fname, "Direct I/O not supported in RocksDB lite");
+#endif  // ROCKSDB_LITE
+#if !defined(OS_MACOSX) && !defined(OS_OPENBSD)
+      flags |= O_DIRECT;
+#endif
+    }
     while (fd < 0) {
       IOSTATS_TIMER_GUARD(open_nanos);
-      fd = open(fname.c_str(), O_CREAT | O_RDWR, 0644);
+      fd = open(fname.c_str(), flags, 0644);
       if (fd < 0) {
         // Error while opening the file
         if (errno == EINTR) {
@@ -426,6 +436,12 @@ class PosixEnv : public Env {
         return IOError(fname, errno);
       }
     }
+#ifdef OS_MACOSX
+    if (options.use_direct_writes && fcntl(fd, F_NOCACHE, 1) == -1) {
+      close(fd);
+      return IOError(fname, errno);
+    }
+#endif
 
     SetFD_CLOEXEC(fd, &options);
     result->reset(new PosixRandomRWFile(fname, fd, options));
@@ -722,6 +722,49 @@ TEST_F(EnvPosixTest, PositionedAppend) {
   ASSERT_EQ('a', result[kBlockSize - 1]);
   ASSERT_EQ('b', result[kBlockSize]);
 }
+
+// Positioned writes to a RandomRWFile can be issued from several threads at
+// once, also with direct IO.
+TEST_F(EnvPosixTest, RandomRWFileDirectWrites) {
+  EnvOptions options;
+  options.use_direct_writes = true;
+  IoctlFriendlyTmpdir ift;
+  const std::string fname = ift.name() + "/f";
+  unique_ptr<RandomRWFile> file;
+  ASSERT_OK(env_->NewRandomRWFile(fname, &file, options));
+  ASSERT_TRUE(file->use_direct_io());
+
+  const size_t kPageSize = 4096;
+  const int kNumThreads = 4;
+  const int kPagesPerThread = 16;
+  std::vector<port::Thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&, t]() {
+      auto data = NewAligned(kPageSize, static_cast<char>('a' + t));
+      for (int i = 0; i < kPagesPerThread; i++) {
+        uint64_t offset = (i * kNumThreads + t) * kPageSize;
+        ASSERT_OK(file->Write(offset, Slice(data.get(), kPageSize)));
+      }
+    });
+  }
+  for (auto& th : threads) {
+    th.join();
+  }
+  ASSERT_OK(file->Close());
+
+  uint64_t size;
+  ASSERT_OK(env_->GetFileSize(fname, &size));
+  ASSERT_EQ(kNumThreads * kPagesPerThread * kPageSize, size);
+  ASSERT_OK(env_->NewRandomRWFile(fname, &file, EnvOptions()));
+  ASSERT_FALSE(file->use_direct_io());
+  std::string scratch(kPageSize, '\0');
+  for (int page = 0; page < kNumThreads * kPagesPerThread; page++) {
+    Slice result;
+    ASSERT_OK(file->Read(page * kPageSize, kPageSize, &result, &scratch[0]));
+    ASSERT_EQ(std::string(kPageSize, 'a' + page % kNumThreads),
+              result.ToString());
+  }
+}
 #endif  // !ROCKSDB_LITE
 
 // Only works in linux platforms
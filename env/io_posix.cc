@@ -898,7 +898,9 @@ size_t PosixWritableFile::GetUniqueId(char* id, size_t max_size) const {
 
 PosixRandomRWFile::PosixRandomRWFile(const std::string& fname, int fd,
                                      const EnvOptions& options)
-    : filename_(fname), fd_(fd) {}
+    : filename_(fname),
+      fd_(fd),
+      use_direct_io_(options.use_direct_writes) {}
 
 PosixRandomRWFile::~PosixRandomRWFile() {
   if (fd_ >= 0) {
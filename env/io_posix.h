@@ -207,6 +207,8 @@ class PosixRandomRWFile : public RandomRWFile {
                              const EnvOptions& options);
   virtual ~PosixRandomRWFile();
 
+  virtual bool use_direct_io() const override { return use_direct_io_; }
+
   virtual Status Write(uint64_t offset, const Slice& data) override;
 
   virtual Status Read(uint64_t offset, size_t n, Slice* result,
@@ -220,6 +222,7 @@ class PosixRandomRWFile : public RandomRWFile {
  private:
   const std::string filename_;
   int fd_;
+  const bool use_direct_io_;
 };
 
 class PosixDirectory : public Directory {
@@ -526,6 +526,59 @@ struct AdvancedColumnFamilyOptions {
   // Default: false
   bool report_bg_io_stats = false;
 
+  // If non-zero, an SST file whose learned index mispredicts the data block
+  // of at least this fraction of its entries is marked for compaction, so
+  // that it is rewritten with a newly trained model. Mispredictions are
+  // measured against the final block layout when the file is built and
+  // stored in its table properties.
+  // Files in the last non-empty level are never picked, same as files
+  // marked by table properties collectors.
+  //
+  // Default: 0 (disabled)
+  //
+  // Dynamically changeable through SetOptions() API
+  double model_error_compaction_trigger = 0;
+
+  // If non-zero, compaction also ends an output file before the first key
+  // at which the file's (key, byte offset) points can no longer be covered
+  // by one straight line within this many bytes. Output files then hold
+  // near-linear key ranges that their learned index fits with small error.
+  // Files shorter than 1/8 of the target file size are never split this way.
+  // Keys are interpreted by their first 8 bytes, as the learned index does.
+  //
+  // Default: 0 (disabled)
+  //
+  // Dynamically changeable through SetOptions() API
+  uint64_t model_output_split_error = 0;
+
+  // If true, each memtable that becomes immutable is rebuilt in the
+  // background (on the flush thread pool) into one contiguous sorted array
+  // indexed by a small learned model, which then serves its Gets, iterators
+  // and flush in place of the memtable representation. Helps when several
+  // immutable memtables wait to be flushed and every Get has to probe them.
+  // Costs about 16 bytes of extra memory per entry until the memtable is
+  // flushed, which is not counted against write_buffer_size or the
+  // WriteBufferManager.
+  //
+  // Default: false
+  //
+  // Dynamically changeable through SetOptions() API
+  bool learned_immutable_memtable = false;
+
+  // If non-zero, each Version of the LSM tree keeps a cache of this many
+  // slots (rounded up to a power of two) recording, per recently read user
+  // key, the first SST file that holds any entry for it. Point lookups that
+  // hit the cache start at that file instead of probing the filters and
+  // indexes of every upper-level file whose range covers the key; results
+  // are the same as without the cache. A cache starts empty with every new
+  // Version, so it helps most with read-heavy workloads between flushes
+  // and compactions. Costs the key plus about 16 bytes per slot.
+  //
+  // Default: 0 (disabled)
+  //
+  // Dynamically changeable through SetOptions() API
+  size_t level_hint_cache_size = 0;
+
   // Create ColumnFamilyOptions with default values for all fields
   AdvancedColumnFamilyOptions();
   // Create ColumnFamilyOptions from Options
@@ -23,8 +23,11 @@
 #pragma once
 
 #include <stdint.h>
+#include <functional>
 #include <memory>
 #include <string>
+#include <vector>
+#include "rocksdb/memory_allocator.h"
 #include "rocksdb/slice.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/status.h"
@@ -41,20 +44,57 @@ class Cache;
 // high_pri_pool_pct.
 // num_shard_bits = -1 means it is automatically determined: every shard
 // will be at least 512KB and number of shard bits will not exceed 6.
-extern std::shared_ptr<Cache> NewLRUCache(size_t capacity,
-                                          int num_shard_bits = -1,
-                                          bool strict_capacity_limit = false,
-                                          double high_pri_pool_ratio = 0.0);
+//
+// If frequency_sketch_size is positive, the cache resists scans: it keeps
+// a TinyLFU sketch of that many 4-bit counters, split among the shards, of
+// how often keys were looked up recently. A new entry that would evict the
+// oldest cached entry is only admitted if its key was looked up more often,
+// and entries that are hit move to a protected segment holding at least 80%
+// of the capacity (which also holds the high-pri pool), so that a burst of
+// keys looked up once cannot flush the entries looked up often. A key looked
+// up as often as that entry is not admitted either, so a cache filled by a
+// scan keeps its entries until keys looked up more than once come along.
+// A few counters per entry the cache holds is enough. Entries that are not
+// admitted are still returned through the handle passed to Insert(), and
+// freed once released.
+//
+// If memory_allocator is set, block based tables allocate the blocks they
+// put in the cache from it. See NewSlabAllocator().
+//
+// With lock_free_hits, each thread remembers a few entries per shard that
+// it found referenced by others, such as pinned index and filter blocks.
+// Looking one of them up again while it is still referenced, and releasing
+// a handle that is not the last one, take no shard mutex. Such hits do not
+// count towards the frequency sketch.
+extern std::shared_ptr<Cache> NewLRUCache(
+    size_t capacity, int num_shard_bits = -1,
+    bool strict_capacity_limit = false, double high_pri_pool_ratio = 0.0,
+    size_t frequency_sketch_size = 0,
+    std::shared_ptr<MemoryAllocator> memory_allocator = nullptr,
+    bool lock_free_hits = false);
 
 // Similar to NewLRUCache, but create a cache based on CLOCK algorithm with
-// better concurrent performance in some cases. See util/clock_cache.cc for
+// better concurrent performance in some cases. See cache/clock_cache.cc for
 // more detail.
 //
-// Return nullptr if it is not supported.
+// Return nullptr if it is not supported (in ROCKSDB_LITE builds).
 extern std::shared_ptr<Cache> NewClockCache(size_t capacity,
                                             int num_shard_bits = -1,
                                             bool strict_capacity_limit = false);
 
+// Counters of one shard of a cache, cumulative since the cache was created.
+struct CacheShardStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  // Acquisitions of the shard mutex that found it held, and the nanoseconds
+  // they spent waiting for it.
+  uint64_t lock_waits = 0;
+  uint64_t lock_wait_nanos = 0;
+  size_t usage = 0;
+  size_t pinned_usage = 0;
+  size_t capacity = 0;
+};
+
 class Cache {
  public:
   // Depending on implementation, cache entries with high priority could be less
@@ -172,12 +212,49 @@ class Cache {
   virtual void ApplyToAllCacheEntries(void (*callback)(void*, size_t),
                                       bool thread_safe) = 0;
 
+  // Like ApplyToAllCacheEntries(), but also passes the key of each entry,
+  // and always locks the accesses. `callback` must not call into the cache.
+  // Caches that cannot enumerate their keys do not call it.
+  virtual void ApplyToAllCacheEntriesWithKey(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+      /*callback*/) {}
+
   // Remove all entries.
   // Prerequisit: no entry is referenced.
   virtual void EraseUnRefEntries() = 0;
 
   virtual std::string GetPrintableOptions() const { return ""; }
 
+  // Sets one entry of *stats per shard of the cache. Caches that are not
+  // sharded leave it empty. Hits and misses are only counted while shard
+  // stats tracking or shard auto tuning is on.
+  virtual void GetShardStats(std::vector<CacheShardStats>* stats) const {
+    stats->clear();
+  }
+
+  // With track set, a sharded cache counts the hits and misses of each
+  // shard for GetShardStats(). Counting costs every lookup an atomic
+  // increment shared by all threads using the shard. Off by default.
+  virtual void SetShardStatsTracking(bool /*track*/) {}
+
+  // With auto_tune set, a sharded cache periodically moves capacity between
+  // its shards. Half the capacity stays split evenly, and the other half
+  // goes to the shards in proportion to their recent lookups, so shards that
+  // hot keys hash into get room for them. Each step moves capacities only
+  // part of the way there, and does not shrink a shard below the usage of
+  // its entries that were hit. Clearing it splits the capacity evenly
+  // again. Off by default.
+  virtual void SetShardAutoTuning(bool /*auto_tune*/) {}
+
+  // The number of shard bits a cache of this capacity should be created
+  // with. It exceeds the current one when, with auto tuning, many shard
+  // mutex acquisitions have been found to wait. -1 if not sharded.
+  virtual int GetSuggestedNumShardBits() const { return -1; }
+
+  // The allocator users should allocate the values they insert from, or
+  // nullptr to use new[].
+  virtual MemoryAllocator* memory_allocator() const { return nullptr; }
+
  private:
   // No copying allowed
   Cache(const Cache&);
@@ -0,0 +1,58 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stddef.h>
+#include <memory>
+
+namespace rocksdb {
+
+// MemoryAllocator allocates the memory of the values a Cache holds. Block
+// based tables read blocks that go to their block cache into memory from
+// the cache's allocator (see NewLRUCache()). Implementations must be
+// thread safe.
+class MemoryAllocator {
+ public:
+  virtual ~MemoryAllocator() {}
+
+  virtual const char* Name() const = 0;
+
+  // Allocates at least `size` bytes. Never returns nullptr.
+  virtual void* Allocate(size_t size) = 0;
+
+  // Frees memory returned by Allocate().
+  virtual void Deallocate(void* p) = 0;
+
+  // Bytes usable at `p`, which was allocated with `allocation_size` bytes.
+  virtual size_t UsableSize(void* /*p*/, size_t allocation_size) const {
+    return allocation_size;
+  }
+};
+
+struct SlabAllocatorOptions {
+  // Memory is mapped in regions of this many bytes, each holding objects of
+  // one size class. If the system has huge pages of this size reserved
+  // (see /proc/sys/vm/nr_hugepages), regions are mapped with MAP_HUGETLB,
+  // otherwise transparent huge pages are requested for them. 0 maps 2MB
+  // regions of regular pages. Windows builds allocate regions from the heap.
+  size_t huge_page_size = 2 << 20;
+
+  // Keep one set of slabs per NUMA node, bind their memory to the node, and
+  // serve each allocation from the node of the CPU making it. Needs a build
+  // with the NUMA library; ignored otherwise.
+  bool numa_aware = false;
+};
+
+// Creates an allocator serving requests of up to 256KB from slabs with four
+// size classes per power of two, so a request is rounded up by less than a
+// quarter of its size, and classes fitting full 4KB, 8KB and 16KB blocks.
+// Freed objects go back to their slab for reuse; slab memory is only
+// returned to the system when the allocator is destroyed.
+// Larger requests use malloc().
+extern std::shared_ptr<MemoryAllocator> NewSlabAllocator(
+    const SlabAllocatorOptions& options = SlabAllocatorOptions());
+
+}  // namespace rocksdb
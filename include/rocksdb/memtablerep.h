@@ -340,5 +340,32 @@ extern MemTableRepFactory* NewHashLinkListRepFactory(
 extern MemTableRepFactory* NewHashCuckooRepFactory(
     size_t write_buffer_size, size_t average_data_size = 64,
     unsigned int hash_function_count = 4);
+
+// This factory creates a mem-table representation backed by an updatable
+// learned index. Entries live in a directory of gapped arrays ("nodes"). A
+// linear model over the first 8 bytes of the user key predicts each entry's
+// node and its slot within the node, and a short exponential search with the
+// comparator corrects the guess. Spare slots let most inserts land without
+// moving other entries; a node is rebuilt with more room when it gets too
+// dense and split in two when it reaches max_node_entries.
+//
+// It suits fixed-size integer-like keys (big endian, bytewise comparator),
+// where the models are accurate and inserts and lookups do far fewer key
+// comparisons than a skip list. Other keys remain correct but search longer.
+// Concurrent inserts are supported; they only block each other when they
+// land in the same node or a node splits. Slot arrays are allocated from
+// the heap and reported through ApproximateMemoryUsage().
+//
+// Parameters:
+//   max_node_entries: a node holding this many entries splits when it is
+//     next full.
+//   initial_density: fraction of slots in use after a node is built or
+//     rebuilt.
+//   max_density: fraction of slots in use at which a node is rebuilt with
+//     initial_density. Higher values use less memory per entry but move more
+//     entries per insert.
+extern MemTableRepFactory* NewLearnedGappedArrayRepFactory(
+    size_t max_node_entries = 4096, double initial_density = 0.75,
+    double max_density = 0.9);
 #endif  // ROCKSDB_LITE
 }  // namespace rocksdb
@@ -811,6 +811,17 @@ struct DBOptions {
   // Not supported in ROCKSDB_LITE mode!
   std::shared_ptr<Cache> row_cache = nullptr;
 
+  // A cache for the results of point lookups, keyed by user key. Unlike
+  // row_cache it holds the final result of a Get() across all levels,
+  // including keys that were not found and values resolved from merge
+  // operands, so a hit skips the memtables and every SST file. Entries are
+  // invalidated by writes to their key, range deletions, file ingestion and
+  // DeleteFilesInRange(). Only Get()s without an explicit snapshot are
+  // served and filled, and column families with a compaction filter or FIFO
+  // compaction do not use it.
+  // Default: nullptr (disabled)
+  std::shared_ptr<Cache> lookup_result_cache = nullptr;
+
 #ifndef ROCKSDB_LITE
   // A filter object supplied to be invoked while processing write-ahead-logs
   // (WALs) during recovery. The filter provides a way to inspect log
@@ -841,6 +852,31 @@ struct DBOptions {
   // DEFAULT: false
   bool avoid_flush_during_recovery = false;
 
+  // If non-zero, every this many seconds, and when the DB is closed, the
+  // offsets of the blocks of the DB's tables found in their block caches are
+  // written to the HOT_BLOCKS file of the DB. DB::Open() then loads those
+  // blocks into the block caches again in the background, so that a
+  // restarted DB does not have to warm its cache up through misses: first
+  // the index, filter and learned model blocks of the listed tables, then
+  // the data blocks, level by level starting with level 0. It stops once a
+  // cache is full. The file is only written once that loading has finished,
+  // so a DB closed before does not replace it with a shorter list. Only
+  // block based tables support it.
+  //
+  // DEFAULT: 0 (disabled)
+  unsigned int block_cache_warmup_persist_period_sec = 0;
+
+  // Number of threads loading blocks into the block cache on DB::Open().
+  //
+  // DEFAULT: 1
+  int block_cache_warmup_threads = 1;
+
+  // If non-zero, the threads loading blocks into the block cache on
+  // DB::Open() read at most this many bytes per second together.
+  //
+  // DEFAULT: 0 (unlimited)
+  uint64_t block_cache_warmup_rate_bytes_per_sec = 0;
+
   // By default RocksDB will flush all memtables on DB close if there are
   // unpersisted data (i.e. with WAL disabled) The flush can be skip to speedup
   // DB close. Unpersisted data WILL BE LOST.
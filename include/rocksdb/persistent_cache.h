@@ -44,6 +44,25 @@ class PersistentCache {
   virtual Status Lookup(const Slice& key, std::unique_ptr<char[]>* data,
                         size_t* size) = 0;
 
+  // Lookup page cache by page identifier, without copying the page
+  //
+  // page_key   Page identifier
+  // value      Pinned to the page data, which stays valid until value is
+  //            reset or destroyed. It has to be released before the cache
+  //            is destroyed.
+  //
+  // The default implementation pins the buffer returned by Lookup()
+  virtual Status LookupPinned(const Slice& key, PinnableSlice* value) {
+    std::unique_ptr<char[]> data;
+    size_t size;
+    Status s = Lookup(key, &data, &size);
+    if (s.ok()) {
+      char* const page = data.release();
+      value->PinSlice(Slice(page, size), &DeletePage, page, nullptr);
+    }
+    return s;
+  }
+
   // Is cache storing uncompressed data ?
   //
   // True if the cache is configured to store uncompressed data else false
@@ -56,6 +75,11 @@ class PersistentCache {
   virtual StatsType Stats() = 0;
 
   virtual std::string GetPrintableOptions() const = 0;
+
+ private:
+  static void DeletePage(void* arg1, void* /*arg2*/) {
+    delete[] static_cast<char*>(arg1);
+  }
 };
 
 // Factor method to create a new persistent cache
@@ -7,6 +7,7 @@
 
 #pragma once
 #include <string>
+#include <vector>
 #include "rocksdb/env.h"
 #include "rocksdb/options.h"
 #include "rocksdb/table_properties.h"
@@ -87,6 +88,58 @@ class SstFileWriter {
   struct Rep;
   Rep* rep_;
 };
+
+struct ParallelSstFileWriterOptions {
+  // Number of files built at the same time. Also bounds the number of files
+  // whose keys and values are held in memory at once, which is one more
+  // than this.
+  int num_threads = 4;
+
+  // An output file is ended once the keys and values added to it, with a
+  // varint length each, reach this many bytes. 0 means
+  // Options::target_file_size_base.
+  uint64_t file_size = 0;
+
+  // Passed on to the SstFileWriter of every file.
+  bool invalidate_page_cache = true;
+};
+
+// ParallelSstFileWriter splits one sorted stream of keys and values into
+// several sst files and builds them on a pool of threads, so that block
+// compression and, for block-based tables, learned model training of one
+// file overlap with the others and with the caller adding keys. The files
+// have the same format as files written by SstFileWriter and, since their
+// key ranges do not overlap, can be ingested together with a single
+// DB::IngestExternalFile() call.
+class ParallelSstFileWriter {
+ public:
+  ParallelSstFileWriter(const EnvOptions& env_options, const Options& options,
+                        ColumnFamilyHandle* column_family = nullptr,
+                        const ParallelSstFileWriterOptions& parallel_options =
+                            ParallelSstFileWriterOptions());
+
+  // Waits for files still being built. Files of a writer that was not
+  // successfully finished are deleted.
+  ~ParallelSstFileWriter();
+
+  // Prepare to write files named "<path_prefix>000001.sst",
+  // "<path_prefix>000002.sst" and so on.
+  Status Open(const std::string& path_prefix);
+
+  // Add key, value to the stream. May block while num_threads files are
+  // being built.
+  // REQUIRES: key is after any previously added key according to comparator.
+  Status Add(const Slice& user_key, const Slice& value);
+
+  // Finish the last file and wait for all of them. On success, `file_infos`
+  // (if not null) receives the info of every file, in key order. On failure
+  // no file is left behind.
+  Status Finish(std::vector<ExternalSstFileInfo>* file_infos = nullptr);
+
+ private:
+  struct Rep;
+  Rep* rep_;
+};
 }  // namespace rocksdb
 
 #endif  // !ROCKSDB_LITE
@@ -24,12 +24,14 @@ enum Tickers : uint32_t {
   // total block cache misses
   // REQUIRES: BLOCK_CACHE_MISS == BLOCK_CACHE_INDEX_MISS +
   //                               BLOCK_CACHE_FILTER_MISS +
-  //                               BLOCK_CACHE_DATA_MISS;
+  //                               BLOCK_CACHE_DATA_MISS +
+  //                               BLOCK_CACHE_LEARNED_MODEL_MISS;
   BLOCK_CACHE_MISS = 0,
   // total block cache hit
   // REQUIRES: BLOCK_CACHE_HIT == BLOCK_CACHE_INDEX_HIT +
   //                              BLOCK_CACHE_FILTER_HIT +
-  //                              BLOCK_CACHE_DATA_HIT;
+  //                              BLOCK_CACHE_DATA_HIT +
+  //                              BLOCK_CACHE_LEARNED_MODEL_HIT;
   BLOCK_CACHE_HIT,
   // # of blocks added to block cache.
   BLOCK_CACHE_ADD,
@@ -219,6 +221,23 @@ enum Tickers : uint32_t {
   // Number of refill intervals where rate limiter's bytes are fully consumed.
   NUMBER_RATE_LIMITER_DRAINS,
 
+  // Point lookups in SST files that did (or did not) find a level hint for
+  // the key. See ColumnFamilyOptions::level_hint_cache_size.
+  LEVEL_HINT_HIT,
+  LEVEL_HINT_MISS,
+
+  // Learned models read through the block cache. See
+  // BlockBasedTableOptions::cache_learned_model_blocks.
+  BLOCK_CACHE_LEARNED_MODEL_MISS,
+  BLOCK_CACHE_LEARNED_MODEL_HIT,
+  BLOCK_CACHE_LEARNED_MODEL_ADD,
+  BLOCK_CACHE_LEARNED_MODEL_BYTES_INSERT,
+
+  // Point lookups answered (or not) by the lookup result cache. See
+  // DBOptions::lookup_result_cache.
+  LOOKUP_RESULT_CACHE_HIT,
+  LOOKUP_RESULT_CACHE_MISS,
+
   TICKER_ENUM_MAX
 };
 
@@ -322,6 +341,15 @@ const std::vector<std::pair<Tickers, std::string>> TickersNameMap = {
     {READ_AMP_ESTIMATE_USEFUL_BYTES, "rocksdb.read.amp.estimate.useful.bytes"},
     {READ_AMP_TOTAL_READ_BYTES, "rocksdb.read.amp.total.read.bytes"},
     {NUMBER_RATE_LIMITER_DRAINS, "rocksdb.number.rate_limiter.drains"},
+    {LEVEL_HINT_HIT, "rocksdb.level.hint.hit"},
+    {LEVEL_HINT_MISS, "rocksdb.level.hint.miss"},
+    {BLOCK_CACHE_LEARNED_MODEL_MISS, "rocksdb.block.cache.learned.model.miss"},
+    {BLOCK_CACHE_LEARNED_MODEL_HIT, "rocksdb.block.cache.learned.model.hit"},
+    {BLOCK_CACHE_LEARNED_MODEL_ADD, "rocksdb.block.cache.learned.model.add"},
+    {BLOCK_CACHE_LEARNED_MODEL_BYTES_INSERT,
+     "rocksdb.block.cache.learned.model.bytes.insert"},
+    {LOOKUP_RESULT_CACHE_HIT, "rocksdb.lookup.result.cache.hit"},
+    {LOOKUP_RESULT_CACHE_MISS, "rocksdb.lookup.result.cache.miss"},
 };
 
 /**
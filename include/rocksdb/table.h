@@ -29,6 +29,7 @@
 namespace rocksdb {
 
 // -- Block-based Table
+class BlockCacheTracer;
 class FlushBlockPolicyFactory;
 class PersistentCache;
 class RandomAccessFile;
@@ -222,6 +223,79 @@ struct BlockBasedTableOptions {
   // This option only affects newly written tables. When reading exising tables,
   // the information about version is read from the footer.
   uint32_t format_version = 2;
+
+  // If true, the learned model of each new table is written in a compact
+  // encoding: leaves no key maps to are dropped, and each remaining leaf is
+  // stored as a float slope plus bit-packed key and position bases, which
+  // takes a few bytes per leaf instead of 16. Readers evaluate the encoding
+  // in place. Tables written this way cannot be opened by versions that do
+  // not know the encoding; tables in either encoding can be read regardless
+  // of this option.
+  //
+  // Default: false
+  bool compact_learned_model = false;
+
+  // With compact_learned_model, a leaf of the learned model whose linear fit
+  // is off by more than this many bytes for some key of the leaf is refit as
+  // two joined lines or as a cubic, whichever is the first to come within
+  // the bound (or else the closest). A data block's worth of bytes keeps
+  // most keys in the block the model predicts. 0 keeps every leaf linear.
+  //
+  // Default: 0
+  uint64_t learned_leaf_max_error = 0;
+
+  // If nonzero, ApproximateOffsetOf(), and so GetApproximateSizes(), answers
+  // from the learned model of each table without touching its index, for
+  // tables whose model predicts offsets within this many bytes of the data
+  // (kModelMaxOffsetError scaled to the table's data size). Other tables
+  // keep seeking the index. 0 always uses the index.
+  //
+  // Default: 0
+  uint64_t model_offset_max_error = 0;
+
+  // If true, the decoded learned model of each table lives in the block
+  // cache, charged by its size and inserted with high priority, so that it
+  // stays resident while in use and is evicted for cold tables. If false,
+  // each table reader loads its model at open and holds it until closed.
+  //
+  // Default: false
+  bool cache_learned_model_blocks = false;
+
+  // If cache_learned_model_blocks is true and the below is true, the learned
+  // model of level-0 files is pinned in the block cache for as long as the
+  // table reader is open, like pin_l0_filter_and_index_blocks_in_cache does
+  // for filter and index blocks.
+  //
+  // Default: false
+  bool pin_l0_learned_model_in_cache = false;
+
+  // If true, block_cache_compressed becomes a second tier of block_cache
+  // instead of a cache of blocks as read from the file. Data blocks evicted
+  // from block_cache are compressed with demoted_block_compression and moved
+  // into block_cache_compressed, within its own capacity. A read that misses
+  // block_cache but hits block_cache_compressed decompresses the block and
+  // moves it back into block_cache. Blocks read from the file only go to
+  // block_cache, so no block is held by both caches. Blocks that do not
+  // compress well, and blocks of tables with a compression dictionary, are
+  // not demoted.
+  //
+  // Requires block_cache_compressed.
+  //
+  // Default: false
+  bool demote_evicted_blocks = false;
+
+  // Compression used for blocks demoted by demote_evicted_blocks. Should be
+  // cheap to decompress, as every promotion pays for it.
+  //
+  // Default: kLZ4Compression
+  CompressionType demoted_block_compression = kLZ4Compression;
+
+  // If set, the lookups of tables in block_cache and the blocks they insert
+  // are recorded here, for SimulateBlockCacheTrace() to replay. See
+  // rocksdb/utilities/block_cache_trace.h.
+  //
+  // Default: nullptr
+  std::shared_ptr<BlockCacheTracer> block_cache_tracer = nullptr;
 };
 
 // Table Properties that are specific to block-based table properties.
@@ -232,6 +306,20 @@ struct BlockBasedTablePropertyNames {
   static const std::string kWholeKeyFiltering;
   // value is "1" for true and "0" for false.
   static const std::string kPrefixFiltering;
+  // value is a varint64: number of entries whose learned-model prediction
+  // does not point at the data block that holds them.
+  static const std::string kModelMispredictedKeys;
+  // value is a varint64: largest distance, in data blocks, between the
+  // block predicted by the learned model and the block holding the entry.
+  static const std::string kModelMaxBlockError;
+  // value is a varint64: size in bytes of the serialized learned model.
+  static const std::string kModelSize;
+  // value is a varint64: microseconds spent training the learned model.
+  static const std::string kModelTrainMicros;
+  // value is a varint64: largest difference, in raw key and value bytes,
+  // between the offset BlockBasedTable::ModelRawOffset() estimates for an
+  // entry and the raw bytes of the entries before it.
+  static const std::string kModelMaxOffsetError;
 };
 
 // Create default block based table factory.
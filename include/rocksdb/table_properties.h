@@ -204,5 +204,15 @@ struct TableProperties {
 extern uint64_t GetDeletedKeys(const UserCollectedProperties& props);
 extern uint64_t GetMergeOperands(const UserCollectedProperties& props,
                                  bool* property_present);
+extern uint64_t GetModelMispredictedKeys(const UserCollectedProperties& props,
+                                         bool* property_present);
+extern uint64_t GetModelMaxBlockError(const UserCollectedProperties& props,
+                                     bool* property_present);
+extern uint64_t GetModelSize(const UserCollectedProperties& props,
+                             bool* property_present);
+extern uint64_t GetModelTrainMicros(const UserCollectedProperties& props,
+                                    bool* property_present);
+extern uint64_t GetModelMaxOffsetError(const UserCollectedProperties& props,
+                                       bool* property_present);
 
 }  // namespace rocksdb
@@ -0,0 +1,123 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rocksdb/cache.h"
+#include "rocksdb/env.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+// What a traced block holds.
+enum class BlockCacheTraceBlockType : char {
+  kData = 0,
+  kIndex = 1,
+  kFilter = 2,
+  kLearnedModel = 3,
+  kNumBlockTypes = 4,
+};
+
+// Which kind of read made a traced access.
+enum class BlockCacheTraceCaller : char {
+  // Get() on the table, and the blocks it reads.
+  kGet = 0,
+  // Iterators created by users.
+  kIterator = 1,
+  // Reads of compaction inputs.
+  kCompaction = 2,
+  // Blocks read while opening a table, by Prefetch(), or by block cache
+  // warm-up.
+  kPrefetch = 3,
+  kNumCallers = 4,
+};
+
+struct BlockCacheTraceRecord {
+  enum Op : char {
+    // A lookup of the key in the block cache.
+    kLookup = 0,
+    // An insert of the block into the block cache after a missed lookup.
+    kInsert = 1,
+  };
+
+  Op op = kLookup;
+  uint64_t timestamp_micros = 0;
+  std::string cache_key;
+  BlockCacheTraceBlockType block_type = BlockCacheTraceBlockType::kData;
+  BlockCacheTraceCaller caller = BlockCacheTraceCaller::kGet;
+  // Level of the table, or -1 if unknown.
+  int level = -1;
+  // For lookups only: whether the key was found.
+  bool is_hit = false;
+  // For lookups only: whether the block is inserted if it was not found.
+  bool fill_cache = true;
+  // Charge of the block in the cache. 0 for lookups that missed.
+  uint64_t charge = 0;
+};
+
+// Records the accesses of block-based tables to their block cache in a
+// compact binary file. Set it as BlockBasedTableOptions::block_cache_tracer
+// of the tables to trace. Tables opened before it is set are not traced.
+// Safe to use from many threads.
+class BlockCacheTracer {
+ public:
+  virtual ~BlockCacheTracer() {}
+
+  virtual void Record(const BlockCacheTraceRecord& record) = 0;
+
+  // Writes out buffered records and closes the file. Later records are
+  // dropped. Also done on destruction.
+  virtual Status Close() = 0;
+};
+
+// Creates a tracer writing to `trace_path`, replacing any file there.
+// Records are buffered in memory and written out in batches.
+Status NewBlockCacheTracer(Env* env, const std::string& trace_path,
+                           std::shared_ptr<BlockCacheTracer>* tracer);
+
+// Reads back the records of a file written by a BlockCacheTracer.
+class BlockCacheTraceReader {
+ public:
+  virtual ~BlockCacheTraceReader() {}
+
+  // Reads the next record into *record. Returns false at the end of the
+  // file or on error, which status() then reports.
+  virtual bool ReadRecord(BlockCacheTraceRecord* record) = 0;
+
+  virtual Status status() const = 0;
+};
+
+Status NewBlockCacheTraceReader(Env* env, const std::string& trace_path,
+                                std::unique_ptr<BlockCacheTraceReader>* reader);
+
+// Lookups and hits of one simulated cache, overall and by caller.
+struct BlockCacheSimulationResult {
+  uint64_t lookups = 0;
+  uint64_t hits = 0;
+  uint64_t caller_lookups[static_cast<int>(
+      BlockCacheTraceCaller::kNumCallers)] = {};
+  uint64_t caller_hits[static_cast<int>(BlockCacheTraceCaller::kNumCallers)] =
+      {};
+
+  double hit_ratio() const {
+    return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+  }
+};
+
+// Replays the trace at `trace_path` against each of `caches`, which should
+// be empty and are only used to hold keys. A cache that misses a lookup
+// gets the block inserted with its traced charge, as the traced cache did,
+// unless the traced read did not fill the cache. Sets one result per cache.
+Status SimulateBlockCacheTrace(
+    Env* env, const std::string& trace_path,
+    const std::vector<std::shared_ptr<Cache>>& caches,
+    std::vector<BlockCacheSimulationResult>* results);
+
+}  // namespace rocksdb
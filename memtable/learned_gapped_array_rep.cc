@@ -0,0 +1,908 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+#ifndef ROCKSDB_LITE
+#include "memtable/learned_gapped_array_rep.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "db/memtable.h"
+#include "port/port.h"
+#include "util/arena.h"
+#include "util/coding.h"
+#include "util/mutexlock.h"
+
+namespace rocksdb {
+
+const size_t LearnedGappedArrayRepFactory::kMinNodeEntries;
+constexpr double LearnedGappedArrayRepFactory::kMinDensity;
+constexpr double LearnedGappedArrayRepFactory::kMaxDensity;
+
+namespace {
+
+// Smallest slot array a node is laid out with.
+const size_t kMinNodeCapacity = 16;
+
+// Maps the user key of a memtable entry to the integer formed by its first
+// 8 bytes, big endian and zero padded. The mapping preserves order under the
+// bytewise comparator. The models below only use it to guess where to start
+// searching, and every search is finished with the real comparator, so other
+// comparators stay correct and merely search longer.
+uint64_t EntryToNumber(const char* entry) {
+  uint32_t len = 0;
+  const char* p = GetVarint32Ptr(entry, entry + 5, &len);
+  size_t user_len = len >= 8 ? len - 8 : 0;
+  uint64_t num = 0;
+  for (size_t i = 0; i < 8; i++) {
+    num <<= 8;
+    if (i < user_len) {
+      num |= static_cast<unsigned char>(p[i]);
+    }
+  }
+  return num;
+}
+
+double Offset(uint64_t x, uint64_t base) {
+  return x >= base ? static_cast<double>(x - base)
+                   : -static_cast<double>(base - x);
+}
+
+// Returns the first index i in [0, n] for which before(i) is false, probing
+// outward from `guess` with exponentially growing steps. `before` must hold
+// for a prefix of [0, n) and fail for the rest.
+template <typename Pred>
+size_t ExponentialSearch(size_t guess, size_t n, const Pred& before) {
+  if (n == 0) {
+    return 0;
+  }
+  size_t lo, hi;
+  if (before(guess)) {
+    lo = guess + 1;
+    hi = lo;
+    for (size_t step = 1; hi < n && before(hi); step *= 2) {
+      lo = hi + 1;
+      hi += step;
+    }
+    hi = std::min(hi, n);
+  } else {
+    hi = guess;
+    lo = guess;
+    for (size_t step = 1; lo > 0 && !before(lo - 1); step *= 2) {
+      hi = lo - 1;
+      lo = hi > step ? hi - step : 0;
+    }
+  }
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (before(mid)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// y = slope * (x - base) + intercept.
+struct LinearModel {
+  uint64_t base = 0;
+  double slope = 0;
+  double intercept = 0;
+
+  // Least-squares fit of ys to the sorted xs. Returns false, leaving a flat
+  // model at the mean of ys, if y does not grow with x.
+  bool Train(const std::vector<uint64_t>& xs, const std::vector<double>& ys) {
+    assert(xs.size() == ys.size());
+    size_t n = xs.size();
+    base = n > 0 ? xs[0] : 0;
+    slope = 0;
+    intercept = 0;
+    double mean_x = 0;
+    for (size_t i = 0; i < n; i++) {
+      mean_x += Offset(xs[i], base);
+      intercept += ys[i];
+    }
+    if (n < 2) {
+      return false;
+    }
+    mean_x /= n;
+    intercept /= n;
+    double sxx = 0, sxy = 0;
+    for (size_t i = 0; i < n; i++) {
+      double dx = Offset(xs[i], base) - mean_x;
+      sxx += dx * dx;
+      sxy += dx * (ys[i] - intercept);
+    }
+    if (!(sxx > 0) || !(sxy > 0)) {
+      return false;
+    }
+    slope = sxy / sxx;
+    intercept -= slope * mean_x;
+    return true;
+  }
+
+  // Returns the prediction for x clamped to [0, limit).
+  size_t Predict(uint64_t x, size_t limit) const {
+    double y = slope * Offset(x, base) + intercept;
+    if (!(y > 0)) {
+      return 0;
+    }
+    if (y >= static_cast<double>(limit - 1)) {
+      return limit - 1;
+    }
+    return static_cast<size_t>(y);
+  }
+};
+
+// Takes a read lock unless `skip` is set, which the rep uses once it is
+// read-only and nothing can change underneath a reader.
+class OptionalReadLock {
+ public:
+  OptionalReadLock(port::RWMutex* mu, bool skip) : mu_(skip ? nullptr : mu) {
+    if (mu_ != nullptr) {
+      mu_->ReadLock();
+    }
+  }
+  ~OptionalReadLock() {
+    if (mu_ != nullptr) {
+      mu_->ReadUnlock();
+    }
+  }
+
+ private:
+  port::RWMutex* const mu_;
+  // No copying allowed
+  OptionalReadLock(const OptionalReadLock&);
+  void operator=(const OptionalReadLock&);
+};
+
+// A gapped array of entry pointers in key order, placed where a linear model
+// of the node's keys predicts them. A gap holds the entry of the next
+// occupied slot (nullptr past the last one), so the whole array stays sorted
+// and can be searched directly; the occupancy bitmap tells entries from gaps.
+struct Node {
+  explicit Node(const char* _pivot) : pivot(_pivot) {}
+
+  // Serializes writers of this node against each other and against readers.
+  // Only taken while holding the rep's directory lock.
+  mutable port::RWMutex latch;
+  // Smallest entry this node may hold; nullptr for the first node.
+  const char* const pivot;
+  LinearModel model;
+  size_t capacity = 0;
+  size_t num_entries = 0;
+  // Number of entries at which the node must grow before the next insert.
+  size_t grow_at = 0;
+  // Changes whenever entries move; iterators use it to tell whether their
+  // slot is still current.
+  uint64_t version = 0;
+  // Inserts since the last layout, and how many of them went past the last
+  // entry.
+  size_t inserts = 0;
+  size_t appends = 0;
+  std::unique_ptr<const char*[]> slots;
+  std::unique_ptr<uint64_t[]> bitmap;
+
+  bool Occupied(size_t i) const {
+    return (bitmap[i >> 6] >> (i & 63)) & 1;
+  }
+
+  void SetOccupied(size_t i) { bitmap[i >> 6] |= uint64_t{1} << (i & 63); }
+
+  // Returns the first slot >= i that holds an entry (with !occupied, the
+  // first gap), or capacity if there is none.
+  size_t NextSlot(size_t i, bool occupied) const {
+    const uint64_t flip = occupied ? 0 : ~uint64_t{0};
+    while (i < capacity) {
+      uint64_t word = (bitmap[i >> 6] ^ flip) >> (i & 63);
+      if (word == 0) {
+        i = (i | 63) + 1;
+        continue;
+      }
+      while ((word & 1) == 0) {
+        word >>= 1;
+        i++;
+      }
+      // Bits past the end read as gaps.
+      return std::min(i, capacity);
+    }
+    return capacity;
+  }
+
+  // Returns the last slot < i that holds an entry (with !occupied, the last
+  // gap), or capacity if there is none.
+  size_t PrevSlot(size_t i, bool occupied) const {
+    const uint64_t flip = occupied ? 0 : ~uint64_t{0};
+    while (i > 0) {
+      size_t j = i - 1;
+      uint64_t word = (bitmap[j >> 6] ^ flip) << (63 - (j & 63));
+      if (word == 0) {
+        i = j & ~static_cast<size_t>(63);
+        continue;
+      }
+      while ((word >> 63) == 0) {
+        word <<= 1;
+        j--;
+      }
+      return j;
+    }
+    return capacity;
+  }
+
+  size_t NextOccupied(size_t i) const { return NextSlot(i, true); }
+  size_t PrevOccupied(size_t i) const { return PrevSlot(i, true); }
+
+  // Most inserts since the last layout went past the last entry.
+  bool Appending() const { return appends * 2 > inserts; }
+
+  size_t MemoryUsage() const {
+    return sizeof(Node) + capacity * sizeof(const char*) +
+           (capacity + 63) / 64 * sizeof(uint64_t);
+  }
+
+  // Appends the entries in order and, if `positions` is set, their slots.
+  void CollectEntries(std::vector<const char*>* entries,
+                      std::vector<size_t>* positions = nullptr) const {
+    entries->reserve(entries->size() + num_entries);
+    for (size_t i = NextOccupied(0); i < capacity; i = NextOccupied(i + 1)) {
+      entries->push_back(slots[i]);
+      if (positions != nullptr) {
+        positions->push_back(i);
+      }
+    }
+  }
+
+  // Returns the first slot whose key is not ordered before `key` (with
+  // `upper`, the first slot ordered after it), or capacity if there is none.
+  size_t Bound(const char* key, uint64_t num, bool upper,
+               const MemTableRep::KeyComparator& compare) const {
+    auto before = [&](size_t i) {
+      const char* slot = slots[i];
+      if (slot == nullptr) {
+        return false;
+      }
+      int c = compare(slot, key);
+      return upper ? c <= 0 : c < 0;
+    };
+    return ExponentialSearch(model.Predict(num, capacity), capacity, before);
+  }
+
+  // Retrains the model on the sorted entries [begin, end) and lays them out
+  // over the first `used` of `new_capacity` slots, each at or after its
+  // predicted slot. Slots past `used` are left free for appends.
+  void Layout(const std::vector<const char*>& entries, size_t begin,
+              size_t end, size_t new_capacity, size_t used,
+              double max_density) {
+    size_t n = end - begin;
+    assert(n < new_capacity);
+    assert(n <= used && used <= new_capacity);
+    capacity = new_capacity;
+    num_entries = n;
+    grow_at = std::min(
+        capacity,
+        std::max(static_cast<size_t>(capacity * max_density), n + 1));
+    inserts = 0;
+    appends = 0;
+    version++;
+    slots.reset(new const char*[capacity]);
+    bitmap.reset(new uint64_t[(capacity + 63) / 64]());
+
+    std::vector<uint64_t> nums;
+    std::vector<double> targets;
+    nums.reserve(n);
+    targets.reserve(n);
+    for (size_t i = begin; i < end; i++) {
+      nums.push_back(EntryToNumber(entries[i]));
+      targets.push_back(static_cast<double>(i - begin) * used / n);
+    }
+    bool trained = model.Train(nums, targets);
+    size_t next_free = 0;
+    for (size_t i = 0; i < n; i++) {
+      // Without a usable model, spread the entries evenly.
+      size_t pos = trained ? model.Predict(nums[i], capacity) : i * used / n;
+      pos = std::min(std::max(pos, next_free), used - (n - i));
+      slots[pos] = entries[begin + i];
+      SetOccupied(pos);
+      next_free = pos + 1;
+    }
+    const char* next = nullptr;
+    for (size_t i = capacity; i-- > 0;) {
+      if (Occupied(i)) {
+        next = slots[i];
+      } else {
+        slots[i] = next;
+      }
+    }
+  }
+
+  // Keeps only the first `new_capacity` slots, which hold `kept` entries,
+  // and refits the model to where those entries are.
+  void Truncate(size_t new_capacity, size_t kept, double max_density) {
+    assert(kept > 0 && kept <= new_capacity && new_capacity <= capacity);
+    size_t words = (new_capacity + 63) / 64;
+    std::unique_ptr<const char*[]> new_slots(new const char*[new_capacity]);
+    std::unique_ptr<uint64_t[]> new_bitmap(new uint64_t[words]);
+    memcpy(new_slots.get(), slots.get(), new_capacity * sizeof(const char*));
+    memcpy(new_bitmap.get(), bitmap.get(), words * sizeof(uint64_t));
+    if (new_capacity % 64 != 0) {
+      new_bitmap[words - 1] &= (uint64_t{1} << (new_capacity % 64)) - 1;
+    }
+    slots.swap(new_slots);
+    bitmap.swap(new_bitmap);
+    capacity = new_capacity;
+    num_entries = kept;
+    grow_at = std::min(
+        capacity,
+        std::max(static_cast<size_t>(capacity * max_density), kept + 1));
+    inserts = 0;
+    appends = 0;
+    version++;
+    // Gaps after the last kept entry no longer lead to an entry.
+    for (size_t i = capacity; i-- > 0 && !Occupied(i);) {
+      slots[i] = nullptr;
+    }
+
+    std::vector<uint64_t> nums;
+    std::vector<double> positions;
+    nums.reserve(kept);
+    positions.reserve(kept);
+    for (size_t i = NextOccupied(0); i < capacity; i = NextOccupied(i + 1)) {
+      nums.push_back(EntryToNumber(slots[i]));
+      positions.push_back(static_cast<double>(i));
+    }
+    model.Train(nums, positions);
+  }
+
+  // REQUIRES: num_entries < capacity, and nothing equal to key is present.
+  void Insert(const char* key, uint64_t num,
+              const MemTableRep::KeyComparator& compare) {
+    assert(num_entries < capacity);
+    size_t pos = Bound(key, num, false /* upper */, compare);
+    inserts++;
+    // Only gaps past the last entry hold nullptr.
+    if (pos == capacity || slots[pos] == nullptr) {
+      appends++;
+    }
+    // Everything before pos is smaller than key, and pos - 1 holds an entry:
+    // a gap there would carry the entry of pos and so not be smaller.
+    if (pos < capacity && !Occupied(pos)) {
+      slots[pos] = key;
+      SetOccupied(pos);
+    } else {
+      // Shift entries by one towards the nearest gap.
+      size_t right = NextSlot(pos, false);
+      size_t left = pos >= 2 ? PrevSlot(pos - 1, false) : capacity;
+      if (right < capacity &&
+          (left == capacity || right - pos <= pos - 1 - left)) {
+        memmove(&slots[pos + 1], &slots[pos],
+                (right - pos) * sizeof(const char*));
+        SetOccupied(right);
+        slots[pos] = key;
+      } else {
+        assert(left < capacity);
+        // Gaps before `left` carry slots[left + 1], which moves into `left`,
+        // so they stay valid.
+        memmove(&slots[left], &slots[left + 1],
+                (pos - 1 - left) * sizeof(const char*));
+        SetOccupied(left);
+        slots[pos - 1] = key;
+      }
+    }
+    num_entries++;
+    version++;
+  }
+};
+
+// A memtable that keeps entries in a directory of gapped-array nodes. A
+// linear model over the node pivots predicts the node for a key, and each
+// node's own model predicts the slot; both guesses are then corrected with an
+// exponential search using the memtable comparator. Nodes grow by relaying
+// out into a larger array and split in half once they reach
+// max_node_entries, retraining their models as they do.
+//
+// Concurrency: the directory is guarded by a reader-writer lock and every
+// node by its own latch. Inserts share the directory lock and take the
+// node's latch exclusively, so concurrent inserts into different nodes do
+// not block each other; only splits take the directory lock exclusively.
+// Once the rep is read-only, readers skip all locking.
+class LearnedGappedArrayRep : public MemTableRep {
+ public:
+  LearnedGappedArrayRep(const KeyComparator& compare,
+                        MemTableAllocator* allocator, size_t max_node_entries,
+                        double initial_density, double max_density);
+
+  // Insert key into the collection. (The caller will pack key and value into a
+  // single buffer and pass that in as the parameter to Insert)
+  // REQUIRES: nothing that compares equal to key is currently in the
+  // collection.
+  virtual void Insert(KeyHandle handle) override;
+
+  virtual void InsertConcurrently(KeyHandle handle) override {
+    Insert(handle);
+  }
+
+  // Returns true iff an entry that compares equal to key is in the collection.
+  virtual bool Contains(const char* key) const override;
+
+  virtual void MarkReadOnly() override {
+    read_only_.store(true, std::memory_order_release);
+  }
+
+  virtual size_t ApproximateMemoryUsage() override {
+    return memory_usage_.load(std::memory_order_relaxed);
+  }
+
+  virtual void Get(const LookupKey& k, void* callback_args,
+                   bool (*callback_func)(void* arg,
+                                         const char* entry)) override;
+
+  virtual uint64_t ApproximateNumEntries(const Slice& start_ikey,
+                                         const Slice& end_ikey) override;
+
+  virtual ~LearnedGappedArrayRep() override {}
+
+  virtual MemTableRep::Iterator* GetIterator(Arena* arena) override;
+
+ private:
+  class Iterator;
+
+  // An entry and where it was found. The slot stays usable only while
+  // neither the directory nor the node has changed since.
+  struct Position {
+    const char* entry = nullptr;
+    size_t node = 0;
+    size_t slot = 0;
+    uint64_t dir_version = 0;
+    uint64_t node_version = 0;
+  };
+
+  bool ReadOnly() const { return read_only_.load(std::memory_order_acquire); }
+
+  // Returns the node whose range holds key.
+  // REQUIRES: dir_lock_ held.
+  size_t FindNode(const char* key, uint64_t num) const;
+
+  // Positions *pos at the first entry not ordered before target (with
+  // `upper`, ordered after it), starting in node idx and moving on to later
+  // nodes. A null target starts at the beginning of node idx. With `resume`,
+  // pos already points into node idx and the search continues after it if the
+  // node is unchanged.
+  // REQUIRES: dir_lock_ held.
+  void ForwardLocked(size_t idx, const char* target, bool upper, bool resume,
+                     Position* pos) const;
+
+  // Positions *pos at the last entry ordered before target (with
+  // `inclusive`, not ordered after it), starting in node idx and moving on to
+  // earlier nodes. A null target starts at the end of node idx.
+  // REQUIRES: dir_lock_ held.
+  void BackwardLocked(size_t idx, const char* target, bool inclusive,
+                      bool resume, Position* pos) const;
+
+  void Seek(const char* target, Position* pos) const;
+  void SeekForPrev(const char* target, Position* pos) const;
+  void SeekToFirst(Position* pos) const;
+  void SeekToLast(Position* pos) const;
+  void Next(Position* pos) const;
+  void Prev(Position* pos) const;
+
+  enum LayoutMode {
+    // Spread the entries at initial_density.
+    kSpread,
+    // Keep the entries at max_density and leave the rest of a full-sized
+    // node free after them, for a node whose inserts mostly land past its
+    // last entry.
+    kAppend,
+  };
+
+  // Lays out the sorted entries [begin, end) in node.
+  void LayoutNode(Node* node, const std::vector<const char*>& entries,
+                  size_t begin, size_t end, LayoutMode mode) const;
+
+  // Relays out the node with room to grow.
+  // REQUIRES: the node's latch held exclusively.
+  void Expand(Node* node);
+
+  // Splits node idx in two halves and retrains the directory model. An
+  // appending node instead keeps most of its entries in place and moves only
+  // the newest eighth to the new node.
+  // REQUIRES: dir_lock_ held exclusively.
+  void Split(size_t idx);
+
+  const KeyComparator& compare_;
+  const size_t max_node_entries_;
+  const double initial_density_;
+  const double max_density_;
+
+  mutable port::RWMutex dir_lock_;
+  std::vector<std::unique_ptr<Node>> nodes_;
+  // pivots_[i] == nodes_[i]->pivot, kept apart so the directory search stays
+  // in one array.
+  std::vector<const char*> pivots_;
+  LinearModel root_model_;
+  // Changes whenever nodes are added.
+  uint64_t dir_version_;
+
+  std::atomic<bool> read_only_;
+  std::atomic<size_t> memory_usage_;
+};
+
+LearnedGappedArrayRep::LearnedGappedArrayRep(const KeyComparator& compare,
+                                             MemTableAllocator* allocator,
+                                             size_t max_node_entries,
+                                             double initial_density,
+                                             double max_density)
+    : MemTableRep(allocator),
+      compare_(compare),
+      max_node_entries_(max_node_entries),
+      initial_density_(initial_density),
+      max_density_(max_density),
+      dir_version_(0),
+      read_only_(false),
+      memory_usage_(0) {
+  nodes_.emplace_back(new Node(nullptr));
+  pivots_.push_back(nullptr);
+  LayoutNode(nodes_[0].get(), std::vector<const char*>(), 0, 0, kSpread);
+  memory_usage_.store(nodes_[0]->MemoryUsage(), std::memory_order_relaxed);
+}
+
+size_t LearnedGappedArrayRep::FindNode(const char* key, uint64_t num) const {
+  size_t n = pivots_.size();
+  if (n == 1) {
+    return 0;
+  }
+  auto at_or_before_key = [&](size_t i) {
+    return i == 0 || compare_(pivots_[i], key) <= 0;
+  };
+  return ExponentialSearch(root_model_.Predict(num, n), n, at_or_before_key) -
+         1;
+}
+
+void LearnedGappedArrayRep::ForwardLocked(size_t idx, const char* target,
+                                          bool upper, bool resume,
+                                          Position* pos) const {
+  bool read_only = ReadOnly();
+  for (bool first = true; idx < nodes_.size(); idx++, first = false) {
+    const Node* node = nodes_[idx].get();
+    OptionalReadLock latch(&node->latch, read_only);
+    size_t slot = 0;
+    if (first) {
+      if (resume && node->version == pos->node_version) {
+        slot = pos->slot + 1;
+      } else if (target != nullptr) {
+        slot = node->Bound(target, EntryToNumber(target), upper, compare_);
+      }
+    }
+    slot = node->NextOccupied(slot);
+    if (slot < node->capacity) {
+      pos->entry = node->slots[slot];
+      pos->node = idx;
+      pos->slot = slot;
+      pos->dir_version = dir_version_;
+      pos->node_version = node->version;
+      return;
+    }
+  }
+  pos->entry = nullptr;
+}
+
+void LearnedGappedArrayRep::BackwardLocked(size_t idx, const char* target,
+                                           bool inclusive, bool resume,
+                                           Position* pos) const {
+  bool read_only = ReadOnly();
+  for (bool first = true;; idx--, first = false) {
+    const Node* node = nodes_[idx].get();
+    OptionalReadLock latch(&node->latch, read_only);
+    size_t end = node->capacity;
+    if (first) {
+      if (resume && node->version == pos->node_version) {
+        end = pos->slot;
+      } else if (target != nullptr) {
+        end = node->Bound(target, EntryToNumber(target), inclusive, compare_);
+      }
+    }
+    size_t slot = node->PrevOccupied(end);
+    if (slot < node->capacity) {
+      pos->entry = node->slots[slot];
+      pos->node = idx;
+      pos->slot = slot;
+      pos->dir_version = dir_version_;
+      pos->node_version = node->version;
+      return;
+    }
+    if (idx == 0) {
+      break;
+    }
+  }
+  pos->entry = nullptr;
+}
+
+void LearnedGappedArrayRep::Seek(const char* target, Position* pos) const {
+  OptionalReadLock dir_lock(&dir_lock_, ReadOnly());
+  ForwardLocked(FindNode(target, EntryToNumber(target)), target,
+                false /* upper */, false /* resume */, pos);
+}
+
+void LearnedGappedArrayRep::SeekForPrev(const char* target,
+                                        Position* pos) const {
+  OptionalReadLock dir_lock(&dir_lock_, ReadOnly());
+  BackwardLocked(FindNode(target, EntryToNumber(target)), target,
+                 true /* inclusive */, false /* resume */, pos);
+}
+
+void LearnedGappedArrayRep::SeekToFirst(Position* pos) const {
+  OptionalReadLock dir_lock(&dir_lock_, ReadOnly());
+  ForwardLocked(0, nullptr, false /* upper */, false /* resume */, pos);
+}
+
+void LearnedGappedArrayRep::SeekToLast(Position* pos) const {
+  OptionalReadLock dir_lock(&dir_lock_, ReadOnly());
+  BackwardLocked(nodes_.size() - 1, nullptr, false /* inclusive */,
+                 false /* resume */, pos);
+}
+
+void LearnedGappedArrayRep::Next(Position* pos) const {
+  assert(pos->entry != nullptr);
+  OptionalReadLock dir_lock(&dir_lock_, ReadOnly());
+  if (pos->dir_version == dir_version_) {
+    ForwardLocked(pos->node, pos->entry, true /* upper */, true /* resume */,
+                  pos);
+  } else {
+    ForwardLocked(FindNode(pos->entry, EntryToNumber(pos->entry)), pos->entry,
+                  true /* upper */, false /* resume */, pos);
+  }
+}
+
+void LearnedGappedArrayRep::Prev(Position* pos) const {
+  assert(pos->entry != nullptr);
+  OptionalReadLock dir_lock(&dir_lock_, ReadOnly());
+  if (pos->dir_version == dir_version_) {
+    BackwardLocked(pos->node, pos->entry, false /* inclusive */,
+                   true /* resume */, pos);
+  } else {
+    BackwardLocked(FindNode(pos->entry, EntryToNumber(pos->entry)),
+                   pos->entry, false /* inclusive */, false /* resume */, pos);
+  }
+}
+
+void LearnedGappedArrayRep::LayoutNode(Node* node,
+                                       const std::vector<const char*>& entries,
+                                       size_t begin, size_t end,
+                                       LayoutMode mode) const {
+  size_t n = end - begin;
+  size_t dense = static_cast<size_t>(n / max_density_) + 1;
+  size_t capacity, used;
+  switch (mode) {
+    case kAppend:
+      used = dense;
+      capacity = std::max(
+          {kMinNodeCapacity, dense + n,
+           static_cast<size_t>(max_node_entries_ / max_density_) + 1});
+      break;
+    case kSpread:
+    default:
+      used = capacity =
+          std::max(kMinNodeCapacity,
+                   static_cast<size_t>((n + 1) / initial_density_) + 1);
+      break;
+  }
+  node->Layout(entries, begin, end, capacity, used, max_density_);
+}
+
+void LearnedGappedArrayRep::Expand(Node* node) {
+  size_t old_usage = node->MemoryUsage();
+  std::vector<const char*> entries;
+  node->CollectEntries(&entries);
+  LayoutNode(node, entries, 0, entries.size(),
+             node->Appending() ? kAppend : kSpread);
+  memory_usage_.fetch_add(node->MemoryUsage() - old_usage,
+                          std::memory_order_relaxed);
+}
+
+void LearnedGappedArrayRep::Split(size_t idx) {
+  Node* left = nodes_[idx].get();
+  size_t old_usage = left->MemoryUsage();
+  bool appending = left->Appending();
+  std::vector<const char*> entries;
+  std::vector<size_t> positions;
+  left->CollectEntries(&entries, appending ? &positions : nullptr);
+  size_t mid = appending
+                   ? entries.size() - std::max<size_t>(entries.size() / 8, 1)
+                   : entries.size() / 2;
+  assert(mid > 0);
+
+  std::unique_ptr<Node> right(new Node(entries[mid]));
+  LayoutNode(right.get(), entries, mid, entries.size(),
+             appending ? kAppend : kSpread);
+  if (appending) {
+    // Older entries are unlikely to see more inserts; keep them where they
+    // are, packed as they were appended.
+    left->Truncate(positions[mid], mid, max_density_);
+  } else {
+    LayoutNode(left, entries, 0, mid, kSpread);
+  }
+  memory_usage_.fetch_add(
+      left->MemoryUsage() + right->MemoryUsage() +
+          sizeof(std::unique_ptr<Node>) + sizeof(const char*) - old_usage,
+      std::memory_order_relaxed);
+  pivots_.insert(pivots_.begin() + idx + 1, right->pivot);
+  nodes_.insert(nodes_.begin() + idx + 1, std::move(right));
+  dir_version_++;
+
+  std::vector<uint64_t> nums;
+  std::vector<double> indexes;
+  nums.reserve(pivots_.size() - 1);
+  indexes.reserve(pivots_.size() - 1);
+  for (size_t i = 1; i < pivots_.size(); i++) {
+    nums.push_back(EntryToNumber(pivots_[i]));
+    indexes.push_back(static_cast<double>(i));
+  }
+  root_model_.Train(nums, indexes);
+}
+
+void LearnedGappedArrayRep::Insert(KeyHandle handle) {
+  const char* key = static_cast<char*>(handle);
+  uint64_t num = EntryToNumber(key);
+  assert(!ReadOnly());
+  while (true) {
+    {
+      ReadLock dir_lock(&dir_lock_);
+      Node* node = nodes_[FindNode(key, num)].get();
+      WriteLock latch(&node->latch);
+      if (node->num_entries >= node->grow_at &&
+          node->num_entries < max_node_entries_) {
+        Expand(node);
+      }
+      if (node->num_entries < node->grow_at) {
+        node->Insert(key, num, compare_);
+        return;
+      }
+    }
+    // The node is full and must split, which rearranges the directory.
+    WriteLock dir_lock(&dir_lock_);
+    size_t idx = FindNode(key, num);
+    const Node* node = nodes_[idx].get();
+    if (node->num_entries >= node->grow_at &&
+        node->num_entries >= max_node_entries_) {
+      Split(idx);
+    }
+  }
+}
+
+bool LearnedGappedArrayRep::Contains(const char* key) const {
+  Position pos;
+  Seek(key, &pos);
+  return pos.entry != nullptr && compare_(pos.entry, key) == 0;
+}
+
+void LearnedGappedArrayRep::Get(const LookupKey& k, void* callback_args,
+                                bool (*callback_func)(void* arg,
+                                                      const char* entry)) {
+  // Holding the directory lock keeps positions valid across entries; node
+  // latches are only held while a node is searched, not during callbacks.
+  OptionalReadLock dir_lock(&dir_lock_, ReadOnly());
+  const char* target = k.memtable_key().data();
+  Position pos;
+  for (ForwardLocked(FindNode(target, EntryToNumber(target)), target,
+                     false /* upper */, false /* resume */, &pos);
+       pos.entry != nullptr && callback_func(callback_args, pos.entry);
+       ForwardLocked(pos.node, pos.entry, true /* upper */, true /* resume */,
+                     &pos)) {
+  }
+}
+
+uint64_t LearnedGappedArrayRep::ApproximateNumEntries(const Slice& start_ikey,
+                                                      const Slice& end_ikey) {
+  bool read_only = ReadOnly();
+  OptionalReadLock dir_lock(&dir_lock_, read_only);
+  std::string tmp;
+  // Number of entries before key, interpolating within its node.
+  auto rank = [&](const char* key) {
+    size_t idx = FindNode(key, EntryToNumber(key));
+    uint64_t count = 0;
+    for (size_t i = 0; i < idx; i++) {
+      count += nodes_[i]->num_entries;
+    }
+    const Node* node = nodes_[idx].get();
+    OptionalReadLock latch(&node->latch, read_only);
+    size_t slot = node->Bound(key, EntryToNumber(key), false, compare_);
+    return count + node->num_entries * slot / node->capacity;
+  };
+  uint64_t start_count = rank(EncodeKey(&tmp, start_ikey));
+  uint64_t end_count = rank(EncodeKey(&tmp, end_ikey));
+  return (end_count >= start_count) ? (end_count - start_count) : 0;
+}
+
+class LearnedGappedArrayRep::Iterator : public MemTableRep::Iterator {
+ public:
+  explicit Iterator(const LearnedGappedArrayRep* rep) : rep_(rep) {}
+
+  virtual ~Iterator() override {}
+
+  // Returns true iff the iterator is positioned at a valid node.
+  virtual bool Valid() const override { return pos_.entry != nullptr; }
+
+  // Returns the key at the current position.
+  // REQUIRES: Valid()
+  virtual const char* key() const override {
+    assert(Valid());
+    return pos_.entry;
+  }
+
+  // Advances to the next position.
+  // REQUIRES: Valid()
+  virtual void Next() override { rep_->Next(&pos_); }
+
+  // Advances to the previous position.
+  // REQUIRES: Valid()
+  virtual void Prev() override { rep_->Prev(&pos_); }
+
+  // Advance to the first entry with a key >= target
+  virtual void Seek(const Slice& internal_key,
+                    const char* memtable_key) override {
+    rep_->Seek(memtable_key != nullptr ? memtable_key
+                                       : EncodeKey(&tmp_, internal_key),
+               &pos_);
+  }
+
+  // Advance to the last entry with a key <= target
+  virtual void SeekForPrev(const Slice& internal_key,
+                           const char* memtable_key) override {
+    rep_->SeekForPrev(memtable_key != nullptr
+                          ? memtable_key
+                          : EncodeKey(&tmp_, internal_key),
+                      &pos_);
+  }
+
+  // Position at the first entry in collection.
+  // Final state of iterator is Valid() iff collection is not empty.
+  virtual void SeekToFirst() override { rep_->SeekToFirst(&pos_); }
+
+  // Position at the last entry in collection.
+  // Final state of iterator is Valid() iff collection is not empty.
+  virtual void SeekToLast() override { rep_->SeekToLast(&pos_); }
+
+ private:
+  const LearnedGappedArrayRep* rep_;
+  Position pos_;
+  std::string tmp_;  // For passing to EncodeKey
+};
+
+MemTableRep::Iterator* LearnedGappedArrayRep::GetIterator(Arena* arena) {
+  if (arena == nullptr) {
+    return new Iterator(this);
+  }
+  char* mem = arena->AllocateAligned(sizeof(Iterator));
+  return new (mem) Iterator(this);
+}
+
+}  // anon namespace
+
+MemTableRep* LearnedGappedArrayRepFactory::CreateMemTableRep(
+    const MemTableRep::KeyComparator& compare, MemTableAllocator* allocator,
+    const SliceTransform* transform, Logger* logger) {
+  size_t max_node_entries = std::max(max_node_entries_, kMinNodeEntries);
+  double max_density =
+      std::min(std::max(max_density_, kMinDensity), kMaxDensity);
+  double initial_density =
+      std::min(std::max(initial_density_, kMinDensity), max_density);
+  return new LearnedGappedArrayRep(compare, allocator, max_node_entries,
+                                   initial_density, max_density);
+}
+
+MemTableRepFactory* NewLearnedGappedArrayRepFactory(size_t max_node_entries,
+                                                    double initial_density,
+                                                    double max_density) {
+  return new LearnedGappedArrayRepFactory(max_node_entries, initial_density,
+                                          max_density);
+}
+
+}  // namespace rocksdb
+#endif  // ROCKSDB_LITE
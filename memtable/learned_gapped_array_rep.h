@@ -0,0 +1,44 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+#ifndef ROCKSDB_LITE
+#include "rocksdb/memtablerep.h"
+
+namespace rocksdb {
+
+class LearnedGappedArrayRepFactory : public MemTableRepFactory {
+ public:
+  // Bounds applied to the factory parameters.
+  static const size_t kMinNodeEntries = 16;
+  static constexpr double kMinDensity = 0.1;
+  static constexpr double kMaxDensity = 0.95;
+
+  explicit LearnedGappedArrayRepFactory(size_t max_node_entries,
+                                        double initial_density,
+                                        double max_density)
+      : max_node_entries_(max_node_entries),
+        initial_density_(initial_density),
+        max_density_(max_density) {}
+
+  virtual ~LearnedGappedArrayRepFactory() {}
+
+  virtual MemTableRep* CreateMemTableRep(
+      const MemTableRep::KeyComparator& compare, MemTableAllocator* allocator,
+      const SliceTransform* transform, Logger* logger) override;
+
+  virtual const char* Name() const override {
+    return "LearnedGappedArrayRepFactory";
+  }
+
+  bool IsInsertConcurrentlySupported() const override { return true; }
+
+ private:
+  const size_t max_node_entries_;
+  const double initial_density_;
+  const double max_density_;
+};
+}  // namespace rocksdb
+#endif  // ROCKSDB_LITE
@@ -0,0 +1,369 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef ROCKSDB_LITE
+
+#include "memtable/learned_gapped_array_rep.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "db/memtable.h"
+#include "memtable/memtable_allocator.h"
+#include "port/port.h"
+#include "port/stack_trace.h"
+#include "rocksdb/comparator.h"
+#include "rocksdb/db.h"
+#include "rocksdb/write_buffer_manager.h"
+#include "util/arena.h"
+#include "util/coding.h"
+#include "util/mutexlock.h"
+#include "util/random.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+namespace {
+
+std::string BigEndianKey(uint64_t key) {
+  std::string result(8, '\0');
+  for (int i = 7; i >= 0; i--) {
+    result[i] = static_cast<char>(key & 0xff);
+    key >>= 8;
+  }
+  return result;
+}
+
+bool FirstEntry(void* arg, const char* entry) {
+  *static_cast<const char**>(arg) = entry;
+  return false;
+}
+
+}  // namespace
+
+class LearnedGappedArrayRepTest : public testing::Test {
+ public:
+  LearnedGappedArrayRepTest()
+      : write_buffer_manager_(0), allocator_(&arena_, &write_buffer_manager_) {
+    Open(BytewiseComparator(), 64);
+  }
+
+  void Open(const Comparator* user_comparator, size_t max_node_entries) {
+    rep_.reset();
+    expected_.clear();
+    internal_comparator_.reset(new InternalKeyComparator(user_comparator));
+    key_comparator_.reset(new MemTable::KeyComparator(*internal_comparator_));
+    factory_.reset(NewLearnedGappedArrayRepFactory(max_node_entries));
+    rep_.reset(factory_->CreateMemTableRep(*key_comparator_, &allocator_,
+                                           nullptr, nullptr));
+  }
+
+  // Builds the memtable entry for (user_key, seq) with an empty value.
+  const char* NewEntry(const Slice& user_key, SequenceNumber seq) {
+    InternalKey internal_key(user_key, seq, kTypeValue);
+    Slice encoded = internal_key.Encode();
+    uint32_t key_size = static_cast<uint32_t>(encoded.size());
+    char* buf = nullptr;
+    rep_->Allocate(VarintLength(key_size) + key_size + VarintLength(0), &buf);
+    char* p = EncodeVarint32(buf, key_size);
+    memcpy(p, encoded.data(), key_size);
+    EncodeVarint32(p + key_size, 0);
+    return buf;
+  }
+
+  const char* Add(const Slice& user_key, SequenceNumber seq) {
+    const char* entry = NewEntry(user_key, seq);
+    rep_->Insert(const_cast<char*>(entry));
+    expected_.push_back(entry);
+    return entry;
+  }
+
+  void SortExpected() {
+    const MemTableRep::KeyComparator& compare = *key_comparator_;
+    std::sort(expected_.begin(), expected_.end(),
+              [&](const char* a, const char* b) { return compare(a, b) < 0; });
+  }
+
+  void Validate() {
+    SortExpected();
+    for (const char* entry : expected_) {
+      ASSERT_TRUE(rep_->Contains(entry));
+    }
+
+    std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator());
+    ASSERT_FALSE(iter->Valid());
+    iter->SeekToFirst();
+    for (const char* entry : expected_) {
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(entry, iter->key());
+      iter->Next();
+    }
+    ASSERT_FALSE(iter->Valid());
+
+    iter->SeekToLast();
+    for (size_t i = expected_.size(); i-- > 0;) {
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(expected_[i], iter->key());
+      iter->Prev();
+    }
+    ASSERT_FALSE(iter->Valid());
+
+    for (size_t i = 0; i < expected_.size(); i++) {
+      const char* entry = expected_[i];
+      iter->Seek(Slice(), entry);
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(entry, iter->key());
+      iter->SeekForPrev(GetLengthPrefixedSlice(entry), nullptr);
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(entry, iter->key());
+
+      Slice internal_key = GetLengthPrefixedSlice(entry);
+      LookupKey lookup_key(ExtractUserKey(internal_key),
+                           GetInternalKeySeqno(internal_key));
+      const char* found = nullptr;
+      rep_->Get(lookup_key, &found, FirstEntry);
+      ASSERT_EQ(entry, found);
+    }
+  }
+
+  Arena arena_;
+  WriteBufferManager write_buffer_manager_;
+  MemTableAllocator allocator_;
+  std::unique_ptr<InternalKeyComparator> internal_comparator_;
+  std::unique_ptr<MemTable::KeyComparator> key_comparator_;
+  std::unique_ptr<MemTableRepFactory> factory_;
+  std::unique_ptr<MemTableRep> rep_;
+  std::vector<const char*> expected_;
+};
+
+TEST_F(LearnedGappedArrayRepTest, Empty) {
+  std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator());
+  iter->SeekToFirst();
+  ASSERT_FALSE(iter->Valid());
+  iter->SeekToLast();
+  ASSERT_FALSE(iter->Valid());
+  const char* entry = NewEntry(BigEndianKey(1), 1);
+  iter->Seek(Slice(), entry);
+  ASSERT_FALSE(iter->Valid());
+  ASSERT_FALSE(rep_->Contains(entry));
+}
+
+TEST_F(LearnedGappedArrayRepTest, RandomIntegerKeys) {
+  Random64 rnd(301);
+  for (SequenceNumber seq = 1; seq <= 20000; seq++) {
+    Add(BigEndianKey(rnd.Next()), seq);
+  }
+  Validate();
+}
+
+TEST_F(LearnedGappedArrayRepTest, SequentialKeysWithVersions) {
+  SequenceNumber seq = 0;
+  for (uint64_t key = 0; key < 20000; key++) {
+    Add(BigEndianKey(1000 + key * 3), ++seq);
+    if (key % 7 == 0) {
+      Add(BigEndianKey(1000 + key * 3), ++seq);
+    }
+  }
+  Validate();
+
+  // All versions of a user key are visited newest first.
+  LookupKey lookup_key(BigEndianKey(1000), kMaxSequenceNumber);
+  const char* found = nullptr;
+  rep_->Get(lookup_key, &found, FirstEntry);
+  ASSERT_NE(nullptr, found);
+  ASSERT_EQ(2U, GetInternalKeySeqno(GetLengthPrefixedSlice(found)));
+}
+
+TEST_F(LearnedGappedArrayRepTest, KeysBeyondModelPrefix) {
+  // The first 8 bytes are identical, so the models cannot tell keys apart.
+  Random rnd(301);
+  char buf[32];
+  for (SequenceNumber seq = 1; seq <= 5000; seq++) {
+    snprintf(buf, sizeof(buf), "shared_prefix_%08u",
+             static_cast<unsigned>(rnd.Uniform(1000000)));
+    Add(buf, seq);
+  }
+  Validate();
+}
+
+TEST_F(LearnedGappedArrayRepTest, ReverseComparator) {
+  Open(ReverseBytewiseComparator(), 64);
+  Random64 rnd(301);
+  for (SequenceNumber seq = 1; seq <= 5000; seq++) {
+    Add(BigEndianKey(rnd.Next()), seq);
+  }
+  Validate();
+}
+
+TEST_F(LearnedGappedArrayRepTest, IteratorSurvivesInserts) {
+  SequenceNumber seq = 0;
+  for (uint64_t key = 0; key < 2000; key += 2) {
+    Add(BigEndianKey(key), ++seq);
+  }
+  std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator());
+  iter->SeekToFirst();
+  const char* prev = nullptr;
+  size_t visited = 0;
+  uint64_t next_odd = 1;
+  while (iter->Valid()) {
+    if (prev != nullptr) {
+      ASSERT_LT((*key_comparator_)(prev, iter->key()), 0);
+    }
+    prev = iter->key();
+    visited++;
+    // Insert odd keys on both sides of the iterator, forcing node splits.
+    for (int i = 0; i < 3 && next_odd < 1000; i++, next_odd += 2) {
+      Add(BigEndianKey(next_odd), ++seq);
+      Add(BigEndianKey(2000 - next_odd), ++seq);
+    }
+    iter->Next();
+  }
+  // Every even key plus the odd keys inserted ahead of the iterator.
+  ASSERT_GT(visited, 1000U);
+  ASSERT_LE(visited, expected_.size());
+
+  // Prev also resumes correctly after the layout changed.
+  iter->SeekToLast();
+  Add(BigEndianKey(5000), ++seq);
+  iter->Prev();
+  ASSERT_TRUE(iter->Valid());
+  ASSERT_EQ(BigEndianKey(1998),
+            ExtractUserKey(GetLengthPrefixedSlice(iter->key())).ToString());
+  Validate();
+}
+
+TEST_F(LearnedGappedArrayRepTest, ConcurrentInserts) {
+  ASSERT_TRUE(factory_->IsInsertConcurrentlySupported());
+  const int kThreads = 4;
+  const uint64_t kPerThread = 5000;
+  // Allocation is not thread-safe, so build all entries up front.
+  std::vector<std::vector<const char*>> entries(kThreads);
+  for (int t = 0; t < kThreads; t++) {
+    for (uint64_t i = 0; i < kPerThread; i++) {
+      entries[t].push_back(
+          NewEntry(BigEndianKey(i * kThreads + t), i * kThreads + t + 1));
+      expected_.push_back(entries[t].back());
+    }
+  }
+
+  std::atomic<bool> done(false);
+  std::atomic<bool> reader_failed(false);
+  port::Thread reader([&]() {
+    while (!done.load()) {
+      std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator());
+      const char* prev = nullptr;
+      for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+        if (prev != nullptr && (*key_comparator_)(prev, iter->key()) >= 0) {
+          reader_failed.store(true);
+        }
+        prev = iter->key();
+      }
+    }
+  });
+  std::vector<port::Thread> writers;
+  for (int t = 0; t < kThreads; t++) {
+    writers.emplace_back([&, t]() {
+      for (const char* entry : entries[t]) {
+        rep_->InsertConcurrently(const_cast<char*>(entry));
+      }
+    });
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  done.store(true);
+  reader.join();
+  ASSERT_FALSE(reader_failed.load());
+  Validate();
+}
+
+TEST_F(LearnedGappedArrayRepTest, MemoryUsageAndEstimates) {
+  Open(BytewiseComparator(), 4096);
+  size_t empty_usage = rep_->ApproximateMemoryUsage();
+  const uint64_t kNumKeys = 100000;
+  for (uint64_t key = 0; key < kNumKeys; key++) {
+    Add(BigEndianKey(key * 10), key + 1);
+  }
+  size_t usage = rep_->ApproximateMemoryUsage();
+  ASSERT_GT(usage, empty_usage);
+  // Slots plus gaps cost less than two pointers per entry.
+  ASSERT_LT(usage, kNumKeys * 2 * sizeof(const char*));
+
+  InternalKey start(BigEndianKey(20000), kMaxSequenceNumber, kTypeValue);
+  InternalKey end(BigEndianKey(70000), kMaxSequenceNumber, kTypeValue);
+  uint64_t count = rep_->ApproximateNumEntries(start.Encode(), end.Encode());
+  ASSERT_GT(count, 4000U);
+  ASSERT_LT(count, 6000U);
+
+  rep_->MarkReadOnly();
+  Validate();
+}
+
+TEST_F(LearnedGappedArrayRepTest, DBReadWrite) {
+  Options options;
+  options.create_if_missing = true;
+  options.memtable_factory.reset(NewLearnedGappedArrayRepFactory(256));
+  options.allow_concurrent_memtable_write = true;
+  std::string dbname = test::TmpDir() + "/learned_gapped_array_rep_test";
+  ASSERT_OK(DestroyDB(dbname, options));
+  DB* db = nullptr;
+  ASSERT_OK(DB::Open(options, dbname, &db));
+
+  Random64 rnd(301);
+  std::vector<std::string> keys;
+  for (int i = 0; i < 5000; i++) {
+    keys.push_back(BigEndianKey(rnd.Next()));
+    ASSERT_OK(db->Put(WriteOptions(), keys.back(), "v1"));
+  }
+  for (int i = 0; i < 5000; i += 5) {
+    ASSERT_OK(db->Put(WriteOptions(), keys[i], "v2"));
+  }
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 0; i < 5000; i++) {
+      std::string value;
+      ASSERT_OK(db->Get(ReadOptions(), keys[i], &value));
+      ASSERT_EQ(i % 5 == 0 ? "v2" : "v1", value);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::unique_ptr<Iterator> iter(db->NewIterator(ReadOptions()));
+    size_t i = 0;
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), i++) {
+      ASSERT_EQ(keys[i], iter->key().ToString());
+    }
+    ASSERT_EQ(keys.size(), i);
+    // Second pass reads the flushed file.
+    ASSERT_OK(db->Flush(FlushOptions()));
+    keys.clear();
+    Random64 replay(301);
+    for (int k = 0; k < 5000; k++) {
+      keys.push_back(BigEndianKey(replay.Next()));
+    }
+  }
+  delete db;
+  ASSERT_OK(DestroyDB(dbname, options));
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  rocksdb::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
+
+#else
+#include <stdio.h>
+
+int main(int argc, char** argv) {
+  fprintf(stderr,
+          "SKIPPED as LearnedGappedArrayRep is not supported in ROCKSDB_LITE\n");
+  return 0;
+}
+
+#endif  // ROCKSDB_LITE
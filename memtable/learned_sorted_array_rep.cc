@@ -0,0 +1,333 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+//
+#include "memtable/learned_sorted_array_rep.h"
+
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "rocksdb/comparator.h"
+#include "util/arena.h"
+#include "util/coding.h"
+
+namespace rocksdb {
+namespace {
+
+// Keys routed to one leaf model, on average.
+const size_t kEntriesPerLeaf = 128;
+
+// The first 8 bytes of `user_key` as a big-endian integer, zero padded.
+// Ordered like the keys themselves under the bytewise comparator.
+uint64_t KeyToNumber(const Slice& user_key) {
+  uint64_t num = 0;
+  for (size_t i = 0; i < 8; i++) {
+    num <<= 8;
+    if (i < user_key.size()) {
+      num |= static_cast<unsigned char>(user_key[i]);
+    }
+  }
+  return num;
+}
+
+double Offset(uint64_t x, uint64_t base) {
+  return x >= base ? static_cast<double>(x - base)
+                   : -static_cast<double>(base - x);
+}
+
+// y = slope * (x - base) + intercept, with slope >= 0 so that predictions
+// never decrease as x grows. The error bounds below rely on that.
+struct LinearModel {
+  uint64_t base = 0;
+  double slope = 0;
+  double intercept = 0;
+
+  // Least-squares fit of positions [begin, end) scaled by `scale` to
+  // xs[begin, end). Falls back to a flat model at the mean position when the
+  // positions do not grow with x.
+  void Train(const std::vector<uint64_t>& xs, size_t begin, size_t end,
+             double scale) {
+    size_t n = end - begin;
+    base = n > 0 ? xs[begin] : 0;
+    slope = 0;
+    intercept = 0;
+    if (n == 0) {
+      return;
+    }
+    double mean_x = 0;
+    for (size_t i = begin; i < end; i++) {
+      mean_x += Offset(xs[i], base);
+      intercept += static_cast<double>(i) * scale;
+    }
+    mean_x /= n;
+    intercept /= n;
+    double sxx = 0, sxy = 0;
+    for (size_t i = begin; i < end; i++) {
+      double dx = Offset(xs[i], base) - mean_x;
+      sxx += dx * dx;
+      sxy += dx * (static_cast<double>(i) * scale - intercept);
+    }
+    if (sxx > 0 && sxy > 0) {
+      slope = sxy / sxx;
+      intercept -= slope * mean_x;
+    }
+  }
+
+  // Returns the prediction for x clamped to [lo, hi].
+  size_t Predict(uint64_t x, size_t lo, size_t hi) const {
+    double y = slope * Offset(x, base) + intercept;
+    if (!(y > static_cast<double>(lo))) {
+      return lo;
+    }
+    if (y >= static_cast<double>(hi)) {
+      return hi;
+    }
+    return static_cast<size_t>(y);
+  }
+};
+
+// Position range of the keys a leaf model covers, and how far its
+// predictions for them stray from their true positions.
+struct Leaf {
+  LinearModel model;
+  size_t begin = 0;
+  size_t end = 0;
+  size_t max_error = 0;
+};
+
+class LearnedSortedArrayRep : public MemTableRep {
+ public:
+  LearnedSortedArrayRep(const KeyComparator& compare,
+                        const Comparator* user_comparator,
+                        MemTableAllocator* allocator, MemTableRep* source);
+
+  // The rep is built read-only.
+  virtual void Insert(KeyHandle handle) override { assert(false); }
+
+  virtual bool Contains(const char* key) const override;
+
+  virtual void Get(const LookupKey& k, void* callback_args,
+                   bool (*callback_func)(void* arg,
+                                         const char* entry)) override;
+
+  virtual uint64_t ApproximateNumEntries(const Slice& start_ikey,
+                                         const Slice& end_ikey) override;
+
+  virtual size_t ApproximateMemoryUsage() override {
+    return entries_.capacity() * sizeof(const char*) +
+           nums_.capacity() * sizeof(uint64_t) +
+           leaves_.capacity() * sizeof(Leaf);
+  }
+
+  virtual ~LearnedSortedArrayRep() override {}
+
+  virtual MemTableRep::Iterator* GetIterator(Arena* arena) override;
+
+ private:
+  class Iterator;
+
+  // Returns the index of the first entry not less than `internal_key`, or
+  // the first greater than it if `upper` is set.
+  size_t Find(const Slice& internal_key, bool upper) const;
+
+  // Binary search of [lo, hi) with the comparator.
+  size_t Search(const Slice& internal_key, bool upper, size_t lo,
+                size_t hi) const;
+
+  const KeyComparator& compare_;
+  std::vector<const char*> entries_;
+  // KeyToNumber() of each entry's user key.
+  std::vector<uint64_t> nums_;
+  // Whether the user comparator orders keys bytewise, so that keys ordered
+  // by nums_ are ordered the same way by the comparator. Searches skip the
+  // model otherwise.
+  const bool use_model_;
+  LinearModel root_;
+  std::vector<Leaf> leaves_;
+};
+
+LearnedSortedArrayRep::LearnedSortedArrayRep(
+    const KeyComparator& compare, const Comparator* user_comparator,
+    MemTableAllocator* allocator, MemTableRep* source)
+    : MemTableRep(allocator),
+      compare_(compare),
+      use_model_(user_comparator == BytewiseComparator()) {
+  std::unique_ptr<MemTableRep::Iterator> iter(source->GetIterator());
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    entries_.push_back(iter->key());
+  }
+  size_t n = entries_.size();
+  if (!use_model_ || n == 0) {
+    return;
+  }
+  nums_.reserve(n);
+  for (const char* entry : entries_) {
+    nums_.push_back(
+        KeyToNumber(ExtractUserKey(GetLengthPrefixedSlice(entry))));
+  }
+  assert(std::is_sorted(nums_.begin(), nums_.end()));
+
+  // The root spreads keys over the leaves by position. Because its
+  // predictions never decrease, each leaf receives a contiguous run of
+  // positions, and a key routed to a leaf sorts between the leaf's first
+  // entry and the next leaf's first entry.
+  size_t num_leaves = std::max<size_t>(1, n / kEntriesPerLeaf);
+  root_.Train(nums_, 0, n, static_cast<double>(num_leaves) / n);
+  leaves_.resize(num_leaves);
+  size_t pos = 0;
+  for (size_t l = 0; l < num_leaves; l++) {
+    Leaf& leaf = leaves_[l];
+    leaf.begin = pos;
+    while (pos < n && root_.Predict(nums_[pos], 0, num_leaves - 1) == l) {
+      pos++;
+    }
+    leaf.end = pos;
+    leaf.model.Train(nums_, leaf.begin, leaf.end, 1.0);
+    for (size_t i = leaf.begin; i < leaf.end; i++) {
+      size_t guess = leaf.model.Predict(nums_[i], leaf.begin, leaf.end);
+      leaf.max_error =
+          std::max(leaf.max_error, guess > i ? guess - i : i - guess);
+    }
+  }
+  assert(pos == n);
+}
+
+size_t LearnedSortedArrayRep::Search(const Slice& internal_key, bool upper,
+                                     size_t lo, size_t hi) const {
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    int c = compare_(entries_[mid], internal_key);
+    if (c < 0 || (upper && c == 0)) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+size_t LearnedSortedArrayRep::Find(const Slice& internal_key,
+                                   bool upper) const {
+  size_t n = entries_.size();
+  if (!use_model_ || n == 0) {
+    return Search(internal_key, upper, 0, n);
+  }
+  uint64_t x = KeyToNumber(ExtractUserKey(internal_key));
+  const Leaf& leaf = leaves_[root_.Predict(x, 0, leaves_.size() - 1)];
+  size_t lo = leaf.begin;
+  size_t hi = leaf.end;
+  if (lo < hi) {
+    // A prediction for x is within max_error of the first key not less than
+    // x, since predictions are monotonic and exact up to that error for the
+    // keys on either side of it.
+    size_t guess = leaf.model.Predict(x, leaf.begin, leaf.end);
+    lo = std::max(lo, guess > leaf.max_error ? guess - leaf.max_error : 0);
+    hi = std::min(hi, guess + leaf.max_error + 1);
+  }
+  const uint64_t* nums = nums_.data();
+  lo = std::lower_bound(nums + lo, nums + hi, x) - nums;
+  if (lo == n || nums[lo] != x) {
+    return lo;
+  }
+  // Keys sharing the 8-byte prefix are told apart by the comparator. Gallop
+  // to the end of their run first, which is usually close.
+  size_t last_equal = lo;
+  hi = lo + 1;
+  for (size_t step = 1; hi < n && nums[hi] == x; step *= 2) {
+    last_equal = hi;
+    hi = std::min(n, hi + step);
+  }
+  hi = std::upper_bound(nums + last_equal, nums + hi, x) - nums;
+  return Search(internal_key, upper, lo, hi);
+}
+
+bool LearnedSortedArrayRep::Contains(const char* key) const {
+  Slice internal_key = GetLengthPrefixedSlice(key);
+  size_t i = Find(internal_key, false);
+  return i < entries_.size() && compare_(entries_[i], internal_key) == 0;
+}
+
+void LearnedSortedArrayRep::Get(const LookupKey& k, void* callback_args,
+                                bool (*callback_func)(void* arg,
+                                                      const char* entry)) {
+  for (size_t i = Find(k.internal_key(), false);
+       i < entries_.size() && callback_func(callback_args, entries_[i]);
+       i++) {
+  }
+}
+
+uint64_t LearnedSortedArrayRep::ApproximateNumEntries(const Slice& start_ikey,
+                                                      const Slice& end_ikey) {
+  size_t start = Find(start_ikey, false);
+  size_t end = Find(end_ikey, false);
+  return end > start ? end - start : 0;
+}
+
+class LearnedSortedArrayRep::Iterator : public MemTableRep::Iterator {
+ public:
+  explicit Iterator(const LearnedSortedArrayRep* rep)
+      : rep_(rep), n_(rep->entries_.size()), pos_(n_) {}
+
+  virtual ~Iterator() override {}
+
+  virtual bool Valid() const override { return pos_ < n_; }
+
+  virtual const char* key() const override {
+    assert(Valid());
+    return rep_->entries_[pos_];
+  }
+
+  virtual void Next() override {
+    assert(Valid());
+    pos_++;
+  }
+
+  virtual void Prev() override {
+    assert(Valid());
+    pos_ = pos_ == 0 ? n_ : pos_ - 1;
+  }
+
+  virtual void Seek(const Slice& internal_key,
+                    const char* memtable_key) override {
+    pos_ = rep_->Find(internal_key, false);
+  }
+
+  virtual void SeekForPrev(const Slice& internal_key,
+                           const char* memtable_key) override {
+    size_t upper = rep_->Find(internal_key, true);
+    pos_ = upper == 0 ? n_ : upper - 1;
+  }
+
+  virtual void SeekToFirst() override { pos_ = 0; }
+
+  virtual void SeekToLast() override { pos_ = n_ == 0 ? 0 : n_ - 1; }
+
+ private:
+  const LearnedSortedArrayRep* const rep_;
+  const size_t n_;
+  size_t pos_;
+};
+
+MemTableRep::Iterator* LearnedSortedArrayRep::GetIterator(Arena* arena) {
+  if (arena == nullptr) {
+    return new Iterator(this);
+  }
+  char* mem = arena->AllocateAligned(sizeof(Iterator));
+  return new (mem) Iterator(this);
+}
+
+}  // anon namespace
+
+MemTableRep* NewLearnedSortedArrayRep(const MemTableRep::KeyComparator& compare,
+                                      const Comparator* user_comparator,
+                                      MemTableAllocator* allocator,
+                                      MemTableRep* source) {
+  return new LearnedSortedArrayRep(compare, user_comparator, allocator,
+                                   source);
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,24 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+#include "rocksdb/memtablerep.h"
+
+namespace rocksdb {
+
+class Comparator;
+
+// Returns a read-only MemTableRep holding the entries of `source` in one
+// sorted array, searched through a two-level learned model of the first 8
+// bytes of their user keys. The model only orders keys like
+// BytewiseComparator(); under any other `user_comparator` the array is binary
+// searched instead. Entries are not copied: `source` must already be
+// read-only and must outlive the returned rep.
+extern MemTableRep* NewLearnedSortedArrayRep(
+    const MemTableRep::KeyComparator& compare,
+    const Comparator* user_comparator, MemTableAllocator* allocator,
+    MemTableRep* source);
+
+}  // namespace rocksdb
@@ -0,0 +1,307 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "memtable/learned_sorted_array_rep.h"
+
+#include <math.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "db/dbformat.h"
+#include "db/memtable.h"
+#include "memtable/memtable_allocator.h"
+#include "port/stack_trace.h"
+#include "rocksdb/comparator.h"
+#include "rocksdb/write_buffer_manager.h"
+#include "util/arena.h"
+#include "util/coding.h"
+#include "util/random.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+namespace {
+
+std::string BigEndianKey(uint64_t key) {
+  std::string result(8, '\0');
+  for (int i = 7; i >= 0; i--) {
+    result[i] = static_cast<char>(key & 0xff);
+    key >>= 8;
+  }
+  return result;
+}
+
+bool FirstEntry(void* arg, const char* entry) {
+  *static_cast<const char**>(arg) = entry;
+  return false;
+}
+
+}  // namespace
+
+class LearnedSortedArrayRepTest : public testing::Test {
+ public:
+  LearnedSortedArrayRepTest()
+      : write_buffer_manager_(0), allocator_(&arena_, &write_buffer_manager_) {
+    Open(BytewiseComparator());
+  }
+
+  void Open(const Comparator* user_comparator) {
+    rep_.reset();
+    source_.reset();
+    expected_.clear();
+    internal_comparator_.reset(new InternalKeyComparator(user_comparator));
+    key_comparator_.reset(new MemTable::KeyComparator(*internal_comparator_));
+    source_.reset(SkipListFactory().CreateMemTableRep(
+        *key_comparator_, &allocator_, nullptr, nullptr));
+  }
+
+  // Builds the memtable entry for (user_key, seq) with an empty value.
+  const char* NewEntry(const Slice& user_key, SequenceNumber seq) {
+    InternalKey internal_key(user_key, seq, kTypeValue);
+    Slice encoded = internal_key.Encode();
+    uint32_t key_size = static_cast<uint32_t>(encoded.size());
+    char* buf = nullptr;
+    source_->Allocate(VarintLength(key_size) + key_size + VarintLength(0),
+                      &buf);
+    char* p = EncodeVarint32(buf, key_size);
+    memcpy(p, encoded.data(), key_size);
+    EncodeVarint32(p + key_size, 0);
+    return buf;
+  }
+
+  void Add(const Slice& user_key, SequenceNumber seq) {
+    const char* entry = NewEntry(user_key, seq);
+    if (source_->Contains(entry)) {
+      return;
+    }
+    source_->Insert(const_cast<char*>(entry));
+    expected_.push_back(entry);
+  }
+
+  void Build() {
+    source_->MarkReadOnly();
+    rep_.reset(NewLearnedSortedArrayRep(
+        *key_comparator_, internal_comparator_->user_comparator(), &allocator_,
+        source_.get()));
+    const MemTableRep::KeyComparator& compare = *key_comparator_;
+    std::sort(expected_.begin(), expected_.end(),
+              [&](const char* a, const char* b) { return compare(a, b) < 0; });
+  }
+
+  void Validate() {
+    Build();
+    for (const char* entry : expected_) {
+      ASSERT_TRUE(rep_->Contains(entry));
+    }
+
+    std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator());
+    ASSERT_FALSE(iter->Valid());
+    iter->SeekToFirst();
+    for (const char* entry : expected_) {
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(entry, iter->key());
+      iter->Next();
+    }
+    ASSERT_FALSE(iter->Valid());
+
+    iter->SeekToLast();
+    for (size_t i = expected_.size(); i-- > 0;) {
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(expected_[i], iter->key());
+      iter->Prev();
+    }
+    ASSERT_FALSE(iter->Valid());
+
+    for (const char* entry : expected_) {
+      Slice internal_key = GetLengthPrefixedSlice(entry);
+      iter->Seek(internal_key, entry);
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(entry, iter->key());
+      iter->SeekForPrev(internal_key, entry);
+      ASSERT_TRUE(iter->Valid());
+      ASSERT_EQ(entry, iter->key());
+
+      LookupKey lookup_key(ExtractUserKey(internal_key),
+                           GetInternalKeySeqno(internal_key));
+      const char* found = nullptr;
+      rep_->Get(lookup_key, &found, FirstEntry);
+      ASSERT_EQ(entry, found);
+    }
+  }
+
+  // Checks Seek() and SeekForPrev() against the sorted entries for keys that
+  // are not in the rep.
+  void ValidateMissing(const std::vector<std::string>& user_keys) {
+    const MemTableRep::KeyComparator& compare = *key_comparator_;
+    std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator());
+    for (const std::string& user_key : user_keys) {
+      InternalKey target(user_key, kMaxSequenceNumber, kValueTypeForSeek);
+      Slice internal_key = target.Encode();
+      auto lower = std::partition_point(
+          expected_.begin(), expected_.end(),
+          [&](const char* e) { return compare(e, internal_key) < 0; });
+      iter->Seek(internal_key, nullptr);
+      if (lower == expected_.end()) {
+        ASSERT_FALSE(iter->Valid());
+      } else {
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(*lower, iter->key());
+      }
+      iter->SeekForPrev(internal_key, nullptr);
+      if (lower == expected_.begin()) {
+        ASSERT_FALSE(iter->Valid());
+      } else {
+        ASSERT_TRUE(iter->Valid());
+        ASSERT_EQ(*(lower - 1), iter->key());
+      }
+    }
+  }
+
+  Arena arena_;
+  WriteBufferManager write_buffer_manager_;
+  MemTableAllocator allocator_;
+  std::unique_ptr<InternalKeyComparator> internal_comparator_;
+  std::unique_ptr<MemTable::KeyComparator> key_comparator_;
+  std::unique_ptr<MemTableRep> source_;
+  std::unique_ptr<MemTableRep> rep_;
+  std::vector<const char*> expected_;
+};
+
+TEST_F(LearnedSortedArrayRepTest, Empty) {
+  Build();
+  std::unique_ptr<MemTableRep::Iterator> iter(rep_->GetIterator());
+  iter->SeekToFirst();
+  ASSERT_FALSE(iter->Valid());
+  iter->SeekToLast();
+  ASSERT_FALSE(iter->Valid());
+  const char* entry = NewEntry(BigEndianKey(1), 1);
+  iter->Seek(GetLengthPrefixedSlice(entry), entry);
+  ASSERT_FALSE(iter->Valid());
+  ASSERT_FALSE(rep_->Contains(entry));
+  ASSERT_EQ(0U, rep_->ApproximateMemoryUsage());
+}
+
+TEST_F(LearnedSortedArrayRepTest, RandomIntegerKeys) {
+  Random64 rnd(301);
+  for (SequenceNumber seq = 1; seq <= 20000; seq++) {
+    Add(BigEndianKey(rnd.Next()), seq);
+  }
+  Validate();
+  std::vector<std::string> missing;
+  for (int i = 0; i < 2000; i++) {
+    missing.push_back(BigEndianKey(rnd.Next()));
+  }
+  missing.push_back(BigEndianKey(0));
+  missing.push_back(BigEndianKey(~0ULL));
+  ValidateMissing(missing);
+}
+
+TEST_F(LearnedSortedArrayRepTest, SkewedKeysWithVersions) {
+  // Exponentially spaced clusters, which one straight line fits badly.
+  Random64 rnd(301);
+  SequenceNumber seq = 0;
+  std::vector<std::string> missing;
+  for (int i = 0; i < 20000; i++) {
+    uint64_t key = static_cast<uint64_t>(exp(rnd.Uniform(40000) / 1000.0));
+    Add(BigEndianKey(key), ++seq);
+    if (i % 5 == 0) {
+      Add(BigEndianKey(key), ++seq);
+    }
+    missing.push_back(BigEndianKey(key + 1));
+  }
+  Validate();
+  ValidateMissing(missing);
+
+  // All versions of a user key are visited newest first.
+  Slice first = ExtractUserKey(GetLengthPrefixedSlice(expected_[0]));
+  LookupKey lookup_key(first, kMaxSequenceNumber);
+  const char* found = nullptr;
+  rep_->Get(lookup_key, &found, FirstEntry);
+  ASSERT_EQ(expected_[0], found);
+}
+
+TEST_F(LearnedSortedArrayRepTest, KeysBeyondModelPrefix) {
+  // The first 8 bytes are identical, so the model cannot tell keys apart.
+  Random rnd(301);
+  char buf[32];
+  std::vector<std::string> missing;
+  for (SequenceNumber seq = 1; seq <= 5000; seq++) {
+    snprintf(buf, sizeof(buf), "shared_prefix_%08u",
+             static_cast<unsigned>(rnd.Uniform(1000000)));
+    Add(buf, seq);
+    missing.push_back(std::string(buf) + "0");
+  }
+  Validate();
+  missing.push_back("shared");
+  missing.push_back("shared_prefix_~");
+  ValidateMissing(missing);
+}
+
+TEST_F(LearnedSortedArrayRepTest, ReverseComparator) {
+  Open(ReverseBytewiseComparator());
+  Random64 rnd(301);
+  std::vector<std::string> missing;
+  for (SequenceNumber seq = 1; seq <= 5000; seq++) {
+    Add(BigEndianKey(rnd.Next()), seq);
+    missing.push_back(BigEndianKey(rnd.Next()));
+  }
+  Validate();
+  ValidateMissing(missing);
+}
+
+// The key prefixes of a single entry, or of entries sharing their first 8
+// bytes, are ordered under any comparator. That must not lead the searches
+// to order keys bytewise.
+TEST_F(LearnedSortedArrayRepTest, ReverseComparatorSingleEntry) {
+  Open(ReverseBytewiseComparator());
+  Add("b", 1);
+  Validate();
+  ValidateMissing({"a", "c"});
+  ASSERT_FALSE(rep_->Contains(NewEntry("a", 1)));
+  ASSERT_FALSE(rep_->Contains(NewEntry("c", 1)));
+}
+
+TEST_F(LearnedSortedArrayRepTest, ReverseComparatorSharedPrefix) {
+  Open(ReverseBytewiseComparator());
+  std::vector<std::string> missing;
+  for (char c = '1'; c <= '9'; c += 2) {
+    Add(std::string("shared_prefix_") + c, 1);
+    missing.push_back(std::string("shared_prefix_") + static_cast<char>(c - 1));
+  }
+  missing.push_back("shared_prefix_~");
+  missing.push_back("a");
+  missing.push_back("z");
+  Validate();
+  ValidateMissing(missing);
+  for (const std::string& user_key : missing) {
+    ASSERT_FALSE(rep_->Contains(NewEntry(user_key, 1)));
+  }
+}
+
+TEST_F(LearnedSortedArrayRepTest, MemoryUsageAndEstimates) {
+  const uint64_t kNumKeys = 100000;
+  for (uint64_t key = 0; key < kNumKeys; key++) {
+    Add(BigEndianKey(key * 10), key + 1);
+  }
+  Build();
+  // An entry pointer and its key prefix per entry, plus the leaf models.
+  size_t usage = rep_->ApproximateMemoryUsage();
+  ASSERT_GE(usage, kNumKeys * 2 * sizeof(uint64_t));
+  ASSERT_LT(usage, kNumKeys * 3 * sizeof(uint64_t));
+
+  InternalKey start(BigEndianKey(200000), kMaxSequenceNumber, kTypeValue);
+  InternalKey end(BigEndianKey(700000), kMaxSequenceNumber, kTypeValue);
+  ASSERT_EQ(50000U, rep_->ApproximateNumEntries(start.Encode(), end.Encode()));
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  rocksdb::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -64,7 +64,8 @@ DEFINE_string(memtablerep, "skiplist",
               "\tvector              -- backed by an std::vector\n"
               "\thashskiplist        -- backed by a hash skip list\n"
               "\thashlinklist        -- backed by a hash linked list\n"
-              "\tcuckoo              -- backed by a cuckoo hash table");
+              "\tcuckoo              -- backed by a cuckoo hash table\n"
+              "\tlearnedgappedarray  -- backed by learned gapped arrays");
 
 DEFINE_int64(bucket_count, 1000000,
              "bucket_count parameter to pass into NewHashSkiplistRepFactory or "
@@ -106,6 +107,10 @@ DEFINE_int64(
     hash_function_count, 4,
     "hash_function_count parameter to pass into NewHashCuckooRepFactory");
 
+DEFINE_int64(
+    max_node_entries, 4096,
+    "max_node_entries parameter to pass into NewLearnedGappedArrayRepFactory");
+
 DEFINE_int32(
     num_threads, 1,
     "Number of concurrent threads to run. If the benchmark includes writes,\n"
@@ -128,6 +133,9 @@ DEFINE_int32(prefix_length, 8,
 DEFINE_int64(vectorrep_count, 0,
              "Number of entries to reserve on VectorRep initialization");
 
+DEFINE_bool(big_endian_keys, false,
+            "Encode keys big endian so that they sort in numeric order");
+
 DEFINE_int64(seed, 0,
              "Seed base for random number generators. "
              "When 0 it is deterministic.");
@@ -237,6 +245,18 @@ class BenchmarkThread {
   RandomGenerator generator_;
 };
 
+// Writes the 8-byte user key for key to dst.
+void EncodeUserKey(char* dst, uint64_t key) {
+  if (FLAGS_big_endian_keys) {
+    for (int i = 7; i >= 0; i--) {
+      dst[i] = static_cast<char>(key & 0xff);
+      key >>= 8;
+    }
+  } else {
+    EncodeFixed64(dst, key);
+  }
+}
+
 class FillBenchmarkThread : public BenchmarkThread {
  public:
   FillBenchmarkThread(MemTableRep* table, KeyGenerator* key_gen,
@@ -254,7 +274,7 @@ class FillBenchmarkThread : public BenchmarkThread {
     assert(buf != nullptr);
     char* p = EncodeVarint32(buf, internal_key_size);
     auto key = key_gen_->Next();
-    EncodeFixed64(p, key);
+    EncodeUserKey(p, key);
     p += 8;
     EncodeFixed64(p, ++(*sequence_));
     p += 8;
@@ -320,10 +340,10 @@ class ReadBenchmarkThread : public BenchmarkThread {
   }
 
   void ReadOne() {
-    std::string user_key;
+    char user_key[8];
     auto key = key_gen_->Next();
-    PutFixed64(&user_key, key);
-    LookupKey lookup_key(user_key, *sequence_);
+    EncodeUserKey(user_key, key);
+    LookupKey lookup_key(Slice(user_key, sizeof(user_key)), *sequence_);
     InternalKeyComparator internal_key_comp(BytewiseComparator());
     CallbackVerifyArgs verify_args;
     verify_args.found = false;
@@ -612,6 +632,9 @@ int main(int argc, char** argv) {
         static_cast<uint32_t>(FLAGS_hash_function_count)));
     options.prefix_extractor.reset(
         rocksdb::NewFixedPrefixTransform(FLAGS_prefix_length));
+  } else if (FLAGS_memtablerep == "learnedgappedarray") {
+    factory.reset(rocksdb::NewLearnedGappedArrayRepFactory(
+        FLAGS_max_node_entries));
 #endif  // ROCKSDB_LITE
   } else {
     fprintf(stdout, "Unknown memtablerep: %s\n", FLAGS_memtablerep.c_str());
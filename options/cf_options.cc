@@ -170,6 +170,15 @@ void MutableCFOptions::Dump(Logger* log) const {
                  paranoid_file_checks);
   ROCKS_LOG_INFO(log, "                       report_bg_io_stats: %d",
                  report_bg_io_stats);
+  ROCKS_LOG_INFO(log, "           model_error_compaction_trigger: %f",
+                 model_error_compaction_trigger);
+  ROCKS_LOG_INFO(log, "                 model_output_split_error: %" PRIu64,
+                 model_output_split_error);
+  ROCKS_LOG_INFO(log, "               learned_immutable_memtable: %d",
+                 learned_immutable_memtable);
+  ROCKS_LOG_INFO(log,
+                 "                    level_hint_cache_size: %" ROCKSDB_PRIszt,
+                 level_hint_cache_size);
   ROCKS_LOG_INFO(log, "                              compression: %d",
                  static_cast<int>(compression));
 }
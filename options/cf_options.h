@@ -149,6 +149,10 @@ struct MutableCFOptions {
             options.max_sequential_skip_in_iterations),
         paranoid_file_checks(options.paranoid_file_checks),
         report_bg_io_stats(options.report_bg_io_stats),
+        model_error_compaction_trigger(options.model_error_compaction_trigger),
+        model_output_split_error(options.model_output_split_error),
+        learned_immutable_memtable(options.learned_immutable_memtable),
+        level_hint_cache_size(options.level_hint_cache_size),
         compression(options.compression) {
     RefreshDerivedOptions(options.num_levels, options.compaction_style);
   }
@@ -175,6 +179,10 @@ struct MutableCFOptions {
         max_sequential_skip_in_iterations(0),
         paranoid_file_checks(false),
         report_bg_io_stats(false),
+        model_error_compaction_trigger(0),
+        model_output_split_error(0),
+        learned_immutable_memtable(false),
+        level_hint_cache_size(0),
         compression(Snappy_Supported() ? kSnappyCompression : kNoCompression) {}
 
   // Must be called after any change to MutableCFOptions
@@ -223,6 +231,10 @@ struct MutableCFOptions {
   uint64_t max_sequential_skip_in_iterations;
   bool paranoid_file_checks;
   bool report_bg_io_stats;
+  double model_error_compaction_trigger;
+  uint64_t model_output_split_error;
+  bool learned_immutable_memtable;
+  size_t level_hint_cache_size;
   CompressionType compression;
 
   // Derived options
@@ -80,12 +80,18 @@ ImmutableDBOptions::ImmutableDBOptions(const DBOptions& options)
       wal_recovery_mode(options.wal_recovery_mode),
       allow_2pc(options.allow_2pc),
       row_cache(options.row_cache),
+      lookup_result_cache(options.lookup_result_cache),
 #ifndef ROCKSDB_LITE
       wal_filter(options.wal_filter),
 #endif  // ROCKSDB_LITE
       fail_if_options_file_error(options.fail_if_options_file_error),
       dump_malloc_stats(options.dump_malloc_stats),
-      avoid_flush_during_recovery(options.avoid_flush_during_recovery) {
+      avoid_flush_during_recovery(options.avoid_flush_during_recovery),
+      block_cache_warmup_persist_period_sec(
+          options.block_cache_warmup_persist_period_sec),
+      block_cache_warmup_threads(options.block_cache_warmup_threads),
+      block_cache_warmup_rate_bytes_per_sec(
+          options.block_cache_warmup_rate_bytes_per_sec) {
 }
 
 void ImmutableDBOptions::Dump(Logger* log) const {
@@ -209,12 +215,27 @@ void ImmutableDBOptions::Dump(Logger* log) const {
     ROCKS_LOG_HEADER(log,
                      "                              Options.row_cache: None");
   }
+  if (lookup_result_cache) {
+    ROCKS_LOG_HEADER(
+        log, "                    Options.lookup_result_cache: %" PRIu64,
+        lookup_result_cache->GetCapacity());
+  } else {
+    ROCKS_LOG_HEADER(
+        log, "                    Options.lookup_result_cache: None");
+  }
 #ifndef ROCKSDB_LITE
   ROCKS_LOG_HEADER(log, "                             Options.wal_filter: %s",
                    wal_filter ? wal_filter->Name() : "None");
 #endif  // ROCKDB_LITE
   ROCKS_LOG_HEADER(log, "            Options.avoid_flush_during_recovery: %d",
                    avoid_flush_during_recovery);
+  ROCKS_LOG_HEADER(log, "  Options.block_cache_warmup_persist_period_sec: %u",
+                   block_cache_warmup_persist_period_sec);
+  ROCKS_LOG_HEADER(log, "             Options.block_cache_warmup_threads: %d",
+                   block_cache_warmup_threads);
+  ROCKS_LOG_HEADER(log,
+                   "  Options.block_cache_warmup_rate_bytes_per_sec: %" PRIu64,
+                   block_cache_warmup_rate_bytes_per_sec);
 }
 
 MutableDBOptions::MutableDBOptions()
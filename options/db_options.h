@@ -72,12 +72,16 @@ struct ImmutableDBOptions {
   WALRecoveryMode wal_recovery_mode;
   bool allow_2pc;
   std::shared_ptr<Cache> row_cache;
+  std::shared_ptr<Cache> lookup_result_cache;
 #ifndef ROCKSDB_LITE
   WalFilter* wal_filter;
 #endif  // ROCKSDB_LITE
   bool fail_if_options_file_error;
   bool dump_malloc_stats;
   bool avoid_flush_during_recovery;
+  unsigned int block_cache_warmup_persist_period_sec;
+  int block_cache_warmup_threads;
+  uint64_t block_cache_warmup_rate_bytes_per_sec;
 };
 
 struct MutableDBOptions {
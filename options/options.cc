@@ -85,7 +85,11 @@ AdvancedColumnFamilyOptions::AdvancedColumnFamilyOptions(const Options& options)
       optimize_filters_for_hits(options.optimize_filters_for_hits),
       paranoid_file_checks(options.paranoid_file_checks),
       force_consistency_checks(options.force_consistency_checks),
-      report_bg_io_stats(options.report_bg_io_stats) {
+      report_bg_io_stats(options.report_bg_io_stats),
+      model_error_compaction_trigger(options.model_error_compaction_trigger),
+      model_output_split_error(options.model_output_split_error),
+      learned_immutable_memtable(options.learned_immutable_memtable),
+      level_hint_cache_size(options.level_hint_cache_size) {
   assert(memtable_factory.get() != nullptr);
   if (max_bytes_for_level_multiplier_additional.size() <
       static_cast<unsigned int>(num_levels)) {
@@ -182,12 +186,18 @@ DBOptions::DBOptions(const Options& options)
       skip_stats_update_on_db_open(options.skip_stats_update_on_db_open),
       wal_recovery_mode(options.wal_recovery_mode),
       row_cache(options.row_cache),
+      lookup_result_cache(options.lookup_result_cache),
 #ifndef ROCKSDB_LITE
       wal_filter(options.wal_filter),
 #endif  // ROCKSDB_LITE
       fail_if_options_file_error(options.fail_if_options_file_error),
       dump_malloc_stats(options.dump_malloc_stats),
       avoid_flush_during_recovery(options.avoid_flush_during_recovery),
+      block_cache_warmup_persist_period_sec(
+          options.block_cache_warmup_persist_period_sec),
+      block_cache_warmup_threads(options.block_cache_warmup_threads),
+      block_cache_warmup_rate_bytes_per_sec(
+          options.block_cache_warmup_rate_bytes_per_sec),
       avoid_flush_during_shutdown(options.avoid_flush_during_shutdown) {
 }
 
@@ -385,6 +395,16 @@ void ColumnFamilyOptions::Dump(Logger* log) const {
                      force_consistency_checks);
     ROCKS_LOG_HEADER(log, "               Options.report_bg_io_stats: %d",
                      report_bg_io_stats);
+    ROCKS_LOG_HEADER(log, "   Options.model_error_compaction_trigger: %f",
+                     model_error_compaction_trigger);
+    ROCKS_LOG_HEADER(log,
+                     "         Options.model_output_split_error: %" PRIu64,
+                     model_output_split_error);
+    ROCKS_LOG_HEADER(log, "       Options.learned_immutable_memtable: %d",
+                     learned_immutable_memtable);
+    ROCKS_LOG_HEADER(
+        log, "            Options.level_hint_cache_size: %" ROCKSDB_PRIszt,
+        level_hint_cache_size);
 }  // ColumnFamilyOptions::Dump
 
 void Options::Dump(Logger* log) const {
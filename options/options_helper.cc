@@ -107,6 +107,7 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.wal_recovery_mode = immutable_db_options.wal_recovery_mode;
   options.allow_2pc = immutable_db_options.allow_2pc;
   options.row_cache = immutable_db_options.row_cache;
+  options.lookup_result_cache = immutable_db_options.lookup_result_cache;
 #ifndef ROCKSDB_LITE
   options.wal_filter = immutable_db_options.wal_filter;
 #endif  // ROCKSDB_LITE
@@ -115,6 +116,12 @@ DBOptions BuildDBOptions(const ImmutableDBOptions& immutable_db_options,
   options.dump_malloc_stats = immutable_db_options.dump_malloc_stats;
   options.avoid_flush_during_recovery =
       immutable_db_options.avoid_flush_during_recovery;
+  options.block_cache_warmup_persist_period_sec =
+      immutable_db_options.block_cache_warmup_persist_period_sec;
+  options.block_cache_warmup_threads =
+      immutable_db_options.block_cache_warmup_threads;
+  options.block_cache_warmup_rate_bytes_per_sec =
+      immutable_db_options.block_cache_warmup_rate_bytes_per_sec;
   options.avoid_flush_during_shutdown =
       mutable_db_options.avoid_flush_during_shutdown;
 
@@ -166,6 +173,13 @@ ColumnFamilyOptions BuildColumnFamilyOptions(
       mutable_cf_options.max_sequential_skip_in_iterations;
   cf_opts.paranoid_file_checks = mutable_cf_options.paranoid_file_checks;
   cf_opts.report_bg_io_stats = mutable_cf_options.report_bg_io_stats;
+  cf_opts.model_error_compaction_trigger =
+      mutable_cf_options.model_error_compaction_trigger;
+  cf_opts.model_output_split_error =
+      mutable_cf_options.model_output_split_error;
+  cf_opts.learned_immutable_memtable =
+      mutable_cf_options.learned_immutable_memtable;
+  cf_opts.level_hint_cache_size = mutable_cf_options.level_hint_cache_size;
   cf_opts.compression = mutable_cf_options.compression;
 
   cf_opts.table_factory = options.table_factory;
@@ -1201,6 +1215,15 @@ Status GetMemTableRepFactoryFromString(const std::string& opts_str,
       return Status::InvalidArgument("Can't parse memtable_factory option ",
                                      opts_str);
     }
+  } else if (opts_list[0] == "learned_gapped_array") {
+    // Expecting format
+    // learned_gapped_array:<max_node_entries>
+    if (2 == len) {
+      size_t max_node_entries = ParseSizeT(opts_list[1]);
+      mem_factory = NewLearnedGappedArrayRepFactory(max_node_entries);
+    } else if (1 == len) {
+      mem_factory = NewLearnedGappedArrayRepFactory();
+    }
   } else {
     return Status::InvalidArgument("Unrecognized memtable_factory option ",
                                    opts_str);
@@ -140,6 +140,7 @@ static std::unordered_map<std::string, OptionTypeInfo> db_options_type_info = {
      // not yet supported
       Env* env;
       std::shared_ptr<Cache> row_cache;
+      std::shared_ptr<Cache> lookup_result_cache;
       std::shared_ptr<DeleteScheduler> delete_scheduler;
       std::shared_ptr<Logger> info_log;
       std::shared_ptr<RateLimiter> rate_limiter;
@@ -326,6 +327,15 @@ static std::unordered_map<std::string, OptionTypeInfo> db_options_type_info = {
     {"avoid_flush_during_recovery",
      {offsetof(struct DBOptions, avoid_flush_during_recovery),
       OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+    {"block_cache_warmup_persist_period_sec",
+     {offsetof(struct DBOptions, block_cache_warmup_persist_period_sec),
+      OptionType::kUInt, OptionVerificationType::kNormal, false, 0}},
+    {"block_cache_warmup_threads",
+     {offsetof(struct DBOptions, block_cache_warmup_threads), OptionType::kInt,
+      OptionVerificationType::kNormal, false, 0}},
+    {"block_cache_warmup_rate_bytes_per_sec",
+     {offsetof(struct DBOptions, block_cache_warmup_rate_bytes_per_sec),
+      OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
     {"avoid_flush_during_shutdown",
      {offsetof(struct DBOptions, avoid_flush_during_shutdown),
       OptionType::kBoolean, OptionVerificationType::kNormal, true,
@@ -498,6 +508,22 @@ static std::unordered_map<std::string, OptionTypeInfo> cf_options_type_info = {
      {offset_of(&ColumnFamilyOptions::max_sequential_skip_in_iterations),
       OptionType::kUInt64T, OptionVerificationType::kNormal, true,
       offsetof(struct MutableCFOptions, max_sequential_skip_in_iterations)}},
+    {"model_error_compaction_trigger",
+     {offset_of(&ColumnFamilyOptions::model_error_compaction_trigger),
+      OptionType::kDouble, OptionVerificationType::kNormal, true,
+      offsetof(struct MutableCFOptions, model_error_compaction_trigger)}},
+    {"model_output_split_error",
+     {offset_of(&ColumnFamilyOptions::model_output_split_error),
+      OptionType::kUInt64T, OptionVerificationType::kNormal, true,
+      offsetof(struct MutableCFOptions, model_output_split_error)}},
+    {"learned_immutable_memtable",
+     {offset_of(&ColumnFamilyOptions::learned_immutable_memtable),
+      OptionType::kBoolean, OptionVerificationType::kNormal, true,
+      offsetof(struct MutableCFOptions, learned_immutable_memtable)}},
+    {"level_hint_cache_size",
+     {offset_of(&ColumnFamilyOptions::level_hint_cache_size),
+      OptionType::kSizeT, OptionVerificationType::kNormal, true,
+      offsetof(struct MutableCFOptions, level_hint_cache_size)}},
     {"target_file_size_base",
      {offset_of(&ColumnFamilyOptions::target_file_size_base),
       OptionType::kUInt64T, OptionVerificationType::kNormal, true,
@@ -627,7 +653,30 @@ static std::unordered_map<std::string, OptionTypeInfo>
           OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
         {"read_amp_bytes_per_bit",
          {offsetof(struct BlockBasedTableOptions, read_amp_bytes_per_bit),
-          OptionType::kSizeT, OptionVerificationType::kNormal, false, 0}}};
+          OptionType::kSizeT, OptionVerificationType::kNormal, false, 0}},
+        {"compact_learned_model",
+         {offsetof(struct BlockBasedTableOptions, compact_learned_model),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"learned_leaf_max_error",
+         {offsetof(struct BlockBasedTableOptions, learned_leaf_max_error),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
+        {"model_offset_max_error",
+         {offsetof(struct BlockBasedTableOptions, model_offset_max_error),
+          OptionType::kUInt64T, OptionVerificationType::kNormal, false, 0}},
+        {"cache_learned_model_blocks",
+         {offsetof(struct BlockBasedTableOptions, cache_learned_model_blocks),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"pin_l0_learned_model_in_cache",
+         {offsetof(struct BlockBasedTableOptions,
+                   pin_l0_learned_model_in_cache),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"demote_evicted_blocks",
+         {offsetof(struct BlockBasedTableOptions, demote_evicted_blocks),
+          OptionType::kBoolean, OptionVerificationType::kNormal, false, 0}},
+        {"demoted_block_compression",
+         {offsetof(struct BlockBasedTableOptions, demoted_block_compression),
+          OptionType::kCompressionType, OptionVerificationType::kNormal, false,
+          0}}};
 
 static std::unordered_map<std::string, OptionTypeInfo> plain_table_type_info = {
     {"user_key_len",
@@ -108,6 +108,8 @@ TEST_F(OptionsSettableTest, BlockBasedTableOptionsAllFieldsSettable) {
        sizeof(std::shared_ptr<Cache>)},
       {offsetof(struct BlockBasedTableOptions, filter_policy),
        sizeof(std::shared_ptr<const FilterPolicy>)},
+      {offsetof(struct BlockBasedTableOptions, block_cache_tracer),
+       sizeof(std::shared_ptr<BlockCacheTracer>)},
   };
 
   // In this test, we catch a new option of BlockBasedTableOptions that is not
@@ -161,7 +163,11 @@ TEST_F(OptionsSettableTest, BlockBasedTableOptionsAllFieldsSettable) {
       "filter_policy=bloomfilter:4:true;whole_key_filtering=1;"
       "format_version=1;"
       "hash_index_allow_collision=false;"
-      "verify_compression=true;read_amp_bytes_per_bit=0",
+      "verify_compression=true;read_amp_bytes_per_bit=0;"
+      "compact_learned_model=true;learned_leaf_max_error=4096;"
+      "model_offset_max_error=65536;cache_learned_model_blocks=true;"
+      "pin_l0_learned_model_in_cache=true;demote_evicted_blocks=true;"
+      "demoted_block_compression=kZSTD",
       new_bbto));
 
   ASSERT_EQ(unset_bytes_base,
@@ -205,6 +211,8 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
       {offsetof(struct DBOptions, listeners),
        sizeof(std::vector<std::shared_ptr<EventListener>>)},
       {offsetof(struct DBOptions, row_cache), sizeof(std::shared_ptr<Cache>)},
+      {offsetof(struct DBOptions, lookup_result_cache),
+       sizeof(std::shared_ptr<Cache>)},
       {offsetof(struct DBOptions, wal_filter), sizeof(const WalFilter*)},
   };
 
@@ -289,6 +297,9 @@ TEST_F(OptionsSettableTest, DBOptionsAllFieldsSettable) {
                              "dump_malloc_stats=false;"
                              "allow_2pc=false;"
                              "avoid_flush_during_recovery=false;"
+                             "block_cache_warmup_persist_period_sec=600;"
+                             "block_cache_warmup_threads=4;"
+                             "block_cache_warmup_rate_bytes_per_sec=1048576;"
                              "avoid_flush_during_shutdown=false;",
                              new_options));
 
@@ -432,7 +443,11 @@ TEST_F(OptionsSettableTest, ColumnFamilyOptionsAllFieldsSettable) {
       "purge_redundant_kvs_while_flush=true;"
       "hard_pending_compaction_bytes_limit=0;"
       "disable_auto_compactions=false;"
-      "report_bg_io_stats=true;",
+      "report_bg_io_stats=true;"
+      "model_error_compaction_trigger=0.25;"
+      "model_output_split_error=4096;"
+      "learned_immutable_memtable=true;"
+      "level_hint_cache_size=1024;",
       new_options));
 
   ASSERT_EQ(unset_bytes_base,
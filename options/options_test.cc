@@ -568,6 +568,15 @@ TEST_F(OptionsTest, GetMemTableRepFactoryFromString) {
   ASSERT_OK(GetMemTableRepFactoryFromString("cuckoo:1024", &new_mem_factory));
   ASSERT_EQ(std::string(new_mem_factory->Name()), "HashCuckooRepFactory");
 
+  ASSERT_OK(GetMemTableRepFactoryFromString("learned_gapped_array",
+                                            &new_mem_factory));
+  ASSERT_OK(GetMemTableRepFactoryFromString("learned_gapped_array:1024",
+                                            &new_mem_factory));
+  ASSERT_EQ(std::string(new_mem_factory->Name()),
+            "LearnedGappedArrayRepFactory");
+  ASSERT_NOK(GetMemTableRepFactoryFromString(
+      "learned_gapped_array:1024:invalid_opt", &new_mem_factory));
+
   ASSERT_NOK(GetMemTableRepFactoryFromString("bad_factory", &new_mem_factory));
 }
 #endif  // !ROCKSDB_LITE
@@ -135,6 +135,16 @@ class Mutex {
 #endif
   }
 
+  bool TryLock() {
+    if (!mutex_.try_lock()) {
+      return false;
+    }
+#ifndef NDEBUG
+    locked_ = true;
+#endif
+    return true;
+  }
+
   void Unlock() {
 #ifndef NDEBUG
     locked_ = false;
@@ -0,0 +1,253 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#ifndef GFLAGS
+#include <cstdio>
+int main() {
+  fprintf(stderr, "Please install gflags to run rocksdb tools\n");
+  return 1;
+}
+#else
+
+#include <gflags/gflags.h>
+
+#include <inttypes.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rmi/learned_index.h"
+#include "rmi/rmi_kernel.h"
+#include "rocksdb/env.h"
+
+using GFLAGS::ParseCommandLineFlags;
+using GFLAGS::SetUsageMessage;
+
+DEFINE_int64(num_keys, 1000000, "Number of keys to train each model on");
+DEFINE_string(leaf_models, "1,100,1000,10000",
+              "Comma-separated list of second-stage model counts to try");
+DEFINE_string(distributions, "sequential,uniform,lognormal,clustered",
+              "Comma-separated list of key distributions to try. "
+              "sequential: evenly spaced; uniform: random 64-bit; "
+              "lognormal: lognormally distributed; clustered: bursts of "
+              "close keys separated by large gaps");
+DEFINE_int64(bytes_per_key, 0,
+             "If positive, train on cumulative byte offsets of entries this "
+             "size, as BlockBasedTableBuilder does, instead of key ranks");
+DEFINE_int64(predict_ops, 1000000, "Number of single-key predictions");
+DEFINE_int32(batch_size, 64,
+             "Number of sorted keys predicted back to back in a batch");
+DEFINE_int64(seed, 301, "Seed for key generation");
+
+namespace rocksdb {
+
+namespace {
+
+typedef LearnedRangeIndexSingleKey<uint64_t, float> LearnedIndex;
+
+// Receives the sum of all predictions so the timed loops are not optimized
+// away.
+volatile uint64_t prediction_sink;
+
+std::vector<std::string> SplitList(const std::string& list) {
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+// Returns sorted, distinct keys, or an empty vector for an unknown name.
+std::vector<uint64_t> GenerateKeys(const std::string& distribution,
+                                   uint64_t n) {
+  std::mt19937_64 rng(FLAGS_seed);
+  std::vector<uint64_t> keys;
+  if (distribution == "sequential") {
+    for (uint64_t i = 0; i < n; i++) {
+      keys.push_back(1000 + i * 16);
+    }
+    return keys;
+  }
+
+  std::set<uint64_t> unique_keys;
+  if (distribution == "uniform") {
+    while (unique_keys.size() < n) {
+      unique_keys.insert(rng());
+    }
+  } else if (distribution == "lognormal") {
+    std::lognormal_distribution<double> dist(0.0, 2.0);
+    while (unique_keys.size() < n) {
+      unique_keys.insert(static_cast<uint64_t>(
+          std::min(dist(rng) * 1e9, 1.8e19)));
+    }
+  } else if (distribution == "clustered") {
+    const uint64_t kBurst = 1000;
+    uint64_t base = 0;
+    while (unique_keys.size() < n) {
+      base += 1000000000 + rng() % 1000000000;
+      uint64_t key = base;
+      for (uint64_t i = 0; i < kBurst && unique_keys.size() < n; i++) {
+        key += 1 + rng() % 64;
+        unique_keys.insert(key);
+      }
+    }
+  } else {
+    return keys;
+  }
+  keys.assign(unique_keys.begin(), unique_keys.end());
+  return keys;
+}
+
+RMIConfig MakeConfig(unsigned leaf_models) {
+  RMIConfig rmi_config;
+  RMIConfig::StageConfig first, second;
+  first.model_type = RMIConfig::StageConfig::LinearRegression;
+  first.model_n = 1;
+  second.model_type = RMIConfig::StageConfig::LinearRegression;
+  second.model_n = leaf_models;
+  rmi_config.stage_configs.push_back(first);
+  rmi_config.stage_configs.push_back(second);
+  return rmi_config;
+}
+
+void RunOne(const std::string& distribution, const std::vector<uint64_t>& keys,
+            unsigned leaf_models) {
+  Env* env = Env::Default();
+  std::vector<uint64_t> positions(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    positions[i] = FLAGS_bytes_per_key > 0 ? (i + 1) * FLAGS_bytes_per_key : i;
+  }
+
+  LearnedIndex index(MakeConfig(leaf_models));
+  uint64_t start = env->NowNanos();
+  for (size_t i = 0; i < keys.size(); i++) {
+    index.insert(keys[i], positions[i]);
+  }
+  index.finish_insert();
+  index.finish_train();
+  uint64_t train_nanos = std::max<uint64_t>(env->NowNanos() - start, 1);
+
+  std::string serialized;
+  index.serialize(serialized);
+
+  uint64_t max_error = 0;
+  double total_error = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    uint64_t predicted = index.get(keys[i]);
+    uint64_t error = predicted > positions[i] ? predicted - positions[i]
+                                              : positions[i] - predicted;
+    max_error = std::max(max_error, error);
+    total_error += error;
+  }
+
+  std::mt19937_64 rng(FLAGS_seed);
+  std::vector<uint64_t> probes(std::max<int64_t>(FLAGS_predict_ops, 1));
+  for (auto& probe : probes) {
+    probe = keys[rng() % keys.size()];
+  }
+  uint64_t sink = 0;
+  start = env->NowNanos();
+  for (uint64_t probe : probes) {
+    sink += index.get(probe);
+  }
+  double predict_nanos =
+      static_cast<double>(env->NowNanos() - start) / probes.size();
+
+  // Same probes through the specialized kernel, if the leaf count has one.
+  std::unique_ptr<RMIKernel> kernel = NewRMIKernel(index.rmi);
+  char kernel_nanos[16] = "-";
+  if (kernel != nullptr) {
+    start = env->NowNanos();
+    for (uint64_t probe : probes) {
+      sink += kernel->Predict(probe);
+    }
+    snprintf(kernel_nanos, sizeof(kernel_nanos), "%.1f",
+             static_cast<double>(env->NowNanos() - start) / probes.size());
+  }
+
+  size_t batch_size = static_cast<size_t>(std::max(FLAGS_batch_size, 1));
+  size_t num_batches = std::max<size_t>(probes.size() / batch_size, 1);
+  std::vector<std::vector<uint64_t>> batches(num_batches);
+  for (size_t b = 0; b < num_batches; b++) {
+    for (size_t i = 0; i < batch_size; i++) {
+      batches[b].push_back(probes[(b * batch_size + i) % probes.size()]);
+    }
+    std::sort(batches[b].begin(), batches[b].end());
+  }
+  start = env->NowNanos();
+  for (const auto& batch : batches) {
+    for (uint64_t probe : batch) {
+      sink += index.get(probe);
+    }
+  }
+  double batch_nanos =
+      static_cast<double>(env->NowNanos() - start) / num_batches;
+  prediction_sink = sink;
+
+  fprintf(stdout,
+          "%-12s %8u %12.0f %10.1f %10s %12.1f %10" ROCKSDB_PRIszt
+          " %14" PRIu64 " %14.1f\n",
+          distribution.c_str(), leaf_models,
+          keys.size() * 1e9 / train_nanos, predict_nanos, kernel_nanos,
+          batch_nanos,
+          serialized.size(), max_error, total_error / keys.size());
+}
+
+}  // namespace
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  SetUsageMessage(std::string("\nUSAGE:\n") + std::string(argv[0]) +
+                  " [OPTIONS]...");
+  ParseCommandLineFlags(&argc, &argv, true);
+
+  std::vector<unsigned> leaf_counts;
+  for (const auto& item : rocksdb::SplitList(FLAGS_leaf_models)) {
+    int leaf_models = atoi(item.c_str());
+    if (leaf_models <= 0) {
+      fprintf(stderr, "Invalid --leaf_models entry '%s'\n", item.c_str());
+      return 1;
+    }
+    leaf_counts.push_back(static_cast<unsigned>(leaf_models));
+  }
+  if (FLAGS_num_keys <= 0) {
+    fprintf(stderr, "--num_keys must be positive\n");
+    return 1;
+  }
+
+  fprintf(stdout, "Keys:       %" PRIi64 "\n", FLAGS_num_keys);
+  fprintf(stdout, "Positions:  %s\n",
+          FLAGS_bytes_per_key > 0 ? "byte offsets" : "ranks");
+  fprintf(stdout, "%-12s %8s %12s %10s %10s %12s %10s %14s %14s\n", "keys",
+          "leaves", "train keys/s", "predict ns", "kernel ns", "batch ns",
+          "bytes", "max error", "mean error");
+  for (const auto& distribution : rocksdb::SplitList(FLAGS_distributions)) {
+    std::vector<uint64_t> keys = rocksdb::GenerateKeys(
+        distribution, static_cast<uint64_t>(FLAGS_num_keys));
+    if (keys.empty()) {
+      fprintf(stderr, "Unknown distribution '%s'\n", distribution.c_str());
+      return 1;
+    }
+    for (unsigned leaf_models : leaf_counts) {
+      rocksdb::RunOne(distribution, keys, leaf_models);
+    }
+  }
+  return 0;
+}
+
+#endif  // GFLAGS
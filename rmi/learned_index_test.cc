@@ -0,0 +1,179 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "rmi/learned_index.h"
+#include "rmi/rmi_kernel.h"
+
+#include <cmath>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "port/stack_trace.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+namespace {
+
+typedef LearnedRangeIndexSingleKey<uint64_t, float> LearnedIndex;
+
+RMIConfig MakeConfig(unsigned leaf_models) {
+  RMIConfig rmi_config;
+  RMIConfig::StageConfig first, second;
+  first.model_type = RMIConfig::StageConfig::LinearRegression;
+  first.model_n = 1;
+  second.model_type = RMIConfig::StageConfig::LinearRegression;
+  second.model_n = leaf_models;
+  rmi_config.stage_configs.push_back(first);
+  rmi_config.stage_configs.push_back(second);
+  return rmi_config;
+}
+
+// Trains `index` to map keys[i] to its rank i; leaf selection scales root
+// predictions by the key count, so positions must be ranks.
+void Train(LearnedIndex* index, const std::vector<uint64_t>& keys) {
+  for (size_t i = 0; i < keys.size(); i++) {
+    index->insert(keys[i], i);
+  }
+  index->finish_insert();
+  index->finish_train();
+}
+
+uint64_t AbsError(uint64_t predicted, uint64_t actual) {
+  return predicted > actual ? predicted - actual : actual - predicted;
+}
+
+std::vector<uint64_t> LognormalKeys(size_t n) {
+  std::mt19937_64 rng(301);
+  std::lognormal_distribution<double> dist(0.0, 1.0);
+  std::set<uint64_t> keys;
+  while (keys.size() < n) {
+    keys.insert(static_cast<uint64_t>(dist(rng) * 1e9));
+  }
+  return std::vector<uint64_t>(keys.begin(), keys.end());
+}
+
+}  // namespace
+
+class LearnedIndexTest : public testing::Test {};
+
+TEST_F(LearnedIndexTest, LinearKeys) {
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 10000; i++) {
+    keys.push_back(1000 + i * 7);
+  }
+  LearnedIndex index(MakeConfig(100));
+  Train(&index, keys);
+  for (size_t i = 0; i < keys.size(); i++) {
+    ASSERT_LE(AbsError(index.get(keys[i]), i), 1U);
+  }
+}
+
+TEST_F(LearnedIndexTest, SerializeRoundTrip) {
+  std::vector<uint64_t> keys = LognormalKeys(5000);
+  for (unsigned leaf_models : {1u, 10u, 1000u}) {
+    RMIConfig rmi_config = MakeConfig(leaf_models);
+    LearnedIndex index(rmi_config);
+    Train(&index, keys);
+
+    std::string serialized;
+    index.serialize(serialized);
+    ASSERT_EQ((1 + leaf_models) * 2 * sizeof(double) + sizeof(unsigned),
+              serialized.size());
+
+    LearnedIndex decoded(serialized, rmi_config);
+    ASSERT_EQ(keys.size(), decoded.rmi.key_n);
+    for (uint64_t key : keys) {
+      ASSERT_EQ(index.get(key), decoded.get(key));
+    }
+  }
+}
+
+TEST_F(LearnedIndexTest, LeafSelectionInRange) {
+  std::vector<uint64_t> keys = LognormalKeys(2000);
+  const unsigned kLeafModels = 64;
+  LearnedIndex index(MakeConfig(kLeafModels));
+  Train(&index, keys);
+  std::vector<uint64_t> probes = keys;
+  // Keys outside the trained range must still pick a valid leaf.
+  probes.push_back(0);
+  probes.push_back(keys.back() * 2);
+  for (uint64_t key : probes) {
+    ASSERT_LT(index.get_model(key), static_cast<int>(kLeafModels));
+  }
+}
+
+TEST_F(LearnedIndexTest, MoreLeavesReduceError) {
+  std::vector<uint64_t> keys = LognormalKeys(20000);
+  double prev_mean_error = 0;
+  for (unsigned leaf_models : {1u, 1000u}) {
+    LearnedIndex index(MakeConfig(leaf_models));
+    Train(&index, keys);
+    double total_error = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+      total_error += AbsError(index.get(keys[i]), i);
+    }
+    double mean_error = total_error / keys.size();
+    if (leaf_models > 1) {
+      ASSERT_LT(mean_error, prev_mean_error);
+    }
+    prev_mean_error = mean_error;
+  }
+}
+
+TEST_F(LearnedIndexTest, KernelMatchesRMI) {
+  std::vector<uint64_t> keys = LognormalKeys(20000);
+  std::vector<uint64_t> probes = keys;
+  std::mt19937_64 rng(301);
+  for (int i = 0; i < 20000; i++) {
+    probes.push_back(rng());
+  }
+  probes.push_back(0);
+  probes.push_back(~0ULL);
+  for (unsigned leaf_models : {1u, 100u, 1000u, 1024u}) {
+    LearnedIndex index(MakeConfig(leaf_models));
+    // Byte offsets, as BlockBasedTableBuilder trains on.
+    for (size_t i = 0; i < keys.size(); i++) {
+      index.insert(keys[i], (i + 1) * 57);
+    }
+    index.finish_insert();
+    index.finish_train();
+    std::unique_ptr<RMIKernel> kernel = NewRMIKernel(index.rmi);
+    ASSERT_TRUE(kernel != nullptr);
+    ASSERT_EQ(leaf_models, kernel->num_leaves());
+    for (uint64_t key : probes) {
+      ASSERT_EQ(index.get(key), kernel->Predict(key));
+      ASSERT_EQ(static_cast<uint32_t>(index.get_model(key)),
+                kernel->Route(key));
+    }
+  }
+  ASSERT_TRUE(NewRMIKernel(LearnedIndex(MakeConfig(7)).rmi) == nullptr);
+}
+
+TEST_F(LearnedIndexTest, KernelWithoutKeys) {
+  // A table with no entries still serializes a model; with key_n == 0 every
+  // key goes to the last leaf.
+  RMIConfig rmi_config = MakeConfig(1000);
+  std::string serialized(
+      (1 + 1000) * 2 * sizeof(double) + sizeof(unsigned), '\0');
+  LearnedIndex index(serialized, rmi_config);
+  std::unique_ptr<RMIKernel> kernel = NewRMIKernel(index.rmi);
+  ASSERT_TRUE(kernel != nullptr);
+  for (uint64_t key : {0ULL, 12345ULL, ~0ULL}) {
+    ASSERT_EQ(999U, kernel->Route(key));
+    ASSERT_EQ(static_cast<uint32_t>(index.get_model(key)), kernel->Route(key));
+    ASSERT_EQ(index.get(key), kernel->Predict(key));
+  }
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  rocksdb::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,123 @@
+#include <stdint.h>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "rmi.h"
+
+#if !defined(RMI_KERNEL_H)
+#define RMI_KERNEL_H
+
+// Evaluates a two-stage linear RMINew without going through its stages: the
+// coefficients are copied into one flat array and root-to-leaf evaluation is
+// a handful of inlined arithmetic and min/max instructions, with no
+// branches, virtual stage objects or libm calls.
+//
+// Results are bit-for-bit those of LearnedRangeIndexSingleKey::get() and
+// RMINew::pick_model_for_key(), so tables placed by one can be read with the
+// other.
+class RMIKernel {
+ public:
+  virtual ~RMIKernel() {}
+
+  // Predicted position of `key`; same as LearnedRangeIndexSingleKey::get().
+  virtual int64_t Predict(uint64_t key) const = 0;
+
+  // Leaf `key` is routed to; same as RMINew::pick_model_for_key().
+  virtual uint32_t Route(uint64_t key) const = 0;
+
+  virtual uint32_t num_leaves() const = 0;
+
+  // Bytes held by the kernel.
+  virtual size_t ApproximateMemoryUsage() const = 0;
+};
+
+// Two linear stages is the only shape RMINew serializes, so only the key
+// type and the leaf count are parameters. The leaf count need not be a power
+// of two: leaves are picked by scaling the root prediction by
+// kNumLeaves / key_n, the arithmetic every existing table was built with.
+template <typename Key_T, uint32_t kNumLeaves>
+class LinearRMIKernel : public RMIKernel {
+ public:
+  template <class Weight_T>
+  explicit LinearRMIKernel(const RMINew<Weight_T>& rmi)
+      : root_w_(rmi.first_stage->models[0].w),
+        root_bias_(rmi.first_stage->models[0].bias),
+        key_n_(static_cast<double>(rmi.key_n)) {
+    assert(rmi.second_stage->get_model_n() == kNumLeaves);
+    for (uint32_t i = 0; i < kNumLeaves; i++) {
+      leaves_[2 * i] = rmi.second_stage->models[i].w;
+      leaves_[2 * i + 1] = rmi.second_stage->models[i].bias;
+    }
+  }
+
+  inline uint32_t RouteKey(Key_T key) const {
+    double pred =
+        std::max(root_bias_ + root_w_ * static_cast<double>(key), 0.0);
+    // A prediction at or past key_n, including any when key_n is 0 and the
+    // ratio is inf or NaN, goes to the last leaf: std::min() returns its
+    // first argument unless the second compares less.
+    double leaf = std::min(static_cast<double>(kNumLeaves - 1),
+                           pred / key_n_ * kNumLeaves);
+    return static_cast<uint32_t>(leaf);
+  }
+
+  inline int64_t PredictKey(Key_T key) const {
+    const double* leaf = &leaves_[2 * RouteKey(key)];
+    double pos =
+        std::max(leaf[1] + leaf[0] * static_cast<double>(key), 0.0);
+    // std::round() of a non-negative value, rounding halves up.
+    int64_t whole = static_cast<int64_t>(pos);
+    return whole + (pos - static_cast<double>(whole) >= 0.5);
+  }
+
+  virtual int64_t Predict(uint64_t key) const override {
+    return PredictKey(static_cast<Key_T>(key));
+  }
+
+  virtual uint32_t Route(uint64_t key) const override {
+    return RouteKey(static_cast<Key_T>(key));
+  }
+
+  virtual uint32_t num_leaves() const override { return kNumLeaves; }
+
+  virtual size_t ApproximateMemoryUsage() const override {
+    return sizeof(*this);
+  }
+
+ private:
+  double root_w_;
+  double root_bias_;
+  double key_n_;
+  // (w, bias) of every leaf, interleaved so one lookup touches one line.
+  double leaves_[2 * kNumLeaves];
+};
+
+// Returns the kernel specialized for the leaf count of `rmi`, or nullptr if
+// it has none, in which case callers keep evaluating `rmi` itself.
+template <class Weight_T>
+std::unique_ptr<RMIKernel> NewRMIKernel(const RMINew<Weight_T>& rmi) {
+  if (rmi.first_stage->get_model_n() != 1) {
+    return nullptr;
+  }
+  switch (rmi.second_stage->get_model_n()) {
+    case 1:
+      return std::unique_ptr<RMIKernel>(new LinearRMIKernel<uint64_t, 1>(rmi));
+    case 100:
+      return std::unique_ptr<RMIKernel>(
+          new LinearRMIKernel<uint64_t, 100>(rmi));
+    case 1000:
+      return std::unique_ptr<RMIKernel>(
+          new LinearRMIKernel<uint64_t, 1000>(rmi));
+    case 1024:
+      return std::unique_ptr<RMIKernel>(
+          new LinearRMIKernel<uint64_t, 1024>(rmi));
+    case 10000:
+      return std::unique_ptr<RMIKernel>(
+          new LinearRMIKernel<uint64_t, 10000>(rmi));
+    default:
+      return nullptr;
+  }
+}
+
+#endif
@@ -32,9 +32,11 @@ LIB_SOURCES =                                                   \
   db/flush_job.cc                                               \
   db/flush_scheduler.cc                                         \
   db/forward_iterator.cc                                        \
+  db/hot_blocks.cc                                              \
   db/internal_stats.cc                                          \
   db/log_reader.cc                                              \
   db/log_writer.cc                                              \
+  db/lookup_result_cache.cc                                     \
   db/managed_iterator.cc                                        \
   db/memtable.cc                                                \
   db/memtable_list.cc                                           \
@@ -63,6 +65,8 @@ LIB_SOURCES =                                                   \
   memtable/hash_cuckoo_rep.cc                                   \
   memtable/hash_linklist_rep.cc                                 \
   memtable/hash_skiplist_rep.cc                                 \
+  memtable/learned_gapped_array_rep.cc                          \
+  memtable/learned_sorted_array_rep.cc                          \
   memtable/memtable_allocator.cc                                \
   memtable/skiplistrep.cc                                       \
   memtable/vectorrep.cc                                         \
@@ -95,6 +99,7 @@ LIB_SOURCES =                                                   \
   table/block_builder.cc                                        \
   table/block_prefix_index.cc                                   \
   table/bloom_block.cc                                          \
+  table/compact_learned_model.cc                                \
   table/cuckoo_table_builder.cc                                 \
   table/cuckoo_table_factory.cc                                 \
   table/cuckoo_table_reader.cc                                  \
@@ -138,6 +143,7 @@ LIB_SOURCES =                                                   \
   util/murmurhash.cc                                            \
   util/random.cc                                                \
   util/rate_limiter.cc                                          \
+  util/slab_allocator.cc                                        \
   util/slice.cc                                                 \
   util/sst_file_manager_impl.cc                                 \
   util/status.cc                                                \
@@ -182,6 +188,7 @@ LIB_SOURCES =                                                   \
   utilities/persistent_cache/persistent_cache_tier.cc           \
   utilities/persistent_cache/volatile_tier_impl.cc              \
   utilities/redis/redis_lists.cc                                \
+  utilities/simulator_cache/block_cache_trace.cc                \
   utilities/simulator_cache/sim_cache.cc                        \
   utilities/spatialdb/spatial_db.cc                             \
   utilities/table_properties_collectors/compact_on_deletion_collector.cc \
@@ -260,6 +267,8 @@ MAIN_SOURCES =                                                    \
   db/file_indexer_test.cc                                               \
   db/filename_test.cc                                                   \
   db/flush_job_test.cc                                                  \
+  db/level_hint_cache_test.cc                                           \
+  db/linear_segment_tracker_test.cc                                     \
   db/listener_test.cc                                                   \
   db/log_test.cc                                                        \
   db/manual_compaction_test.cc                                          \
@@ -280,14 +289,19 @@ MAIN_SOURCES =                                                    \
   env/env_test.cc                                                       \
   env/mock_env_test.cc                                                  \
   memtable/inlineskiplist_test.cc                                       \
+  memtable/learned_gapped_array_rep_test.cc                             \
+  memtable/learned_sorted_array_rep_test.cc                             \
   memtable/memtablerep_bench.cc                                         \
   memtable/skiplist_test.cc                                             \
   monitoring/histogram_test.cc                                          \
   monitoring/iostats_context_test.cc                                    \
   monitoring/statistics_test.cc                                         \
   options/options_test.cc                                               \
+  rmi/learned_index_bench.cc                                            \
+  rmi/learned_index_test.cc                                             \
   table/block_based_filter_block_test.cc                                \
   table/block_test.cc                                                   \
+  table/compact_learned_model_test.cc                                   \
   table/cuckoo_table_builder_test.cc                                    \
   table/cuckoo_table_reader_test.cc                                     \
   table/full_filter_block_test.cc                                       \
@@ -312,6 +326,7 @@ MAIN_SOURCES =                                                    \
   util/filelock_test.cc                                                 \
   util/log_write_bench.cc                                               \
   util/rate_limiter_test.cc                                             \
+  util/slab_allocator_test.cc                                           \
   util/slice_transform_test.cc                                          \
   util/timer_queue_test.cc                                             \
   util/thread_list_test.cc                                              \
@@ -331,6 +346,8 @@ MAIN_SOURCES =                                                    \
   utilities/option_change_migration/option_change_migration_test.cc           \
   utilities/options/options_util_test.cc                                \
   utilities/redis/redis_lists_test.cc                                   \
+  utilities/simulator_cache/block_cache_trace_sim.cc                    \
+  utilities/simulator_cache/block_cache_trace_test.cc                   \
   utilities/simulator_cache/sim_cache_test.cc                           \
   utilities/spatialdb/spatial_db_test.cc                                \
   utilities/table_properties_collectors/compact_on_deletion_collector_test.cc  \
@@ -205,6 +205,26 @@ void BlockIter::SeekToLast() {
   }
 }
 
+void BlockIter::SeekToEntry(uint32_t n, uint32_t restart_interval) {
+  if (data_ == nullptr) {  // Not init yet
+    return;
+  }
+  assert(restart_interval > 0);
+  uint32_t index = n / restart_interval;
+  if (index >= num_restarts_) {
+    current_ = restarts_;
+    restart_index_ = num_restarts_;
+    key_.Clear();
+    value_.clear();
+    return;
+  }
+  SeekToRestartPoint(index);
+  ParseNextKey();
+  for (uint32_t i = n % restart_interval; i > 0 && Valid(); i--) {
+    ParseNextKey();
+  }
+}
+
 void BlockIter::CorruptionError() {
   current_ = restarts_;
   restart_index_ = num_restarts_;
@@ -399,7 +419,11 @@ Block::Block(BlockContents&& contents, SequenceNumber _global_seqno,
       data_(contents_.data.data()),
       size_(contents_.data.size()),
       global_seqno_(_global_seqno) {
-  if (size_ < sizeof(uint32_t)) {
+  if (contents_.compression_type != kNoCompression) {
+    // Compressed contents, as kept in block_cache_compressed, have no
+    // restart array to check; they are only ever decompressed.
+    restart_offset_ = 0;
+  } else if (size_ < sizeof(uint32_t)) {
     size_ = 0;  // Error marker
   } else {
     restart_offset_ =
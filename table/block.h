@@ -10,6 +10,7 @@
 #pragma once
 #include <stddef.h>
 #include <stdint.h>
+#include <memory>
 #include <string>
 #include <vector>
 #ifdef ROCKSDB_MALLOC_USABLE_SIZE
@@ -37,6 +38,7 @@ struct BlockContents;
 class Comparator;
 class BlockIter;
 class BlockPrefixIndex;
+class BlockDemoter;
 
 // BlockReadAmpBitmap is a bitmap that map the rocksdb::Block data bytes to
 // a bitmap with ratio bytes_per_bit. Whenever we access a range of bytes in
@@ -144,6 +146,10 @@ class Block {
   const char* data() const { return data_; }
   bool cachable() const { return contents_.cachable; }
   size_t usable_size() const {
+    MemoryAllocator* allocator = contents_.allocation.get_deleter().allocator;
+    if (allocator != nullptr) {
+      return allocator->UsableSize(contents_.allocation.get(), size_);
+    }
 #ifdef ROCKSDB_MALLOC_USABLE_SIZE
     if (contents_.allocation.get() != nullptr) {
       return malloc_usable_size(contents_.allocation.get());
@@ -180,6 +186,13 @@ class Block {
 
   SequenceNumber global_seqno() const { return global_seqno_; }
 
+  // Where this block goes, compressed, once it is evicted from the block
+  // cache. See BlockBasedTableOptions::demote_evicted_blocks.
+  const std::shared_ptr<BlockDemoter>& demoter() const { return demoter_; }
+  void set_demoter(const std::shared_ptr<BlockDemoter>& demoter) {
+    demoter_ = demoter;
+  }
+
  private:
   BlockContents contents_;
   const char* data_;            // contents_.data.data()
@@ -190,6 +203,7 @@ class Block {
   // All keys in the block will have seqno = global_seqno_, regardless of
   // the encoded value (kDisableGlobalSequenceNumber means disabled)
   const SequenceNumber global_seqno_;
+  std::shared_ptr<BlockDemoter> demoter_;
 
   // No copying allowed
   Block(const Block&);
@@ -272,6 +286,11 @@ class BlockIter : public InternalIterator {
 
   virtual void SeekToLast() override;
 
+  // Positions at entry `n`, counting from 0, of a block built with
+  // `restart_interval`, without comparing any keys. Not valid if the block
+  // has no such entry.
+  void SeekToEntry(uint32_t n, uint32_t restart_interval);
+
 #ifndef NDEBUG
   ~BlockIter() {
     // Assert that the BlockIter is never deleted while Pinning is Enabled.
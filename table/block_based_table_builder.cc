@@ -21,6 +21,7 @@
 #include <utility>
 
 #include "db/dbformat.h"
+#include "rmi/rmi_kernel.h"
 
 #include "rocksdb/cache.h"
 #include "rocksdb/comparator.h"
@@ -35,6 +36,7 @@
 #include "table/block_based_table_factory.h"
 #include "table/block_based_table_reader.h"
 #include "table/block_builder.h"
+#include "table/compact_learned_model.h"
 #include "table/filter_block.h"
 #include "table/format.h"
 #include "table/full_filter_block.h"
@@ -239,6 +241,16 @@ struct BlockBasedTableBuilder::Rep {
   // for model
   uint64_t _bytes = 0;
   std::vector<std::pair<std::string, std::string>> all_values;
+  // Entries whose predicted data block differs from the block they are
+  // written to, and the largest such distance (in blocks).
+  uint64_t model_mispredicted_keys = 0;
+  uint64_t model_max_block_error = 0;
+  // Largest error of BlockBasedTable::ModelRawOffset() over all entries.
+  uint64_t model_max_offset_error = 0;
+  // Serialized learned model, written by WriteLearnBlock(), and the time
+  // spent training it.
+  std::string learned_model_contents;
+  uint64_t model_train_micros = 0;
 
   const ImmutableCFOptions ioptions;
   const BlockBasedTableOptions table_options;
@@ -251,6 +263,8 @@ struct BlockBasedTableBuilder::Rep {
 
   InternalKeySliceTransform internal_prefix_transform;
   std::unique_ptr<IndexBuilder> index_builder;
+  // Same object as index_builder when the index is partitioned.
+  PartitionedIndexBuilder* p_index_builder = nullptr;
 
   std::string last_key;
   const CompressionType compression_type;
@@ -300,7 +314,6 @@ struct BlockBasedTableBuilder::Rep {
                 table_options, data_block)),
         column_family_id(_column_family_id),
         column_family_name(_column_family_name) {
-    PartitionedIndexBuilder* p_index_builder = nullptr;
     if (table_options.index_type ==
         BlockBasedTableOptions::kTwoLevelIndexSearch) {
       p_index_builder = PartitionedIndexBuilder::CreateIndexBuilder(
@@ -368,18 +381,8 @@ BlockBasedTableBuilder::BlockBasedTableBuilder(
   }
 
     // new learnedMod
-  RMIConfig rmi_config;
-  RMIConfig::StageConfig first, second;
-
-  first.model_type = RMIConfig::StageConfig::LinearRegression;
-  first.model_n = 1;
-
-  second.model_n = 1000;
-  second.model_type = RMIConfig::StageConfig::LinearRegression;
-  rmi_config.stage_configs.push_back(first);
-  rmi_config.stage_configs.push_back(second);
-
-  LearnedMod = new LearnedRangeIndexSingleKey<uint64_t,float> (rmi_config);
+  LearnedMod = new LearnedRangeIndexSingleKey<uint64_t,float> (
+      BlockBasedTable::LearnedModelConfig());
 }
 
 BlockBasedTableBuilder::~BlockBasedTableBuilder() {
@@ -557,10 +560,8 @@ void BlockBasedTableBuilder::WriteBlock(const Slice& raw_block_contents,
 }
 
 void BlockBasedTableBuilder::WriteLearnBlock(BlockHandle* handle) {
-  string param;
-  LearnedMod->serialize(param);
-  Slice raw(param);
   Rep* r = rep_;
+  Slice raw(r->learned_model_contents);
   handle->set_offset(r->offset);
   handle->set_size(raw.size());
   r->status = r->file->Append(raw);
@@ -658,13 +659,78 @@ Status BlockBasedTableBuilder::InsertBlockInCache(const Slice& block_contents,
   return Status::OK();
 }
 
+void BlockBasedTableBuilder::EncodeCompactLearnedModel(std::string* dst) {
+  Rep* r = rep_;
+  auto& rmi = LearnedMod->rmi;
+  size_t num_leaves = rmi.second_stage->get_model_n();
+  std::vector<CompactLearnedModel::Leaf> leaves(num_leaves);
+  // Keys and byte offsets routed to each leaf, to pick its shape from.
+  uint64_t max_error = r->table_options.learned_leaf_max_error;
+  std::vector<std::vector<uint64_t>> leaf_keys(max_error > 0 ? num_leaves : 0);
+  std::vector<std::vector<uint64_t>> leaf_positions(leaf_keys.size());
+  uint64_t position = 0;
+  for (auto& item : r->all_values) {
+    uint64_t lekey = Slice(item.first).Touint64_t();
+    size_t i = rmi.pick_model_for_key(static_cast<double>(lekey));
+    CompactLearnedModel::Leaf& leaf = leaves[i];
+    if (!leaf.kept || lekey < leaf.key_base) {
+      leaf.kept = true;
+      leaf.key_base = lekey;
+    }
+    if (max_error > 0) {
+      // Same positions as the model was trained on in Add().
+      position += item.first.size() + item.second.size();
+      leaf_keys[i].push_back(lekey);
+      leaf_positions[i].push_back(position);
+    }
+  }
+  for (size_t i = 0; i < num_leaves; i++) {
+    // Leaves without keys were never trained.
+    if (leaves[i].kept) {
+      leaves[i].SetLinear(leaves[i].key_base, rmi.second_stage->models[i].w,
+                          rmi.second_stage->models[i].bias);
+      if (max_error > 0) {
+        CompactLearnedModel::FitLeaf(leaf_keys[i], leaf_positions[i],
+                                     max_error, &leaves[i]);
+      }
+    }
+  }
+  double root_slope = 0;
+  double root_intercept = 0;
+  if (!r->all_values.empty()) {
+    root_slope = rmi.first_stage->models[0].w;
+    root_intercept = rmi.first_stage->models[0].bias;
+  }
+  CompactLearnedModel::Encode(root_slope, root_intercept,
+                              static_cast<uint32_t>(r->all_values.size()),
+                              leaves, dst);
+}
+
 Status BlockBasedTableBuilder::Finish() {
   Rep* r = rep_;
   // std::cout << __func__ << " Finish " <<  std::endl;
   bool empty_data_block = r->data_block.empty();
 
+  uint64_t train_start_micros = r->ioptions.env->NowMicros();
   LearnedMod->finish_insert();
   LearnedMod->finish_train();
+  std::unique_ptr<CompactLearnedModel> compact_model;
+  std::unique_ptr<RMIKernel> model_kernel;
+  if (r->table_options.compact_learned_model) {
+    EncodeCompactLearnedModel(&r->learned_model_contents);
+    // Place the entries with the model readers will evaluate, so that float
+    // rounding of the slopes cannot move a key to another block.
+    compact_model.reset(new CompactLearnedModel());
+    Status s = compact_model->Init(std::string(r->learned_model_contents));
+    assert(s.ok());
+  } else {
+    LearnedMod->serialize(r->learned_model_contents);
+    model_kernel = NewRMIKernel(LearnedMod->rmi);
+  }
+  r->model_train_micros = r->ioptions.env->NowMicros() - train_start_micros;
+  const uint64_t raw_size = r->_bytes;
+  const uint64_t num_model_entries = r->all_values.size();
+  uint64_t raw_offset = 0;
   r->_bytes = 0;
 
 
@@ -678,8 +744,23 @@ Status BlockBasedTableBuilder::Finish() {
     Slice key(item.first);
     Slice value(item.second);
     uint64_t lekey = key.Touint64_t();
-    auto value_get = LearnedMod->get(lekey);
-    int block_num = value_get / 4096;
+    int64_t value_get;
+    if (model_kernel != nullptr) {
+      value_get = model_kernel->Predict(lekey);
+    } else if (compact_model != nullptr) {
+      value_get = compact_model->Predict(lekey);
+    } else {
+      value_get = LearnedMod->get(lekey);
+    }
+    int block_num = static_cast<int>(value_get / 4096);
+
+    uint64_t estimated_offset = BlockBasedTable::ModelRawOffset(
+        static_cast<uint64_t>(value_get), raw_size, num_model_entries);
+    r->model_max_offset_error = std::max(
+        r->model_max_offset_error, estimated_offset > raw_offset
+                                       ? estimated_offset - raw_offset
+                                       : raw_offset - estimated_offset);
+    raw_offset += key.size() + value.size();
     // std::cout << __func__ << " item.first: " << key.ToString(true) << std::endl;
     // std::cout << __func__ << " lekey: " << lekey << std::endl;
     // std::cout << __func__ << " block_num: " << block_num << std::endl;
@@ -691,8 +772,9 @@ Status BlockBasedTableBuilder::Finish() {
       }
 
       // auto should_flush = r->flush_block_policy->Update(item.first, item.second);
-      if (block_num != based) {
-        assert(!r->data_block.empty());
+      // Never cut an empty block: the model may place the first keys of the
+      // table past block 0.
+      if (block_num != based && !r->data_block.empty()) {
         Flush();
         based += 1;
 
@@ -711,6 +793,16 @@ Status BlockBasedTableBuilder::Finish() {
         }
       }
 
+      // The entry lands in data block `based`; ModelGet() will look for it
+      // in block `block_num`.
+      if (block_num != based) {
+        uint64_t block_error = static_cast<uint64_t>(
+            block_num > based ? block_num - based : based - block_num);
+        r->model_mispredicted_keys++;
+        r->model_max_block_error =
+            std::max(r->model_max_block_error, block_error);
+      }
+
       // Note: PartitionedFilterBlockBuilder requires key being added to filter
       // builder after being added to index builder.
       if (r->filter_builder != nullptr) {
@@ -785,7 +877,8 @@ Status BlockBasedTableBuilder::Finish() {
   //    2. [meta block: properties]
   //    3. [meta block: compression dictionary]
   //    4. [meta block: range deletion tombstone]
-  //    5. [metaindex block]
+  //    5. [meta block: model partitions]
+  //    6. [metaindex block]
   // write meta blocks
   MetaIndexBuilder meta_index_builder;
   for (const auto& item : index_blocks.meta_blocks) {
@@ -852,6 +945,22 @@ Status BlockBasedTableBuilder::Finish() {
                                            r->ioptions.info_log,
                                            &property_block_builder);
 
+      // Add learned model accuracy, measured against the final block layout
+      property_block_builder.Add(
+          BlockBasedTablePropertyNames::kModelMispredictedKeys,
+          r->model_mispredicted_keys);
+      property_block_builder.Add(
+          BlockBasedTablePropertyNames::kModelMaxBlockError,
+          r->model_max_block_error);
+      property_block_builder.Add(BlockBasedTablePropertyNames::kModelSize,
+                                 r->learned_model_contents.size());
+      property_block_builder.Add(
+          BlockBasedTablePropertyNames::kModelTrainMicros,
+          r->model_train_micros);
+      property_block_builder.Add(
+          BlockBasedTablePropertyNames::kModelMaxOffsetError,
+          r->model_max_offset_error);
+
       BlockHandle properties_block_handle;
       WriteRawBlock(
           property_block_builder.Finish(),
@@ -874,6 +983,23 @@ Status BlockBasedTableBuilder::Finish() {
                     &range_del_block_handle);
       meta_index_builder.Add(kRangeDelBlock, range_del_block_handle);
     }  // range deletion tombstone meta block
+
+    // Write how many data blocks each index partition holds, so that
+    // ModelGet() can turn a predicted block number into a partition and an
+    // entry in it without searching the index.
+    if (ok() && r->p_index_builder != nullptr) {
+      std::string partitions;
+      PutFixed32(&partitions, static_cast<uint32_t>(
+                                  r->table_options.index_block_restart_interval));
+      for (uint32_t num_entries : r->p_index_builder->partition_num_entries()) {
+        PutFixed32(&partitions, num_entries);
+      }
+      BlockHandle model_partitions_block_handle;
+      WriteRawBlock(partitions, kNoCompression,
+                    &model_partitions_block_handle);
+      meta_index_builder.Add(BlockBasedTable::kModelPartitionsBlock,
+                             model_partitions_block_handle);
+    }
   }    // meta blocks
 
   // Write index block
@@ -971,6 +1097,8 @@ TableProperties BlockBasedTableBuilder::GetTableProperties() const {
 
 const std::string BlockBasedTable::kFilterBlockPrefix = "filter.";
 const std::string BlockBasedTable::kFullFilterBlockPrefix = "fullfilter.";
+const std::string BlockBasedTable::kModelPartitionsBlock =
+    "rocksdb.model.partitions";
 const std::string BlockBasedTable::kPartitionedFilterBlockPrefix =
     "partitionedfilter.";
 }  // namespace rocksdb
@@ -112,6 +112,11 @@ class BlockBasedTableBuilder : public TableBuilder {
   // REQUIRES: Finish(), Abandon() have not been called
   void Flush();
 
+  // Encodes the trained learned model as a CompactLearnedModel into `dst`,
+  // refitting leaves as BlockBasedTableOptions::learned_leaf_max_error asks.
+  // REQUIRES: the model has been trained on all entries added so far.
+  void EncodeCompactLearnedModel(std::string* dst);
+
   // Some compression libraries fail when the raw size is bigger than int. If
   // uncompressed size is bigger than kCompressionSizeLimit, don't compress it
   const uint64_t kCompressionSizeLimit = std::numeric_limits<int>::max();
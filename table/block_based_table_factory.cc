@@ -8,8 +8,13 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
 #include "table/block_based_table_factory.h"
 
+#include <inttypes.h>
 #include <memory>
 #include <string>
 #include <stdint.h>
@@ -20,6 +25,7 @@
 #include "table/block_based_table_builder.h"
 #include "table/block_based_table_reader.h"
 #include "table/format.h"
+#include "util/compression.h"
 
 namespace rocksdb {
 
@@ -94,6 +100,24 @@ Status BlockBasedTableFactory::SanitizeOptions(
         "Enable pin_l0_filter_and_index_blocks_in_cache, "
         ", but block cache is disabled");
   }
+  if (table_options_.cache_learned_model_blocks &&
+      table_options_.no_block_cache) {
+    return Status::InvalidArgument(
+        "Enable cache_learned_model_blocks, but block cache is disabled");
+  }
+  if (table_options_.demote_evicted_blocks) {
+    if (table_options_.block_cache_compressed == nullptr) {
+      return Status::InvalidArgument(
+          "Enable demote_evicted_blocks, but there is no "
+          "block_cache_compressed to demote blocks to");
+    }
+    if (table_options_.demoted_block_compression == kNoCompression ||
+        !CompressionTypeSupported(table_options_.demoted_block_compression)) {
+      return Status::InvalidArgument(
+          "demoted_block_compression is not a compression type supported in "
+          "this build");
+    }
+  }
   if (!BlockBasedTableSupportedVersion(table_options_.format_version)) {
     return Status::InvalidArgument(
         "Unsupported BlockBasedTable format_version. Please check "
@@ -162,6 +186,9 @@ std::string BlockBasedTableFactory::GetPrintableTableOptions() const {
     ret.append("  block_cache_compressed_options:\n");
     ret.append(table_options_.block_cache_compressed->GetPrintableOptions());
   }
+  snprintf(buffer, kBufferSize, "  block_cache_tracer: %p\n",
+           static_cast<void*>(table_options_.block_cache_tracer.get()));
+  ret.append(buffer);
   snprintf(buffer, kBufferSize, "  persistent_cache: %p\n",
            static_cast<void*>(table_options_.persistent_cache.get()));
   ret.append(buffer);
@@ -192,6 +219,28 @@ std::string BlockBasedTableFactory::GetPrintableTableOptions() const {
   snprintf(buffer, kBufferSize, "  format_version: %d\n",
            table_options_.format_version);
   ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  compact_learned_model: %d\n",
+           table_options_.compact_learned_model);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  learned_leaf_max_error: %" PRIu64 "\n",
+           table_options_.learned_leaf_max_error);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  model_offset_max_error: %" PRIu64 "\n",
+           table_options_.model_offset_max_error);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  cache_learned_model_blocks: %d\n",
+           table_options_.cache_learned_model_blocks);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  pin_l0_learned_model_in_cache: %d\n",
+           table_options_.pin_l0_learned_model_in_cache);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  demote_evicted_blocks: %d\n",
+           table_options_.demote_evicted_blocks);
+  ret.append(buffer);
+  snprintf(buffer, kBufferSize, "  demoted_block_compression: %s\n",
+           CompressionTypeToString(table_options_.demoted_block_compression)
+               .c_str());
+  ret.append(buffer);
   return ret;
 }
 
@@ -210,6 +259,16 @@ const std::string BlockBasedTablePropertyNames::kWholeKeyFiltering =
     "rocksdb.block.based.table.whole.key.filtering";
 const std::string BlockBasedTablePropertyNames::kPrefixFiltering =
     "rocksdb.block.based.table.prefix.filtering";
+const std::string BlockBasedTablePropertyNames::kModelMispredictedKeys =
+    "rocksdb.block.based.table.model.mispredicted.keys";
+const std::string BlockBasedTablePropertyNames::kModelMaxOffsetError =
+    "rocksdb.block.based.table.model.max.offset.error";
+const std::string BlockBasedTablePropertyNames::kModelMaxBlockError =
+    "rocksdb.block.based.table.model.max.block.error";
+const std::string BlockBasedTablePropertyNames::kModelSize =
+    "rocksdb.block.based.table.model.size";
+const std::string BlockBasedTablePropertyNames::kModelTrainMicros =
+    "rocksdb.block.based.table.model.train.micros";
 const std::string kHashIndexPrefixesBlock = "rocksdb.hashindex.prefixes";
 const std::string kHashIndexPrefixesMetadataBlock =
     "rocksdb.hashindex.metadata";
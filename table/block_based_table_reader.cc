@@ -8,6 +8,7 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 #include "table/block_based_table_reader.h"
 
+#include <atomic>
 #include <algorithm>
 #include <limits>
 #include <string>
@@ -23,12 +24,15 @@
 #include "rocksdb/filter_policy.h"
 #include "rocksdb/iterator.h"
 #include "rocksdb/options.h"
+#include "rocksdb/rate_limiter.h"
 #include "rocksdb/statistics.h"
 #include "rocksdb/table.h"
 #include "rocksdb/table_properties.h"
+#include "rocksdb/utilities/block_cache_trace.h"
 
 #include "table/block.h"
 #include "table/block_based_filter_block.h"
+#include "table/block_based_table_builder.h"
 #include "table/block_based_table_factory.h"
 #include "table/block_prefix_index.h"
 #include "table/filter_block.h"
@@ -48,6 +52,7 @@
 #include "util/stop_watch.h"
 #include "util/string_util.h"
 #include "util/sync_point.h"
+#include "util/thread_local.h"
 
 namespace rocksdb {
 
@@ -60,7 +65,6 @@ typedef BlockBasedTable::IndexReader IndexReader;
 
 BlockBasedTable::~BlockBasedTable() {
   Close();
-  delete rep_->learnedMod;
   delete rep_;
 }
 
@@ -78,10 +82,12 @@ Status ReadBlockFromFile(RandomAccessFileReader* file, const Footer& footer,
                          const Slice& compression_dict,
                          const PersistentCacheOptions& cache_options,
                          SequenceNumber global_seqno,
-                         size_t read_amp_bytes_per_bit) {
+                         size_t read_amp_bytes_per_bit,
+                         MemoryAllocator* allocator = nullptr) {
   BlockContents contents;
   Status s = ReadBlockContents(file, footer, options, handle, &contents, ioptions,
-                               do_uncompress, compression_dict, cache_options);
+                               do_uncompress, compression_dict, cache_options,
+                               allocator);
   if (s.ok()) {
     result->reset(new Block(std::move(contents), global_seqno,
                             read_amp_bytes_per_bit, ioptions.statistics));
@@ -148,6 +154,153 @@ Cache::Handle* GetEntryFromCache(Cache* block_cache, const Slice& key,
   return cache_handle;
 }
 
+#if ROCKSDB_SUPPORT_THREAD_LOCAL
+// The caller of the block cache accesses made on this thread, while a
+// ScopedBlockCacheTraceCaller sets it, and kNumCallers otherwise.
+__thread BlockCacheTraceCaller tls_block_cache_caller =
+    BlockCacheTraceCaller::kNumCallers;
+#endif
+
+BlockCacheTraceCaller CurrentBlockCacheTraceCaller() {
+#if ROCKSDB_SUPPORT_THREAD_LOCAL
+  if (tls_block_cache_caller != BlockCacheTraceCaller::kNumCallers) {
+    return tls_block_cache_caller;
+  }
+#endif
+  return BlockCacheTraceCaller::kIterator;
+}
+
+// Records a lookup of `key` in block_cache, which returned `handle`.
+void TraceBlockCacheLookup(BlockCacheTracer* tracer, Cache* block_cache,
+                           const Slice& key, Cache::Handle* handle,
+                           BlockCacheTraceBlockType block_type, int level,
+                           bool fill_cache) {
+  if (tracer == nullptr) {
+    return;
+  }
+  BlockCacheTraceRecord record;
+  record.op = BlockCacheTraceRecord::kLookup;
+  record.cache_key.assign(key.data(), key.size());
+  record.block_type = block_type;
+  record.caller = CurrentBlockCacheTraceCaller();
+  record.level = level;
+  record.is_hit = handle != nullptr;
+  record.fill_cache = fill_cache;
+  record.charge = handle != nullptr ? block_cache->GetUsage(handle) : 0;
+  tracer->Record(record);
+}
+
+// Records an insert of a block that missed block_cache.
+void TraceBlockCacheInsert(BlockCacheTracer* tracer, const Slice& key,
+                           BlockCacheTraceBlockType block_type, int level,
+                           size_t charge) {
+  if (tracer == nullptr) {
+    return;
+  }
+  BlockCacheTraceRecord record;
+  record.op = BlockCacheTraceRecord::kInsert;
+  record.cache_key.assign(key.data(), key.size());
+  record.block_type = block_type;
+  record.caller = CurrentBlockCacheTraceCaller();
+  record.level = level;
+  record.charge = charge;
+  tracer->Record(record);
+}
+
+}  // namespace
+
+ScopedBlockCacheTraceCaller::ScopedBlockCacheTraceCaller(
+    BlockCacheTraceCaller caller)
+    : saved_(BlockCacheTraceCaller::kNumCallers) {
+#if ROCKSDB_SUPPORT_THREAD_LOCAL
+  saved_ = tls_block_cache_caller;
+  tls_block_cache_caller = caller;
+#endif
+}
+
+ScopedBlockCacheTraceCaller::~ScopedBlockCacheTraceCaller() {
+#if ROCKSDB_SUPPORT_THREAD_LOCAL
+  tls_block_cache_caller = saved_;
+#endif
+}
+
+// Moves the data blocks of one table that are evicted from its block cache
+// into its compressed block cache. Shared by the table reader and by the
+// blocks of the table in the block cache, which can outlive the reader.
+class BlockDemoter {
+ public:
+  BlockDemoter(const std::shared_ptr<Cache>& block_cache_compressed,
+               CompressionType compression_type, uint32_t format_version,
+               const Slice& cache_key_prefix,
+               const Slice& compressed_cache_key_prefix)
+      : block_cache_compressed_(block_cache_compressed),
+        compression_type_(compression_type),
+        format_version_(format_version),
+        cache_key_prefix_size_(cache_key_prefix.size()),
+        compressed_cache_key_prefix_(compressed_cache_key_prefix.ToString()),
+        disabled_(false) {}
+
+  // Compresses `block`, which the block cache held under `cache_key`, into
+  // the compressed block cache. Blocks that do not compress well are
+  // dropped instead, as are all blocks once the demoter is disabled.
+  void Demote(const Slice& cache_key, const Block& block) {
+    assert(cache_key.size() > cache_key_prefix_size_);
+    if (disabled_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    CompressionType type = compression_type_;
+    std::string compressed;
+    Slice contents = CompressBlock(Slice(block.data(), block.size()),
+                                   CompressionOptions(), &type,
+                                   format_version_, Slice() /* dict */,
+                                   &compressed);
+    if (type == kNoCompression) {
+      return;
+    }
+    // Lay the block out as read from a file, with the compression type
+    // right after the contents, which is where UncompressBlockContents()
+    // looks for it.
+    size_t n = contents.size();
+    std::unique_ptr<char[]> buf(new char[n + 1]);
+    memcpy(buf.get(), contents.data(), n);
+    buf[n] = static_cast<char>(type);
+    Block* demoted = new Block(BlockContents(std::move(buf), n, true, type),
+                               block.global_seqno());
+
+    // Both keys end with the varint offset of the block in the file.
+    std::string key = compressed_cache_key_prefix_;
+    key.append(cache_key.data() + cache_key_prefix_size_,
+               cache_key.size() - cache_key_prefix_size_);
+    // Deletes the block if it cannot be inserted.
+    block_cache_compressed_->Insert(key, demoted, demoted->usable_size(),
+                                    &DeleteCachedEntry<Block>);
+  }
+
+  // Stops demoting the blocks of the table. Called once the table is closed:
+  // its blocks left in the block cache are then freed because the cache is
+  // destroyed or the file was deleted, not because the cache ran out of
+  // room, and compressing them would be wasted work.
+  void Disable() { disabled_.store(true, std::memory_order_relaxed); }
+
+ private:
+  std::shared_ptr<Cache> block_cache_compressed_;
+  const CompressionType compression_type_;
+  const uint32_t format_version_;
+  const size_t cache_key_prefix_size_;
+  const std::string compressed_cache_key_prefix_;
+  std::atomic<bool> disabled_;
+};
+
+namespace {
+
+// Delete a data block evicted from the block cache, after demoting it to the
+// compressed block cache.
+void DemoteCachedBlock(const Slice& key, void* value) {
+  Block* block = reinterpret_cast<Block*>(value);
+  block->demoter()->Demote(key, *block);
+  delete block;
+}
+
 }  // namespace
 
 // Index that allows binary search lookup in a two-level index structure.
@@ -523,6 +676,18 @@ Slice BlockBasedTable::GetCacheKey(const char* cache_key_prefix,
   return Slice(cache_key, static_cast<size_t>(end - cache_key));
 }
 
+RMIConfig BlockBasedTable::LearnedModelConfig() {
+  RMIConfig rmi_config;
+  RMIConfig::StageConfig first, second;
+  first.model_type = RMIConfig::StageConfig::LinearRegression;
+  first.model_n = 1;
+  second.model_n = 1000;
+  second.model_type = RMIConfig::StageConfig::LinearRegression;
+  rmi_config.stage_configs.push_back(first);
+  rmi_config.stage_configs.push_back(second);
+  return rmi_config;
+}
+
 Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
                              const EnvOptions& env_options,
                              const BlockBasedTableOptions& table_options,
@@ -533,6 +698,7 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
                              const bool prefetch_index_and_filter_in_cache,
                              const bool skip_filters, const int level) {
   table_reader->reset();
+  ScopedBlockCacheTraceCaller trace_caller(BlockCacheTraceCaller::kPrefetch);
 
   Footer footer;
 
@@ -551,27 +717,13 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
         "version of RocksDB?");
   }
 
-  //read model
-  size_t n = static_cast<size_t>(footer.learned_handle().size());
-  char* buf = new char[n];
-  Slice contents;
-  s = file->Read(footer.learned_handle().offset(), n, &contents, buf);
-
-  RMIConfig rmi_config;
-  RMIConfig::StageConfig first, second;
-  first.model_type = RMIConfig::StageConfig::LinearRegression;
-  first.model_n = 1;
-  second.model_n = 1000;
-  second.model_type = RMIConfig::StageConfig::LinearRegression;
-  rmi_config.stage_configs.push_back(first);
-  rmi_config.stage_configs.push_back(second);
-
   // We've successfully read the footer. We are ready to serve requests.
   // Better not mutate rep_ after the creation. eg. internal_prefix_transform
   // raw pointer will be used to create HashIndexReader, whose reset may
   // access a dangling pointer.
   Rep* rep = new BlockBasedTable::Rep(ioptions, env_options, table_options,
                                       internal_comparator, skip_filters);
+  rep->level = level;
   rep->block_pos.clear();
 
   // delete iiter;
@@ -580,7 +732,6 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
   rep->footer = footer;
   rep->index_type = table_options.index_type;
   rep->hash_index_allow_collision = table_options.hash_index_allow_collision;
-  rep->learnedMod = new LearnedRangeIndexSingleKey<uint64_t,float> (string(contents.data(),contents.size()), rmi_config);
   // We need to wrap data with internal_prefix_transform to make sure it can
   // handle prefix correctly.
   rep->internal_prefix_transform.reset(
@@ -588,6 +739,16 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
   SetupCacheKeyPrefix(rep, file_size);
   unique_ptr<BlockBasedTable> new_table(new BlockBasedTable(rep));
 
+  // Without a block cache to hold it, the learned model is loaded here and
+  // kept until the table is closed.
+  if (!table_options.cache_learned_model_blocks ||
+      table_options.block_cache == nullptr) {
+    s = ReadLearnedModel(rep, &rep->learned_model);
+    if (!s.ok()) {
+      return s;
+    }
+  }
+
   // page cache options
   rep->persistent_cache_options =
       PersistentCacheOptions(rep->table_options.persistent_cache,
@@ -691,6 +852,21 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
     }
   }
 
+  // Blocks are demoted without a dictionary, so tables that have one keep
+  // filling the compressed block cache as they read blocks instead.
+  if (table_options.demote_evicted_blocks &&
+      table_options.block_cache != nullptr &&
+      table_options.block_cache_compressed != nullptr &&
+      rep->compression_dict_block == nullptr) {
+    rep->block_demoter = std::make_shared<BlockDemoter>(
+        table_options.block_cache_compressed,
+        table_options.demoted_block_compression,
+        table_options.format_version,
+        Slice(rep->cache_key_prefix, rep->cache_key_prefix_size),
+        Slice(rep->compressed_cache_key_prefix,
+              rep->compressed_cache_key_prefix_size));
+  }
+
   // Read the range del meta block
   bool found_range_del_block;
   s = SeekToRangeDelBlock(meta_iter.get(), &found_range_del_block,
@@ -715,6 +891,33 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
     }
   }
 
+  // Read the index partition sizes ModelGet() maps data blocks with. Without
+  // them it falls back to the handles of all data blocks, read below.
+  {
+    Status partitions_status = ReadModelPartitions(rep, meta_iter.get());
+    if (!partitions_status.ok()) {
+      ROCKS_LOG_WARN(rep->ioptions.info_log,
+                     "Encountered error while reading model partitions %s",
+                     partitions_status.ToString().c_str());
+    }
+  }
+
+  // Answer ApproximateOffsetOf() from the model if its recorded error,
+  // scaled from raw to stored bytes, is within the configured bound.
+  if (table_options.model_offset_max_error > 0 && rep->table_properties) {
+    const TableProperties& props = *rep->table_properties;
+    bool property_present = false;
+    uint64_t raw_error = GetModelMaxOffsetError(
+        props.user_collected_properties, &property_present);
+    uint64_t raw_size = props.raw_key_size + props.raw_value_size;
+    if (property_present && raw_size > 0) {
+      double error = static_cast<double>(raw_error) / raw_size *
+                     static_cast<double>(props.data_size);
+      rep->model_offsets =
+          error <= static_cast<double>(table_options.model_offset_max_error);
+    }
+  }
+
   // Determine whether whole key filtering is supported.
   if (rep->table_properties) {
     rep->whole_key_filtering &=
@@ -793,14 +996,31 @@ Status BlockBasedTable::Open(const ImmutableCFOptions& ioptions,
     }
   }
 
+  // Load a block-cached learned model like the index and filter above, and
+  // keep it checked out for level-0 files if asked to.
+  if (s.ok() && rep->learned_model == nullptr &&
+      (prefetch_index_and_filter_in_cache || level == 0)) {
+    CachableEntry<LearnedModelReader> model_entry;
+    s = new_table->GetLearnedModel(false /* no_io */, &model_entry);
+    if (s.ok()) {
+      if (table_options.pin_l0_learned_model_in_cache && level == 0) {
+        rep->learned_model_entry = model_entry;
+      } else {
+        new_table->ReleaseLearnedModel(&model_entry);
+      }
+    }
+  }
+
   if (s.ok()) {
-    BlockIter iiter_on_stack;
-    auto iiter = new_table->NewIndexIterator(ReadOptions(), nullptr);
-    for (iiter->SeekToFirst(); iiter->Valid(); iiter->Next()) {
-      Slice handle_value = iiter->value();
-      BlockHandle handle;
-      handle.DecodeFrom(&handle_value);
-      rep->block_pos.push_back({handle.offset(),handle.size()});
+    if (rep->model_partitions.empty()) {
+      unique_ptr<InternalIterator> iiter(
+          new_table->NewIndexIterator(ReadOptions(), nullptr));
+      for (iiter->SeekToFirst(); iiter->Valid(); iiter->Next()) {
+        Slice handle_value = iiter->value();
+        BlockHandle handle;
+        handle.DecodeFrom(&handle_value);
+        rep->block_pos.push_back({handle.offset(),handle.size()});
+      }
     }
     *table_reader = std::move(new_table);
   }
@@ -842,6 +1062,9 @@ size_t BlockBasedTable::ApproximateMemoryUsage() const {
   if (rep_->index_reader) {
     usage += rep_->index_reader->ApproximateMemoryUsage();
   }
+  if (rep_->learned_model) {
+    usage += rep_->learned_model->ApproximateMemoryUsage();
+  }
   return usage;
 }
 
@@ -881,11 +1104,15 @@ Status BlockBasedTable::GetDataBlockFromCache(
     const ImmutableCFOptions& ioptions, const ReadOptions& read_options,
     BlockBasedTable::CachableEntry<Block>* block, uint32_t format_version,
     const Slice& compression_dict, size_t read_amp_bytes_per_bit,
-    bool is_index) {
+    bool is_index, const std::shared_ptr<BlockDemoter>& demoter,
+    BlockCacheTracer* tracer, int level) {
   Status s;
   Block* compressed_block = nullptr;
   Cache::Handle* block_cache_compressed_handle = nullptr;
   Statistics* statistics = ioptions.statistics;
+  const BlockCacheTraceBlockType block_type =
+      is_index ? BlockCacheTraceBlockType::kIndex
+               : BlockCacheTraceBlockType::kData;
 
   // Lookup uncompressed cache first
   if (block_cache != nullptr) {
@@ -893,6 +1120,10 @@ Status BlockBasedTable::GetDataBlockFromCache(
         block_cache, block_cache_key,
         is_index ? BLOCK_CACHE_INDEX_MISS : BLOCK_CACHE_DATA_MISS,
         is_index ? BLOCK_CACHE_INDEX_HIT : BLOCK_CACHE_DATA_HIT, statistics);
+    TraceBlockCacheLookup(tracer, block_cache, block_cache_key,
+                          block->cache_handle, block_type, level,
+                          read_options.fill_cache &&
+                              read_options.read_tier != kBlockCacheTier);
     if (block->cache_handle != nullptr) {
       block->value =
           reinterpret_cast<Block*>(block_cache->Value(block->cache_handle));
@@ -925,10 +1156,10 @@ Status BlockBasedTable::GetDataBlockFromCache(
 
   // Retrieve the uncompressed contents into a new buffer
   BlockContents contents;
-  s = UncompressBlockContents(compressed_block->data(),
-                              compressed_block->size(), &contents,
-                              format_version, compression_dict,
-                              ioptions);
+  s = UncompressBlockContents(
+      compressed_block->data(), compressed_block->size(), &contents,
+      format_version, compression_dict, ioptions,
+      block_cache != nullptr ? block_cache->memory_allocator() : nullptr);
 
   // Insert uncompressed block into block cache
   if (s.ok()) {
@@ -939,10 +1170,22 @@ Status BlockBasedTable::GetDataBlockFromCache(
     assert(block->value->compression_type() == kNoCompression);
     if (block_cache != nullptr && block->value->cachable() &&
         read_options.fill_cache) {
+      const bool demote = demoter != nullptr && !is_index;
+      if (demote) {
+        block->value->set_demoter(demoter);
+      }
       s = block_cache->Insert(
           block_cache_key, block->value, block->value->usable_size(),
-          &DeleteCachedEntry<Block>, &(block->cache_handle));
+          demote ? &DemoteCachedBlock : &DeleteCachedEntry<Block>,
+          &(block->cache_handle));
       if (s.ok()) {
+        if (demote) {
+          // The block moved back up; the compressed copy is freed once
+          // released below.
+          block_cache_compressed->Erase(compressed_block_cache_key);
+        }
+        TraceBlockCacheInsert(tracer, block_cache_key, block_type, level,
+                              block->value->usable_size());
         RecordTick(statistics, BLOCK_CACHE_ADD);
         if (is_index) {
           RecordTick(statistics, BLOCK_CACHE_INDEX_ADD);
@@ -974,7 +1217,8 @@ Status BlockBasedTable::PutDataBlockToCache(
     const ReadOptions& read_options, const ImmutableCFOptions& ioptions,
     CachableEntry<Block>* block, Block* raw_block, uint32_t format_version,
     const Slice& compression_dict, size_t read_amp_bytes_per_bit, bool is_index,
-    Cache::Priority priority) {
+    Cache::Priority priority, const std::shared_ptr<BlockDemoter>& demoter,
+    BlockCacheTracer* tracer, int level) {
   assert(raw_block->compression_type() == kNoCompression ||
          block_cache_compressed != nullptr);
 
@@ -983,8 +1227,10 @@ Status BlockBasedTable::PutDataBlockToCache(
   BlockContents contents;
   Statistics* statistics = ioptions.statistics;
   if (raw_block->compression_type() != kNoCompression) {
-    s = UncompressBlockContents(raw_block->data(), raw_block->size(), &contents,
-                                format_version, compression_dict, ioptions);
+    s = UncompressBlockContents(
+        raw_block->data(), raw_block->size(), &contents, format_version,
+        compression_dict, ioptions,
+        block_cache != nullptr ? block_cache->memory_allocator() : nullptr);
   }
   if (!s.ok()) {
     delete raw_block;
@@ -1000,10 +1246,11 @@ Status BlockBasedTable::PutDataBlockToCache(
     raw_block = nullptr;
   }
 
-  // Insert compressed block into compressed block cache.
+  // Insert compressed block into compressed block cache, unless it only
+  // takes blocks demoted from the block cache.
   // Release the hold on the compressed cache entry immediately.
   if (block_cache_compressed != nullptr && raw_block != nullptr &&
-      raw_block->cachable()) {
+      raw_block->cachable() && demoter == nullptr) {
     s = block_cache_compressed->Insert(compressed_block_cache_key, raw_block,
                                        raw_block->usable_size(),
                                        &DeleteCachedEntry<Block>);
@@ -1020,11 +1267,20 @@ Status BlockBasedTable::PutDataBlockToCache(
   // insert into uncompressed block cache
   assert((block->value->compression_type() == kNoCompression));
   if (block_cache != nullptr && block->value->cachable()) {
+    const bool demote = demoter != nullptr && !is_index;
+    if (demote) {
+      block->value->set_demoter(demoter);
+    }
     s = block_cache->Insert(
         block_cache_key, block->value, block->value->usable_size(),
-        &DeleteCachedEntry<Block>, &(block->cache_handle), priority);
+        demote ? &DemoteCachedBlock : &DeleteCachedEntry<Block>,
+        &(block->cache_handle), priority);
     if (s.ok()) {
       assert(block->cache_handle != nullptr);
+      TraceBlockCacheInsert(tracer, block_cache_key,
+                            is_index ? BlockCacheTraceBlockType::kIndex
+                                     : BlockCacheTraceBlockType::kData,
+                            level, block->value->usable_size());
       RecordTick(statistics, BLOCK_CACHE_ADD);
       if (is_index) {
         RecordTick(statistics, BLOCK_CACHE_INDEX_ADD);
@@ -1147,6 +1403,10 @@ BlockBasedTable::CachableEntry<FilterBlockReader> BlockBasedTable::GetFilter(
   auto cache_handle =
       GetEntryFromCache(block_cache, key, BLOCK_CACHE_FILTER_MISS,
                         BLOCK_CACHE_FILTER_HIT, statistics);
+  BlockCacheTracer* tracer = rep_->table_options.block_cache_tracer.get();
+  TraceBlockCacheLookup(tracer, block_cache, key, cache_handle,
+                        BlockCacheTraceBlockType::kFilter, rep_->level,
+                        !no_io);
 
   FilterBlockReader* filter = nullptr;
   if (cache_handle != nullptr) {
@@ -1165,6 +1425,8 @@ BlockBasedTable::CachableEntry<FilterBlockReader> BlockBasedTable::GetFilter(
               ? Cache::Priority::HIGH
               : Cache::Priority::LOW);
       if (s.ok()) {
+        TraceBlockCacheInsert(tracer, key, BlockCacheTraceBlockType::kFilter,
+                              rep_->level, filter->size());
         RecordTick(statistics, BLOCK_CACHE_ADD);
         RecordTick(statistics, BLOCK_CACHE_FILTER_ADD);
         RecordTick(statistics, BLOCK_CACHE_FILTER_BYTES_INSERT, filter->size());
@@ -1206,6 +1468,9 @@ InternalIterator* BlockBasedTable::NewIndexIterator(
   auto cache_handle =
       GetEntryFromCache(block_cache, key, BLOCK_CACHE_INDEX_MISS,
                         BLOCK_CACHE_INDEX_HIT, statistics);
+  BlockCacheTracer* tracer = rep_->table_options.block_cache_tracer.get();
+  TraceBlockCacheLookup(tracer, block_cache, key, cache_handle,
+                        BlockCacheTraceBlockType::kIndex, rep_->level, !no_io);
 
   if (cache_handle == nullptr && no_io) {
     if (input_iter != nullptr) {
@@ -1240,6 +1505,8 @@ InternalIterator* BlockBasedTable::NewIndexIterator(
 
     if (s.ok()) {
       size_t usable_size = index_reader->usable_size();
+      TraceBlockCacheInsert(tracer, key, BlockCacheTraceBlockType::kIndex,
+                            rep_->level, usable_size);
       RecordTick(statistics, BLOCK_CACHE_ADD);
       RecordTick(statistics, BLOCK_CACHE_INDEX_ADD);
       RecordTick(statistics, BLOCK_CACHE_INDEX_BYTES_INSERT, usable_size);
@@ -1383,7 +1650,9 @@ Status BlockBasedTable::MaybeLoadDataBlockToCache(
     s = GetDataBlockFromCache(
         key, ckey, block_cache, block_cache_compressed, rep->ioptions, ro,
         block_entry, rep->table_options.format_version, compression_dict,
-        rep->table_options.read_amp_bytes_per_bit, is_index);
+        rep->table_options.read_amp_bytes_per_bit, is_index,
+        rep->block_demoter, rep->table_options.block_cache_tracer.get(),
+        rep->level);
 
     if (block_entry->value == nullptr && !no_io && ro.fill_cache) {
       std::unique_ptr<Block> raw_block;
@@ -1393,7 +1662,9 @@ Status BlockBasedTable::MaybeLoadDataBlockToCache(
             rep->file.get(), rep->footer, ro, handle, &raw_block, rep->ioptions,
             block_cache_compressed == nullptr, compression_dict,
             rep->persistent_cache_options, rep->global_seqno,
-            rep->table_options.read_amp_bytes_per_bit);
+            rep->table_options.read_amp_bytes_per_bit,
+            block_cache != nullptr ? block_cache->memory_allocator()
+                                   : nullptr);
       }
 
       if (s.ok()) {
@@ -1406,7 +1677,9 @@ Status BlockBasedTable::MaybeLoadDataBlockToCache(
                     rep->table_options
                         .cache_index_and_filter_blocks_with_high_priority
                 ? Cache::Priority::HIGH
-                : Cache::Priority::LOW);
+                : Cache::Priority::LOW,
+            rep->block_demoter, rep->table_options.block_cache_tracer.get(),
+            rep->level);
       }
     }
   }
@@ -1639,6 +1912,7 @@ bool BlockBasedTable::FullFilterKeyMayMatch(const ReadOptions& read_options,
 Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
                             GetContext* get_context, bool skip_filters) {
   Status s;
+  ScopedBlockCacheTraceCaller trace_caller(BlockCacheTraceCaller::kGet);
   // std::cout << " begin read! " << std::endl;
   const bool no_io = read_options.read_tier == kBlockCacheTier;
   CachableEntry<FilterBlockReader> filter_entry;
@@ -1678,15 +1952,6 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
       } else {
         BlockIter biter;
         handle.DecodeFrom(&handle_value);
-        uint64_t lekey = key.Touint64_t();
-        auto value_get = rep_->learnedMod->get(lekey);
-        int block_num = value_get / 4096;
-
-        if (rep_->block_pos[block_num].first != handle.offset()){
-          std::cout << __func__ << " no find key: " << lekey << " ;block_num:" << block_num << std::endl;
-          std::cout << __func__ << " handle_offset: " << handle.offset() << " ;handle_size: " << handle.size() << std::endl;
-          std::cout << __func__ << " ModelGet_offset: " << rep_->block_pos[block_num].first << " ;ModelGet_size: " << rep_->block_pos[block_num].second << std::endl;
-        }
         NewDataBlockIterator(rep_, read_options, handle, &biter);
         // std::cout << __func__ << " NewDataBlockIterator over"  << std::endl;
         if (read_options.read_tier == kBlockCacheTier &&
@@ -1735,9 +2000,247 @@ Status BlockBasedTable::Get(const ReadOptions& read_options, const Slice& key,
   return s;
 }
 
+Status BlockBasedTable::LearnedModelReader::Create(
+    std::string&& contents, std::unique_ptr<LearnedModelReader>* result) {
+  std::unique_ptr<LearnedModelReader> reader(new LearnedModelReader());
+  reader->encoded_size_ = contents.size();
+  if (CompactLearnedModel::IsCompact(contents)) {
+    reader->compact_.reset(new CompactLearnedModel());
+    Status s = reader->compact_->Init(std::move(contents));
+    if (!s.ok()) {
+      return s;
+    }
+  } else {
+    reader->rmi_.reset(new LearnedRangeIndexSingleKey<uint64_t, float>(
+        contents, LearnedModelConfig()));
+    reader->kernel_ = NewRMIKernel(reader->rmi_->rmi);
+    if (reader->kernel_ != nullptr) {
+      reader->rmi_.reset();
+    }
+  }
+  *result = std::move(reader);
+  return Status::OK();
+}
+
+uint64_t BlockBasedTable::LearnedModelReader::Predict(uint64_t key) const {
+  if (kernel_ != nullptr) {
+    return static_cast<uint64_t>(kernel_->Predict(key));
+  }
+  if (compact_ != nullptr) {
+    return static_cast<uint64_t>(compact_->Predict(key));
+  }
+  return static_cast<uint64_t>(rmi_->get(key));
+}
+
+size_t BlockBasedTable::LearnedModelReader::ApproximateMemoryUsage() const {
+  size_t usage = sizeof(*this);
+  if (kernel_ != nullptr) {
+    usage += kernel_->ApproximateMemoryUsage();
+  } else if (compact_ != nullptr) {
+    usage += sizeof(*compact_) + compact_->size();
+  } else {
+    // The decoded stages take about as much as their serialized form.
+    usage += sizeof(*rmi_) + encoded_size_;
+  }
+  return usage;
+}
+
+Status BlockBasedTable::ReadLearnedModel(
+    Rep* rep, std::unique_ptr<LearnedModelReader>* result) {
+  const BlockHandle& handle = rep->footer.learned_handle();
+  size_t n = static_cast<size_t>(handle.size());
+  std::unique_ptr<char[]> buf(new char[n]);
+  Slice contents;
+  Status s = rep->file->Read(handle.offset(), n, &contents, buf.get());
+  if (!s.ok()) {
+    return s;
+  }
+  return LearnedModelReader::Create(contents.ToString(), result);
+}
+
+Status BlockBasedTable::GetLearnedModel(
+    bool no_io, CachableEntry<LearnedModelReader>* entry) const {
+  if (rep_->learned_model != nullptr) {
+    *entry = {rep_->learned_model.get(), nullptr /* cache handle */};
+    return Status::OK();
+  }
+  if (rep_->learned_model_entry.IsSet()) {
+    *entry = rep_->learned_model_entry;
+    return Status::OK();
+  }
+
+  Cache* block_cache = rep_->table_options.block_cache.get();
+  assert(block_cache != nullptr);
+  char cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
+  auto key = GetCacheKey(rep_->cache_key_prefix, rep_->cache_key_prefix_size,
+                         rep_->footer.learned_handle(), cache_key);
+
+  Statistics* statistics = rep_->ioptions.statistics;
+  auto cache_handle =
+      GetEntryFromCache(block_cache, key, BLOCK_CACHE_LEARNED_MODEL_MISS,
+                        BLOCK_CACHE_LEARNED_MODEL_HIT, statistics);
+  BlockCacheTracer* tracer = rep_->table_options.block_cache_tracer.get();
+  TraceBlockCacheLookup(tracer, block_cache, key, cache_handle,
+                        BlockCacheTraceBlockType::kLearnedModel, rep_->level,
+                        !no_io);
+  if (cache_handle != nullptr) {
+    *entry = {reinterpret_cast<LearnedModelReader*>(
+                  block_cache->Value(cache_handle)),
+              cache_handle};
+    return Status::OK();
+  }
+  if (no_io) {
+    return Status::Incomplete("no blocking io");
+  }
+
+  std::unique_ptr<LearnedModelReader> model;
+  Status s = ReadLearnedModel(rep_, &model);
+  if (!s.ok()) {
+    return s;
+  }
+  // The model is consulted on every lookup in the table, so it is cached
+  // with high priority like the index and filter blocks can be.
+  size_t charge = model->ApproximateMemoryUsage();
+  s = block_cache->Insert(key, model.get(), charge,
+                          &DeleteCachedEntry<LearnedModelReader>,
+                          &cache_handle, Cache::Priority::HIGH);
+  if (!s.ok()) {
+    RecordTick(statistics, BLOCK_CACHE_ADD_FAILURES);
+    return s;
+  }
+  TraceBlockCacheInsert(tracer, key, BlockCacheTraceBlockType::kLearnedModel,
+                        rep_->level, charge);
+  RecordTick(statistics, BLOCK_CACHE_ADD);
+  RecordTick(statistics, BLOCK_CACHE_LEARNED_MODEL_ADD);
+  RecordTick(statistics, BLOCK_CACHE_LEARNED_MODEL_BYTES_INSERT, charge);
+  RecordTick(statistics, BLOCK_CACHE_BYTES_WRITE, charge);
+  *entry = {model.release(), cache_handle};
+  return Status::OK();
+}
+
+void BlockBasedTable::ReleaseLearnedModel(
+    CachableEntry<LearnedModelReader>* entry) const {
+  // An entry pinned in rep_ is released when the table is closed.
+  if (entry->cache_handle != nullptr && !rep_->learned_model_entry.IsSet()) {
+    entry->Release(rep_->table_options.block_cache.get());
+  }
+  entry->value = nullptr;
+  entry->cache_handle = nullptr;
+}
+
+size_t BlockBasedTable::NumModelBlocks() const {
+  if (rep_->model_partitions.empty()) {
+    return rep_->block_pos.size();
+  }
+  return rep_->model_partition_first_block.back();
+}
+
+Status BlockBasedTable::GetModelBlockHandle(const ReadOptions& read_options,
+                                            uint32_t block_num,
+                                            BlockHandle* handle) const {
+  if (rep_->model_partitions.empty()) {
+    *handle = BlockHandle(rep_->block_pos[block_num].first,
+                          rep_->block_pos[block_num].second);
+    return Status::OK();
+  }
+
+  // Partitions are cut by size, so they hold about as many blocks each:
+  // start at the partition block_num falls in proportionally and step to
+  // the one that holds it, usually zero or one step away.
+  const std::vector<uint32_t>& first_block = rep_->model_partition_first_block;
+  size_t num_partitions = rep_->model_partitions.size();
+  assert(block_num < first_block.back());
+  size_t p = static_cast<size_t>(static_cast<uint64_t>(block_num) *
+                                 num_partitions / first_block.back());
+  while (p > 0 && first_block[p] > block_num) {
+    p--;
+  }
+  while (first_block[p + 1] <= block_num) {
+    p++;
+  }
+
+  BlockIter iiter;
+  NewDataBlockIterator(rep_, read_options, rep_->model_partitions[p], &iiter,
+                       true /* is_index */);
+  if (!iiter.status().ok()) {
+    return iiter.status();
+  }
+  iiter.SeekToEntry(block_num - first_block[p],
+                    rep_->model_partition_restart_interval);
+  if (!iiter.Valid()) {
+    return Status::Corruption("index partition has fewer blocks than recorded");
+  }
+  Slice handle_value = iiter.value();
+  return handle->DecodeFrom(&handle_value);
+}
+
+Status BlockBasedTable::ReadModelPartitions(Rep* rep,
+                                            InternalIterator* meta_iter) {
+  BlockHandle partitions_handle;
+  if (!FindMetaBlock(meta_iter, kModelPartitionsBlock, &partitions_handle)
+           .ok()) {
+    // The index is not partitioned, or the table predates the block.
+    return Status::OK();
+  }
+  BlockContents partitions_contents;
+  Status s = ReadBlockContents(rep->file.get(), rep->footer, ReadOptions(),
+                               partitions_handle, &partitions_contents,
+                               rep->ioptions, false /* decompress */);
+  if (!s.ok()) {
+    return s;
+  }
+  Slice input = partitions_contents.data;
+  uint32_t restart_interval = 0;
+  if (!GetFixed32(&input, &restart_interval) || restart_interval == 0 ||
+      input.size() % sizeof(uint32_t) != 0) {
+    return Status::Corruption("bad model partitions block");
+  }
+  std::vector<uint32_t> first_block(1, 0);
+  uint32_t num_blocks = 0;
+  while (GetFixed32(&input, &num_blocks)) {
+    first_block.push_back(first_block.back() + num_blocks);
+  }
+
+  // The top-level index holds the handle of each partition, in order.
+  std::unique_ptr<Block> index_block;
+  s = ReadBlockFromFile(rep->file.get(), rep->footer, ReadOptions(),
+                        rep->footer.index_handle(), &index_block, rep->ioptions,
+                        true /* decompress */, Slice() /*compression dict*/,
+                        rep->persistent_cache_options,
+                        kDisableGlobalSequenceNumber,
+                        0 /* read_amp_bytes_per_bit */);
+  if (!s.ok()) {
+    return s;
+  }
+  std::vector<BlockHandle> partitions;
+  std::unique_ptr<InternalIterator> iter(
+      index_block->NewIterator(&rep->internal_comparator, nullptr, true));
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    Slice handle_value = iter->value();
+    BlockHandle partition;
+    s = partition.DecodeFrom(&handle_value);
+    if (!s.ok()) {
+      return s;
+    }
+    partitions.push_back(partition);
+  }
+  if (!iter->status().ok()) {
+    return iter->status();
+  }
+  if (partitions.size() + 1 != first_block.size()) {
+    return Status::Corruption("model partitions do not match the index");
+  }
+
+  rep->model_partitions = std::move(partitions);
+  rep->model_partition_first_block = std::move(first_block);
+  rep->model_partition_restart_interval = restart_interval;
+  return Status::OK();
+}
+
 Status BlockBasedTable::ModelGet(const ReadOptions& read_options, const Slice& key,
                             GetContext* get_context, bool skip_filters) {
   Status s;
+  ScopedBlockCacheTraceCaller trace_caller(BlockCacheTraceCaller::kGet);
   const bool no_io = read_options.read_tier == kBlockCacheTier;
   CachableEntry<FilterBlockReader> filter_entry;
   if (!skip_filters) {
@@ -1757,12 +2260,47 @@ Status BlockBasedTable::ModelGet(const ReadOptions& read_options, const Slice& k
     //   iiter_unique_ptr.reset(iiter);
     // }
     uint64_t lekey = key.Touint64_t();
-    auto value_get = rep_->learnedMod->get(lekey);
-    int block_num = value_get / 4096;
 
     bool done = false;
     do {
-      BlockHandle handle(rep_->block_pos[block_num].first, rep_->block_pos[block_num].second);
+      size_t num_blocks = NumModelBlocks();
+      if (num_blocks == 0) {
+        break;
+      }
+      CachableEntry<LearnedModelReader> model_entry;
+      s = GetLearnedModel(no_io, &model_entry);
+      if (no_io && s.IsIncomplete()) {
+        // The learned model is not in the block cache.
+        get_context->MarkKeyMayExist();
+        s = Status::OK();
+        break;
+      }
+      if (!s.ok()) {
+        break;
+      }
+      auto value_get = model_entry.value->Predict(lekey);
+      ReleaseLearnedModel(&model_entry);
+      int block_num = static_cast<int>(
+          std::min<uint64_t>(value_get / 4096, port::kMaxInt32));
+      // Keys outside the trained range can be predicted past either end of
+      // the table; look in the nearest data block instead.
+      if (block_num < 0) {
+        block_num = 0;
+      } else if (static_cast<size_t>(block_num) >= num_blocks) {
+        block_num = static_cast<int>(num_blocks) - 1;
+      }
+      BlockHandle handle;
+      s = GetModelBlockHandle(read_options, static_cast<uint32_t>(block_num),
+                              &handle);
+      if (no_io && s.IsIncomplete()) {
+        // The index partition is not in the block cache.
+        get_context->MarkKeyMayExist();
+        s = Status::OK();
+        break;
+      }
+      if (!s.ok()) {
+        break;
+      }
       bool not_exist_in_filter =
           filter != nullptr && filter->IsBlockBased() == true &&
           !filter->KeyMayMatch(ExtractUserKey(key), handle.offset(), no_io);
@@ -1828,6 +2366,7 @@ Status BlockBasedTable::Prefetch(const Slice* const begin,
   if (begin && end && comparator.Compare(*begin, *end) > 0) {
     return Status::InvalidArgument(*begin, *end);
   }
+  ScopedBlockCacheTraceCaller trace_caller(BlockCacheTraceCaller::kPrefetch);
 
   BlockIter iiter_on_stack;
   auto iiter = NewIndexIterator(ReadOptions(), &iiter_on_stack);
@@ -1871,6 +2410,100 @@ Status BlockBasedTable::Prefetch(const Slice* const begin,
   return Status::OK();
 }
 
+Cache* BlockBasedTable::GetBlockCacheKeyPrefix(Slice* key_prefix) const {
+  Cache* block_cache = rep_->table_options.block_cache.get();
+  if (block_cache == nullptr || rep_->cache_key_prefix_size == 0) {
+    return nullptr;
+  }
+  *key_prefix = Slice(rep_->cache_key_prefix, rep_->cache_key_prefix_size);
+  return block_cache;
+}
+
+Status BlockBasedTable::WarmUpMetaBlocks() {
+  ScopedBlockCacheTraceCaller trace_caller(BlockCacheTraceCaller::kPrefetch);
+  Status s;
+  if (rep_->table_options.cache_index_and_filter_blocks) {
+    // As in Open(), reading them through the cache inserts them into it.
+    std::unique_ptr<InternalIterator> iiter(NewIndexIterator(ReadOptions()));
+    s = iiter->status();
+    if (s.ok()) {
+      auto filter_entry = GetFilter();
+      filter_entry.Release(rep_->table_options.block_cache.get());
+    }
+  }
+  if (s.ok() && rep_->learned_model == nullptr) {
+    CachableEntry<LearnedModelReader> model_entry;
+    s = GetLearnedModel(false /* no_io */, &model_entry);
+    if (s.ok()) {
+      ReleaseLearnedModel(&model_entry);
+    }
+  }
+  return s;
+}
+
+Status BlockBasedTable::WarmUpDataBlocks(const std::vector<uint64_t>& offsets,
+                                         RateLimiter* rate_limiter,
+                                         const std::atomic<bool>* stop) {
+  Cache* block_cache = rep_->table_options.block_cache.get();
+  if (block_cache == nullptr || offsets.empty()) {
+    return Status::OK();
+  }
+  assert(std::is_sorted(offsets.begin(), offsets.end()));
+  ScopedBlockCacheTraceCaller trace_caller(BlockCacheTraceCaller::kPrefetch);
+
+  BlockIter iiter_on_stack;
+  auto iiter = NewIndexIterator(ReadOptions(), &iiter_on_stack);
+  std::unique_ptr<InternalIterator> iiter_unique_ptr;
+  if (iiter != &iiter_on_stack) {
+    iiter_unique_ptr = std::unique_ptr<InternalIterator>(iiter);
+  }
+  if (!iiter->status().ok()) {
+    return iiter->status();
+  }
+
+  Slice compression_dict;
+  if (rep_->compression_dict_block) {
+    compression_dict = rep_->compression_dict_block->data;
+  }
+  // Walk the index and the offsets together, loading the blocks in both.
+  auto next = offsets.begin();
+  for (iiter->SeekToFirst(); iiter->Valid() && next != offsets.end();
+       iiter->Next()) {
+    if (stop != nullptr && stop->load(std::memory_order_relaxed)) {
+      return Status::Incomplete("block cache warm-up stopped");
+    }
+    if (block_cache->GetUsage() >= block_cache->GetCapacity()) {
+      return Status::Incomplete("block cache full");
+    }
+    Slice input = iiter->value();
+    BlockHandle handle;
+    Status s = handle.DecodeFrom(&input);
+    if (!s.ok()) {
+      return s;
+    }
+    next = std::lower_bound(next, offsets.end(), handle.offset());
+    if (next == offsets.end() || *next != handle.offset()) {
+      continue;
+    }
+    if (rate_limiter != nullptr) {
+      int64_t bytes = static_cast<int64_t>(handle.size() + kBlockTrailerSize);
+      while (bytes > 0) {
+        int64_t request = std::min(bytes, rate_limiter->GetSingleBurstBytes());
+        rate_limiter->Request(request, Env::IO_LOW, rep_->ioptions.statistics);
+        bytes -= request;
+      }
+    }
+    CachableEntry<Block> block;
+    s = MaybeLoadDataBlockToCache(rep_, ReadOptions(), handle,
+                                  compression_dict, &block);
+    if (!s.ok()) {
+      return s;
+    }
+    block.Release(block_cache);
+  }
+  return iiter->status();
+}
+
 bool BlockBasedTable::TEST_KeyInCache(const ReadOptions& options,
                                       const Slice& key) {
   std::unique_ptr<InternalIterator> iiter(NewIndexIterator(options));
@@ -1981,7 +2614,32 @@ Status BlockBasedTable::CreateIndexReader(
   }
 }
 
+uint64_t BlockBasedTable::ModelRawOffset(uint64_t predicted,
+                                         uint64_t raw_size,
+                                         uint64_t num_entries) {
+  if (num_entries == 0) {
+    return 0;
+  }
+  uint64_t average_entry = raw_size / num_entries;
+  return std::min(predicted > average_entry ? predicted - average_entry : 0,
+                  raw_size);
+}
+
 uint64_t BlockBasedTable::ApproximateOffsetOf(const Slice& key) {
+  CachableEntry<LearnedModelReader> model_entry;
+  if (rep_->model_offsets &&
+      GetLearnedModel(false /* no_io */, &model_entry).ok()) {
+    // Assume stored bytes follow raw bytes evenly through the data blocks.
+    const TableProperties& props = *rep_->table_properties;
+    uint64_t raw_size = props.raw_key_size + props.raw_value_size;
+    uint64_t raw_offset =
+        ModelRawOffset(model_entry.value->Predict(key.Touint64_t()), raw_size,
+                       props.num_entries);
+    ReleaseLearnedModel(&model_entry);
+    return static_cast<uint64_t>(static_cast<double>(raw_offset) / raw_size *
+                                 static_cast<double>(props.data_size));
+  }
+
   unique_ptr<InternalIterator> index_iter(NewIndexIterator(ReadOptions()));
 
   index_iter->Seek(key);
@@ -2208,9 +2866,13 @@ Status BlockBasedTable::DumpTable(WritableFile* out_file) {
 }
 
 void BlockBasedTable::Close() {
+  if (rep_->block_demoter != nullptr) {
+    rep_->block_demoter->Disable();
+  }
   rep_->filter_entry.Release(rep_->table_options.block_cache.get());
   rep_->index_entry.Release(rep_->table_options.block_cache.get());
   rep_->range_del_entry.Release(rep_->table_options.block_cache.get());
+  rep_->learned_model_entry.Release(rep_->table_options.block_cache.get());
   // cleanup index and filter blocks to avoid accessing dangling pointer
   if (!rep_->table_options.no_block_cache) {
     char cache_key[kMaxCacheKeyPrefixSize + kMaxVarint64Length];
@@ -2223,6 +2885,11 @@ void BlockBasedTable::Close() {
                                 rep_->cache_key_prefix_size,
                                 rep_->dummy_index_reader_offset, cache_key);
     rep_->table_options.block_cache.get()->Erase(key);
+    if (rep_->table_options.cache_learned_model_blocks) {
+      key = GetCacheKey(rep_->cache_key_prefix, rep_->cache_key_prefix_size,
+                        rep_->footer.learned_handle(), cache_key);
+      rep_->table_options.block_cache.get()->Erase(key);
+    }
   }
 }
 
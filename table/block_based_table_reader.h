@@ -22,8 +22,10 @@
 #include "rocksdb/statistics.h"
 #include "rocksdb/status.h"
 #include "rocksdb/table.h"
+#include "rocksdb/utilities/block_cache_trace.h"
 #include "table/filter_block.h"
 #include "table/format.h"
+#include "table/compact_learned_model.h"
 #include "table/persistent_cache_helper.h"
 #include "table/table_properties_internal.h"
 #include "table/table_reader.h"
@@ -31,10 +33,12 @@
 #include "util/coding.h"
 #include "util/file_reader_writer.h"
 #include "rmi/learned_index.h"
+#include "rmi/rmi_kernel.h"
 
 namespace rocksdb {
 
 class Block;
+class BlockDemoter;
 class BlockIter;
 class BlockHandle;
 class Cache;
@@ -58,6 +62,18 @@ using std::unique_ptr;
 
 typedef std::vector<std::pair<std::string, std::string>> KVPairBlock;
 
+// Attributes the block cache accesses made on this thread in its scope to
+// `caller` in block cache traces. Accesses made outside of any scope are
+// attributed to iterators.
+class ScopedBlockCacheTraceCaller {
+ public:
+  explicit ScopedBlockCacheTraceCaller(BlockCacheTraceCaller caller);
+  ~ScopedBlockCacheTraceCaller();
+
+ private:
+  BlockCacheTraceCaller saved_;
+};
+
 // A Table is a sorted map from strings to strings.  Tables are
 // immutable and persistent.  A Table may be safely accessed from
 // multiple threads without external synchronization.
@@ -66,6 +82,15 @@ class BlockBasedTable : public TableReader {
   static const std::string kFilterBlockPrefix;
   static const std::string kFullFilterBlockPrefix;
   static const std::string kPartitionedFilterBlockPrefix;
+  // Meta block recording how many data blocks each index partition holds.
+  static const std::string kModelPartitionsBlock;
+
+  // Raw key and value bytes of the entries before a key the learned model
+  // predicts `predicted` for, in a table of `num_entries` entries and
+  // `raw_size` raw bytes. The model is trained on the raw bytes up to and
+  // including each entry, so one average entry is taken off.
+  static uint64_t ModelRawOffset(uint64_t predicted, uint64_t raw_size,
+                                 uint64_t num_entries);
   // The longest prefix of the cache key used to identify blocks.
   // For Posix files the unique ID is three varints.
   static const size_t kMaxCacheKeyPrefixSize = kMaxVarint64Length * 3 + 1;
@@ -95,6 +120,11 @@ class BlockBasedTable : public TableReader {
                      bool prefetch_index_and_filter_in_cache = true,
                      bool skip_filters = false, int level = -1);
 
+  // Shape of the learned model stored in every table: a single linear model
+  // that routes each key to one of 1000 linear leaf models. Builder and
+  // reader must agree on it, since the serialized model does not record it.
+  static RMIConfig LearnedModelConfig();
+
   bool PrefixMayMatch(const Slice& internal_key);
 
   // Returns a new iterator over the table contents.
@@ -121,6 +151,14 @@ class BlockBasedTable : public TableReader {
   // IO or iteration error.
   Status Prefetch(const Slice* begin, const Slice* end) override;
 
+  Cache* GetBlockCacheKeyPrefix(Slice* key_prefix) const override;
+
+  Status WarmUpMetaBlocks() override;
+
+  Status WarmUpDataBlocks(const std::vector<uint64_t>& offsets,
+                          RateLimiter* rate_limiter,
+                          const std::atomic<bool>* stop) override;
+
   // Given a key, return an approximate byte offset in the file where
   // the data for that key begins (or would begin if the key were
   // present in the file).  The returned value is in terms of file
@@ -191,6 +229,31 @@ class BlockBasedTable : public TableReader {
     Statistics* statistics_;
   };
 
+  // The learned model of a table, decoded from whichever encoding it was
+  // written with and ready to evaluate. Owned by the table reader, or by the
+  // block cache when cache_learned_model_blocks is set.
+  class LearnedModelReader {
+   public:
+    // Decodes the model stored in `contents`.
+    static Status Create(std::string&& contents,
+                         std::unique_ptr<LearnedModelReader>* result);
+
+    // Byte offset the model predicts for `key`.
+    uint64_t Predict(uint64_t key) const;
+
+    // Memory held by the decoded model.
+    size_t ApproximateMemoryUsage() const;
+
+   private:
+    // Exactly one of the three is set: the compact encoding, or the
+    // serialized model, evaluated through a kernel specialized for its leaf
+    // count when there is one.
+    std::unique_ptr<LearnedRangeIndexSingleKey<uint64_t, float>> rmi_;
+    std::unique_ptr<CompactLearnedModel> compact_;
+    std::unique_ptr<RMIKernel> kernel_;
+    size_t encoded_size_ = 0;
+  };
+
   static Slice GetCacheKey(const char* cache_key_prefix,
                            size_t cache_key_prefix_size,
                            const BlockHandle& handle, char* cache_key);
@@ -214,6 +277,32 @@ class BlockBasedTable : public TableReader {
  private:
   bool compaction_optimized_;
 
+  // Sets `entry` to the learned model, held by rep_ or, with
+  // cache_learned_model_blocks, found in or read into the block cache.
+  // Returns Incomplete if it is not cached and `no_io` is set. Callers pass
+  // the entry to ReleaseLearnedModel() when done.
+  Status GetLearnedModel(bool no_io,
+                         CachableEntry<LearnedModelReader>* entry) const;
+  void ReleaseLearnedModel(CachableEntry<LearnedModelReader>* entry) const;
+
+  // Reads and decodes the learned model from the file of `rep`.
+  static Status ReadLearnedModel(
+      Rep* rep, std::unique_ptr<LearnedModelReader>* result);
+
+  // Number of data blocks ModelGet() can predict.
+  size_t NumModelBlocks() const;
+
+  // Handle of data block `block_num`, counting from 0 in file order. With a
+  // partitioned index, reads only the partition holding it, through the
+  // block cache; may return Incomplete when read_options does not allow I/O.
+  Status GetModelBlockHandle(const ReadOptions& read_options,
+                             uint32_t block_num, BlockHandle* handle) const;
+
+  // Reads the partition handles of a partitioned index and the number of
+  // data blocks in each into `rep`. Leaves `rep` unchanged if the table does
+  // not record them.
+  static Status ReadModelPartitions(Rep* rep, InternalIterator* meta_iter);
+
   // input_iter: if it is not null, update this one and return it as Iterator
   static InternalIterator* NewDataBlockIterator(Rep* rep, const ReadOptions& ro,
                                                 const Slice& index_value,
@@ -267,13 +356,19 @@ class BlockBasedTable : public TableReader {
   // pointer to the block as well as its block handle.
   // @param compression_dict Data for presetting the compression library's
   //    dictionary.
+  // @param demoter If set, data blocks inserted into block_cache move to
+  //    block_cache_compressed when evicted, and back on a hit there.
+  // @param tracer If set, records the accesses to block_cache, as made by a
+  //    table of level `level`.
   static Status GetDataBlockFromCache(
       const Slice& block_cache_key, const Slice& compressed_block_cache_key,
       Cache* block_cache, Cache* block_cache_compressed,
       const ImmutableCFOptions& ioptions, const ReadOptions& read_options,
       BlockBasedTable::CachableEntry<Block>* block, uint32_t format_version,
       const Slice& compression_dict, size_t read_amp_bytes_per_bit,
-      bool is_index = false);
+      bool is_index = false,
+      const std::shared_ptr<BlockDemoter>& demoter = nullptr,
+      BlockCacheTracer* tracer = nullptr, int level = -1);
 
   // Put a raw block (maybe compressed) to the corresponding block caches.
   // This method will perform decompression against raw_block if needed and then
@@ -285,13 +380,19 @@ class BlockBasedTable : public TableReader {
   // responsible for releasing its memory if error occurs.
   // @param compression_dict Data for presetting the compression library's
   //    dictionary.
+  // @param demoter If set, data blocks inserted into block_cache move to
+  //    block_cache_compressed when evicted, and back on a hit there.
+  // @param tracer If set, records the insert into block_cache, as made by a
+  //    table of level `level`.
   static Status PutDataBlockToCache(
       const Slice& block_cache_key, const Slice& compressed_block_cache_key,
       Cache* block_cache, Cache* block_cache_compressed,
       const ReadOptions& read_options, const ImmutableCFOptions& ioptions,
       CachableEntry<Block>* block, Block* raw_block, uint32_t format_version,
       const Slice& compression_dict, size_t read_amp_bytes_per_bit,
-      bool is_index = false, Cache::Priority pri = Cache::Priority::LOW);
+      bool is_index = false, Cache::Priority pri = Cache::Priority::LOW,
+      const std::shared_ptr<BlockDemoter>& demoter = nullptr,
+      BlockCacheTracer* tracer = nullptr, int level = -1);
 
   // Calls (*handle_result)(arg, ...) repeatedly, starting with the entry found
   // after a call to Seek(key), until handle_result returns false.
@@ -408,8 +509,25 @@ struct BlockBasedTable::Rep {
         global_seqno(kDisableGlobalSequenceNumber) {}
 
   const ImmutableCFOptions& ioptions;
-  LearnedRangeIndexSingleKey<uint64_t,float>* learnedMod;
+  // The learned model, unless table_options.cache_learned_model_blocks is
+  // set and it is read through the block cache instead. For level-0 files
+  // with pin_l0_learned_model_in_cache, the cached model is kept checked out
+  // in learned_model_entry until the reader is closed.
+  std::unique_ptr<LearnedModelReader> learned_model;
+  CachableEntry<LearnedModelReader> learned_model_entry;
+  // Offset and size of every data block, unless the index is partitioned
+  // and model_partitions is set instead.
   std::vector<std::pair<uint32_t, uint32_t>> block_pos;
+  // Handle of every index partition, the number of data blocks before each
+  // with the total last, and the restart interval partitions were built
+  // with. Lets ModelGet() load one partition on demand instead of keeping
+  // the handles of all data blocks in memory.
+  std::vector<BlockHandle> model_partitions;
+  std::vector<uint32_t> model_partition_first_block;
+  uint32_t model_partition_restart_interval = 1;
+  // Whether ApproximateOffsetOf() answers from the model, which is the case
+  // when table_options.model_offset_max_error bounds its recorded error.
+  bool model_offsets = false;
   const EnvOptions& env_options;
   const BlockBasedTableOptions& table_options;
   const FilterPolicy* const filter_policy;
@@ -422,6 +540,9 @@ struct BlockBasedTable::Rep {
   size_t persistent_cache_key_prefix_size = 0;
   char compressed_cache_key_prefix[kMaxCacheKeyPrefixSize];
   size_t compressed_cache_key_prefix_size = 0;
+  // Set with table_options.demote_evicted_blocks. Data blocks of the table
+  // in the block cache share it.
+  std::shared_ptr<BlockDemoter> block_demoter;
   uint64_t dummy_index_reader_offset =
       0;  // ID that is unique for the block cache.
   PersistentCacheOptions persistent_cache_options;
@@ -477,6 +598,9 @@ struct BlockBasedTable::Rep {
   // A value of kDisableGlobalSequenceNumber means that this feature is disabled
   // and every key have it's own seqno.
   SequenceNumber global_seqno;
+
+  // Level of the table, or -1 if unknown.
+  int level = -1;
 };
 
 }  // namespace rocksdb
@@ -129,6 +129,39 @@ TEST_F(BlockTest, SimpleTest) {
   delete iter;
 }
 
+TEST_F(BlockTest, SeekToEntry) {
+  Options options = Options();
+  std::vector<std::string> keys;
+  std::vector<std::string> values;
+  int num_records = 1000;
+  GenerateRandomKVs(&keys, &values, 0, num_records);
+
+  for (uint32_t restart_interval : {1, 3, 16}) {
+    BlockBuilder builder(static_cast<int>(restart_interval));
+    for (int i = 0; i < num_records; i++) {
+      builder.Add(keys[i], values[i]);
+    }
+    BlockContents contents;
+    contents.data = builder.Finish();
+    contents.cachable = false;
+    Block reader(std::move(contents), kDisableGlobalSequenceNumber);
+
+    BlockIter iter;
+    reader.NewIterator(options.comparator, &iter);
+    for (int i = num_records - 1; i >= 0; i--) {
+      iter.SeekToEntry(static_cast<uint32_t>(i), restart_interval);
+      ASSERT_TRUE(iter.Valid());
+      ASSERT_EQ(keys[i], iter.key().ToString());
+      ASSERT_EQ(values[i], iter.value().ToString());
+    }
+    iter.SeekToEntry(static_cast<uint32_t>(num_records), restart_interval);
+    ASSERT_FALSE(iter.Valid());
+    iter.SeekToEntry(static_cast<uint32_t>(num_records) + restart_interval,
+                     restart_interval);
+    ASSERT_FALSE(iter.Valid());
+  }
+}
+
 // return the block contents
 BlockContents GetBlockContents(std::unique_ptr<BlockBuilder> *builder,
                                const std::vector<std::string> &keys,
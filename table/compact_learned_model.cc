@@ -0,0 +1,593 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "table/compact_learned_model.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "port/port.h"
+#include "util/coding.h"
+
+namespace rocksdb {
+
+namespace {
+
+const uint64_t kCompactLearnedModelMagic = 0x3fa7c2e95d1b8046ull;
+const size_t kHeaderSize = 48;
+// Header flag: the model has hinge or cubic leaves.
+const unsigned char kHasShapes = 1;
+
+int BitsSet(uint64_t v) {
+#ifdef _MSC_VER
+  return static_cast<int>(__popcnt64(v));
+#else
+  return __builtin_popcountll(v);
+#endif
+}
+
+uint32_t BitsNeeded(uint64_t v) {
+  uint32_t bits = 0;
+  for (; v != 0; v >>= 1) {
+    bits++;
+  }
+  return bits;
+}
+
+uint64_t DoubleToBits(double d) {
+  uint64_t bits;
+  memcpy(&bits, &d, sizeof(bits));
+  return bits;
+}
+
+double BitsToDouble(uint64_t bits) {
+  double d;
+  memcpy(&d, &bits, sizeof(d));
+  return d;
+}
+
+// Words needed for `n` values of `bits` bits, plus one so that a value can
+// always be read with two whole-word loads.
+size_t PackedWords(size_t n, uint32_t bits) {
+  return (n * bits + 63) / 64 + 1;
+}
+
+void PutPacked(const std::vector<uint64_t>& values, uint32_t bits,
+               std::string* dst) {
+  std::vector<uint64_t> words(PackedWords(values.size(), bits), 0);
+  for (size_t i = 0; bits > 0 && i < values.size(); i++) {
+    uint64_t bit = i * bits;
+    uint32_t shift = bit % 64;
+    words[bit / 64] |= values[i] << shift;
+    if (shift + bits > 64) {
+      words[bit / 64 + 1] |= values[i] >> (64 - shift);
+    }
+  }
+  for (uint64_t word : words) {
+    PutFixed64(dst, word);
+  }
+}
+
+uint64_t GetPacked(const char* words, uint64_t index, uint32_t bits) {
+  if (bits == 0) {
+    return 0;
+  }
+  uint64_t bit = index * bits;
+  const char* p = words + bit / 64 * sizeof(uint64_t);
+  uint32_t shift = bit % 64;
+  uint64_t value = DecodeFixed64(p) >> shift;
+  if (shift + bits > 64) {
+    value |= DecodeFixed64(p + sizeof(uint64_t)) << (64 - shift);
+  }
+  return bits == 64 ? value : value & ((uint64_t{1} << bits) - 1);
+}
+
+// Signed difference of two keys.
+double KeyOffset(uint64_t key, uint64_t base) {
+  return key >= base ? static_cast<double>(key - base)
+                     : -static_cast<double>(base - key);
+}
+
+size_t BitmapWords(uint32_t bits) { return (bits + 63) / 64; }
+
+bool TestBit(const char* bitmap, uint32_t i) {
+  return (DecodeFixed64(bitmap + i / 64 * sizeof(uint64_t)) >> (i % 64)) & 1;
+}
+
+// Number of set bits before bit `i`, given the count before each word.
+uint32_t RankIn(const char* bitmap, const char* ranks, uint32_t i) {
+  uint32_t word = i / 64;
+  uint64_t below = DecodeFixed64(bitmap + word * sizeof(uint64_t)) &
+                   ((uint64_t{1} << (i % 64)) - 1);
+  return DecodeFixed32(ranks + word * sizeof(uint32_t)) + BitsSet(below);
+}
+
+// Total number of set bits, or 0 for an empty bitmap.
+uint32_t CountBits(const char* bitmap, const char* ranks, size_t words) {
+  if (words == 0) {
+    return 0;
+  }
+  return DecodeFixed32(ranks + (words - 1) * sizeof(uint32_t)) +
+         BitsSet(DecodeFixed64(bitmap + (words - 1) * sizeof(uint64_t)));
+}
+
+void PutBitmap(const std::vector<uint64_t>& bitmap, std::string* dst) {
+  for (uint64_t word : bitmap) {
+    PutFixed64(dst, word);
+  }
+  uint32_t rank = 0;
+  for (uint64_t word : bitmap) {
+    PutFixed32(dst, rank);
+    rank += BitsSet(word);
+  }
+}
+
+int64_t RoundPosition(double pos) {
+  return pos > 0 ? static_cast<int64_t>(llround(pos)) : 0;
+}
+
+uint64_t MaxError(const CompactLearnedModel::Leaf& leaf,
+                  const std::vector<uint64_t>& keys,
+                  const std::vector<uint64_t>& positions) {
+  uint64_t max_error = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    int64_t predicted =
+        RoundPosition(CompactLearnedModel::Evaluate(leaf, keys[i]));
+    int64_t actual = static_cast<int64_t>(positions[i]);
+    max_error = std::max(max_error,
+                         static_cast<uint64_t>(predicted > actual
+                                                   ? predicted - actual
+                                                   : actual - predicted));
+  }
+  return max_error;
+}
+
+// Least squares fit of y = sum(coef[j] * basis_j(u)) through the normal
+// equations. `u` is scaled to [0, 1], which keeps them well conditioned for
+// the few low-order terms used here. Returns false if they are singular.
+template <size_t N, typename Basis>
+bool FitBasis(const std::vector<double>& u, const std::vector<double>& y,
+              const Basis& basis, double coef[N]) {
+  double a[N][N + 1] = {};
+  double phi[N];
+  for (size_t i = 0; i < u.size(); i++) {
+    basis(u[i], phi);
+    for (size_t r = 0; r < N; r++) {
+      for (size_t c = 0; c < N; c++) {
+        a[r][c] += phi[r] * phi[c];
+      }
+      a[r][N] += phi[r] * y[i];
+    }
+  }
+  for (size_t col = 0; col < N; col++) {
+    size_t pivot = col;
+    for (size_t r = col + 1; r < N; r++) {
+      if (fabs(a[r][col]) > fabs(a[pivot][col])) {
+        pivot = r;
+      }
+    }
+    if (fabs(a[pivot][col]) < 1e-12) {
+      return false;
+    }
+    for (size_t c = 0; c <= N; c++) {
+      std::swap(a[col][c], a[pivot][c]);
+    }
+    for (size_t r = 0; r < N; r++) {
+      if (r != col) {
+        double f = a[r][col] / a[col][col];
+        for (size_t c = col; c <= N; c++) {
+          a[r][c] -= f * a[col][c];
+        }
+      }
+    }
+  }
+  for (size_t r = 0; r < N; r++) {
+    coef[r] = a[r][N] / a[r][r];
+  }
+  return true;
+}
+
+}  // namespace
+
+void CompactLearnedModel::Leaf::SetLinear(uint64_t base, double w,
+                                          double intercept) {
+  kept = true;
+  key_base = base;
+  slope = w;
+  pos_base = intercept + w * static_cast<double>(base);
+  shape = kLinear;
+}
+
+double CompactLearnedModel::Evaluate(const Leaf& leaf, uint64_t key) {
+  double x = KeyOffset(key, leaf.key_base);
+  double pos = leaf.pos_base + leaf.slope * x;
+  if (leaf.shape == kHinge) {
+    double past = x - static_cast<double>(leaf.split);
+    if (past > 0) {
+      pos += leaf.bend * past;
+    }
+  } else if (leaf.shape == kCubic) {
+    pos += x * x * (leaf.quadratic + leaf.cubic * x);
+  }
+  return pos;
+}
+
+void CompactLearnedModel::Quantize(Leaf* leaf) {
+  leaf->pos_base = static_cast<double>(llround(leaf->pos_base));
+  leaf->slope = static_cast<float>(leaf->slope);
+}
+
+void CompactLearnedModel::FitLeaf(const std::vector<uint64_t>& keys,
+                                  const std::vector<uint64_t>& positions,
+                                  uint64_t max_error, Leaf* leaf) {
+  assert(keys.size() == positions.size());
+  Quantize(leaf);
+  uint64_t linear_error = MaxError(*leaf, keys, positions);
+  if (linear_error <= max_error || keys.size() < 4) {
+    return;
+  }
+
+  // Fit in u = (key - key_base) / span and y = position - positions[0],
+  // then scale the coefficients back to key offsets.
+  double span = 1.0;
+  for (uint64_t key : keys) {
+    span = std::max(span, KeyOffset(key, leaf->key_base));
+  }
+  double y0 = static_cast<double>(positions[0]);
+  std::vector<double> u(keys.size());
+  std::vector<double> y(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    u[i] = KeyOffset(keys[i], leaf->key_base) / span;
+    y[i] = static_cast<double>(positions[i]) - y0;
+  }
+
+  // The bend goes at one of the keys: try every eighth of the leaf, then
+  // narrow down around the best split so far until neighboring keys are
+  // tried, which takes O(log n) rounds of a few fits each.
+  Leaf hinge;
+  uint64_t hinge_error = port::kMaxUint64;
+  size_t best_at = 0;
+  auto try_split = [&](size_t at) {
+    if (keys[at] <= leaf->key_base) {
+      return;
+    }
+    uint64_t split = keys[at] - leaf->key_base;
+    double s = static_cast<double>(split) / span;
+    double coef[3];
+    if (!FitBasis<3>(u, y,
+                     [s](double v, double* phi) {
+                       phi[0] = 1;
+                       phi[1] = v;
+                       phi[2] = std::max(v - s, 0.0);
+                     },
+                     coef)) {
+      return;
+    }
+    Leaf candidate = *leaf;
+    candidate.shape = kHinge;
+    candidate.pos_base = y0 + coef[0];
+    candidate.slope = coef[1] / span;
+    candidate.split = split;
+    candidate.bend = coef[2] / span;
+    Quantize(&candidate);
+    uint64_t error = MaxError(candidate, keys, positions);
+    if (error < hinge_error) {
+      hinge = candidate;
+      hinge_error = error;
+      best_at = at;
+    }
+  };
+  const size_t kSteps = 8;
+  size_t step = std::max<size_t>(keys.size() / kSteps, 1);
+  for (size_t at = step; at < keys.size(); at += step) {
+    try_split(at);
+  }
+  while (hinge_error > max_error && step > 1) {
+    size_t center = best_at;
+    size_t fine = std::max<size_t>(step / kSteps, 1);
+    size_t end = std::min(center + step, keys.size());
+    for (size_t at = center > step ? center - step + fine : 1; at < end;
+         at += fine) {
+      if (at != center) {
+        try_split(at);
+      }
+    }
+    step = fine;
+  }
+
+  if (hinge_error <= max_error) {
+    *leaf = hinge;
+    return;
+  }
+
+  Leaf cubic;
+  uint64_t cubic_error = port::kMaxUint64;
+  double coef[4];
+  if (FitBasis<4>(u, y,
+                  [](double v, double* phi) {
+                    phi[0] = 1;
+                    phi[1] = v;
+                    phi[2] = v * v;
+                    phi[3] = v * v * v;
+                  },
+                  coef)) {
+    cubic = *leaf;
+    cubic.shape = kCubic;
+    cubic.pos_base = y0 + coef[0];
+    cubic.slope = coef[1] / span;
+    cubic.quadratic = coef[2] / (span * span);
+    cubic.cubic = coef[3] / (span * span * span);
+    Quantize(&cubic);
+    cubic_error = MaxError(cubic, keys, positions);
+  }
+  if (cubic_error <= max_error) {
+    *leaf = cubic;
+  } else if (hinge_error < linear_error && hinge_error <= cubic_error) {
+    *leaf = hinge;
+  } else if (cubic_error < linear_error) {
+    *leaf = cubic;
+  }
+}
+
+void CompactLearnedModel::Encode(double root_slope, double root_intercept,
+                                 uint32_t num_keys,
+                                 const std::vector<Leaf>& leaves,
+                                 std::string* dst) {
+  uint32_t num_leaves = static_cast<uint32_t>(leaves.size());
+  std::vector<uint64_t> bitmap(BitmapWords(num_leaves), 0);
+  std::vector<Leaf> kept;
+  for (uint32_t i = 0; i < num_leaves; i++) {
+    if (leaves[i].kept) {
+      bitmap[i / 64] |= uint64_t{1} << (i % 64);
+      kept.push_back(leaves[i]);
+      Quantize(&kept.back());
+    }
+  }
+  uint32_t num_kept = static_cast<uint32_t>(kept.size());
+
+  uint64_t key_ref = 0;
+  int64_t pos_ref = 0;
+  std::vector<uint64_t> hinge_bitmap(BitmapWords(num_kept), 0);
+  std::vector<uint64_t> cubic_bitmap(BitmapWords(num_kept), 0);
+  bool has_shapes = false;
+  for (uint32_t i = 0; i < num_kept; i++) {
+    int64_t pos_base = static_cast<int64_t>(kept[i].pos_base);
+    key_ref = i == 0 ? kept[i].key_base : std::min(key_ref, kept[i].key_base);
+    pos_ref = i == 0 ? pos_base : std::min(pos_ref, pos_base);
+    if (kept[i].shape == kHinge) {
+      hinge_bitmap[i / 64] |= uint64_t{1} << (i % 64);
+      has_shapes = true;
+    } else if (kept[i].shape == kCubic) {
+      cubic_bitmap[i / 64] |= uint64_t{1} << (i % 64);
+      has_shapes = true;
+    }
+  }
+  uint64_t max_key_delta = 0;
+  uint64_t max_pos_delta = 0;
+  std::vector<uint64_t> key_deltas;
+  std::vector<uint64_t> pos_deltas;
+  for (const Leaf& leaf : kept) {
+    key_deltas.push_back(leaf.key_base - key_ref);
+    max_key_delta = std::max(max_key_delta, key_deltas.back());
+    pos_deltas.push_back(
+        static_cast<uint64_t>(static_cast<int64_t>(leaf.pos_base)) -
+        static_cast<uint64_t>(pos_ref));
+    max_pos_delta = std::max(max_pos_delta, pos_deltas.back());
+  }
+  uint32_t key_bits = BitsNeeded(max_key_delta);
+  uint32_t pos_bits = BitsNeeded(max_pos_delta);
+
+  PutFixed64(dst, DoubleToBits(root_slope));
+  PutFixed64(dst, DoubleToBits(root_intercept));
+  PutFixed32(dst, num_keys);
+  PutFixed32(dst, num_leaves);
+  PutFixed32(dst, num_kept);
+  dst->push_back(static_cast<char>(key_bits));
+  dst->push_back(static_cast<char>(pos_bits));
+  dst->push_back(static_cast<char>(has_shapes ? kHasShapes : 0));
+  dst->push_back('\0');
+  PutFixed64(dst, key_ref);
+  PutFixed64(dst, static_cast<uint64_t>(pos_ref));
+  PutBitmap(bitmap, dst);
+  for (const Leaf& leaf : kept) {
+    float slope = static_cast<float>(leaf.slope);
+    uint32_t bits;
+    memcpy(&bits, &slope, sizeof(bits));
+    PutFixed32(dst, bits);
+  }
+  PutPacked(key_deltas, key_bits, dst);
+  PutPacked(pos_deltas, pos_bits, dst);
+  if (has_shapes) {
+    PutBitmap(hinge_bitmap, dst);
+    PutBitmap(cubic_bitmap, dst);
+    for (const Leaf& leaf : kept) {
+      if (leaf.shape == kHinge) {
+        PutFixed64(dst, leaf.split);
+        PutFixed64(dst, DoubleToBits(leaf.bend));
+      }
+    }
+    for (const Leaf& leaf : kept) {
+      if (leaf.shape == kCubic) {
+        PutFixed64(dst, DoubleToBits(leaf.quadratic));
+        PutFixed64(dst, DoubleToBits(leaf.cubic));
+      }
+    }
+  }
+  PutFixed64(dst, kCompactLearnedModelMagic);
+}
+
+bool CompactLearnedModel::IsCompact(const Slice& contents) {
+  return contents.size() >= kHeaderSize + sizeof(uint64_t) &&
+         DecodeFixed64(contents.data() + contents.size() - sizeof(uint64_t)) ==
+             kCompactLearnedModelMagic;
+}
+
+CompactLearnedModel::CompactLearnedModel()
+    : root_slope_(0),
+      root_intercept_(0),
+      num_keys_(0),
+      num_leaves_(0),
+      num_kept_(0),
+      num_hinge_(0),
+      num_cubic_(0),
+      key_bits_(0),
+      pos_bits_(0),
+      key_ref_(0),
+      pos_ref_(0),
+      bitmap_(nullptr),
+      ranks_(nullptr),
+      slopes_(nullptr),
+      key_deltas_(nullptr),
+      pos_deltas_(nullptr),
+      hinge_bitmap_(nullptr),
+      hinge_ranks_(nullptr),
+      cubic_bitmap_(nullptr),
+      cubic_ranks_(nullptr),
+      hinge_leaves_(nullptr),
+      cubic_leaves_(nullptr) {}
+
+Status CompactLearnedModel::Init(std::string&& contents) {
+  contents_ = std::move(contents);
+  hinge_bitmap_ = hinge_ranks_ = cubic_bitmap_ = cubic_ranks_ = nullptr;
+  hinge_leaves_ = cubic_leaves_ = nullptr;
+  num_hinge_ = num_cubic_ = 0;
+  if (!IsCompact(contents_)) {
+    return Status::Corruption("Not a compact learned model");
+  }
+  const char* p = contents_.data();
+  root_slope_ = BitsToDouble(DecodeFixed64(p));
+  root_intercept_ = BitsToDouble(DecodeFixed64(p + 8));
+  num_keys_ = DecodeFixed32(p + 16);
+  num_leaves_ = DecodeFixed32(p + 20);
+  num_kept_ = DecodeFixed32(p + 24);
+  key_bits_ = static_cast<unsigned char>(p[28]);
+  pos_bits_ = static_cast<unsigned char>(p[29]);
+  unsigned char flags = static_cast<unsigned char>(p[30]);
+  key_ref_ = DecodeFixed64(p + 32);
+  pos_ref_ = static_cast<int64_t>(DecodeFixed64(p + 40));
+  if (num_leaves_ == 0 || num_kept_ > num_leaves_ || key_bits_ > 64 ||
+      pos_bits_ > 64) {
+    return Status::Corruption("Bad compact learned model header");
+  }
+  if ((flags & ~kHasShapes) != 0) {
+    return Status::NotSupported("Unknown compact learned model flags " +
+                                std::to_string(flags));
+  }
+
+  size_t num_words = BitmapWords(num_leaves_);
+  size_t offset = kHeaderSize;
+  bitmap_ = p + offset;
+  offset += num_words * sizeof(uint64_t);
+  ranks_ = p + offset;
+  offset += num_words * sizeof(uint32_t);
+  slopes_ = p + offset;
+  offset += num_kept_ * sizeof(uint32_t);
+  key_deltas_ = p + offset;
+  offset += PackedWords(num_kept_, key_bits_) * sizeof(uint64_t);
+  pos_deltas_ = p + offset;
+  offset += PackedWords(num_kept_, pos_bits_) * sizeof(uint64_t);
+  size_t kept_words = BitmapWords(num_kept_);
+  size_t shape_bitmaps_size =
+      2 * kept_words * (sizeof(uint64_t) + sizeof(uint32_t));
+  if ((flags & kHasShapes) != 0 &&
+      offset + shape_bitmaps_size <= contents_.size()) {
+    hinge_bitmap_ = p + offset;
+    hinge_ranks_ = hinge_bitmap_ + kept_words * sizeof(uint64_t);
+    cubic_bitmap_ = hinge_ranks_ + kept_words * sizeof(uint32_t);
+    cubic_ranks_ = cubic_bitmap_ + kept_words * sizeof(uint64_t);
+    offset += shape_bitmaps_size;
+    num_hinge_ = CountBits(hinge_bitmap_, hinge_ranks_, kept_words);
+    num_cubic_ = CountBits(cubic_bitmap_, cubic_ranks_, kept_words);
+    hinge_leaves_ = p + offset;
+    offset += num_hinge_ * 2 * sizeof(uint64_t);
+    cubic_leaves_ = p + offset;
+    offset += num_cubic_ * 2 * sizeof(uint64_t);
+  }
+  offset += sizeof(uint64_t);
+  if (offset != contents_.size()) {
+    return Status::Corruption("Compact learned model has " +
+                              std::to_string(contents_.size()) +
+                              " bytes, expected " + std::to_string(offset));
+  }
+  if (CountBits(bitmap_, ranks_, num_words) != num_kept_ ||
+      num_hinge_ + num_cubic_ > num_kept_) {
+    return Status::Corruption("Compact learned model leaf bitmap mismatch");
+  }
+  return Status::OK();
+}
+
+uint32_t CompactLearnedModel::Route(uint64_t key) const {
+  // Same arithmetic as RMINew::pick_model_for_key().
+  double pred = std::max(
+      root_intercept_ + root_slope_ * static_cast<double>(key), 0.0);
+  if (pred >= num_keys_) {
+    return num_leaves_ - 1;
+  }
+  return static_cast<uint32_t>(pred / num_keys_ * num_leaves_);
+}
+
+void CompactLearnedModel::GetKeptLeaf(uint32_t kept_index,
+                                      Leaf* result) const {
+  result->kept = true;
+  result->key_base = key_ref_ + GetPacked(key_deltas_, kept_index, key_bits_);
+  result->pos_base = static_cast<double>(static_cast<int64_t>(
+      static_cast<uint64_t>(pos_ref_) +
+      GetPacked(pos_deltas_, kept_index, pos_bits_)));
+  uint32_t bits = DecodeFixed32(slopes_ + kept_index * sizeof(uint32_t));
+  float slope;
+  memcpy(&slope, &bits, sizeof(bits));
+  result->slope = slope;
+  result->shape = kLinear;
+  if (hinge_bitmap_ == nullptr) {
+    return;
+  }
+  if (TestBit(hinge_bitmap_, kept_index)) {
+    const char* q = hinge_leaves_ + RankIn(hinge_bitmap_, hinge_ranks_,
+                                           kept_index) *
+                                        2 * sizeof(uint64_t);
+    result->shape = kHinge;
+    result->split = DecodeFixed64(q);
+    result->bend = BitsToDouble(DecodeFixed64(q + sizeof(uint64_t)));
+  } else if (TestBit(cubic_bitmap_, kept_index)) {
+    const char* q = cubic_leaves_ + RankIn(cubic_bitmap_, cubic_ranks_,
+                                           kept_index) *
+                                        2 * sizeof(uint64_t);
+    result->shape = kCubic;
+    result->quadratic = BitsToDouble(DecodeFixed64(q));
+    result->cubic = BitsToDouble(DecodeFixed64(q + sizeof(uint64_t)));
+  }
+}
+
+bool CompactLearnedModel::GetLeaf(uint32_t leaf, Leaf* result) const {
+  if (leaf >= num_leaves_ || !TestBit(bitmap_, leaf)) {
+    return false;
+  }
+  GetKeptLeaf(RankIn(bitmap_, ranks_, leaf), result);
+  return true;
+}
+
+int64_t CompactLearnedModel::Predict(uint64_t key) const {
+  if (num_kept_ == 0) {
+    return 0;
+  }
+  uint32_t leaf = Route(key);
+  uint32_t kept_index = RankIn(bitmap_, ranks_, leaf);
+  if (!TestBit(bitmap_, leaf) && kept_index > 0) {
+    // No key of the table was routed here; the closest kept leaf before
+    // holds the keys just below this one.
+    kept_index--;
+  }
+  Leaf result;
+  GetKeptLeaf(kept_index, &result);
+  return RoundPosition(Evaluate(result, key));
+}
+
+}  // namespace rocksdb
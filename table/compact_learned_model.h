@@ -0,0 +1,159 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "rocksdb/slice.h"
+#include "rocksdb/status.h"
+
+namespace rocksdb {
+
+// A compact, directly evaluated encoding of the two-stage learned model that
+// block-based tables use to place and find data blocks.
+//
+// The root routes a key to one of the leaves exactly as the serialized
+// LearnedRangeIndexSingleKey model does. Leaves that no key of the table is
+// routed to are dropped; a lookup that lands on one uses the closest kept leaf
+// before it. A kept leaf stores the smallest key routed to it, its predicted
+// position at that key and a float slope, so that with x = key - key_base
+//
+//   position = pos_base + slope * x
+//
+// stays exact near the leaf however large the keys are. Leaves whose keys
+// bend away from one line can add a second line from some x on (kHinge) or
+// quadratic and cubic terms (kCubic). Key and position bases are stored as
+// bit-packed deltas from the smallest base in the model, each with just
+// enough bits for the largest delta, and are read in place.
+//
+// Layout, all fixed-width little-endian:
+//   root slope, root intercept       double, double
+//   num_keys, num_leaves, num_kept   uint32 x 3
+//   key_bits, pos_bits, flags, pad   uint8 x 4
+//   key_ref, pos_ref                 uint64, int64
+//   kept-leaf bitmap                 uint64 x ceil(num_leaves / 64)
+//   kept leaves before each word     uint32 x ceil(num_leaves / 64)
+//   slopes                           float x num_kept
+//   key base deltas                  bit-packed, in uint64 words, + 1 word
+//   position base deltas             bit-packed, in uint64 words, + 1 word
+//   if flags & kHasShapes, over kept leaves:
+//     hinge bitmap and ranks         as above, over ceil(num_kept / 64) words
+//     cubic bitmap and ranks         as above
+//     hinge leaves                   (uint64 split, double bend) x num_hinge
+//     cubic leaves                   (double quadratic, double cubic) x num_cubic
+//   magic                            uint64
+class CompactLearnedModel {
+ public:
+  enum LeafShape : unsigned char {
+    kLinear = 0,
+    // Adds bend * (x - split) once x exceeds split.
+    kHinge = 1,
+    // Adds quadratic * x^2 + cubic * x^3.
+    kCubic = 2,
+  };
+
+  struct Leaf {
+    // Whether any key was routed to this leaf. Other leaves are dropped.
+    bool kept = false;
+    // The smallest key routed to this leaf.
+    uint64_t key_base = 0;
+    // Encoded rounded to an integer.
+    double pos_base = 0;
+    // Encoded as a float.
+    double slope = 0;
+    LeafShape shape = kLinear;
+    uint64_t split = 0;
+    double bend = 0;
+    double quadratic = 0;
+    double cubic = 0;
+
+    // Makes this a kept linear leaf predicting slope * key + intercept, the
+    // form LearnedRangeIndexSingleKey leaves are trained in.
+    void SetLinear(uint64_t base, double w, double intercept);
+  };
+
+  // Appends the encoding of a model with the given root and leaves to `dst`.
+  // `num_keys` is the number of keys the root was trained on.
+  static void Encode(double root_slope, double root_intercept,
+                     uint32_t num_keys, const std::vector<Leaf>& leaves,
+                     std::string* dst);
+
+  // Returns true if `contents` ends with the magic number of this encoding,
+  // as opposed to holding a serialized LearnedRangeIndexSingleKey.
+  static bool IsCompact(const Slice& contents);
+
+  // Position `leaf` predicts for `key`, before rounding. Leaves read back
+  // from an encoding evaluate exactly like what was encoded once passed
+  // through Quantize().
+  static double Evaluate(const Leaf& leaf, uint64_t key);
+
+  // Rounds the fields of `leaf` the way Encode() stores them.
+  static void Quantize(Leaf* leaf);
+
+  // Picks the shape of a kept leaf from the (key, position) pairs routed to
+  // it, in table order, starting from the linear model already in `leaf`.
+  // Keeps the cheapest shape whose largest error is at most `max_error`, or
+  // the most accurate one if none is. The result is quantized.
+  static void FitLeaf(const std::vector<uint64_t>& keys,
+                      const std::vector<uint64_t>& positions,
+                      uint64_t max_error, Leaf* leaf);
+
+  CompactLearnedModel();
+
+  // Takes over `contents` and checks that its layout is consistent.
+  Status Init(std::string&& contents);
+
+  // Returns the predicted position of `key`, which is never negative.
+  int64_t Predict(uint64_t key) const;
+
+  // Returns the leaf the root routes `key` to, in [0, num_leaves()).
+  uint32_t Route(uint64_t key) const;
+
+  // Returns false if leaf `leaf` was dropped. Otherwise decodes it.
+  bool GetLeaf(uint32_t leaf, Leaf* result) const;
+
+  double root_slope() const { return root_slope_; }
+  double root_intercept() const { return root_intercept_; }
+  uint32_t num_keys() const { return num_keys_; }
+  uint32_t num_leaves() const { return num_leaves_; }
+  uint32_t num_kept_leaves() const { return num_kept_; }
+  uint32_t num_hinge_leaves() const { return num_hinge_; }
+  uint32_t num_cubic_leaves() const { return num_cubic_; }
+  size_t size() const { return contents_.size(); }
+
+ private:
+  // Decodes the kept leaf with index `kept_index`.
+  void GetKeptLeaf(uint32_t kept_index, Leaf* result) const;
+
+  std::string contents_;
+  double root_slope_;
+  double root_intercept_;
+  uint32_t num_keys_;
+  uint32_t num_leaves_;
+  uint32_t num_kept_;
+  uint32_t num_hinge_;
+  uint32_t num_cubic_;
+  uint32_t key_bits_;
+  uint32_t pos_bits_;
+  uint64_t key_ref_;
+  int64_t pos_ref_;
+  const char* bitmap_;
+  const char* ranks_;
+  const char* slopes_;
+  const char* key_deltas_;
+  const char* pos_deltas_;
+  // Null unless the model has hinge or cubic leaves.
+  const char* hinge_bitmap_;
+  const char* hinge_ranks_;
+  const char* cubic_bitmap_;
+  const char* cubic_ranks_;
+  const char* hinge_leaves_;
+  const char* cubic_leaves_;
+};
+
+}  // namespace rocksdb
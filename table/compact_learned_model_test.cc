@@ -0,0 +1,329 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "table/compact_learned_model.h"
+
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "port/stack_trace.h"
+#include "rmi/learned_index.h"
+#include "table/block_based_table_reader.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+namespace {
+
+typedef LearnedRangeIndexSingleKey<uint64_t, float> LearnedIndex;
+
+std::vector<uint64_t> LognormalKeys(size_t n) {
+  std::mt19937_64 rng(301);
+  std::lognormal_distribution<double> dist(0.0, 1.0);
+  std::set<uint64_t> keys;
+  while (keys.size() < n) {
+    keys.insert(static_cast<uint64_t>(dist(rng) * 1e9));
+  }
+  return std::vector<uint64_t>(keys.begin(), keys.end());
+}
+
+// Encodes a trained `index` the way BlockBasedTableBuilder does.
+std::string EncodeIndex(LearnedIndex* index,
+                        const std::vector<uint64_t>& keys) {
+  auto& rmi = index->rmi;
+  std::vector<CompactLearnedModel::Leaf> leaves(
+      rmi.second_stage->get_model_n());
+  for (uint64_t key : keys) {
+    CompactLearnedModel::Leaf& leaf = leaves[index->get_model(key)];
+    if (!leaf.kept || key < leaf.key_base) {
+      leaf.kept = true;
+      leaf.key_base = key;
+    }
+  }
+  for (size_t i = 0; i < leaves.size(); i++) {
+    if (leaves[i].kept) {
+      leaves[i].SetLinear(leaves[i].key_base, rmi.second_stage->models[i].w,
+                          rmi.second_stage->models[i].bias);
+    }
+  }
+  std::string encoded;
+  CompactLearnedModel::Encode(rmi.first_stage->models[0].w,
+                              rmi.first_stage->models[0].bias,
+                              static_cast<uint32_t>(keys.size()), leaves,
+                              &encoded);
+  return encoded;
+}
+
+// Ten leaves over keys [0, 1000): key k is routed to leaf k / 100.
+std::string EncodeTenLeaves(const std::vector<CompactLearnedModel::Leaf>& l) {
+  std::string encoded;
+  CompactLearnedModel::Encode(1.0, 0.0, 1000, l, &encoded);
+  return encoded;
+}
+
+CompactLearnedModel::Leaf MakeLeaf(uint64_t key_base, double slope,
+                                   double intercept) {
+  CompactLearnedModel::Leaf leaf;
+  leaf.SetLinear(key_base, slope, intercept);
+  return leaf;
+}
+
+// Largest error of `leaf` over the given keys, as Predict() rounds it.
+uint64_t MaxLeafError(const CompactLearnedModel::Leaf& leaf,
+                      const std::vector<uint64_t>& keys,
+                      const std::vector<uint64_t>& positions) {
+  uint64_t max_error = 0;
+  for (size_t i = 0; i < keys.size(); i++) {
+    double pos = std::max(CompactLearnedModel::Evaluate(leaf, keys[i]), 0.0);
+    max_error = std::max(
+        max_error, static_cast<uint64_t>(std::abs(
+                       llround(pos) - static_cast<int64_t>(positions[i]))));
+  }
+  return max_error;
+}
+
+// Fits keys 1000, 1010, ... to `positions`, starting from the line through
+// the first and last point.
+CompactLearnedModel::Leaf FitCurve(const std::vector<uint64_t>& positions,
+                                   uint64_t max_error,
+                                   std::vector<uint64_t>* keys) {
+  keys->clear();
+  for (size_t i = 0; i < positions.size(); i++) {
+    keys->push_back(1000 + i * 10);
+  }
+  double slope = static_cast<double>(positions.back() - positions.front()) /
+                 static_cast<double>(keys->back() - keys->front());
+  CompactLearnedModel::Leaf leaf;
+  leaf.SetLinear(keys->front(), slope,
+                 positions.front() - slope * keys->front());
+  CompactLearnedModel::FitLeaf(*keys, positions, max_error, &leaf);
+  return leaf;
+}
+
+}  // namespace
+
+class CompactLearnedModelTest : public testing::Test {};
+
+TEST_F(CompactLearnedModelTest, MatchesSerializedModel) {
+  std::vector<uint64_t> keys = LognormalKeys(20000);
+  LearnedIndex index(BlockBasedTable::LearnedModelConfig());
+  // Positions are byte offsets of 100-byte entries, as in a table.
+  for (size_t i = 0; i < keys.size(); i++) {
+    index.insert(keys[i], (i + 1) * 100);
+  }
+  index.finish_insert();
+  index.finish_train();
+  std::string serialized;
+  index.serialize(serialized);
+
+  std::string encoded = EncodeIndex(&index, keys);
+  ASSERT_TRUE(CompactLearnedModel::IsCompact(encoded));
+  ASSERT_FALSE(CompactLearnedModel::IsCompact(serialized));
+  CompactLearnedModel model;
+  ASSERT_OK(model.Init(std::move(encoded)));
+  ASSERT_EQ(1000U, model.num_leaves());
+  ASSERT_EQ(keys.size(), model.num_keys());
+  ASSERT_GT(model.num_kept_leaves(), 0U);
+  ASSERT_LT(model.size(), serialized.size() / 4);
+
+  for (uint64_t key : keys) {
+    ASSERT_EQ(static_cast<uint32_t>(index.get_model(key)), model.Route(key));
+    int64_t expected = index.get(key);
+    int64_t actual = model.Predict(key);
+    // The float slope costs a little precision far from the leaf base.
+    ASSERT_LE(std::abs(expected - actual), 2 + expected / 1000000);
+  }
+}
+
+TEST_F(CompactLearnedModelTest, DroppedLeavesUseClosestKeptLeaf) {
+  std::vector<CompactLearnedModel::Leaf> leaves(10);
+  leaves[2] = MakeLeaf(250, 2.0, 100.0);
+  leaves[7] = MakeLeaf(700, 0.5, 1000.0);
+  CompactLearnedModel model;
+  ASSERT_OK(model.Init(EncodeTenLeaves(leaves)));
+  ASSERT_EQ(2U, model.num_kept_leaves());
+
+  CompactLearnedModel::Leaf leaf;
+  ASSERT_FALSE(model.GetLeaf(3, &leaf));
+  ASSERT_TRUE(model.GetLeaf(7, &leaf));
+  ASSERT_EQ(700U, leaf.key_base);
+  ASSERT_EQ(1350, leaf.pos_base);
+  ASSERT_EQ(0.5, leaf.slope);
+
+  ASSERT_EQ(3U, model.Route(399));
+  // Leaves 0 and 1 have no kept leaf before them.
+  ASSERT_EQ(100 + 2 * 50, model.Predict(50));
+  ASSERT_EQ(100 + 2 * 260, model.Predict(260));
+  ASSERT_EQ(100 + 2 * 650, model.Predict(650));
+  ASSERT_EQ(1000 + 720 / 2, model.Predict(720));
+  ASSERT_EQ(1000 + 5000 / 2, model.Predict(5000));
+  // Predictions are never negative.
+  leaves[2] = MakeLeaf(250, 2.0, -1000.0);
+  ASSERT_OK(model.Init(EncodeTenLeaves(leaves)));
+  ASSERT_EQ(0, model.Predict(10));
+}
+
+TEST_F(CompactLearnedModelTest, BitWidths) {
+  // Identical bases take no bits at all.
+  std::vector<CompactLearnedModel::Leaf> leaves(10);
+  for (size_t i = 0; i < leaves.size(); i++) {
+    leaves[i] = MakeLeaf(500, 0.0, 42.0);
+  }
+  CompactLearnedModel model;
+  ASSERT_OK(model.Init(EncodeTenLeaves(leaves)));
+  for (uint64_t key = 0; key < 1000; key += 7) {
+    ASSERT_EQ(42, model.Predict(key));
+  }
+
+  // Bases spanning the whole key space need all 64 bits.
+  std::mt19937_64 rng(301);
+  const size_t kLeaves = 300;
+  leaves.assign(kLeaves, CompactLearnedModel::Leaf());
+  for (size_t i = 0; i < kLeaves; i++) {
+    if (i % 3 != 0) {
+      leaves[i] = MakeLeaf(i == 1 ? ~0ULL : rng(), 0.0,
+                           static_cast<double>(rng() >> 20));
+    }
+  }
+  std::string encoded;
+  CompactLearnedModel::Encode(0.0, 0.0, 1, leaves, &encoded);
+  ASSERT_OK(model.Init(std::move(encoded)));
+  for (size_t i = 0; i < kLeaves; i++) {
+    CompactLearnedModel::Leaf leaf;
+    ASSERT_EQ(leaves[i].kept, model.GetLeaf(static_cast<uint32_t>(i), &leaf));
+    if (leaves[i].kept) {
+      ASSERT_EQ(leaves[i].key_base, leaf.key_base);
+      ASSERT_EQ(leaves[i].pos_base, leaf.pos_base);
+    }
+  }
+}
+
+TEST_F(CompactLearnedModelTest, NoKeptLeaves) {
+  CompactLearnedModel model;
+  ASSERT_OK(model.Init(EncodeTenLeaves(
+      std::vector<CompactLearnedModel::Leaf>(10))));
+  ASSERT_EQ(0U, model.num_kept_leaves());
+  ASSERT_EQ(0, model.Predict(0));
+  ASSERT_EQ(0, model.Predict(~0ULL));
+}
+
+TEST_F(CompactLearnedModelTest, Corruption) {
+  std::vector<CompactLearnedModel::Leaf> leaves(10);
+  leaves[4] = MakeLeaf(400, 1.0, 0.0);
+  std::string encoded = EncodeTenLeaves(leaves);
+  CompactLearnedModel model;
+
+  // A dropped word in the middle.
+  std::string truncated = encoded.substr(0, 48) + encoded.substr(56);
+  ASSERT_TRUE(CompactLearnedModel::IsCompact(truncated));
+  ASSERT_TRUE(model.Init(std::move(truncated)).IsCorruption());
+
+  // A leaf count that does not match the bitmap.
+  std::string bad_count = encoded;
+  bad_count[24] = 2;
+  ASSERT_TRUE(model.Init(std::move(bad_count)).IsCorruption());
+
+  ASSERT_TRUE(model.Init(std::string("short")).IsCorruption());
+  ASSERT_OK(model.Init(std::move(encoded)));
+}
+
+TEST_F(CompactLearnedModelTest, FitLeafPicksCheapestShape) {
+  std::vector<uint64_t> keys;
+  std::vector<uint64_t> line, bent, curved;
+  for (uint64_t i = 0; i < 1000; i++) {
+    line.push_back(100 + 30 * i);
+    bent.push_back(i < 600 ? 100 + 10 * i : 6100 + 200 * (i - 600));
+    curved.push_back(100 + i * i * i / 1000);
+  }
+
+  CompactLearnedModel::Leaf leaf = FitCurve(line, 2, &keys);
+  ASSERT_EQ(CompactLearnedModel::kLinear, leaf.shape);
+  ASSERT_LE(MaxLeafError(leaf, keys, line), 2U);
+
+  leaf = FitCurve(bent, 200, &keys);
+  ASSERT_EQ(CompactLearnedModel::kHinge, leaf.shape);
+  ASSERT_LE(MaxLeafError(leaf, keys, bent), 200U);
+
+  // Neither one line nor two come within 10 bytes of a cubic.
+  leaf = FitCurve(curved, 10, &keys);
+  ASSERT_EQ(CompactLearnedModel::kCubic, leaf.shape);
+  ASSERT_LE(MaxLeafError(leaf, keys, curved), 10U);
+
+  // An unreachable bound still gets the most accurate shape.
+  std::mt19937_64 rng(301);
+  std::vector<uint64_t> noisy = curved;
+  for (auto& pos : noisy) {
+    pos += rng() % 5000;
+  }
+  CompactLearnedModel::Leaf linear = FitCurve(noisy, 0x7fffffff, &keys);
+  ASSERT_EQ(CompactLearnedModel::kLinear, linear.shape);
+  leaf = FitCurve(noisy, 1, &keys);
+  ASSERT_NE(CompactLearnedModel::kLinear, leaf.shape);
+  ASSERT_LT(MaxLeafError(leaf, keys, noisy),
+            MaxLeafError(linear, keys, noisy));
+}
+
+TEST_F(CompactLearnedModelTest, ShapesRoundTrip) {
+  std::vector<CompactLearnedModel::Leaf> leaves(10);
+  leaves[1] = MakeLeaf(100, 2.0, 0.0);
+  leaves[3] = MakeLeaf(300, 1.5, 10.0);
+  leaves[3].shape = CompactLearnedModel::kHinge;
+  leaves[3].split = 40;
+  leaves[3].bend = 3.25;
+  leaves[6] = MakeLeaf(600, 0.75, 20.0);
+  leaves[6].shape = CompactLearnedModel::kCubic;
+  leaves[6].quadratic = 0.01;
+  leaves[6].cubic = -1e-5;
+  std::string linear_only;
+  CompactLearnedModel::Encode(1.0, 0.0, 1000, {leaves[0], leaves[1]},
+                              &linear_only);
+
+  std::string encoded = EncodeTenLeaves(leaves);
+  CompactLearnedModel model;
+  ASSERT_OK(model.Init(std::string(encoded)));
+  ASSERT_EQ(3U, model.num_kept_leaves());
+  ASSERT_EQ(1U, model.num_hinge_leaves());
+  ASSERT_EQ(1U, model.num_cubic_leaves());
+  // Each kept leaf also serves the dropped leaves after it.
+  const uint32_t kKept[] = {1, 3, 6, 10};
+  for (int k = 0; k < 3; k++) {
+    uint32_t i = kKept[k];
+    CompactLearnedModel::Leaf expected = leaves[i];
+    CompactLearnedModel::Quantize(&expected);
+    CompactLearnedModel::Leaf leaf;
+    ASSERT_TRUE(model.GetLeaf(i, &leaf));
+    ASSERT_EQ(expected.shape, leaf.shape);
+    ASSERT_EQ(expected.key_base, leaf.key_base);
+    ASSERT_EQ(expected.pos_base, leaf.pos_base);
+    ASSERT_EQ(expected.slope, leaf.slope);
+    for (uint64_t key = i * 100; key < kKept[k + 1] * 100; key++) {
+      ASSERT_EQ(llround(CompactLearnedModel::Evaluate(expected, key)),
+                model.Predict(key));
+    }
+  }
+  // 460 at key 300, then 1.5 per key, plus 3.25 per key past 340.
+  ASSERT_EQ(460 + 150 + 195, model.Predict(400));
+
+  // Models with only linear leaves carry no shape section.
+  ASSERT_OK(model.Init(std::move(linear_only)));
+  ASSERT_EQ(0U, model.num_hinge_leaves());
+  ASSERT_EQ(0U, model.num_cubic_leaves());
+
+  std::string unknown_flags = encoded;
+  unknown_flags[30] = 0x2;
+  ASSERT_TRUE(model.Init(std::move(unknown_flags)).IsNotSupported());
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  rocksdb::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -318,13 +318,16 @@ Status ReadBlockContents(RandomAccessFileReader* file, const Footer& footer,
                          const ImmutableCFOptions &ioptions,
                          bool decompression_requested,
                          const Slice& compression_dict,
-                         const PersistentCacheOptions& cache_options) {
+                         const PersistentCacheOptions& cache_options,
+                         MemoryAllocator* allocator) {
   Status status;
   Slice slice;
   size_t n = static_cast<size_t>(handle.size());
-  std::unique_ptr<char[]> heap_buf;
+  CacheAllocationPtr heap_buf;
   char stack_buf[DefaultStackBufferSize];
   char* used_buf = nullptr;
+  PinnableSlice cached_page;
+  bool cache_hit = false;
   rocksdb::CompressionType compression_type;
 
   if (cache_options.persistent_cache &&
@@ -349,15 +352,16 @@ Status ReadBlockContents(RandomAccessFileReader* file, const Footer& footer,
       cache_options.persistent_cache->IsCompressed()) {
     // lookup uncompressed cache mode p-cache
     status = PersistentCacheHelper::LookupRawPage(
-        cache_options, handle, &heap_buf, n + kBlockTrailerSize);
+        cache_options, handle, &cached_page, n + kBlockTrailerSize);
   } else {
     status = Status::NotFound();
   }
 
   if (status.ok()) {
-    // cache hit
-    used_buf = heap_buf.get();
-    slice = Slice(heap_buf.get(), n);
+    // cache hit, the page stays in the cache's buffer until cached_page goes
+    // out of scope
+    cache_hit = true;
+    slice = Slice(cached_page.data(), n);
   } else {
     if (ioptions.info_log && !status.IsNotFound()) {
       assert(!status.ok());
@@ -372,7 +376,7 @@ Status ReadBlockContents(RandomAccessFileReader* file, const Footer& footer,
       // trivially allocated stack buffer instead of needing a full malloc()
       used_buf = &stack_buf[0];
     } else {
-      heap_buf = std::unique_ptr<char[]>(new char[n + kBlockTrailerSize]);
+      heap_buf = AllocateBlock(n + kBlockTrailerSize, allocator);
       used_buf = heap_buf.get();
     }
 
@@ -398,14 +402,19 @@ Status ReadBlockContents(RandomAccessFileReader* file, const Footer& footer,
     // compressed page, uncompress, update cache
     status = UncompressBlockContents(slice.data(), n, contents,
                                      footer.version(), compression_dict,
-                                     ioptions);
+                                     ioptions, allocator);
+  } else if (cache_hit) {
+    // the page is found in the persistent cache, copy it out of the cache
+    heap_buf = AllocateBlock(n, allocator);
+    memcpy(heap_buf.get(), slice.data(), n);
+    *contents = BlockContents(std::move(heap_buf), n, true, compression_type);
   } else if (slice.data() != used_buf) {
     // the slice content is not the buffer provided
     *contents = BlockContents(Slice(slice.data(), n), false, compression_type);
   } else {
     // page is uncompressed, the buffer either stack or heap provided
     if (used_buf == &stack_buf[0]) {
-      heap_buf = std::unique_ptr<char[]>(new char[n]);
+      heap_buf = AllocateBlock(n, allocator);
       memcpy(heap_buf.get(), stack_buf, n);
     }
     *contents = BlockContents(std::move(heap_buf), n, true, compression_type);
@@ -425,8 +434,9 @@ Status ReadBlockContents(RandomAccessFileReader* file, const Footer& footer,
 Status UncompressBlockContentsForCompressionType(
     const char* data, size_t n, BlockContents* contents,
     uint32_t format_version, const Slice& compression_dict,
-    CompressionType compression_type, const ImmutableCFOptions &ioptions) {
-  std::unique_ptr<char[]> ubuf;
+    CompressionType compression_type, const ImmutableCFOptions &ioptions,
+    MemoryAllocator* allocator) {
+  CacheAllocationPtr ubuf;
 
   assert(compression_type != kNoCompression && "Invalid compression type");
 
@@ -441,7 +451,7 @@ Status UncompressBlockContentsForCompressionType(
       if (!Snappy_GetUncompressedLength(data, n, &ulength)) {
         return Status::Corruption(snappy_corrupt_msg);
       }
-      ubuf.reset(new char[ulength]);
+      ubuf = AllocateBlock(ulength, allocator);
       if (!Snappy_Uncompress(data, n, ubuf.get())) {
         return Status::Corruption(snappy_corrupt_msg);
       }
@@ -474,10 +484,12 @@ Status UncompressBlockContentsForCompressionType(
           BlockContents(std::move(ubuf), decompress_size, true, kNoCompression);
       break;
     case kLZ4Compression:
-      ubuf.reset(LZ4_Uncompress(
-          data, n, &decompress_size,
-          GetCompressFormatForVersion(kLZ4Compression, format_version),
-          compression_dict));
+      ubuf = CacheAllocationPtr(
+          LZ4_Uncompress(
+              data, n, &decompress_size,
+              GetCompressFormatForVersion(kLZ4Compression, format_version),
+              compression_dict, allocator),
+          allocator);
       if (!ubuf) {
         static char lz4_corrupt_msg[] =
           "LZ4 not supported or corrupted LZ4 compressed block contents";
@@ -487,10 +499,12 @@ Status UncompressBlockContentsForCompressionType(
           BlockContents(std::move(ubuf), decompress_size, true, kNoCompression);
       break;
     case kLZ4HCCompression:
-      ubuf.reset(LZ4_Uncompress(
-          data, n, &decompress_size,
-          GetCompressFormatForVersion(kLZ4HCCompression, format_version),
-          compression_dict));
+      ubuf = CacheAllocationPtr(
+          LZ4_Uncompress(
+              data, n, &decompress_size,
+              GetCompressFormatForVersion(kLZ4HCCompression, format_version),
+              compression_dict, allocator),
+          allocator);
       if (!ubuf) {
         static char lz4hc_corrupt_msg[] =
           "LZ4HC not supported or corrupted LZ4HC compressed block contents";
@@ -511,7 +525,9 @@ Status UncompressBlockContentsForCompressionType(
       break;
     case kZSTD:
     case kZSTDNotFinalCompression:
-      ubuf.reset(ZSTD_Uncompress(data, n, &decompress_size, compression_dict));
+      ubuf = CacheAllocationPtr(ZSTD_Uncompress(data, n, &decompress_size,
+                                                compression_dict, allocator),
+                                allocator);
       if (!ubuf) {
         static char zstd_corrupt_msg[] =
             "ZSTD not supported or corrupted ZSTD compressed block contents";
@@ -524,6 +540,15 @@ Status UncompressBlockContentsForCompressionType(
       return Status::Corruption("bad block type");
   }
 
+  if (allocator != nullptr &&
+      contents->allocation.get_deleter().allocator != allocator) {
+    // Zlib, BZip2 and XPRESS grow their output with new[] as they go.
+    size_t size = contents->data.size();
+    CacheAllocationPtr copy = AllocateBlock(size, allocator);
+    memcpy(copy.get(), contents->data.data(), size);
+    *contents = BlockContents(std::move(copy), size, true, kNoCompression);
+  }
+
   if(ShouldReportDetailedTime(ioptions.env, ioptions.statistics)){
     MeasureTime(ioptions.statistics, DECOMPRESSION_TIMES_NANOS,
       timer.ElapsedNanos());
@@ -544,11 +569,12 @@ Status UncompressBlockContentsForCompressionType(
 Status UncompressBlockContents(const char* data, size_t n,
                                BlockContents* contents, uint32_t format_version,
                                const Slice& compression_dict,
-                               const ImmutableCFOptions &ioptions) {
+                               const ImmutableCFOptions &ioptions,
+                               MemoryAllocator* allocator) {
   assert(data[n] != kNoCompression);
   return UncompressBlockContentsForCompressionType(
       data, n, contents, format_version, compression_dict,
-      (CompressionType)data[n], ioptions);
+      (CompressionType)data[n], ioptions, allocator);
 }
 
 }  // namespace rocksdb
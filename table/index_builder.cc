@@ -92,6 +92,8 @@ void PartitionedIndexBuilder::AddIndexEntry(
     entries_.push_back(
         {sub_index_last_key_,
          std::unique_ptr<ShortenedIndexBuilder>(sub_index_builder_)});
+    partition_num_entries_.push_back(sub_index_num_entries_ + 1);
+    sub_index_num_entries_ = 0;
     sub_index_builder_ = nullptr;
     cut_filter_block = true;
   } else {
@@ -105,6 +107,8 @@ void PartitionedIndexBuilder::AddIndexEntry(
         entries_.push_back(
             {sub_index_last_key_,
              std::unique_ptr<ShortenedIndexBuilder>(sub_index_builder_)});
+        partition_num_entries_.push_back(sub_index_num_entries_);
+        sub_index_num_entries_ = 0;
         cut_filter_block = true;
         sub_index_builder_ = nullptr;
       }
@@ -115,6 +119,7 @@ void PartitionedIndexBuilder::AddIndexEntry(
     sub_index_builder_->AddIndexEntry(last_key_in_current_block,
                                       first_key_in_next_block, block_handle);
     sub_index_last_key_ = std::string(*last_key_in_current_block);
+    sub_index_num_entries_++;
   }
 }
 
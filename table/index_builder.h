@@ -15,6 +15,7 @@
 #include <list>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "rocksdb/comparator.h"
 #include "table/block_based_table_factory.h"
@@ -310,6 +311,12 @@ class PartitionedIndexBuilder : public IndexBuilder {
 
   std::string& GetPartitionKey() { return sub_index_last_key_; }
 
+  // Number of data blocks indexed by each partition, in the order the
+  // partitions are written. Complete once the last index entry is added.
+  const std::vector<uint32_t>& partition_num_entries() const {
+    return partition_num_entries_;
+  }
+
  private:
   void MakeNewSubIndexBuilder();
 
@@ -323,6 +330,9 @@ class PartitionedIndexBuilder : public IndexBuilder {
   ShortenedIndexBuilder* sub_index_builder_;
   // the last key in the active partition index builder
   std::string sub_index_last_key_;
+  // number of entries in the active partition index builder
+  uint32_t sub_index_num_entries_ = 0;
+  std::vector<uint32_t> partition_num_entries_;
   std::unique_ptr<FlushBlockPolicy> flush_policy_;
   // true if Finish is called once but not complete yet.
   bool finishing_indexes = false;
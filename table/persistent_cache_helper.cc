@@ -48,7 +48,7 @@ void PersistentCacheHelper::InsertUncompressedPage(
 
 Status PersistentCacheHelper::LookupRawPage(
     const PersistentCacheOptions& cache_options, const BlockHandle& handle,
-    std::unique_ptr<char[]>* raw_data, const size_t raw_data_size) {
+    PinnableSlice* raw_data, const size_t raw_data_size) {
   assert(cache_options.persistent_cache);
   assert(cache_options.persistent_cache->IsCompressed());
 
@@ -58,8 +58,7 @@ Status PersistentCacheHelper::LookupRawPage(
                                           cache_options.key_prefix.size(),
                                           handle, cache_key);
   // Lookup page
-  size_t size;
-  Status s = cache_options.persistent_cache->Lookup(key, raw_data, &size);
+  Status s = cache_options.persistent_cache->LookupPinned(key, raw_data);
   if (!s.ok()) {
     // cache miss
     RecordTick(cache_options.statistics, PERSISTENT_CACHE_MISS);
@@ -68,7 +67,7 @@ Status PersistentCacheHelper::LookupRawPage(
 
   // cache hit
   assert(raw_data_size == handle.size() + kBlockTrailerSize);
-  assert(size == raw_data_size);
+  assert(raw_data->size() == raw_data_size);
   RecordTick(cache_options.statistics, PERSISTENT_CACHE_HIT);
   return Status::OK();
 }
@@ -29,10 +29,10 @@ class PersistentCacheHelper {
       const PersistentCacheOptions& cache_options, const BlockHandle& handle,
       const BlockContents& contents);
 
-  // lookup block from raw page cacge
+  // lookup block from raw page cacge, pinning the page in raw_data
   static Status LookupRawPage(const PersistentCacheOptions& cache_options,
                               const BlockHandle& handle,
-                              std::unique_ptr<char[]>* raw_data,
+                              PinnableSlice* raw_data,
                               const size_t raw_data_size);
 
   // lookup block from uncompressed cache
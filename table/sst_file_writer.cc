@@ -5,12 +5,18 @@
 
 #include "rocksdb/sst_file_writer.h"
 
+#include <inttypes.h>
+#include <memory>
 #include <vector>
 #include "db/dbformat.h"
+#include "port/port.h"
 #include "rocksdb/table.h"
+#include "rocksdb/threadpool.h"
 #include "table/block_based_table_builder.h"
 #include "table/sst_file_writer_collectors.h"
+#include "util/coding.h"
 #include "util/file_reader_writer.h"
+#include "util/mutexlock.h"
 #include "util/sync_point.h"
 
 namespace rocksdb {
@@ -226,6 +232,205 @@ void SstFileWriter::InvalidatePageCache(bool closing) {
 uint64_t SstFileWriter::FileSize() {
   return rep_->file_info.file_size;
 }
+
+struct ParallelSstFileWriter::Rep {
+  Rep(const EnvOptions& _env_options, const Options& _options,
+      ColumnFamilyHandle* _cfh,
+      const ParallelSstFileWriterOptions& _parallel_options)
+      : env_options(_env_options),
+        options(_options),
+        cfh(_cfh),
+        parallel_options(_parallel_options),
+        file_size(_parallel_options.file_size > 0
+                      ? _parallel_options.file_size
+                      : _options.target_file_size_base),
+        opened(false),
+        finished(false),
+        num_entries(0),
+        cv(&mu),
+        in_flight(0) {
+    if (parallel_options.num_threads < 1) {
+      parallel_options.num_threads = 1;
+    }
+  }
+
+  // Builds file `file_index` from the length-prefixed keys and values in
+  // `entries`.
+  void BuildFile(size_t file_index, const std::string& entries);
+
+  // Hands the current chunk to the thread pool, first waiting for a thread
+  // if all are busy.
+  void ScheduleChunk();
+
+  EnvOptions env_options;
+  Options options;
+  ColumnFamilyHandle* cfh;
+  ParallelSstFileWriterOptions parallel_options;
+  uint64_t file_size;
+  std::string path_prefix;
+  bool opened;
+  bool finished;
+  std::unique_ptr<ThreadPool> thread_pool;
+
+  // The file being filled by Add().
+  std::string chunk;
+  uint64_t num_entries;
+  std::string last_key;
+
+  port::Mutex mu;
+  port::CondVar cv;
+  // Guarded by mu.
+  int in_flight;
+  Status status;
+  std::vector<ExternalSstFileInfo> file_infos;
+};
+
+void ParallelSstFileWriter::Rep::BuildFile(size_t file_index,
+                                           const std::string& entries) {
+  SstFileWriter writer(env_options, options, cfh,
+                       parallel_options.invalidate_page_cache);
+  ExternalSstFileInfo file_info;
+  std::string file_path;
+  {
+    MutexLock l(&mu);
+    file_path = file_infos[file_index].file_path;
+  }
+  Status s = writer.Open(file_path);
+  Slice input(entries);
+  Slice key, value;
+  while (s.ok() && GetLengthPrefixedSlice(&input, &key) &&
+         GetLengthPrefixedSlice(&input, &value)) {
+    s = writer.Add(key, value);
+  }
+  if (s.ok()) {
+    s = writer.Finish(&file_info);
+  }
+  TEST_SYNC_POINT("ParallelSstFileWriter::BuildFile:Done");
+
+  MutexLock l(&mu);
+  if (s.ok()) {
+    file_infos[file_index] = file_info;
+  } else if (status.ok()) {
+    status = s;
+  }
+  in_flight--;
+  cv.SignalAll();
+}
+
+void ParallelSstFileWriter::Rep::ScheduleChunk() {
+  size_t file_index;
+  {
+    MutexLock l(&mu);
+    while (in_flight >= parallel_options.num_threads) {
+      cv.Wait();
+    }
+    in_flight++;
+    file_index = file_infos.size();
+    char name[32];
+    snprintf(name, sizeof(name), "%06" PRIu64 ".sst",
+             static_cast<uint64_t>(file_index + 1));
+    file_infos.emplace_back();
+    file_infos.back().file_path = path_prefix + name;
+  }
+  std::shared_ptr<std::string> entries(new std::string());
+  entries->swap(chunk);
+  chunk.reserve(entries->size());
+  num_entries = 0;
+  thread_pool->SubmitJob([this, file_index, entries]() {
+    BuildFile(file_index, *entries);
+  });
+}
+
+ParallelSstFileWriter::ParallelSstFileWriter(
+    const EnvOptions& env_options, const Options& options,
+    ColumnFamilyHandle* column_family,
+    const ParallelSstFileWriterOptions& parallel_options)
+    : rep_(new Rep(env_options, options, column_family, parallel_options)) {}
+
+ParallelSstFileWriter::~ParallelSstFileWriter() {
+  Rep* r = rep_;
+  if (r->thread_pool) {
+    r->thread_pool->WaitForJobsAndJoinAllThreads();
+  }
+  if (r->opened && !r->finished) {
+    for (const auto& file_info : r->file_infos) {
+      r->options.env->DeleteFile(file_info.file_path);
+    }
+  }
+  delete rep_;
+}
+
+Status ParallelSstFileWriter::Open(const std::string& path_prefix) {
+  Rep* r = rep_;
+  if (r->opened) {
+    return Status::InvalidArgument("Writer is already opened");
+  }
+  r->path_prefix = path_prefix;
+  r->thread_pool.reset(NewThreadPool(r->parallel_options.num_threads));
+  r->opened = true;
+  return Status::OK();
+}
+
+Status ParallelSstFileWriter::Add(const Slice& user_key, const Slice& value) {
+  Rep* r = rep_;
+  if (!r->opened || r->finished) {
+    return Status::InvalidArgument("Writer is not opened");
+  }
+  if ((r->num_entries > 0 || !r->file_infos.empty()) &&
+      r->options.comparator->Compare(user_key, r->last_key) <= 0) {
+    // Make sure that keys are added in order
+    return Status::InvalidArgument("Keys must be added in order");
+  }
+  {
+    MutexLock l(&r->mu);
+    if (!r->status.ok()) {
+      return r->status;
+    }
+  }
+
+  PutLengthPrefixedSlice(&r->chunk, user_key);
+  PutLengthPrefixedSlice(&r->chunk, value);
+  r->num_entries++;
+  r->last_key.assign(user_key.data(), user_key.size());
+  if (r->chunk.size() >= r->file_size) {
+    r->ScheduleChunk();
+  }
+  return Status::OK();
+}
+
+Status ParallelSstFileWriter::Finish(
+    std::vector<ExternalSstFileInfo>* file_infos) {
+  Rep* r = rep_;
+  if (!r->opened || r->finished) {
+    return Status::InvalidArgument("Writer is not opened");
+  }
+  if (r->num_entries > 0) {
+    r->ScheduleChunk();
+  }
+  r->thread_pool->WaitForJobsAndJoinAllThreads();
+  r->thread_pool.reset();
+
+  Status s;
+  {
+    MutexLock l(&r->mu);
+    s = r->status;
+  }
+  if (s.ok() && r->file_infos.empty()) {
+    s = Status::InvalidArgument("Cannot create sst file with no entries");
+  }
+  r->finished = true;
+  if (!s.ok()) {
+    // Files that failed were already deleted by their SstFileWriter.
+    for (const auto& file_info : r->file_infos) {
+      r->options.env->DeleteFile(file_info.file_path);
+    }
+    return s;
+  }
+  if (file_infos != nullptr) {
+    *file_infos = r->file_infos;
+  }
+  return s;
+}
 #endif  // !ROCKSDB_LITE
 
 }  // namespace rocksdb
@@ -8,7 +8,9 @@
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 
 #pragma once
+#include <atomic>
 #include <memory>
+#include <vector>
 #include "table/internal_iterator.h"
 
 namespace rocksdb {
@@ -17,6 +19,8 @@ class Iterator;
 struct ParsedInternalKey;
 class Slice;
 class Arena;
+class Cache;
+class RateLimiter;
 struct ReadOptions;
 struct TableProperties;
 class GetContext;
@@ -95,6 +99,31 @@ class TableReader {
     return Status::OK();
   }
 
+  // Returns the block cache the table reads its blocks into and sets
+  // *key_prefix to the prefix of their keys there, which the varint64 file
+  // offset of the block follows. Returns nullptr if there is no such cache.
+  virtual Cache* GetBlockCacheKeyPrefix(Slice* key_prefix) const {
+    (void) key_prefix;
+    return nullptr;
+  }
+
+  // Loads the index, filter and other meta blocks the table keeps in the
+  // block cache into it.
+  virtual Status WarmUpMetaBlocks() { return Status::OK(); }
+
+  // Loads the data blocks at the ascending file offsets in `offsets` into
+  // the block cache, skipping offsets that start no data block. Requests the
+  // size of each block from `rate_limiter`, if set, before reading it.
+  // Returns Incomplete once `*stop` is set or the block cache is full.
+  virtual Status WarmUpDataBlocks(const std::vector<uint64_t>& offsets,
+                                  RateLimiter* rate_limiter,
+                                  const std::atomic<bool>* stop) {
+    (void) offsets;
+    (void) rate_limiter;
+    (void) stop;
+    return Status::OK();
+  }
+
   // convert db file to a human readable form
   virtual Status DumpTable(WritableFile* out_file) {
     return Status::NotSupported("DumpTable() not supported");
@@ -31,6 +31,7 @@
 #include "rocksdb/perf_context.h"
 #include "rocksdb/slice_transform.h"
 #include "rocksdb/statistics.h"
+#include "rocksdb/utilities/block_cache_trace.h"
 #include "rocksdb/write_buffer_manager.h"
 #include "table/block.h"
 #include "table/block_based_table_builder.h"
@@ -371,11 +372,12 @@ class TableConstructor: public Constructor {
     return table_reader_->ApproximateOffsetOf(key);
   }
 
-  virtual Status Reopen(const ImmutableCFOptions& ioptions) {
+  virtual Status Reopen(const ImmutableCFOptions& ioptions, int level = -1) {
     file_reader_.reset(test::GetRandomAccessFileReader(new test::StringSource(
         GetSink()->contents(), uniq_id_, ioptions.allow_mmap_reads)));
     return ioptions.table_factory->NewTableReader(
-        TableReaderOptions(ioptions, soptions, *last_internal_key_),
+        TableReaderOptions(ioptions, soptions, *last_internal_key_,
+                           false /* skip_filters */, level),
         std::move(file_reader_), GetSink()->contents().size(), &table_reader_);
   }
 
@@ -2182,6 +2184,423 @@ TEST_F(BlockBasedTableTest, BlockCacheLeak) {
   c.ResetTableReader();
 }
 
+// Returns `num_keys` ascending 8-byte big-endian user keys, the i-th one
+// being a random number in [i * 1000, i * 1000 + 1000), for the learned
+// model to fit.
+static std::vector<std::string> GenerateModelUserKeys(uint64_t num_keys) {
+  Random rnd(301);
+  std::vector<std::string> user_keys;
+  for (uint64_t i = 0; i < num_keys; i++) {
+    uint64_t key = i * 1000 + rnd.Uniform(1000);
+    std::string user_key(8, '\0');
+    for (int b = 7; b >= 0; b--) {
+      user_key[b] = static_cast<char>(key & 0xff);
+      key >>= 8;
+    }
+    user_keys.push_back(user_key);
+  }
+  return user_keys;
+}
+
+// ModelGet() must find a key in the data block the model predicts the same
+// way whether that block's handle comes from one index block kept whole in
+// memory or from an index partition loaded on demand.
+TEST_F(BlockBasedTableTest, ModelGetWithPartitionedIndex) {
+  std::vector<std::string> user_keys = GenerateModelUserKeys(20000);
+
+  // Returns which keys ModelGet() finds in a table with the given index.
+  auto model_get_all = [&](BlockBasedTableOptions::IndexType index_type,
+                           int restart_interval, std::vector<bool>* found) {
+    Options options;
+    BlockBasedTableOptions table_options;
+    table_options.index_type = index_type;
+    table_options.index_block_restart_interval = restart_interval;
+    // Small partitions, so that the table has many.
+    table_options.metadata_block_size = 128;
+    table_options.block_cache = NewLRUCache(8 << 20);
+    options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+
+    TableConstructor c(BytewiseComparator(),
+                       true /* convert_to_internal_key_ */);
+    for (const std::string& user_key : user_keys) {
+      c.Add(user_key, std::string(100, 'v') + user_key);
+    }
+    std::vector<std::string> keys;
+    stl_wrappers::KVMap kvmap;
+    const ImmutableCFOptions ioptions(options);
+    c.Finish(options, ioptions, table_options,
+             GetPlainInternalComparator(options.comparator), &keys, &kvmap);
+    auto reader = dynamic_cast<BlockBasedTable*>(c.GetTableReader());
+
+    // Nothing is cached yet, so a lookup that may not do I/O cannot load
+    // an index partition or a data block.
+    ReadOptions no_io;
+    no_io.read_tier = kBlockCacheTier;
+    {
+      const std::string& user_key = kvmap.begin()->first;
+      PinnableSlice value;
+      bool value_found = true;
+      GetContext get_context(options.comparator, nullptr, nullptr, nullptr,
+                             GetContext::kNotFound, user_key, &value,
+                             &value_found, nullptr, nullptr, nullptr);
+      InternalKey ikey(user_key, kMaxSequenceNumber, kTypeValue);
+      ASSERT_OK(reader->ModelGet(no_io, ikey.Encode(), &get_context));
+      ASSERT_EQ(GetContext::kFound, get_context.State());
+      ASSERT_FALSE(value_found);
+    }
+
+    found->clear();
+    for (const auto& kv : kvmap) {
+      PinnableSlice value;
+      GetContext get_context(options.comparator, nullptr, nullptr, nullptr,
+                             GetContext::kNotFound, kv.first, &value, nullptr,
+                             nullptr, nullptr, nullptr);
+      InternalKey ikey(kv.first, kMaxSequenceNumber, kTypeValue);
+      ASSERT_OK(reader->ModelGet(ReadOptions(), ikey.Encode(), &get_context));
+      found->push_back(get_context.State() == GetContext::kFound);
+      if (found->back()) {
+        ASSERT_EQ(kv.second, value.ToString());
+      }
+    }
+  };
+
+  std::vector<bool> expected;
+  model_get_all(BlockBasedTableOptions::kBinarySearch, 1, &expected);
+  ASSERT_EQ(user_keys.size(), expected.size());
+  ASSERT_GT(std::count(expected.begin(), expected.end(), true),
+            static_cast<int>(user_keys.size() / 2));
+  for (int restart_interval : {1, 4}) {
+    std::vector<bool> found;
+    model_get_all(BlockBasedTableOptions::kTwoLevelIndexSearch,
+                  restart_interval, &found);
+    ASSERT_TRUE(expected == found);
+  }
+}
+
+TEST_F(BlockBasedTableTest, ModelApproximateOffsetOf) {
+  std::vector<std::string> user_keys = GenerateModelUserKeys(20000);
+
+  // Returns ApproximateOffsetOf() of every key, and the table's data size
+  // and recorded model offset error in stored bytes.
+  auto offsets_of = [&](uint64_t model_offset_max_error,
+                        std::vector<uint64_t>* offsets, uint64_t* data_size,
+                        double* max_error) {
+    Options options;
+    BlockBasedTableOptions table_options;
+    table_options.model_offset_max_error = model_offset_max_error;
+    options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+    TableConstructor c(BytewiseComparator(),
+                       true /* convert_to_internal_key_ */);
+    for (size_t i = 0; i < user_keys.size(); i++) {
+      c.Add(user_keys[i], std::string(100 + i * 37 % 100, 'v'));
+    }
+    std::vector<std::string> keys;
+    stl_wrappers::KVMap kvmap;
+    const ImmutableCFOptions ioptions(options);
+    c.Finish(options, ioptions, table_options,
+             GetPlainInternalComparator(options.comparator), &keys, &kvmap);
+    auto props = c.GetTableReader()->GetTableProperties();
+    bool property_present = false;
+    uint64_t raw_error = GetModelMaxOffsetError(
+        props->user_collected_properties, &property_present);
+    ASSERT_TRUE(property_present);
+    *data_size = props->data_size;
+    *max_error = static_cast<double>(raw_error) /
+                 (props->raw_key_size + props->raw_value_size) *
+                 props->data_size;
+    offsets->clear();
+    for (const std::string& user_key : user_keys) {
+      offsets->push_back(c.ApproximateOffsetOf(user_key));
+    }
+    offsets->push_back(c.ApproximateOffsetOf(std::string(8, '\xff')));
+  };
+
+  std::vector<uint64_t> from_index, from_model, bound_too_small;
+  uint64_t data_size;
+  double max_error;
+  offsets_of(0, &from_index, &data_size, &max_error);
+  offsets_of(data_size, &from_model, &data_size, &max_error);
+  ASSERT_GT(max_error, 1);
+  ASSERT_LT(max_error, data_size / 10);
+  offsets_of(1, &bound_too_small, &data_size, &max_error);
+  ASSERT_TRUE(from_index == bound_too_small);
+
+  // The index answers with the start of the key's data block, the model
+  // with an estimate of the key's own offset.
+  const uint64_t kBlockSlack = 2 * 4096;
+  ASSERT_FALSE(from_index == from_model);
+  for (size_t i = 0; i < from_index.size(); i++) {
+    uint64_t diff = from_index[i] > from_model[i]
+                        ? from_index[i] - from_model[i]
+                        : from_model[i] - from_index[i];
+    ASSERT_LE(diff, max_error + kBlockSlack) << i;
+  }
+  ASSERT_EQ(data_size, from_model.back());
+}
+
+TEST_F(BlockBasedTableTest, LearnedModelInBlockCache) {
+  std::vector<std::string> user_keys = GenerateModelUserKeys(20000);
+
+  Options options;
+  options.statistics = CreateDBStatistics();
+  BlockBasedTableOptions table_options;
+  table_options.block_cache = NewLRUCache(8 << 20);
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  TableConstructor c(BytewiseComparator(), true /* convert_to_internal_key_ */);
+  for (const std::string& user_key : user_keys) {
+    c.Add(user_key, std::string(100, 'v') + user_key);
+  }
+  std::vector<std::string> keys;
+  stl_wrappers::KVMap kvmap;
+  const ImmutableCFOptions ioptions(options);
+  c.Finish(options, ioptions, table_options,
+           GetPlainInternalComparator(options.comparator), &keys, &kvmap);
+
+  // Returns which keys ModelGet() finds.
+  auto model_get_all = [&](std::vector<bool>* found) {
+    auto reader = dynamic_cast<BlockBasedTable*>(c.GetTableReader());
+    found->clear();
+    for (const auto& kv : kvmap) {
+      PinnableSlice value;
+      GetContext get_context(options.comparator, nullptr, nullptr, nullptr,
+                             GetContext::kNotFound, kv.first, &value, nullptr,
+                             nullptr, nullptr, nullptr);
+      InternalKey ikey(kv.first, kMaxSequenceNumber, kTypeValue);
+      ASSERT_OK(reader->ModelGet(ReadOptions(), ikey.Encode(), &get_context));
+      found->push_back(get_context.State() == GetContext::kFound);
+      if (found->back()) {
+        ASSERT_EQ(kv.second, value.ToString());
+      }
+    }
+  };
+  // Returns whether a lookup that may not do I/O could tell the first key is
+  // absent, which it cannot without the learned model.
+  auto model_in_cache = [&]() {
+    auto reader = dynamic_cast<BlockBasedTable*>(c.GetTableReader());
+    ReadOptions no_io;
+    no_io.read_tier = kBlockCacheTier;
+    const std::string& user_key = kvmap.begin()->first;
+    PinnableSlice value;
+    bool value_found = true;
+    GetContext get_context(options.comparator, nullptr, nullptr, nullptr,
+                           GetContext::kNotFound, user_key, &value,
+                           &value_found, nullptr, nullptr, nullptr);
+    InternalKey ikey(user_key, kMaxSequenceNumber, kTypeValue);
+    EXPECT_OK(reader->ModelGet(no_io, ikey.Encode(), &get_context));
+    // The data block is cached, so only a missing model stops the lookup.
+    return value_found;
+  };
+
+  std::vector<bool> expected;
+  model_get_all(&expected);
+  const size_t owned_usage = c.GetTableReader()->ApproximateMemoryUsage();
+  Statistics* stats = options.statistics.get();
+  ASSERT_EQ(0, stats->getTickerCount(BLOCK_CACHE_LEARNED_MODEL_ADD));
+
+  // With the model in the block cache, the reader no longer holds it.
+  table_options.cache_learned_model_blocks = true;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  const ImmutableCFOptions cached_ioptions(options);
+  ASSERT_OK(c.Reopen(cached_ioptions));
+  ASSERT_LT(c.GetTableReader()->ApproximateMemoryUsage(), owned_usage);
+  ASSERT_EQ(1, stats->getTickerCount(BLOCK_CACHE_LEARNED_MODEL_MISS));
+  ASSERT_EQ(1, stats->getTickerCount(BLOCK_CACHE_LEARNED_MODEL_ADD));
+  uint64_t model_charge =
+      stats->getTickerCount(BLOCK_CACHE_LEARNED_MODEL_BYTES_INSERT);
+  ASSERT_GT(model_charge, 0);
+  ASSERT_EQ(0, table_options.block_cache->GetPinnedUsage());
+
+  std::vector<bool> found;
+  model_get_all(&found);
+  ASSERT_TRUE(expected == found);
+  ASSERT_EQ(kvmap.size(),
+            stats->getTickerCount(BLOCK_CACHE_LEARNED_MODEL_HIT));
+  ASSERT_TRUE(model_in_cache());
+
+  // Once evicted, the model is read back on the next lookup that may do I/O.
+  table_options.block_cache->EraseUnRefEntries();
+  ASSERT_FALSE(model_in_cache());
+  ASSERT_EQ(2, stats->getTickerCount(BLOCK_CACHE_LEARNED_MODEL_MISS));
+  ASSERT_EQ(1, stats->getTickerCount(BLOCK_CACHE_LEARNED_MODEL_ADD));
+  model_get_all(&found);
+  ASSERT_TRUE(expected == found);
+  ASSERT_EQ(2, stats->getTickerCount(BLOCK_CACHE_LEARNED_MODEL_ADD));
+
+  // A level-0 reader keeps its model checked out until it is closed.
+  table_options.pin_l0_learned_model_in_cache = true;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  const ImmutableCFOptions pinned_ioptions(options);
+  c.ResetTableReader();
+  table_options.block_cache->EraseUnRefEntries();
+  ASSERT_OK(c.Reopen(pinned_ioptions, 0 /* level */));
+  ASSERT_GE(table_options.block_cache->GetPinnedUsage(), model_charge);
+  table_options.block_cache->EraseUnRefEntries();
+  model_get_all(&found);
+  ASSERT_TRUE(expected == found);
+  ASSERT_TRUE(model_in_cache());
+  c.ResetTableReader();
+  ASSERT_EQ(0, table_options.block_cache->GetPinnedUsage());
+}
+
+TEST_F(BlockBasedTableTest, DemoteEvictedBlocks) {
+  CompressionType type = kNoCompression;
+  for (CompressionType t :
+       {kLZ4Compression, kSnappyCompression, kZlibCompression, kZSTD}) {
+    if (CompressionTypeSupported(t)) {
+      type = t;
+      break;
+    }
+  }
+  if (type == kNoCompression) {
+    fprintf(stderr, "skipping test, compression disabled\n");
+    return;
+  }
+
+  Options options;
+  options.statistics = CreateDBStatistics();
+  options.compression = kNoCompression;
+  BlockBasedTableOptions table_options;
+  table_options.block_size = 1024;
+  // Room for a few data blocks only.
+  table_options.block_cache = NewLRUCache(16 * 1024, 0);
+  table_options.block_cache_compressed = NewLRUCache(1 << 20, 0);
+  table_options.demote_evicted_blocks = true;
+  table_options.demoted_block_compression = type;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+
+  TableConstructor c(BytewiseComparator(), true /* convert_to_internal_key_ */);
+  for (int i = 0; i < 2000; i++) {
+    char key[16];
+    snprintf(key, sizeof(key), "k%06d", i);
+    c.Add(key, std::string(100, 'a' + i % 26));
+  }
+  std::vector<std::string> keys;
+  stl_wrappers::KVMap kvmap;
+  const ImmutableCFOptions ioptions(options);
+  c.Finish(options, ioptions, table_options,
+           GetPlainInternalComparator(options.comparator), &keys, &kvmap);
+  uint64_t data_size = c.GetTableReader()->GetTableProperties()->data_size;
+
+  auto read_all = [&]() {
+    std::unique_ptr<InternalIterator> iter(c.NewIterator());
+    auto kv = kvmap.begin();
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next(), kv++) {
+      ASSERT_TRUE(kv != kvmap.end());
+      ASSERT_EQ(kv->first, iter->key().ToString());
+      ASSERT_EQ(kv->second, iter->value().ToString());
+    }
+    ASSERT_OK(iter->status());
+    ASSERT_TRUE(kv == kvmap.end());
+  };
+
+  // Blocks read from the file only go to the block cache, and move to the
+  // compressed block cache as they are evicted from it.
+  Statistics* stats = options.statistics.get();
+  read_all();
+  ASSERT_EQ(0, stats->getTickerCount(BLOCK_CACHE_COMPRESSED_ADD));
+  ASSERT_EQ(0, stats->getTickerCount(BLOCK_CACHE_COMPRESSED_HIT));
+  uint64_t misses = stats->getTickerCount(BLOCK_CACHE_COMPRESSED_MISS);
+  ASSERT_GT(misses, 16);
+  size_t demoted_usage = table_options.block_cache_compressed->GetUsage();
+  ASSERT_GT(demoted_usage, 0);
+  ASSERT_LT(demoted_usage, data_size / 2);
+
+  // Now every block is in one of the two caches, and a hit in the
+  // compressed one moves the block back.
+  read_all();
+  ASSERT_EQ(misses, stats->getTickerCount(BLOCK_CACHE_COMPRESSED_MISS));
+  ASSERT_GT(stats->getTickerCount(BLOCK_CACHE_COMPRESSED_HIT), 16);
+  ASSERT_EQ(0, stats->getTickerCount(BLOCK_CACHE_COMPRESSED_ADD));
+
+  // Demotion needs somewhere to demote to.
+  table_options.block_cache_compressed.reset();
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+  ASSERT_TRUE(options.table_factory->SanitizeOptions(
+                  DBOptions(options), ColumnFamilyOptions(options))
+                  .IsInvalidArgument());
+}
+
+TEST_F(BlockBasedTableTest, BlockCacheTracer) {
+  Env* env = Env::Default();
+  std::string trace_path = test::TmpDir(env) + "/table_block_cache_trace";
+  std::shared_ptr<BlockCacheTracer> tracer;
+  ASSERT_OK(NewBlockCacheTracer(env, trace_path, &tracer));
+
+  Options options;
+  BlockBasedTableOptions table_options;
+  table_options.block_cache = NewLRUCache(1 << 20, 0);
+  table_options.cache_index_and_filter_blocks = true;
+  table_options.block_cache_tracer = tracer;
+  options.table_factory.reset(NewBlockBasedTableFactory(table_options));
+
+  TableConstructor c(BytewiseComparator());
+  std::string user_key = "k04";
+  InternalKey internal_key(user_key, 0, kTypeValue);
+  std::string encoded_key = internal_key.Encode().ToString();
+  c.Add(encoded_key, "hello");
+  std::vector<std::string> keys;
+  stl_wrappers::KVMap kvmap;
+  const ImmutableCFOptions ioptions(options);
+  c.Finish(options, ioptions, table_options,
+           GetPlainInternalComparator(options.comparator), &keys, &kvmap);
+
+  PinnableSlice value;
+  GetContext get_context(options.comparator, nullptr, nullptr, nullptr,
+                         GetContext::kNotFound, user_key, &value, nullptr,
+                         nullptr, nullptr, nullptr);
+  ASSERT_OK(c.GetTableReader()->Get(ReadOptions(), encoded_key, &get_context));
+  ASSERT_EQ(GetContext::kFound, get_context.State());
+  {
+    std::unique_ptr<InternalIterator> iter(c.NewIterator());
+    iter->SeekToFirst();
+    ASSERT_TRUE(iter->Valid());
+  }
+  ASSERT_OK(tracer->Close());
+
+  std::unique_ptr<BlockCacheTraceReader> reader;
+  ASSERT_OK(NewBlockCacheTraceReader(env, trace_path, &reader));
+  std::vector<BlockCacheTraceRecord> records;
+  BlockCacheTraceRecord record;
+  while (reader->ReadRecord(&record)) {
+    records.push_back(record);
+  }
+  ASSERT_OK(reader->status());
+  ASSERT_OK(env->DeleteFile(trace_path));
+
+  // Opening the table brings in its index, the Get() misses the data block
+  // and fills the cache with it, and the iterator then finds it there.
+  bool prefetched_index = false;
+  bool get_filled_data = false;
+  bool iterator_hit_data = false;
+  for (size_t i = 0; i < records.size(); i++) {
+    const BlockCacheTraceRecord& r = records[i];
+    if (r.op != BlockCacheTraceRecord::kLookup) {
+      continue;
+    }
+    if (r.caller == BlockCacheTraceCaller::kPrefetch &&
+        r.block_type == BlockCacheTraceBlockType::kIndex) {
+      prefetched_index = true;
+    }
+    if (r.caller == BlockCacheTraceCaller::kGet &&
+        r.block_type == BlockCacheTraceBlockType::kData && !r.is_hit) {
+      ASSERT_LT(i + 1, records.size());
+      ASSERT_EQ(BlockCacheTraceRecord::kInsert, records[i + 1].op);
+      ASSERT_EQ(r.cache_key, records[i + 1].cache_key);
+      ASSERT_GT(records[i + 1].charge, 0);
+      get_filled_data = true;
+    }
+    if (r.caller == BlockCacheTraceCaller::kIterator &&
+        r.block_type == BlockCacheTraceBlockType::kData) {
+      ASSERT_TRUE(r.is_hit);
+      ASSERT_GT(r.charge, 0);
+      iterator_hit_data = true;
+    }
+  }
+  ASSERT_TRUE(prefetched_index);
+  ASSERT_TRUE(get_filled_data);
+  ASSERT_TRUE(iterator_hit_data);
+}
+
 TEST_F(BlockBasedTableTest, NewIndexIteratorLeak) {
   // A regression test to avoid data race described in
   // https://github.com/facebook/rocksdb/issues/1267
@@ -28,6 +28,8 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstddef>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <unordered_map>
@@ -142,6 +144,9 @@ DEFINE_string(
     "\treadreverse   -- read N times in reverse order\n"
     "\treadrandom    -- read N times in random order\n"
     "\treadmissing   -- read N missing keys in random order\n"
+    "\tlearnedcompare -- read N random keys through the index block and "
+    "N through the learned model, alternating per Get, and compare Get "
+    "latency percentiles, blocks per Get and model size and build time\n"
     "\treadwhilewriting      -- 1 writer, N threads doing random "
     "reads\n"
     "\treadwhilemerging      -- 1 merger, N threads doing random "
@@ -277,6 +282,58 @@ DEFINE_bool(enable_numa, false,
 
 DEFINE_bool(is_model, false, "is_model");
 
+DEFINE_string(key_distribution, "uniform",
+              "How key numbers map to key bytes. uniform: big-endian key "
+              "number; lognormal: lognormally spaced integers; timestamp: "
+              "microsecond timestamps arriving in bursts; hashed: sparse "
+              "64-bit hashed IDs; zipfian: uniform keys, but writes and "
+              "random reads pick them with a Zipfian skew; prefixed_string: "
+              "decimal IDs under a few long shared prefixes");
+
+DEFINE_double(key_lognormal_sigma, 2.0,
+              "Shape parameter of --key_distribution=lognormal");
+
+DEFINE_int64(key_timestamp_burst, 1000,
+             "Keys per burst with --key_distribution=timestamp");
+
+DEFINE_double(key_zipf_theta, 0.99,
+              "Skew of --key_distribution=zipfian, in (0, 1)");
+
+DEFINE_int32(key_string_prefixes, 16,
+             "Number of shared prefixes with "
+             "--key_distribution=prefixed_string");
+
+enum KeyDistribution {
+  kUniformKeys,
+  kLognormalKeys,
+  kTimestampKeys,
+  kHashedKeys,
+  kZipfianKeys,
+  kPrefixedStringKeys
+};
+
+static enum KeyDistribution StringToKeyDistribution(const char* ctype) {
+  assert(ctype);
+
+  if (!strcasecmp(ctype, "uniform"))
+    return kUniformKeys;
+  else if (!strcasecmp(ctype, "lognormal"))
+    return kLognormalKeys;
+  else if (!strcasecmp(ctype, "timestamp"))
+    return kTimestampKeys;
+  else if (!strcasecmp(ctype, "hashed"))
+    return kHashedKeys;
+  else if (!strcasecmp(ctype, "zipfian"))
+    return kZipfianKeys;
+  else if (!strcasecmp(ctype, "prefixed_string"))
+    return kPrefixedStringKeys;
+
+  fprintf(stdout, "Cannot parse key distribution %s\n", ctype);
+  return kUniformKeys;
+}
+
+static enum KeyDistribution FLAGS_key_distribution_e = kUniformKeys;
+
 DEFINE_int64(db_write_buffer_size, rocksdb::Options().db_write_buffer_size,
              "Number of bytes to buffer in all memtables before compacting");
 
@@ -313,6 +370,15 @@ DEFINE_int32(max_write_buffer_number_to_maintain,
              "after they are flushed.  If this value is set to -1, "
              "'max_write_buffer_number' will be used.");
 
+DEFINE_bool(learned_immutable_memtable,
+            rocksdb::Options().learned_immutable_memtable,
+            "Rebuild immutable memtables into learned sorted arrays while "
+            "they wait to be flushed.");
+
+DEFINE_uint64(level_hint_cache_size, rocksdb::Options().level_hint_cache_size,
+              "Slots per Version of the cache of levels where recent Gets "
+              "found their keys. 0 disables it.");
+
 DEFINE_int32(max_background_compactions,
              rocksdb::Options().max_background_compactions,
              "The maximum number of concurrent background compactions"
@@ -376,6 +442,26 @@ DEFINE_double(cache_high_pri_pool_ratio, 0.0,
               "If > 0.0, we also enable "
               "cache_index_and_filter_blocks_with_high_priority.");
 
+DEFINE_int64(cache_frequency_sketch_size, 0,
+             "If positive, the LRU block cache admits new blocks by TinyLFU, "
+             "with a frequency sketch of this many counters, and protects "
+             "blocks that were hit in a segmented LRU.");
+
+DEFINE_bool(cache_slab_allocator, false,
+            "Allocate the blocks put in the LRU block cache from a slab "
+            "allocator backed by huge pages.");
+
+DEFINE_int64(cache_slab_huge_page_size, 2 << 20,
+             "Huge page size of the slab allocator. 0 uses regular pages.");
+
+DEFINE_bool(cache_slab_numa, false,
+            "Keep the slab allocator's memory on the NUMA node of the "
+            "allocating thread.");
+
+DEFINE_bool(cache_lock_free_hits, false,
+            "Let LRU block cache hits on blocks that are already referenced, "
+            "such as pinned index and filter blocks, skip the shard mutex.");
+
 DEFINE_bool(use_clock_cache, false,
             "Replace default LRU block cache with clock cache.");
 
@@ -407,6 +493,39 @@ DEFINE_int32(read_amp_bytes_per_bit,
              rocksdb::BlockBasedTableOptions().read_amp_bytes_per_bit,
              "Number of bytes per bit to be used in block read-amp bitmap");
 
+DEFINE_bool(compact_learned_model,
+            rocksdb::BlockBasedTableOptions().compact_learned_model,
+            "Write the learned model of each table in the compact encoding");
+
+DEFINE_uint64(learned_leaf_max_error,
+              rocksdb::BlockBasedTableOptions().learned_leaf_max_error,
+              "With --compact_learned_model, refit leaves whose linear model "
+              "errs by more than this many bytes as two lines or a cubic");
+
+DEFINE_uint64(model_offset_max_error,
+              rocksdb::BlockBasedTableOptions().model_offset_max_error,
+              "Answer approximate sizes from the learned model of tables whose "
+              "model offsets are within this many bytes");
+
+DEFINE_bool(cache_learned_model_blocks,
+            rocksdb::BlockBasedTableOptions().cache_learned_model_blocks,
+            "Keep the learned model of each table in the block cache");
+
+DEFINE_bool(pin_l0_learned_model_in_cache,
+            rocksdb::BlockBasedTableOptions().pin_l0_learned_model_in_cache,
+            "With --cache_learned_model_blocks, pin the learned models of L0 "
+            "files in the block cache");
+
+DEFINE_bool(demote_evicted_blocks,
+            rocksdb::BlockBasedTableOptions().demote_evicted_blocks,
+            "Compress data blocks evicted from the block cache into the "
+            "compressed block cache (--compressed_cache_size), and move them "
+            "back on a hit there");
+
+DEFINE_string(demoted_block_compression, "lz4",
+              "Algorithm used to compress blocks demoted by "
+              "--demote_evicted_blocks");
+
 DEFINE_int64(compressed_cache_size, -1,
              "Number of bytes to use as a cache of compressed data.");
 
@@ -414,6 +533,25 @@ DEFINE_int64(row_cache_size, 0,
              "Number of bytes to use as a cache of individual rows"
              " (0 = disabled).");
 
+DEFINE_int64(lookup_result_cache_size, 0,
+             "Number of bytes to use as a cache of point lookup results,"
+             " including keys not found (0 = disabled).");
+
+DEFINE_uint64(block_cache_warmup_persist_period_sec,
+              rocksdb::Options().block_cache_warmup_persist_period_sec,
+              "Period of persisting the blocks found in the block cache, which"
+              " are loaded into it again when the DB is reopened"
+              " (0 = disabled).");
+
+DEFINE_int32(block_cache_warmup_threads,
+             rocksdb::Options().block_cache_warmup_threads,
+             "Number of threads loading blocks into the block cache on open.");
+
+DEFINE_uint64(block_cache_warmup_rate_bytes_per_sec,
+              rocksdb::Options().block_cache_warmup_rate_bytes_per_sec,
+              "Rate limit of loading blocks into the block cache on open"
+              " (0 = unlimited).");
+
 DEFINE_int32(open_files, rocksdb::Options().max_open_files,
              "Maximum number of files to keep open at the same time"
              " (use default if == 0)");
@@ -621,6 +759,10 @@ DEFINE_string(
     "\t--statistics\n"
     "\t--row_cache_size\n"
     "\t--row_cache_numshardbits\n"
+    "\t--lookup_result_cache_size\n"
+    "\t--block_cache_warmup_persist_period_sec\n"
+    "\t--block_cache_warmup_threads\n"
+    "\t--block_cache_warmup_rate_bytes_per_sec\n"
     "\t--enable_io_prio\n"
     "\t--dump_malloc_stats\n"
     "\t--num_multi_db\n");
@@ -901,7 +1043,8 @@ enum RepFactory {
   kPrefixHash,
   kVectorRep,
   kHashLinkedList,
-  kCuckoo
+  kCuckoo,
+  kLearnedGappedArray
 };
 
 static enum RepFactory StringToRepFactory(const char* ctype) {
@@ -917,6 +1060,8 @@ static enum RepFactory StringToRepFactory(const char* ctype) {
     return kHashLinkedList;
   else if (!strcasecmp(ctype, "cuckoo"))
     return kCuckoo;
+  else if (!strcasecmp(ctype, "learned_gapped_array"))
+    return kLearnedGappedArray;
 
   fprintf(stdout, "Cannot parse memreptable %s\n", ctype);
   return kSkipList;
@@ -1783,6 +1928,129 @@ class Duration {
   uint64_t start_at_;
 };
 
+// Returns the sum of 1 / i^theta for i in [1, n], for theta in (0, 1). The
+// terms past the first million are summed with the Euler-Maclaurin formula,
+// whose error there is far below what a double holds, so that billions of
+// keys do not take billions of pow() calls.
+static double Zeta(uint64_t n, double theta) {
+  const uint64_t kExactTerms = 1 << 20;
+  double zeta = 0;
+  for (uint64_t i = 1; i <= std::min(n, kExactTerms); i++) {
+    zeta += 1.0 / std::pow(static_cast<double>(i), theta);
+  }
+  if (n > kExactTerms) {
+    // The terms in (m, n]: the integral of x^-theta over [m, n], plus the
+    // trapezoid and first derivative corrections, minus the m-th term
+    // already counted.
+    const double m = static_cast<double>(kExactTerms);
+    const double x = static_cast<double>(n);
+    auto f = [theta](double y) { return std::pow(y, -theta); };
+    auto df = [theta](double y) { return -theta * std::pow(y, -theta - 1); };
+    zeta += (std::pow(x, 1 - theta) - std::pow(m, 1 - theta)) / (1 - theta) +
+            (f(x) - f(m)) / 2 + (df(x) - df(m)) / 12;
+  }
+  return zeta;
+}
+
+// Draws numbers in [0, n) with a Zipfian skew, following Gray et al.,
+// "Quickly Generating Billion-Record Synthetic Databases". Rank 0 is the most
+// popular; callers scatter ranks over the key space themselves. Next() may be
+// called from several threads at once.
+class ZipfianGenerator {
+ public:
+  ZipfianGenerator(uint64_t n, double theta)
+      : n_(std::max<uint64_t>(n, 1)), theta_(theta) {
+    double zeta2 = 1.0 + std::pow(0.5, theta_);
+    zetan_ = Zeta(n_, theta_);
+    alpha_ = 1.0 / (1.0 - theta_);
+    eta_ = (1.0 - std::pow(2.0 / n_, 1.0 - theta_)) / (1.0 - zeta2 / zetan_);
+  }
+
+  uint64_t Next(Random64* rand) const {
+    double u = static_cast<double>(rand->Next() >> 11) /
+               static_cast<double>(1ull << 53);
+    double uz = u * zetan_;
+    if (uz < 1.0) {
+      return 0;
+    }
+    if (uz < 1.0 + std::pow(0.5, theta_)) {
+      return std::min<uint64_t>(1, n_ - 1);
+    }
+    uint64_t rank = static_cast<uint64_t>(
+        n_ * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return std::min(rank, n_ - 1);
+  }
+
+ private:
+  const uint64_t n_;
+  const double theta_;
+  double zetan_;
+  double alpha_;
+  double eta_;
+};
+
+// Returns the generator for n and theta, only built the first time, as each
+// reader thread and the benchmark itself would otherwise sum the same zeta.
+static std::shared_ptr<const ZipfianGenerator> GetZipfianGenerator(
+    uint64_t n, double theta) {
+  static port::Mutex mutex;
+  static std::map<std::pair<uint64_t, double>,
+                  std::shared_ptr<const ZipfianGenerator>>
+      generators;
+  MutexLock l(&mutex);
+  auto& generator = generators[std::make_pair(n, theta)];
+  if (!generator) {
+    generator = std::make_shared<ZipfianGenerator>(n, theta);
+  }
+  return generator;
+}
+
+// splitmix64 finalizer: a bijection on 64-bit integers that spreads
+// consecutive numbers over the whole range.
+static uint64_t ScrambleKeyNumber(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// Inverse of the standard normal CDF (Acklam's rational approximation,
+// relative error below 1.2e-9), for 0 < p < 1.
+static double NormalQuantile(double p) {
+  static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02,
+                             -2.759285104469687e+02, 1.383577518672690e+02,
+                             -3.066479806614716e+01, 2.506628277459239e+00};
+  static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02,
+                             -1.556989798598866e+02, 6.680131188771972e+01,
+                             -1.328068155288572e+01};
+  static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01,
+                             -2.400758277161838e+00, -2.549732539343734e+00,
+                             4.374664141464968e+00,  2.938163982698783e+00};
+  static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01,
+                             2.445134137142996e+00, 3.754408661907416e+00};
+  const double kLow = 0.02425;
+  if (p < kLow) {
+    double q = std::sqrt(-2 * std::log(p));
+    return (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q +
+            c[5]) /
+           ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+  }
+  if (p > 1 - kLow) {
+    double q = std::sqrt(-2 * std::log(1 - p));
+    return -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q +
+             c[5]) /
+           ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1);
+  }
+  double q = p - 0.5;
+  double r = q * q;
+  return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r +
+          a[5]) *
+         q /
+         (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1);
+}
+
 class Benchmark {
  private:
   std::shared_ptr<Cache> cache_;
@@ -1805,6 +2073,8 @@ class Benchmark {
   int64_t reads_;
   int64_t deletes_;
   double read_random_exp_range_;
+  // Picks random read keys with --key_distribution=zipfian.
+  std::shared_ptr<const ZipfianGenerator> read_zipf_;
   int64_t writes_;
   int64_t readwrites_;
   int64_t merge_keys_;
@@ -1908,6 +2178,9 @@ class Benchmark {
       case kCuckoo:
         fprintf(stdout, "Memtablerep: cuckoo\n");
         break;
+      case kLearnedGappedArray:
+        fprintf(stdout, "Memtablerep: learned_gapped_array\n");
+        break;
     }
     fprintf(stdout, "Perf Level: %d\n", FLAGS_perf_level);
 
@@ -2040,9 +2313,19 @@ class Benchmark {
       }
       return cache;
     } else {
+      std::shared_ptr<MemoryAllocator> allocator;
+      if (FLAGS_cache_slab_allocator) {
+        SlabAllocatorOptions slab_options;
+        slab_options.huge_page_size =
+            static_cast<size_t>(FLAGS_cache_slab_huge_page_size);
+        slab_options.numa_aware = FLAGS_cache_slab_numa;
+        allocator = NewSlabAllocator(slab_options);
+      }
       return NewLRUCache((size_t)capacity, FLAGS_cache_numshardbits,
                          false /*strict_capacity_limit*/,
-                         FLAGS_cache_high_pri_pool_ratio);
+                         FLAGS_cache_high_pri_pool_ratio,
+                         (size_t)FLAGS_cache_frequency_sketch_size, allocator,
+                         FLAGS_cache_lock_free_hits);
     }
   }
 
@@ -2100,6 +2383,10 @@ class Benchmark {
       exit(1);
     }
 
+    if (FLAGS_key_distribution_e == kZipfianKeys) {
+      read_zipf_ = GetZipfianGenerator(FLAGS_num, FLAGS_key_zipf_theta);
+    }
+
     std::vector<std::string> files;
     FLAGS_env->GetChildren(FLAGS_db, &files);
     for (size_t i = 0; i < files.size(); i++) {
@@ -2155,6 +2442,11 @@ class Benchmark {
   //   |        key 00000         |
   //   ----------------------------
   void GenerateKeyFromInt(uint64_t v, int64_t num_keys, Slice* key) {
+    if (FLAGS_key_distribution_e == kPrefixedStringKeys) {
+      GeneratePrefixedStringKey(v, key);
+      return;
+    }
+    v = MapKeyNumber(v, num_keys);
     char* start = const_cast<char*>(key->data());
     char* pos = start;
     if (keys_per_prefix_ > 0) {
@@ -2189,6 +2481,63 @@ class Benchmark {
     }
   }
 
+  // Place key number v (out of num_keys) in the key space according to
+  // --key_distribution. Distinct numbers always map to distinct values, and
+  // all but hashed keys keep their order.
+  uint64_t MapKeyNumber(uint64_t v, int64_t num_keys) {
+    switch (FLAGS_key_distribution_e) {
+      case kLognormalKeys: {
+        double p = (static_cast<double>(v) + 0.5) /
+                   static_cast<double>(std::max<int64_t>(num_keys, 1));
+        p = std::min(std::max(p, 1e-12), 1 - 1e-12);
+        // Median at 2^32; adding v keeps rounded values distinct.
+        double x = std::exp(FLAGS_key_lognormal_sigma * NormalQuantile(p)) *
+                   4294967296.0;
+        return static_cast<uint64_t>(std::min(x, 4.0e18)) + v;
+      }
+      case kTimestampKeys: {
+        // Bursts of events 64us apart on average, separated by one to three
+        // hours of silence.
+        const uint64_t kStartMicros = 1500000000ULL * 1000000;
+        const uint64_t kHourMicros = 3600ULL * 1000000;
+        uint64_t burst_len = static_cast<uint64_t>(
+            std::min<int64_t>(std::max<int64_t>(FLAGS_key_timestamp_burst, 1),
+                              1 << 24));
+        uint64_t burst = v / burst_len;
+        uint64_t within = v % burst_len;
+        return kStartMicros + burst * 2 * kHourMicros +
+               ScrambleKeyNumber(burst) % kHourMicros + within * 64 +
+               ScrambleKeyNumber(v) % 64;
+      }
+      case kHashedKeys:
+        return ScrambleKeyNumber(v);
+      default:
+        return v;
+    }
+  }
+
+  // "org<NNN>:" followed by the zero-padded decimal key number. Each group
+  // shares a prefix longer than the 8 key bytes the learned model sees.
+  void GeneratePrefixedStringKey(uint64_t v, Slice* key) {
+    char* start = const_cast<char*>(key->data());
+    uint64_t groups = static_cast<uint64_t>(
+        std::min(std::max(FLAGS_key_string_prefixes, 1), 1000));
+    char prefix[16];
+    snprintf(prefix, sizeof(prefix), "org%03u:",
+             static_cast<unsigned>(v % groups));
+    const int kPrefixLen = 7;
+    memcpy(start, prefix, kPrefixLen);
+    char digits[21];
+    snprintf(digits, sizeof(digits), "%020" PRIu64, v / groups);
+    int width = key_size_ - kPrefixLen;
+    if (width > 20) {
+      memset(start + kPrefixLen, '0', width - 20);
+      memcpy(start + key_size_ - 20, digits, 20);
+    } else {
+      memcpy(start + kPrefixLen, digits + 20 - width, width);
+    }
+  }
+
   std::string GetPathForMultiple(std::string base_name, size_t id) {
     if (!base_name.empty()) {
 #ifndef OS_WIN
@@ -2365,6 +2714,8 @@ void VerifyDBFromDB(std::string& truth_db_name) {
         method = &Benchmark::ReadRandom;
       } else if (name == "readrandomfast") {
         method = &Benchmark::ReadRandomFast;
+      } else if (name == "learnedcompare") {
+        method = &Benchmark::LearnedCompare;
       } else if (name == "multireadrandom") {
         fprintf(stderr, "entries_per_batch = %" PRIi64 "\n",
                 entries_per_batch_);
@@ -2830,6 +3181,9 @@ void VerifyDBFromDB(std::string& truth_db_name) {
       FLAGS_min_write_buffer_number_to_merge;
     options.max_write_buffer_number_to_maintain =
         FLAGS_max_write_buffer_number_to_maintain;
+    options.learned_immutable_memtable = FLAGS_learned_immutable_memtable;
+    options.level_hint_cache_size =
+        static_cast<size_t>(FLAGS_level_hint_cache_size);
     options.base_background_compactions = FLAGS_base_background_compactions;
     options.max_background_compactions = FLAGS_max_background_compactions;
     options.max_subcompactions = static_cast<uint32_t>(FLAGS_subcompactions);
@@ -2911,6 +3265,9 @@ void VerifyDBFromDB(std::string& truth_db_name) {
         options.memtable_factory.reset(NewHashCuckooRepFactory(
             options.write_buffer_size, FLAGS_key_size + FLAGS_value_size));
         break;
+      case kLearnedGappedArray:
+        options.memtable_factory.reset(NewLearnedGappedArrayRepFactory());
+        break;
 #else
       default:
         fprintf(stderr, "Only skip list is supported in lite mode\n");
@@ -2986,6 +3343,18 @@ void VerifyDBFromDB(std::string& truth_db_name) {
       block_based_options.filter_policy = filter_policy_;
       block_based_options.format_version = 2;
       block_based_options.read_amp_bytes_per_bit = FLAGS_read_amp_bytes_per_bit;
+      block_based_options.compact_learned_model = FLAGS_compact_learned_model;
+      block_based_options.learned_leaf_max_error =
+          FLAGS_learned_leaf_max_error;
+      block_based_options.model_offset_max_error =
+          FLAGS_model_offset_max_error;
+      block_based_options.cache_learned_model_blocks =
+          FLAGS_cache_learned_model_blocks;
+      block_based_options.pin_l0_learned_model_in_cache =
+          FLAGS_pin_l0_learned_model_in_cache;
+      block_based_options.demote_evicted_blocks = FLAGS_demote_evicted_blocks;
+      block_based_options.demoted_block_compression =
+          StringToCompressionType(FLAGS_demoted_block_compression.c_str());
       if (FLAGS_read_cache_path != "") {
 #ifndef ROCKSDB_LITE
         Status rc_status;
@@ -3155,6 +3524,20 @@ void VerifyDBFromDB(std::string& truth_db_name) {
         options.row_cache = NewLRUCache(FLAGS_row_cache_size);
       }
     }
+    if (FLAGS_lookup_result_cache_size) {
+      if (FLAGS_cache_numshardbits >= 1) {
+        options.lookup_result_cache = NewLRUCache(
+            FLAGS_lookup_result_cache_size, FLAGS_cache_numshardbits);
+      } else {
+        options.lookup_result_cache =
+            NewLRUCache(FLAGS_lookup_result_cache_size);
+      }
+    }
+    options.block_cache_warmup_persist_period_sec =
+        static_cast<unsigned int>(FLAGS_block_cache_warmup_persist_period_sec);
+    options.block_cache_warmup_threads = FLAGS_block_cache_warmup_threads;
+    options.block_cache_warmup_rate_bytes_per_sec =
+        FLAGS_block_cache_warmup_rate_bytes_per_sec;
     if (FLAGS_enable_io_prio) {
       FLAGS_env->LowerThreadPoolIOPriority(Env::LOW);
       FLAGS_env->LowerThreadPoolIOPriority(Env::HIGH);
@@ -3294,6 +3677,9 @@ void VerifyDBFromDB(std::string& truth_db_name) {
         mode_(mode),
         num_(num),
         next_(0) {
+      if (mode_ == RANDOM && FLAGS_key_distribution_e == kZipfianKeys) {
+        zipf_ = GetZipfianGenerator(num_, FLAGS_key_zipf_theta);
+      }
       if (mode_ == UNIQUE_RANDOM) {
         // NOTE: if memory consumption of this approach becomes a concern,
         // we can either break it into pieces and only random shuffle a section
@@ -3314,6 +3700,10 @@ void VerifyDBFromDB(std::string& truth_db_name) {
         case SEQUENTIAL:
           return next_++;
         case RANDOM:
+          if (zipf_) {
+            // Scatter popular ranks so hot keys are not adjacent.
+            return ScrambleKeyNumber(zipf_->Next(rand_)) % num_;
+          }
           return rand_->Next() % num_;
         case UNIQUE_RANDOM:
           assert(next_ + 1 < num_);
@@ -3329,6 +3719,7 @@ void VerifyDBFromDB(std::string& truth_db_name) {
     const uint64_t num_;
     uint64_t next_;
     std::vector<uint64_t> values_;
+    std::shared_ptr<const ZipfianGenerator> zipf_;
   };
 
   DB* SelectDB(ThreadState* thread) {
@@ -3922,6 +4313,10 @@ void VerifyDBFromDB(std::string& truth_db_name) {
   }
 
   int64_t GetRandomKey(Random64* rand) {
+    if (read_zipf_) {
+      return static_cast<int64_t>(ScrambleKeyNumber(read_zipf_->Next(rand)) %
+                                  FLAGS_num);
+    }
     uint64_t rand_int = rand->Next();
     int64_t key_rand;
     if (read_random_exp_range_ == 0) {
@@ -4006,6 +4401,101 @@ void VerifyDBFromDB(std::string& truth_db_name) {
     }
   }
 
+  // Issues N random Gets through the index block and N through the learned
+  // model (ReadOptions::is_model), alternating between the two on every Get
+  // so that both see the same block cache and page cache state, and reports
+  // Get latency percentiles and blocks accessed per Get for each, along with
+  // the size and training time of the models of all live tables.
+  void LearnedCompare(ThreadState* thread) {
+    DB* db = SelectDB(thread);
+    std::unique_ptr<const char[]> key_guard;
+    Slice key = AllocateKey(&key_guard);
+    PinnableSlice value;
+    PerfLevel prev_perf_level = GetPerfLevel();
+    if (prev_perf_level < kEnableCount) {
+      SetPerfLevel(kEnableCount);
+    }
+
+    struct ModeStats {
+      HistogramImpl latency_nanos;
+      uint64_t blocks = 0;
+      int64_t read = 0;
+      int64_t found = 0;
+    };
+    ModeStats stats[2];
+    // Threads start with different modes, so that neither always goes first.
+    int use_model = thread->tid % 2;
+    Duration duration(FLAGS_duration, reads_ * 2);
+    while (!duration.Done(1)) {
+      ReadOptions options(FLAGS_verify_checksum, true, use_model == 1);
+      ModeStats& mode = stats[use_model];
+      GenerateKeyFromInt(GetRandomKey(&thread->rand), FLAGS_num, &key);
+      value.Reset();
+      uint64_t blocks_before =
+          perf_context.block_read_count + perf_context.block_cache_hit_count;
+      uint64_t start = FLAGS_env->NowNanos();
+      Status s = db->Get(options, db->DefaultColumnFamily(), key, &value);
+      mode.latency_nanos.Add(FLAGS_env->NowNanos() - start);
+      mode.blocks += perf_context.block_read_count +
+                     perf_context.block_cache_hit_count - blocks_before;
+      mode.read++;
+      if (s.ok()) {
+        mode.found++;
+      } else if (!s.IsNotFound()) {
+        fprintf(stderr, "Get returned an error: %s\n", s.ToString().c_str());
+        abort();
+      }
+      thread->stats.FinishedOps(nullptr, db, 1, kRead);
+      use_model ^= 1;
+    }
+
+    for (int m = 0; m <= 1; m++) {
+      const ModeStats& mode = stats[m];
+      char msg[256];
+      snprintf(msg, sizeof(msg),
+               "(%s, interleaved per Get: p50 %.3f p99 %.3f p99.9 %.3f "
+               "micros/Get, %.3f blocks/Get, %" PRIi64 " of %" PRIi64
+               " found)\n",
+               m == 1 ? "learned" : "binary search",
+               mode.latency_nanos.Percentile(50) / 1000,
+               mode.latency_nanos.Percentile(99) / 1000,
+               mode.latency_nanos.Percentile(99.9) / 1000,
+               mode.read == 0 ? 0.0 : static_cast<double>(mode.blocks) /
+                                          mode.read,
+               mode.found, mode.read);
+      thread->stats.AddMessage(msg);
+    }
+    SetPerfLevel(prev_perf_level);
+
+    if (thread->tid == 0) {
+      TablePropertiesCollection props;
+      Status s = db->GetPropertiesOfAllTables(&props);
+      if (!s.ok()) {
+        fprintf(stderr, "GetPropertiesOfAllTables: %s\n",
+                s.ToString().c_str());
+        return;
+      }
+      uint64_t num_models = 0;
+      uint64_t model_bytes = 0;
+      uint64_t train_micros = 0;
+      for (const auto& file_props : props) {
+        const auto& user_props = file_props.second->user_collected_properties;
+        bool present = false;
+        model_bytes += GetModelSize(user_props, &present);
+        if (present) {
+          num_models++;
+          train_micros += GetModelTrainMicros(user_props, &present);
+        }
+      }
+      char msg[200];
+      snprintf(msg, sizeof(msg),
+               "(%" PRIu64 " learned models, %" PRIu64 " bytes, trained in %"
+               PRIu64 " micros)\n",
+               num_models, model_bytes, train_micros);
+      thread->stats.AddMessage(msg);
+    }
+  }
+
   // Calls MultiGet over a list of keys from a random distribution.
   // Returns the total number of keys found.
   void MultiReadRandom(ThreadState* thread) {
@@ -5163,6 +5653,18 @@ int db_bench_tool(int argc, char** argv) {
   }
 
   FLAGS_rep_factory = StringToRepFactory(FLAGS_memtablerep.c_str());
+  FLAGS_key_distribution_e =
+      StringToKeyDistribution(FLAGS_key_distribution.c_str());
+  if (FLAGS_key_distribution_e == kPrefixedStringKeys &&
+      FLAGS_key_size < 12) {
+    fprintf(stderr, "prefixed_string keys need --key_size of at least 12\n");
+    exit(1);
+  }
+  if (FLAGS_key_distribution_e == kZipfianKeys &&
+      (FLAGS_key_zipf_theta <= 0 || FLAGS_key_zipf_theta >= 1)) {
+    fprintf(stderr, "--key_zipf_theta must be in (0, 1)\n");
+    exit(1);
+  }
 
   // The number of background threads should be at least as much the
   // max number of concurrent compactions.
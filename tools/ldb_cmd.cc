@@ -2812,6 +2812,10 @@ void DumpSstFile(std::string filename, bool output_hex, bool show_properties) {
                        table_properties->user_collected_properties)
                 << std::endl;
     }
+    st = reader.ShowLearnedModel(false /* print_coefficients */);
+    if (!st.ok()) {
+      std::cerr << filename << ": " << st.ToString() << std::endl;
+    }
   }
 }
 
@@ -15,6 +15,8 @@
 #include "rocksdb/filter_policy.h"
 #include "table/block_based_table_factory.h"
 #include "table/table_builder.h"
+#include "table/table_reader.h"
+#include "tools/sst_dump_tool_imp.h"
 #include "util/file_reader_writer.h"
 #include "util/testharness.h"
 #include "util/testutil.h"
@@ -205,6 +207,36 @@ TEST_F(SSTDumpToolTest, CompressedSizes) {
     delete[] usage[i];
   }
 }
+
+TEST_F(SSTDumpToolTest, LearnedModel) {
+  std::string file_name = "rocksdb_sst_test.sst";
+  createSST(file_name, table_options_);
+
+  {
+    SstFileReader reader(file_name, false /* verify_checksum */,
+                         false /* output_hex */);
+    ASSERT_OK(reader.getStatus());
+    ASSERT_OK(reader.ShowLearnedModel(false /* print_coefficients */));
+    ASSERT_OK(reader.VerifyLearnedModel());
+  }
+
+  char* usage[4];
+  for (int i = 0; i < 4; i++) {
+    usage[i] = new char[optLength];
+  }
+  snprintf(usage[0], optLength, "./sst_dump");
+  snprintf(usage[1], optLength, "--command=verify_model");
+  snprintf(usage[2], optLength, "--show_model");
+  snprintf(usage[3], optLength, "--file=rocksdb_sst_test.sst");
+
+  rocksdb::SSTDumpTool tool;
+  ASSERT_TRUE(!tool.Run(4, usage));
+
+  cleanup(file_name);
+  for (int i = 0; i < 4; i++) {
+    delete[] usage[i];
+  }
+}
 }  // namespace rocksdb
 
 int main(int argc, char** argv) {
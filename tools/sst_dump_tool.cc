@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "db/memtable.h"
+#include "monitoring/histogram.h"
 #include "db/write_batch_internal.h"
 #include "options/cf_options.h"
 #include "rocksdb/db.h"
@@ -30,13 +31,16 @@
 #include "table/block.h"
 #include "table/block_based_table_builder.h"
 #include "table/block_based_table_factory.h"
+#include "table/block_based_table_reader.h"
 #include "table/block_builder.h"
 #include "table/format.h"
 #include "table/meta_blocks.h"
 #include "table/plain_table_factory.h"
 #include "table/table_reader.h"
+#include "util/coding.h"
 #include "util/compression.h"
 #include "util/random.h"
+#include "util/string_util.h"
 
 #include "port/port.h"
 
@@ -347,18 +351,271 @@ Status SstFileReader::ReadTableProperties(
   return init_result_;
 }
 
+Status SstFileReader::ReadLearnedModel(
+    unique_ptr<RandomAccessFileReader>* file, Footer* footer,
+    unique_ptr<LearnedRangeIndexSingleKey<uint64_t, float>>* model,
+    unique_ptr<CompactLearnedModel>* compact_model) {
+  unique_ptr<RandomAccessFile> raw_file;
+  uint64_t file_size = 0;
+  Status s = options_.env->NewRandomAccessFile(file_name_, &raw_file,
+                                               soptions_);
+  if (s.ok()) {
+    s = options_.env->GetFileSize(file_name_, &file_size);
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  file->reset(new RandomAccessFileReader(std::move(raw_file)));
+
+  s = ReadFooterFromFile(file->get(), file_size, footer);
+  if (!s.ok()) {
+    return s;
+  }
+  if (footer->table_magic_number() != kBlockBasedTableMagicNumber &&
+      footer->table_magic_number() != kLegacyBlockBasedTableMagicNumber) {
+    return Status::NotSupported("Learned model is only stored in block based "
+                                "tables");
+  }
+
+  const BlockHandle& handle = footer->learned_handle();
+  size_t size = static_cast<size_t>(handle.size());
+  std::unique_ptr<char[]> buf(new char[size]);
+  Slice contents;
+  s = (*file)->Read(handle.offset(), size, &contents, buf.get());
+  if (s.ok() && contents.size() != size) {
+    s = Status::Corruption("Truncated learned model block");
+  }
+  if (!s.ok()) {
+    return s;
+  }
+  if (CompactLearnedModel::IsCompact(contents)) {
+    compact_model->reset(new CompactLearnedModel());
+    return (*compact_model)->Init(contents.ToString());
+  }
+
+  RMIConfig rmi_config = BlockBasedTable::LearnedModelConfig();
+  // Serialized as (w, bias) of every model followed by the key count.
+  size_t expected_size =
+      (1 + rmi_config.stage_configs[1].model_n) * 2 * sizeof(double) +
+      sizeof(unsigned);
+  if (size != expected_size) {
+    return Status::Corruption(
+        "Learned model block has " + ToString(size) + " bytes, expected " +
+        ToString(expected_size));
+  }
+  model->reset(new LearnedRangeIndexSingleKey<uint64_t, float>(
+      contents.ToString(), rmi_config));
+  return s;
+}
+
+Status SstFileReader::ShowLearnedModel(bool print_coefficients) {
+  unique_ptr<RandomAccessFileReader> file;
+  Footer footer;
+  unique_ptr<LearnedRangeIndexSingleKey<uint64_t, float>> model;
+  unique_ptr<CompactLearnedModel> compact_model;
+  Status s = ReadLearnedModel(&file, &footer, &model, &compact_model);
+  if (!s.ok()) {
+    return s;
+  }
+
+  if (compact_model != nullptr) {
+    fprintf(stdout,
+            "Learned Model (compact):\n"
+            "------------------------------\n"
+            "  model block offset: %" PRIu64 " size: %" PRIu64 "\n"
+            "  keys: %u\n"
+            "  leaf models: %u (%u kept, %u hinge, %u cubic)\n"
+            "  root: w=%.17g bias=%.17g\n",
+            footer.learned_handle().offset(), footer.learned_handle().size(),
+            compact_model->num_keys(), compact_model->num_leaves(),
+            compact_model->num_kept_leaves(),
+            compact_model->num_hinge_leaves(),
+            compact_model->num_cubic_leaves(), compact_model->root_slope(),
+            compact_model->root_intercept());
+    for (uint32_t i = 0; print_coefficients && i < compact_model->num_leaves();
+         i++) {
+      CompactLearnedModel::Leaf leaf;
+      if (!compact_model->GetLeaf(i, &leaf)) {
+        continue;
+      }
+      fprintf(stdout, "  leaf %u: key_base=%" PRIu64 " pos_base=%.0f slope=%.9g",
+              i, leaf.key_base, leaf.pos_base, leaf.slope);
+      if (leaf.shape == CompactLearnedModel::kHinge) {
+        fprintf(stdout, " split=+%" PRIu64 " bend=%.17g", leaf.split,
+                leaf.bend);
+      } else if (leaf.shape == CompactLearnedModel::kCubic) {
+        fprintf(stdout, " quadratic=%.17g cubic=%.17g", leaf.quadratic,
+                leaf.cubic);
+      }
+      fprintf(stdout, "\n");
+    }
+    return s;
+  }
+
+  auto& rmi = model->rmi;
+  fprintf(stdout,
+          "Learned Model:\n"
+          "------------------------------\n"
+          "  model block offset: %" PRIu64 " size: %" PRIu64 "\n"
+          "  keys: %u\n"
+          "  leaf models: %u\n",
+          footer.learned_handle().offset(), footer.learned_handle().size(),
+          rmi.key_n,
+          rmi.second_stage->get_model_n());
+  for (auto& m : rmi.first_stage->models) {
+    fprintf(stdout, "  root: w=%.17g bias=%.17g\n", m.w, m.bias);
+  }
+  if (print_coefficients) {
+    for (unsigned i = 0; i < rmi.second_stage->get_model_n(); i++) {
+      auto& m = rmi.second_stage->models[i];
+      fprintf(stdout, "  leaf %u: w=%.17g bias=%.17g\n", i, m.w, m.bias);
+    }
+  }
+  return s;
+}
+
+Status SstFileReader::VerifyLearnedModel() {
+  unique_ptr<RandomAccessFileReader> file;
+  Footer footer;
+  unique_ptr<LearnedRangeIndexSingleKey<uint64_t, float>> model;
+  unique_ptr<CompactLearnedModel> compact_model;
+  Status s = ReadLearnedModel(&file, &footer, &model, &compact_model);
+  if (!s.ok()) {
+    return s;
+  }
+  uint32_t num_leaves = compact_model != nullptr
+                            ? compact_model->num_leaves()
+                            : model->rmi.second_stage->get_model_n();
+  uint64_t trained_keys = compact_model != nullptr
+                              ? compact_model->num_keys()
+                              : model->rmi.key_n;
+  if (table_reader_) {
+    auto props = table_reader_->GetTableProperties();
+    auto pos = props->user_collected_properties.find(
+        BlockBasedTablePropertyNames::kIndexType);
+    if (pos != props->user_collected_properties.end() &&
+        DecodeFixed32(pos->second.c_str()) ==
+            BlockBasedTableOptions::kTwoLevelIndexSearch) {
+      return Status::NotSupported("Partitioned index is not supported");
+    }
+  }
+
+  BlockContents index_contents;
+  s = ReadBlockContents(file.get(), footer, ReadOptions(),
+                        footer.index_handle(), &index_contents, ioptions_);
+  if (!s.ok()) {
+    return s;
+  }
+  Block index_block(std::move(index_contents), kDisableGlobalSequenceNumber);
+  unique_ptr<InternalIterator> index_iter(
+      index_block.NewIterator(&internal_comparator_));
+
+  // Error buckets, in data blocks: 0, 1, 2-3, 4-7, 8+.
+  const int kBuckets = 5;
+  struct LeafStats {
+    uint64_t keys = 0;
+    uint64_t max_error = 0;
+    uint64_t buckets[kBuckets] = {0, 0, 0, 0, 0};
+  };
+  std::vector<LeafStats> leaves(num_leaves);
+  HistogramImpl error_hist;
+  int actual_block = 0;
+  for (index_iter->SeekToFirst(); index_iter->Valid();
+       index_iter->Next(), actual_block++) {
+    Slice handle_value = index_iter->value();
+    BlockHandle handle;
+    s = handle.DecodeFrom(&handle_value);
+    if (!s.ok()) {
+      return s;
+    }
+    BlockContents data_contents;
+    s = ReadBlockContents(file.get(), footer, ReadOptions(), handle,
+                          &data_contents, ioptions_);
+    if (!s.ok()) {
+      return s;
+    }
+    Block data_block(std::move(data_contents), kDisableGlobalSequenceNumber);
+    unique_ptr<InternalIterator> data_iter(
+        data_block.NewIterator(&internal_comparator_));
+    for (data_iter->SeekToFirst(); data_iter->Valid(); data_iter->Next()) {
+      uint64_t lekey = data_iter->key().Touint64_t();
+      // Same arithmetic as BlockBasedTableBuilder::Finish().
+      int block_num;
+      unsigned leaf_num;
+      if (compact_model != nullptr) {
+        block_num = static_cast<int>(compact_model->Predict(lekey) / 4096);
+        leaf_num = compact_model->Route(lekey);
+      } else {
+        block_num = static_cast<int>(model->get(lekey) / 4096);
+        leaf_num = model->rmi.pick_model_for_key(lekey);
+      }
+      uint64_t error = static_cast<uint64_t>(
+          block_num > actual_block ? block_num - actual_block
+                                   : actual_block - block_num);
+      LeafStats& leaf = leaves[leaf_num];
+      leaf.keys++;
+      leaf.max_error = std::max(leaf.max_error, error);
+      int bucket = 0;
+      for (uint64_t e = error; e > 0 && bucket < kBuckets - 1; e >>= 1) {
+        bucket++;
+      }
+      leaf.buckets[bucket]++;
+      error_hist.Add(error);
+    }
+    if (!data_iter->status().ok()) {
+      return data_iter->status();
+    }
+  }
+  if (!index_iter->status().ok()) {
+    return index_iter->status();
+  }
+
+  uint64_t num_keys = error_hist.num();
+  uint64_t mispredicted_keys = num_keys;
+  for (auto& leaf : leaves) {
+    mispredicted_keys -= leaf.buckets[0];
+  }
+  fprintf(stdout,
+          "Learned Model Verification:\n"
+          "------------------------------\n"
+          "  data blocks: %d\n"
+          "  keys: %" PRIu64 " (model trained on %" PRIu64 ")\n"
+          "  mispredicted keys: %" PRIu64 " (%.4f%%)\n"
+          "  block error histogram:\n%s",
+          actual_block, num_keys, trained_keys, mispredicted_keys,
+          num_keys == 0 ? 0.0 : 100.0 * mispredicted_keys / num_keys,
+          error_hist.ToString().c_str());
+  fprintf(stdout, "  %-6s %10s %10s %10s %10s %10s %10s %10s\n", "leaf",
+          "keys", "err=0", "err=1", "err=2-3", "err=4-7", "err>=8",
+          "max_err");
+  for (size_t i = 0; i < leaves.size(); i++) {
+    const LeafStats& leaf = leaves[i];
+    if (leaf.keys == 0) {
+      continue;
+    }
+    fprintf(stdout,
+            "  %-6" ROCKSDB_PRIszt " %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+            " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n",
+            i, leaf.keys, leaf.buckets[0], leaf.buckets[1], leaf.buckets[2],
+            leaf.buckets[3], leaf.buckets[4], leaf.max_error);
+  }
+  return s;
+}
+
 namespace {
 
 void print_help() {
   fprintf(stderr,
-          R"(sst_dump --file=<data_dir_OR_sst_file> [--command=check|scan|raw]
+          R"(sst_dump --file=<data_dir_OR_sst_file> [--command=check|scan|raw|verify_model]
     --file=<data_dir_OR_sst_file>
       Path to SST file or directory containing SST files
 
-    --command=check|scan|raw
+    --command=check|scan|raw|verify_model
         check: Iterate over entries in files but dont print anything except if an error is encounterd (default command)
         scan: Iterate over entries in files and print them to screen
         raw: Dump all the table contents to <file_name>_dump.txt
+        verify_model: Compare the data block predicted by the learned model with the block holding each key and
+          print per-leaf error histograms and the fraction of keys whose predicted block is wrong
 
     --output_hex
       Can be combined with scan command to print the keys and values in Hex
@@ -385,6 +642,9 @@ void print_help() {
     --show_properties
       Print table properties after iterating over the file
 
+    --show_model
+      Print the learned model stored in each file: key count, number of leaf models and all coefficients
+
     --show_compression_sizes
       Independent command that will recreate the SST file using 16K block size with different
       compressions and report the size of the file using such compression
@@ -417,6 +677,7 @@ int SSTDumpTool::Run(int argc, char** argv) {
   bool show_properties = false;
   bool show_compression_sizes = false;
   bool show_summary = false;
+  bool show_model = false;
   bool set_block_size = false;
   std::string from_key;
   std::string to_key;
@@ -457,6 +718,8 @@ int SSTDumpTool::Run(int argc, char** argv) {
       show_compression_sizes = true;
     } else if (strcmp(argv[i], "--show_summary") == 0) {
       show_summary = true;
+    } else if (strcmp(argv[i], "--show_model") == 0) {
+      show_model = true;
     } else if (strncmp(argv[i], "--set_block_size=", 17) == 0) {
       set_block_size = true;
       block_size_str = argv[i] + 17;
@@ -570,6 +833,20 @@ int SSTDumpTool::Run(int argc, char** argv) {
       continue;
     }
 
+    if (command == "verify_model") {
+      st = reader.VerifyLearnedModel();
+      if (!st.ok()) {
+        fprintf(stderr, "%s: %s\n", filename.c_str(), st.ToString().c_str());
+      }
+    }
+
+    if (show_model) {
+      st = reader.ShowLearnedModel(true /* print_coefficients */);
+      if (!st.ok()) {
+        fprintf(stderr, "%s: %s\n", filename.c_str(), st.ToString().c_str());
+      }
+    }
+
     // scan all files in give file path.
     if (command == "" || command == "scan" || command == "check") {
       st = reader.ReadSequential(
@@ -619,6 +896,25 @@ int SSTDumpTool::Run(int argc, char** argv) {
           } else {
             fprintf(stdout, "  # merge operands: UNKNOWN\n");
           }
+
+          uint64_t mispredicted_keys = rocksdb::GetModelMispredictedKeys(
+              table_properties->user_collected_properties, &property_present);
+          if (property_present) {
+            fprintf(stdout, "  # model mispredicted keys: %" PRIu64 "\n",
+                    mispredicted_keys);
+            fprintf(stdout, "  # model max block error: %" PRIu64 "\n",
+                    rocksdb::GetModelMaxBlockError(
+                        table_properties->user_collected_properties,
+                        &property_present));
+            uint64_t max_offset_error = rocksdb::GetModelMaxOffsetError(
+                table_properties->user_collected_properties, &property_present);
+            if (property_present) {
+              fprintf(stdout, "  # model max offset error: %" PRIu64 "\n",
+                      max_offset_error);
+            }
+          } else {
+            fprintf(stdout, "  # model mispredicted keys: UNKNOWN\n");
+          }
         }
         total_num_files += 1;
         total_num_data_blocks += table_properties->num_data_blocks;
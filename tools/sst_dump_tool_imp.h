@@ -11,6 +11,9 @@
 #include <string>
 #include "db/dbformat.h"
 #include "options/cf_options.h"
+#include "rmi/learned_index.h"
+#include "table/compact_learned_model.h"
+#include "table/format.h"
 #include "util/file_reader_writer.h"
 
 namespace rocksdb {
@@ -35,6 +38,15 @@ class SstFileReader {
 
   int ShowAllCompressionSizes(size_t block_size);
 
+  // Decode the learned model stored at footer.learned_handle() and print its
+  // shape. With print_coefficients, also print (w, bias) of every model.
+  Status ShowLearnedModel(bool print_coefficients);
+
+  // Walk the index and data blocks and compare, for every key, the data
+  // block predicted by the learned model with the block that holds it.
+  // Prints per-leaf error statistics and the blocks a lookup would probe.
+  Status VerifyLearnedModel();
+
  private:
   // Get the TableReader implementation for the sst file
   Status GetTableReader(const std::string& file_path);
@@ -44,6 +56,14 @@ class SstFileReader {
   uint64_t CalculateCompressedTableSize(const TableBuilderOptions& tb_options,
                                         size_t block_size);
 
+  // Open a private reader on the file (file_ is handed over to the table
+  // reader) and decode its footer and learned model. Depending on how the
+  // model was encoded, either `model` or `compact_model` is set.
+  Status ReadLearnedModel(
+      unique_ptr<RandomAccessFileReader>* file, Footer* footer,
+      unique_ptr<LearnedRangeIndexSingleKey<uint64_t, float>>* model,
+      unique_ptr<CompactLearnedModel>* compact_model);
+
   Status SetTableOptionsByMagicNumber(uint64_t table_magic_number);
   Status SetOldTableOptions();
 
@@ -13,6 +13,7 @@
 #include <limits>
 #include <string>
 
+#include "rocksdb/memory_allocator.h"
 #include "rocksdb/options.h"
 #include "util/coding.h"
 
@@ -583,10 +584,13 @@ inline bool LZ4_Compress(const CompressionOptions& opts,
 // header in varint32 format
 // @param compression_dict Data for presetting the compression library's
 //    dictionary.
+// @param allocator If set, the output is allocated from it instead of with
+//    new[].
 inline char* LZ4_Uncompress(const char* input_data, size_t input_length,
                             int* decompress_size,
                             uint32_t compress_format_version,
-                            const Slice& compression_dict = Slice()) {
+                            const Slice& compression_dict = Slice(),
+                            MemoryAllocator* allocator = nullptr) {
 #ifdef LZ4
   uint32_t output_len = 0;
   if (compress_format_version == 2) {
@@ -606,7 +610,9 @@ inline char* LZ4_Uncompress(const char* input_data, size_t input_length,
     input_data += 8;
   }
 
-  char* output = new char[output_len];
+  char* output = allocator != nullptr
+                     ? static_cast<char*>(allocator->Allocate(output_len))
+                     : new char[output_len];
 #if LZ4_VERSION_NUMBER >= 10400  // r124+
   LZ4_streamDecode_t* stream = LZ4_createStreamDecode();
   if (compression_dict.size()) {
@@ -624,7 +630,11 @@ inline char* LZ4_Uncompress(const char* input_data, size_t input_length,
 #endif  // LZ4_VERSION_NUMBER >= 10400
 
   if (*decompress_size < 0) {
-    delete[] output;
+    if (allocator != nullptr) {
+      allocator->Deallocate(output);
+    } else {
+      delete[] output;
+    }
     return nullptr;
   }
   assert(*decompress_size == static_cast<int>(output_len));
@@ -759,9 +769,12 @@ inline bool ZSTD_Compress(const CompressionOptions& opts, const char* input,
 
 // @param compression_dict Data for presetting the compression library's
 //    dictionary.
+// @param allocator If set, the output is allocated from it instead of with
+//    new[].
 inline char* ZSTD_Uncompress(const char* input_data, size_t input_length,
                              int* decompress_size,
-                             const Slice& compression_dict = Slice()) {
+                             const Slice& compression_dict = Slice(),
+                             MemoryAllocator* allocator = nullptr) {
 #ifdef ZSTD
   uint32_t output_len = 0;
   if (!compression::GetDecompressedSizeInfo(&input_data, &input_length,
@@ -769,7 +782,9 @@ inline char* ZSTD_Uncompress(const char* input_data, size_t input_length,
     return nullptr;
   }
 
-  char* output = new char[output_len];
+  char* output = allocator != nullptr
+                     ? static_cast<char*>(allocator->Allocate(output_len))
+                     : new char[output_len];
   size_t actual_output_length;
 #if ZSTD_VERSION_NUMBER >= 500  // v0.5.0+
   ZSTD_DCtx* context = ZSTD_createDCtx();
@@ -219,8 +219,18 @@ std::string IdentityFileName(const std::string& dbname) {
   return dbname + "/IDENTITY";
 }
 
+std::string HotBlocksFileName(const std::string& dbname) {
+  return dbname + "/HOT_BLOCKS";
+}
+
+std::string TempHotBlocksFileName(const std::string& dbname) {
+  return HotBlocksFileName(dbname) + "." + kTempFileNameSuffix;
+}
+
 // Owned filenames have the form:
 //    dbname/IDENTITY
+//    dbname/HOT_BLOCKS
+//    dbname/HOT_BLOCKS.dbtmp
 //    dbname/CURRENT
 //    dbname/LOCK
 //    dbname/<info_log_name_prefix>
@@ -248,6 +258,10 @@ bool ParseFileName(const std::string& fname, uint64_t* number,
   if (rest == "IDENTITY") {
     *number = 0;
     *type = kIdentityFile;
+  } else if (rest == "HOT_BLOCKS" ||
+             rest == std::string("HOT_BLOCKS.") + kTempFileNameSuffix) {
+    *number = 0;
+    *type = kHotBlocksFile;
   } else if (rest == "CURRENT") {
     *number = 0;
     *type = kCurrentFile;
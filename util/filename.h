@@ -39,7 +39,8 @@ enum FileType {
   kMetaDatabase,
   kIdentityFile,
   kOptionsFile,
-  kBlobFile
+  kBlobFile,
+  kHotBlocksFile
 };
 
 // Return the name of the log file with the specified number
@@ -142,6 +143,14 @@ extern std::string MetaDatabaseName(const std::string& dbname,
 // either from a backup-image or empty
 extern std::string IdentityFileName(const std::string& dbname);
 
+// Return the name of the file listing the blocks found in the block cache,
+// which are loaded into it again when the db is opened.
+extern std::string HotBlocksFileName(const std::string& dbname);
+
+// Return the name the hot blocks file is written under before it is renamed
+// to HotBlocksFileName().
+extern std::string TempHotBlocksFileName(const std::string& dbname);
+
 // If filename is a rocksdb file, store the type of the file in *type.
 // The number encoded in the filename is stored in *number.  If the
 // filename was successfully parsed, returns true.  Else return false.
@@ -0,0 +1,281 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/slab_allocator.h"
+
+#ifndef OS_WIN
+#include <sys/mman.h>
+#endif
+#ifdef NUMA
+#include <numa.h>
+#include <sched.h>
+#endif
+#include <stdlib.h>
+#include <algorithm>
+#include <new>
+
+namespace rocksdb {
+
+namespace {
+
+// Four classes per power of two from 64 bytes to kMaxClassSize, and one
+// just above each common block size. A full 4KB, 8KB or 16KB block with the
+// header, and its trailer when it is kept, would otherwise take a class a
+// quarter larger.
+const size_t kClassSizes[] = {
+    64,     80,     96,     112,    128,    160,    192,    224,
+    256,    320,    384,    448,    512,    640,    768,    896,
+    1024,   1280,   1536,   1792,   2048,   2560,   3072,   3584,
+    4096,   4128,   5120,   6144,   7168,   8192,   8224,   10240,
+    12288,  14336,  16384,  16416,  20480,  24576,  28672,  32768,
+    40960,  49152,  57344,  65536,  81920,  98304,  114688, 131072,
+    163840, 196608, 229376, 262144};
+const size_t kNumClasses = sizeof(kClassSizes) / sizeof(kClassSizes[0]);
+
+// Regions are 2MB when huge pages are not used.
+const size_t kDefaultRegionSize = 2 << 20;
+
+size_t RegionSize(size_t huge_page_size) {
+  size_t size = std::max(huge_page_size, kDefaultRegionSize);
+  return (size + SlabAllocator::kSlabSize - 1) / SlabAllocator::kSlabSize *
+         SlabAllocator::kSlabSize;
+}
+
+}  // namespace
+
+// MSVC complains that it is already defined since it is static in the header.
+#ifndef _MSC_VER
+const size_t SlabAllocator::kSlabSize;
+const size_t SlabAllocator::kMaxClassSize;
+const size_t SlabAllocator::kHeaderSize;
+const uint32_t SlabAllocator::kLargeClass;
+#endif
+
+SlabAllocator::SlabAllocator(const SlabAllocatorOptions& options)
+    : huge_page_size_(options.huge_page_size),
+      region_size_(RegionSize(options.huge_page_size)),
+      num_nodes_(1),
+      hugetlb_bytes_(0) {
+  static_assert(sizeof(Header) == kHeaderSize, "header size");
+  assert(kClassSizes[kNumClasses - 1] == kMaxClassSize);
+  assert(std::is_sorted(kClassSizes, kClassSizes + kNumClasses));
+#ifdef NUMA
+  if (options.numa_aware && numa_available() != -1) {
+    num_nodes_ = numa_max_node() + 1;
+  }
+#endif
+  free_lists_.reset(new FreeList[kNumClasses * num_nodes_]);
+  node_regions_.resize(num_nodes_);
+}
+
+SlabAllocator::~SlabAllocator() {
+  for (char* region : regions_) {
+#ifndef OS_WIN
+    munmap(region, region_size_);
+#else
+    free(region);
+#endif
+  }
+}
+
+size_t SlabAllocator::ClassSize(size_t size) {
+  uint32_t index = SizeClassIndex(size);
+  return index < kNumClasses ? kClassSizes[index] : 0;
+}
+
+uint32_t SlabAllocator::SizeClassIndex(size_t size) {
+  return static_cast<uint32_t>(
+      std::lower_bound(kClassSizes, kClassSizes + kNumClasses, size) -
+      kClassSizes);
+}
+
+int SlabAllocator::CurrentNode() const {
+#ifdef NUMA
+  if (num_nodes_ > 1) {
+    int cpu = sched_getcpu();
+    if (cpu >= 0) {
+      int node = numa_node_of_cpu(cpu);
+      if (node >= 0 && node < num_nodes_) {
+        return node;
+      }
+    }
+  }
+#endif
+  return 0;
+}
+
+void* SlabAllocator::Allocate(size_t size) {
+  uint32_t index = SizeClassIndex(size + kHeaderSize);
+  if (index >= kNumClasses) {
+    return AllocateLarge(size);
+  }
+  int node = CurrentNode();
+  FreeList& list = free_lists_[index * num_nodes_ + node];
+  char* object;
+  {
+    std::lock_guard<SpinMutex> lock(list.mutex);
+    object = list.head;
+    if (object != nullptr) {
+      list.head = *reinterpret_cast<char**>(object);
+    }
+  }
+  if (object == nullptr) {
+    char* slab = NewSlab(node);
+    if (slab == nullptr) {
+      return AllocateLarge(size);
+    }
+    // Keep the first object and chain the rest into the free list.
+    size_t class_size = kClassSizes[index];
+    char* last = slab + (kSlabSize / class_size - 1) * class_size;
+    for (char* p = slab + class_size; p < last; p += class_size) {
+      *reinterpret_cast<char**>(p) = p + class_size;
+    }
+    object = slab;
+    if (last != slab) {
+      std::lock_guard<SpinMutex> lock(list.mutex);
+      *reinterpret_cast<char**>(last) = list.head;
+      list.head = slab + class_size;
+    }
+  }
+  Header* header = reinterpret_cast<Header*>(object);
+  header->size_class = index;
+  header->node = static_cast<uint32_t>(node);
+  header->size = size;
+  return object + kHeaderSize;
+}
+
+void SlabAllocator::Deallocate(void* p) {
+  if (p == nullptr) {
+    return;
+  }
+  char* object = static_cast<char*>(p) - kHeaderSize;
+  const Header* header = reinterpret_cast<const Header*>(object);
+  if (header->size_class == kLargeClass) {
+    free(object);
+    return;
+  }
+  FreeList& list =
+      free_lists_[header->size_class * num_nodes_ + header->node];
+  std::lock_guard<SpinMutex> lock(list.mutex);
+  *reinterpret_cast<char**>(object) = list.head;
+  list.head = object;
+}
+
+size_t SlabAllocator::UsableSize(void* p, size_t /*allocation_size*/) const {
+  const Header* header =
+      reinterpret_cast<const Header*>(static_cast<char*>(p) - kHeaderSize);
+  if (header->size_class == kLargeClass) {
+    return static_cast<size_t>(header->size);
+  }
+  return kClassSizes[header->size_class] - kHeaderSize;
+}
+
+void* SlabAllocator::AllocateLarge(size_t size) {
+  char* object = static_cast<char*>(malloc(size + kHeaderSize));
+  if (object == nullptr) {
+    throw std::bad_alloc();
+  }
+  Header* header = reinterpret_cast<Header*>(object);
+  header->size_class = kLargeClass;
+  header->node = 0;
+  header->size = size;
+  return object + kHeaderSize;
+}
+
+size_t SlabAllocator::GetMappedBytes() const {
+  MutexLock l(&mutex_);
+  return regions_.size() * region_size_;
+}
+
+size_t SlabAllocator::GetHugeTlbBytes() const {
+  MutexLock l(&mutex_);
+  return hugetlb_bytes_;
+}
+
+char* SlabAllocator::NewSlab(int node) {
+  MutexLock l(&mutex_);
+  NodeRegion& region = node_regions_[node];
+  if (region.next == region.end) {
+    char* addr = MapRegion(node);
+    if (addr == nullptr) {
+      return nullptr;
+    }
+    region.next = addr;
+    region.end = addr + region_size_;
+  }
+  char* slab = region.next;
+  region.next += kSlabSize;
+  return slab;
+}
+
+char* SlabAllocator::MapRegion(int node) {
+  mutex_.AssertHeld();
+  // Reserve first so that push_back() below cannot throw and leak the
+  // mapping.
+  regions_.reserve(regions_.size() + 1);
+  char* addr = nullptr;
+#ifndef OS_WIN
+#ifdef MAP_HUGETLB
+  if (huge_page_size_ > 0) {
+    void* p = mmap(nullptr, region_size_, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+      addr = static_cast<char*>(p);
+      hugetlb_bytes_ += region_size_;
+    }
+  }
+#endif  // MAP_HUGETLB
+  if (addr == nullptr) {
+    // No reserved huge pages. Map regular pages, starting on a huge page
+    // boundary so that transparent huge pages can back them.
+    size_t align = huge_page_size_;
+    size_t length = region_size_ + align;
+    void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+      return nullptr;
+    }
+    char* start = static_cast<char*>(p);
+    char* end = start + length;
+    if (align > 0) {
+      uintptr_t misalignment = reinterpret_cast<uintptr_t>(start) % align;
+      addr = start + (misalignment == 0 ? 0 : align - misalignment);
+    } else {
+      addr = start;
+    }
+    if (addr > start) {
+      munmap(start, addr - start);
+    }
+    if (end > addr + region_size_) {
+      munmap(addr + region_size_, end - (addr + region_size_));
+    }
+#ifdef MADV_HUGEPAGE
+    if (huge_page_size_ > 0) {
+      madvise(addr, region_size_, MADV_HUGEPAGE);
+    }
+#endif
+  }
+#ifdef NUMA
+  if (num_nodes_ > 1) {
+    numa_tonode_memory(addr, region_size_, node);
+  }
+#endif
+#else   // OS_WIN
+  (void)node;
+  addr = static_cast<char*>(malloc(region_size_));
+  if (addr == nullptr) {
+    return nullptr;
+  }
+#endif  // OS_WIN
+  regions_.push_back(addr);
+  return addr;
+}
+
+std::shared_ptr<MemoryAllocator> NewSlabAllocator(
+    const SlabAllocatorOptions& options) {
+  return std::make_shared<SlabAllocator>(options);
+}
+
+}  // namespace rocksdb
@@ -0,0 +1,105 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#pragma once
+
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include "port/port.h"
+#include "rocksdb/memory_allocator.h"
+#include "util/mutexlock.h"
+
+namespace rocksdb {
+
+// SlabAllocator maps memory in regions of huge pages, cuts the regions into
+// slabs of kSlabSize bytes and each slab into objects of one size class.
+// Every object starts with a small header naming its class and NUMA node,
+// so Deallocate() needs no lookup: the object goes back on the free list of
+// its class on its node. Each free list has its own spin lock; the region
+// mutex is only taken to hand out a new slab.
+class SlabAllocator : public MemoryAllocator {
+ public:
+  static const size_t kSlabSize = 1 << 20;
+  // Objects are carved out of slabs if their size plus the header fits the
+  // largest class.
+  static const size_t kMaxClassSize = 256 << 10;
+  static const size_t kHeaderSize = 16;
+
+  explicit SlabAllocator(const SlabAllocatorOptions& options);
+  ~SlabAllocator();
+
+  virtual const char* Name() const override { return "SlabAllocator"; }
+
+  virtual void* Allocate(size_t size) override;
+
+  virtual void Deallocate(void* p) override;
+
+  virtual size_t UsableSize(void* p, size_t allocation_size) const override;
+
+  // Bytes mapped for slabs, and the part of them mapped with MAP_HUGETLB.
+  size_t GetMappedBytes() const;
+  size_t GetHugeTlbBytes() const;
+
+  // The NUMA nodes slabs are kept for. 1 unless numa_aware is set.
+  int num_nodes() const { return num_nodes_; }
+
+  // The size of the class an object of `size` bytes, header included, is
+  // served from. Exposed for tests.
+  static size_t ClassSize(size_t size);
+
+ private:
+  // Header of an object allocated with malloc() because it is too large.
+  static const uint32_t kLargeClass = UINT32_MAX;
+
+  struct Header {
+    uint32_t size_class;
+    uint32_t node;
+    // Requested size of large objects.
+    uint64_t size;
+  };
+
+  struct FreeList {
+    SpinMutex mutex;
+    // Chained through the first word of each free object.
+    char* head = nullptr;
+    // Keeps each list on a cache line of its own.
+    char padding[CACHE_LINE_SIZE - 2 * sizeof(char*)];
+  };
+
+  struct NodeRegion {
+    // The part of the node's last region not handed out as slabs yet.
+    char* next = nullptr;
+    char* end = nullptr;
+  };
+
+  static uint32_t SizeClassIndex(size_t size);
+
+  int CurrentNode() const;
+
+  // Returns a new slab of kSlabSize bytes on `node`, or nullptr if no more
+  // memory can be mapped.
+  char* NewSlab(int node);
+
+  // Maps a new region of region_size_ bytes for `node`.
+  // REQUIRES: mutex_ held
+  char* MapRegion(int node);
+
+  void* AllocateLarge(size_t size);
+
+  const size_t huge_page_size_;
+  const size_t region_size_;
+  int num_nodes_;
+  // num_nodes_ lists per size class, indexed by class * num_nodes_ + node.
+  std::unique_ptr<FreeList[]> free_lists_;
+
+  mutable port::Mutex mutex_;
+  std::vector<char*> regions_;
+  std::vector<NodeRegion> node_regions_;
+  size_t hugetlb_bytes_;
+};
+
+}  // namespace rocksdb
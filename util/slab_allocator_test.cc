@@ -0,0 +1,137 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "util/slab_allocator.h"
+
+#include <string.h>
+#include <set>
+#include <vector>
+
+#include "port/port.h"
+#include "util/random.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class SlabAllocatorTest : public testing::Test {};
+
+TEST_F(SlabAllocatorTest, ClassSize) {
+  ASSERT_EQ(64U, SlabAllocator::ClassSize(1));
+  ASSERT_EQ(64U, SlabAllocator::ClassSize(64));
+  ASSERT_EQ(80U, SlabAllocator::ClassSize(65));
+  // A full block of the common sizes with its trailer and the header fits
+  // a class just above the block size.
+  for (size_t block_size : {4096, 8192, 16384}) {
+    ASSERT_EQ(block_size + 32,
+              SlabAllocator::ClassSize(block_size + 5 +
+                                       SlabAllocator::kHeaderSize));
+  }
+  ASSERT_EQ(5120U, SlabAllocator::ClassSize(4129));
+  ASSERT_EQ(SlabAllocator::kMaxClassSize,
+            SlabAllocator::ClassSize(SlabAllocator::kMaxClassSize));
+  ASSERT_EQ(0U, SlabAllocator::ClassSize(SlabAllocator::kMaxClassSize + 1));
+  // Requests are rounded up by less than a quarter.
+  for (size_t size = 64; size <= SlabAllocator::kMaxClassSize; size += 37) {
+    size_t class_size = SlabAllocator::ClassSize(size);
+    ASSERT_GE(class_size, size);
+    ASSERT_LT(class_size - size, size / 4 + 1);
+  }
+}
+
+TEST_F(SlabAllocatorTest, AllocateAndReuse) {
+  for (size_t huge_page_size : {size_t{0}, size_t{2 << 20}}) {
+    SlabAllocatorOptions options;
+    options.huge_page_size = huge_page_size;
+    SlabAllocator allocator(options);
+    ASSERT_EQ(0U, allocator.GetMappedBytes());
+
+    std::vector<char*> objects;
+    for (int i = 0; i < 100; i++) {
+      char* p = static_cast<char*>(allocator.Allocate(4000));
+      ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(p) % 8);
+      ASSERT_EQ(SlabAllocator::ClassSize(4000 + SlabAllocator::kHeaderSize) -
+                    SlabAllocator::kHeaderSize,
+                allocator.UsableSize(p, 4000));
+      memset(p, i, 4000);
+      objects.push_back(p);
+    }
+    for (int i = 0; i < 100; i++) {
+      ASSERT_EQ(static_cast<char>(i), objects[i][0]);
+      ASSERT_EQ(static_cast<char>(i), objects[i][3999]);
+    }
+    size_t mapped = allocator.GetMappedBytes();
+    ASSERT_GT(mapped, 0U);
+    ASSERT_LE(allocator.GetHugeTlbBytes(), mapped);
+
+    // Freed objects are handed out again before new slabs are cut.
+    std::set<char*> freed(objects.begin(), objects.end());
+    for (char* p : objects) {
+      allocator.Deallocate(p);
+    }
+    for (int i = 0; i < 100; i++) {
+      char* p = static_cast<char*>(allocator.Allocate(4000));
+      ASSERT_EQ(1U, freed.count(p));
+      allocator.Deallocate(p);
+    }
+    ASSERT_EQ(mapped, allocator.GetMappedBytes());
+  }
+}
+
+TEST_F(SlabAllocatorTest, LargeAllocation) {
+  SlabAllocatorOptions options;
+  SlabAllocator allocator(options);
+  size_t size = SlabAllocator::kMaxClassSize + 1;
+  char* p = static_cast<char*>(allocator.Allocate(size));
+  memset(p, 'x', size);
+  ASSERT_EQ(size, allocator.UsableSize(p, size));
+  // No slab is mapped for it.
+  ASSERT_EQ(0U, allocator.GetMappedBytes());
+  allocator.Deallocate(p);
+  allocator.Deallocate(nullptr);
+}
+
+TEST_F(SlabAllocatorTest, MultiThreaded) {
+  auto allocator = NewSlabAllocator();
+  const int kNumThreads = 4;
+  const int kNumOps = 20000;
+  std::vector<port::Thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&allocator, t]() {
+      Random rnd(301 + t);
+      std::vector<std::pair<char*, size_t>> live;
+      for (int i = 0; i < kNumOps; i++) {
+        if (!live.empty() && rnd.OneIn(2)) {
+          size_t index = rnd.Uniform(static_cast<int>(live.size()));
+          char* p = live[index].first;
+          size_t size = live[index].second;
+          // Nobody else wrote over the object.
+          ASSERT_EQ(static_cast<char>(t), p[0]);
+          ASSERT_EQ(static_cast<char>(t), p[size - 1]);
+          allocator->Deallocate(p);
+          live[index] = live.back();
+          live.pop_back();
+        } else {
+          size_t size = 1 + rnd.Skewed(17);
+          char* p = static_cast<char*>(allocator->Allocate(size));
+          memset(p, t, size);
+          live.emplace_back(p, size);
+        }
+      }
+      for (auto& object : live) {
+        allocator->Deallocate(object.first);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
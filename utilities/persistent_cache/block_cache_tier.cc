@@ -265,6 +265,19 @@ Status BlockCacheTier::InsertImpl(const Slice& key, const Slice& data) {
 
 Status BlockCacheTier::Lookup(const Slice& key, unique_ptr<char[]>* val,
                               size_t* size) {
+  PinnableSlice value;
+  Status status = LookupPinned(key, &value);
+  if (!status.ok()) {
+    return status;
+  }
+
+  val->reset(new char[value.size()]);
+  memcpy(val->get(), value.data(), value.size());
+  *size = value.size();
+  return status;
+}
+
+Status BlockCacheTier::LookupPinned(const Slice& key, PinnableSlice* value) {
   StopWatchNano timer(opt_.env, /*auto_start=*/ true);
 
   LBA lba;
@@ -287,11 +300,11 @@ Status BlockCacheTier::Lookup(const Slice& key, unique_ptr<char[]>* val,
 
   assert(file->refs_);
 
-  unique_ptr<char[]> scratch(new char[lba.size_]);
+  AlignedBuffer* buf = nullptr;
   Slice blk_key;
   Slice blk_val;
 
-  status = file->Read(lba, &blk_key, &blk_val, scratch.get());
+  status = file->ReadPinned(lba, &blk_key, &blk_val, &read_buffer_pool_, &buf);
   --file->refs_;
   if (!status) {
     stats_.cache_misses_++;
@@ -302,17 +315,23 @@ Status BlockCacheTier::Lookup(const Slice& key, unique_ptr<char[]>* val,
 
   assert(blk_key == key);
 
-  val->reset(new char[blk_val.size()]);
-  memcpy(val->get(), blk_val.data(), blk_val.size());
-  *size = blk_val.size();
+  // the value points into the read buffer, which goes back to the pool once
+  // the caller releases the value
+  value->PinSlice(blk_val, &BlockCacheTier::ReleaseReadBuffer,
+                  &read_buffer_pool_, buf);
 
-  stats_.bytes_read_.Add(*size);
+  stats_.bytes_read_.Add(blk_val.size());
   stats_.cache_hits_++;
   stats_.read_hit_latency_.Add(timer.ElapsedNanos() / 1000);
 
   return Status::OK();
 }
 
+void BlockCacheTier::ReleaseReadBuffer(void* pool, void* buf) {
+  static_cast<CacheReadBufferPool*>(pool)->Release(
+      static_cast<AlignedBuffer*>(buf));
+}
+
 bool BlockCacheTier::Erase(const Slice& key) {
   WriteLock _(&lock_);
   BlockInfo* info = metadata_.Remove(key);
@@ -45,6 +45,7 @@ class BlockCacheTier : public PersistentCacheTier {
       : opt_(opt),
         insert_ops_(opt_.max_write_pipeline_backlog_size),
         buffer_allocator_(opt.write_buffer_size, opt.write_buffer_count()),
+        read_buffer_pool_(static_cast<size_t>(opt.read_buffer_pool_size)),
         writer_(this, opt_.writer_qdepth, opt_.writer_dispatch_size) {
     Info(opt_.log, "Initializing allocator. size=%d B count=%d",
          opt_.write_buffer_size, opt_.write_buffer_count());
@@ -59,6 +60,7 @@ class BlockCacheTier : public PersistentCacheTier {
   Status Insert(const Slice& key, const char* data, const size_t size) override;
   Status Lookup(const Slice& key, std::unique_ptr<char[]>* data,
                 size_t* size) override;
+  Status LookupPinned(const Slice& key, PinnableSlice* value) override;
   Status Open() override;
   Status Close() override;
   bool Erase(const Slice& key) override;
@@ -112,6 +114,8 @@ class BlockCacheTier : public PersistentCacheTier {
   std::string GetCachePath() const { return opt_.path + "/cache"; }
   // Cleanup folder
   Status CleanupCacheFolder(const std::string& folder);
+  // Return a pinned read buffer to the pool
+  static void ReleaseReadBuffer(void* pool, void* buf);
 
   // Statistics
   struct Statistics {
@@ -144,6 +148,7 @@ class BlockCacheTier : public PersistentCacheTier {
   uint32_t writer_cache_id_ = 0;                // Current cache file identifier
   WriteableCacheFile* cache_file_ = nullptr;    // Current cache file reference
   CacheWriteBufferAllocator buffer_allocator_;  // Buffer provider
+  CacheReadBufferPool read_buffer_pool_;        // Buffers for lookups
   ThreadedWriter writer_;                       // Writer threads
   BlockCacheTierMetadata metadata_;             // Cache meta data manager
   std::atomic<uint64_t> size_{0};               // Size of the cache
@@ -31,6 +31,18 @@ Status NewWritableCacheFile(Env* const env, const std::string& filepath,
   return s;
 }
 
+Status NewDirectWriteCacheFile(Env* const env, const std::string& filepath,
+                               std::unique_ptr<RandomRWFile>* file) {
+  EnvOptions opt;
+  opt.use_direct_writes = true;
+  Status s = env->NewRandomRWFile(filepath, file, opt);
+  if (s.ok() && !(*file)->use_direct_io()) {
+    file->reset();
+    s = Status::NotSupported("direct writes not supported by the env");
+  }
+  return s;
+}
+
 Status NewRandomAccessCacheFile(Env* const env, const std::string& filepath,
                                 std::unique_ptr<RandomAccessFile>* file,
                                 const bool use_direct_reads = true) {
@@ -240,6 +252,61 @@ bool RandomAccessCacheFile::Read(const LBA& lba, Slice* key, Slice* val,
   return ParseRec(lba, key, val, scratch);
 }
 
+bool RandomAccessCacheFile::ReadPinned(const LBA& lba, Slice* key, Slice* val,
+                                       CacheReadBufferPool* pool,
+                                       AlignedBuffer** buf) {
+  ReadLock _(&rwlock_);
+
+  assert(lba.cache_id_ == cache_id_);
+
+  if (!freader_) {
+    return false;
+  }
+
+  // With direct IO, the file reader would read the aligned span into a bounce
+  // buffer and copy the record out. Read the aligned span straight into the
+  // pooled buffer instead, and parse the record in place.
+  RandomAccessFile* const file = freader_->file();
+  const bool read_aligned =
+      file->use_direct_io() &&
+      CacheWriteBuffer::kAlignment % file->GetRequiredBufferAlignment() == 0;
+  size_t off = lba.off_;
+  size_t size = lba.size_;
+  if (read_aligned) {
+    const size_t alignment = file->GetRequiredBufferAlignment();
+    off = TruncateToPageBoundary(alignment, lba.off_);
+    size = Roundup(lba.off_ + lba.size_, alignment) - off;
+  }
+
+  AlignedBuffer* const tmp = pool->Allocate(size);
+  Slice result;
+  Status s = read_aligned
+                 ? file->Read(off, size, &result, tmp->BufferStart())
+                 : freader_->Read(off, size, &result, tmp->BufferStart());
+  const size_t rec_off = lba.off_ - off;
+  if (s.ok() && result.size() < rec_off + lba.size_) {
+    s = Status::Corruption("short read");
+  }
+  if (!s.ok()) {
+    Error(log_, "Error reading from file %s. %s", Path().c_str(),
+          s.ToString().c_str());
+    pool->Release(tmp);
+    return false;
+  }
+
+  if (result.data() != tmp->BufferStart()) {
+    memcpy(tmp->BufferStart(), result.data(), rec_off + lba.size_);
+  }
+
+  if (!ParseRec(lba, key, val, tmp->BufferStart() + rec_off)) {
+    pool->Release(tmp);
+    return false;
+  }
+
+  *buf = tmp;
+  return true;
+}
+
 bool RandomAccessCacheFile::ParseRec(const LBA& lba, Slice* key, Slice* val,
                                      char* scratch) {
   Slice data(scratch, lba.size_);
@@ -268,7 +335,7 @@ WriteableCacheFile::~WriteableCacheFile() {
     // This file never flushed. We give priority to shutdown since this is a
     // cache
     // TODO(krad): Figure a way to flush the pending data
-    if (file_) {
+    if (file_ || rw_file_) {
       assert(refs_ == 1);
       --refs_;
     }
@@ -292,7 +359,19 @@ bool WriteableCacheFile::Create(const bool enable_direct_writes,
                    s.ToString().c_str());
   }
 
-  s = NewWritableCacheFile(env_, Path(), &file_);
+  if (enable_direct_writes) {
+    // positioned writes leave the tail of an existing file in place
+    env_->DeleteFile(Path());
+    s = NewDirectWriteCacheFile(env_, Path(), &rw_file_);
+    if (!s.ok()) {
+      // the file system may not support direct IO
+      ROCKS_LOG_WARN(log_, "Unable to create file %s for direct writes. %s",
+                     Path().c_str(), s.ToString().c_str());
+    }
+  }
+  if (!rw_file_) {
+    s = NewWritableCacheFile(env_, Path(), &file_);
+  }
   if (!s.ok()) {
     ROCKS_LOG_WARN(log_, "Unable to create file %s. %s", Path().c_str(),
                    s.ToString().c_str());
@@ -381,34 +460,39 @@ void WriteableCacheFile::DispatchBuffer() {
   assert(buf_doff_ <= buf_woff_);
   assert(buf_woff_ <= bufs_.size());
 
-  if (pending_ios_) {
-    return;
-  }
+  assert(file_ || rw_file_);
+  // buffered appends have to reach the file in order
+  const size_t max_pending_ios = rw_file_ ? writer_->QueueDepth() : 1;
 
-  if (!eof_ && buf_doff_ == buf_woff_) {
-    // dispatch buffer is pointing to write buffer and we haven't hit eof
-    return;
-  }
+  while (pending_ios_ < max_pending_ios && buf_doff_ < bufs_.size()) {
+    if (!eof_ && buf_doff_ == buf_woff_) {
+      // dispatch buffer is pointing to write buffer and we haven't hit eof
+      return;
+    }
 
-  assert(eof_ || buf_doff_ < buf_woff_);
-  assert(buf_doff_ < bufs_.size());
-  assert(file_);
+    assert(eof_ || buf_doff_ < buf_woff_);
 
-  auto* buf = bufs_[buf_doff_];
-  const uint64_t file_off = buf_doff_ * alloc_->BufferSize();
+    auto* buf = bufs_[buf_doff_];
+    const uint64_t file_off = buf_doff_ * alloc_->BufferSize();
 
-  assert(!buf->Free() ||
-         (eof_ && buf_doff_ == buf_woff_ && buf_woff_ < bufs_.size()));
-  // we have reached end of file, and there is space in the last buffer
-  // pad it with zero for direct IO
-  buf->FillTrailingZeros();
+    assert(!buf->Free() ||
+           (eof_ && buf_doff_ == buf_woff_ && buf_woff_ < bufs_.size()));
+    // we have reached end of file, and there is space in the last buffer
+    // pad it with zero for direct IO
+    buf->FillTrailingZeros();
 
-  assert(buf->Used() % kFileAlignmentSize == 0);
+    assert(buf->Used() % kFileAlignmentSize == 0);
 
-  writer_->Write(file_.get(), buf, file_off,
-                 std::bind(&WriteableCacheFile::BufferWriteDone, this));
-  pending_ios_++;
-  buf_doff_++;
+    if (rw_file_) {
+      writer_->Write(rw_file_.get(), buf, file_off,
+                     std::bind(&WriteableCacheFile::BufferWriteDone, this));
+    } else {
+      writer_->Write(file_.get(), buf, file_off,
+                     std::bind(&WriteableCacheFile::BufferWriteDone, this));
+    }
+    pending_ios_++;
+    buf_doff_++;
+  }
 }
 
 void WriteableCacheFile::BufferWriteDone() {
@@ -448,6 +532,27 @@ bool WriteableCacheFile::ReadBuffer(const LBA& lba, Slice* key, Slice* block,
   return ParseRec(lba, key, block, scratch);
 }
 
+bool WriteableCacheFile::ReadPinned(const LBA& lba, Slice* key, Slice* block,
+                                    CacheReadBufferPool* pool,
+                                    AlignedBuffer** buf) {
+  ReadLock _(&rwlock_);
+  const bool closed = eof_ && bufs_.empty();
+  if (closed) {
+    // the file is closed, read from disk
+    return RandomAccessCacheFile::ReadPinned(lba, key, block, pool, buf);
+  }
+
+  // file is still being written, read from buffers
+  AlignedBuffer* const tmp = pool->Allocate(lba.size_);
+  if (!ReadBuffer(lba, key, block, tmp->BufferStart())) {
+    pool->Release(tmp);
+    return false;
+  }
+
+  *buf = tmp;
+  return true;
+}
+
 bool WriteableCacheFile::ReadBuffer(const LBA& lba, char* data) {
   rwlock_.AssertHeld();
 
@@ -502,8 +607,17 @@ void WriteableCacheFile::Close() {
   Info(log_, "Closing file %s. size=%d written=%d", Path().c_str(), size_,
        disk_woff_);
 
+  if (rw_file_) {
+    Status s = rw_file_->Close();
+    if (!s.ok()) {
+      Error(log_, "Error closing file %s. %s", Path().c_str(),
+            s.ToString().c_str());
+    }
+  }
+
   ClearBuffers();
   file_.reset();
+  rw_file_.reset();
 
   assert(refs_);
   --refs_;
@@ -522,7 +636,7 @@ void WriteableCacheFile::ClearBuffers() {
 //
 ThreadedWriter::ThreadedWriter(PersistentCacheTier* const cache,
                                const size_t qdepth, const size_t io_size)
-    : Writer(cache), io_size_(io_size) {
+    : Writer(cache), qdepth_(qdepth), io_size_(io_size) {
   for (size_t i = 0; i < qdepth; ++i) {
     port::Thread th(&ThreadedWriter::ThreadMain, this);
     threads_.push_back(std::move(th));
@@ -549,6 +663,12 @@ void ThreadedWriter::Write(WritableFile* const file, CacheWriteBuffer* buf,
   q_.Push(IO(file, buf, file_off, callback));
 }
 
+void ThreadedWriter::Write(RandomRWFile* const file, CacheWriteBuffer* buf,
+                           const uint64_t file_off,
+                           const std::function<void()> callback) {
+  q_.Push(IO(file, buf, file_off, callback));
+}
+
 void ThreadedWriter::ThreadMain() {
   while (true) {
     // Fetch the IO to process
@@ -576,7 +696,10 @@ void ThreadedWriter::DispatchIO(const IO& io) {
   size_t written = 0;
   while (written < io.buf_->Used()) {
     Slice data(io.buf_->Data() + written, io_size_);
-    Status s = io.file_->Append(data);
+    // positioned writes carry their own offset, so that the buffers of a
+    // file can be written in parallel
+    Status s = io.rw_file_ ? io.rw_file_->Write(io.file_off_ + written, data)
+                           : io.file_->Append(data);
     assert(s.ok());
     if (!s.ok()) {
       // That is definite IO error to device. There is not much we can
@@ -45,6 +45,17 @@
 //
 // Write IO code path :
 //
+// The records are appended to aligned in-memory buffers, which are handed to
+// the writer threads as they fill up. With direct writes, each buffer is
+// written at its own offset in the file, so the writers flush several buffers
+// of a file in parallel. Buffered writes are appended one buffer at a time.
+//
+// Read IO code path :
+//
+// A pinned read fetches the record into an aligned buffer of the
+// CacheReadBufferPool and hands out the value in place; the buffer goes back
+// to the pool once the caller releases it.
+//
 namespace rocksdb {
 
 class WriteableCacheFile;
@@ -75,12 +86,19 @@ class Writer {
   explicit Writer(PersistentCacheTier* const cache) : cache_(cache) {}
   virtual ~Writer() {}
 
-  // write buffer to file at the given offset
+  // append buffer to file, which the buffer's offset is the end of
   virtual void Write(WritableFile* const file, CacheWriteBuffer* buf,
                      const uint64_t file_off,
                      const std::function<void()> callback) = 0;
+  // write buffer to file at the given offset. positioned writes to the same
+  // file may be issued at the same time
+  virtual void Write(RandomRWFile* const file, CacheWriteBuffer* buf,
+                     const uint64_t file_off,
+                     const std::function<void()> callback) = 0;
   // stop the writer
   virtual void Stop() = 0;
+  // max number of buffers that can be written at the same time
+  virtual size_t QueueDepth() const { return 1; }
 
   PersistentCacheTier* const cache_;
 };
@@ -114,6 +132,15 @@ class BlockCacheFile : public LRUElement<BlockCacheFile> {
     return false;
   }
 
+  // read the record into a buffer from the pool, and return key and value
+  // pointing into it. The caller owns *buf on success and gives it back to
+  // the pool once done with the key and value.
+  virtual bool ReadPinned(const LBA& lba, Slice* key, Slice* block,
+                          CacheReadBufferPool* pool, AlignedBuffer** buf) {
+    assert(!"not implemented");
+    return false;
+  }
+
   // get file path
   std::string Path() const {
     return dir_ + "/" + std::to_string(cache_id_) + ".rc";
@@ -156,6 +183,9 @@ class RandomAccessCacheFile : public BlockCacheFile {
   bool Open(const bool enable_direct_reads);
   // read data from the disk
   bool Read(const LBA& lba, Slice* key, Slice* block, char* scratch) override;
+  // read data from the disk into a pooled buffer
+  bool ReadPinned(const LBA& lba, Slice* key, Slice* block,
+                  CacheReadBufferPool* pool, AlignedBuffer** buf) override;
 
  private:
   std::unique_ptr<RandomAccessFileReader> freader_;
@@ -200,6 +230,10 @@ class WriteableCacheFile : public RandomAccessCacheFile {
     return ReadBuffer(lba, key, block, scratch);
   }
 
+  // read data from logical file into a pooled buffer
+  bool ReadPinned(const LBA& lba, Slice* key, Slice* block,
+                  CacheReadBufferPool* pool, AlignedBuffer** buf) override;
+
   // append data to end of file
   bool Append(const Slice&, const Slice&, LBA* const) override;
   // End-of-file
@@ -230,11 +264,16 @@ class WriteableCacheFile : public RandomAccessCacheFile {
   //   (next buffer to           (next buffer to fill)
   //   flush to disk)
   //
-  //  The buffers are flushed to disk serially for a given file
+  //  The buffers are flushed to disk serially for a given file, unless the
+  //  file is written with direct IO. Direct writes are positioned writes to
+  //  rw_file_, and up to Writer::QueueDepth() buffers of the file are flushed
+  //  at the same time. WritableFile is not safe to write from several threads
+  //  at once, so file_ is only used for serial appends.
 
   CacheWriteBufferAllocator* const alloc_ = nullptr;  // Buffer provider
   Writer* const writer_ = nullptr;                    // File writer thread
   std::unique_ptr<WritableFile> file_;   // RocksDB Env file abstraction
+  std::unique_ptr<RandomRWFile> rw_file_;  // File for direct writes
   std::vector<CacheWriteBuffer*> bufs_;  // Written buffers
   uint32_t size_ = 0;                    // Size of the file
   const uint32_t max_size_;              // Max size of the file
@@ -258,12 +297,16 @@ class ThreadedWriter : public Writer {
     explicit IO(WritableFile* const file, CacheWriteBuffer* const buf,
                 const uint64_t file_off, const std::function<void()> callback)
         : file_(file), buf_(buf), file_off_(file_off), callback_(callback) {}
+    explicit IO(RandomRWFile* const file, CacheWriteBuffer* const buf,
+                const uint64_t file_off, const std::function<void()> callback)
+        : rw_file_(file), buf_(buf), file_off_(file_off), callback_(callback) {}
 
     IO(const IO&) = default;
     IO& operator=(const IO&) = default;
     size_t Size() const { return sizeof(IO); }
 
-    WritableFile* file_ = nullptr;           // File to write to
+    WritableFile* file_ = nullptr;           // File to append to
+    RandomRWFile* rw_file_ = nullptr;        // File to write to at file_off_
     CacheWriteBuffer* const buf_ = nullptr;  // buffer to write
     uint64_t file_off_ = 0;                  // file offset
     bool signal_ = false;                    // signal to exit thread loop
@@ -275,14 +318,19 @@ class ThreadedWriter : public Writer {
   virtual ~ThreadedWriter() { assert(threads_.empty()); }
 
   void Stop() override;
+  size_t QueueDepth() const override { return qdepth_; }
   void Write(WritableFile* const file, CacheWriteBuffer* buf,
              const uint64_t file_off,
              const std::function<void()> callback) override;
+  void Write(RandomRWFile* const file, CacheWriteBuffer* buf,
+             const uint64_t file_off,
+             const std::function<void()> callback) override;
 
  private:
   void ThreadMain();
   void DispatchIO(const IO& io);
 
+  const size_t qdepth_ = 0;
   const size_t io_size_ = 0;
   BoundedQueue<IO> q_;
   std::vector<port::Thread> threads_;
@@ -7,8 +7,10 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "include/rocksdb/comparator.h"
+#include "util/aligned_buffer.h"
 #include "util/arena.h"
 #include "util/mutexlock.h"
 
@@ -19,10 +21,15 @@ namespace rocksdb {
 //
 // Buffer abstraction that can be manipulated via append
 // (not thread safe)
+//
+// The buffer is aligned so that it can be written to the device with direct IO
 class CacheWriteBuffer {
  public:
+  static const size_t kAlignment = 4 * 1024;
+
   explicit CacheWriteBuffer(const size_t size) : size_(size), pos_(0) {
-    buf_.reset(new char[size_]);
+    buf_.Alignment(kAlignment);
+    buf_.AllocateNewBuffer(size_);
     assert(!pos_);
     assert(size_);
   }
@@ -31,14 +38,14 @@ class CacheWriteBuffer {
 
   void Append(const char* buf, const size_t size) {
     assert(pos_ + size <= size_);
-    memcpy(buf_.get() + pos_, buf, size);
+    memcpy(Data() + pos_, buf, size);
     pos_ += size;
     assert(pos_ <= size_);
   }
 
   void FillTrailingZeros() {
     assert(pos_ <= size_);
-    memset(buf_.get() + pos_, '0', size_ - pos_);
+    memset(Data() + pos_, '0', size_ - pos_);
     pos_ = size_;
   }
 
@@ -46,10 +53,10 @@ class CacheWriteBuffer {
   size_t Free() const { return size_ - pos_; }
   size_t Capacity() const { return size_; }
   size_t Used() const { return pos_; }
-  char* Data() const { return buf_.get(); }
+  char* Data() const { return buf_.BufferStart(); }
 
  private:
-  std::unique_ptr<char[]> buf_;
+  mutable AlignedBuffer buf_;
   const size_t size_;
   size_t pos_;
 };
@@ -124,4 +131,93 @@ class CacheWriteBufferAllocator {
   std::list<CacheWriteBuffer*> bufs_;  // Buffer stash
 };
 
+//
+// CacheReadBufferPool
+//
+// Pool of aligned buffers for reading records from the cache files. A pinned
+// lookup holds on to its buffer until the caller is done with the data, and
+// then gives it back to the pool for the next read. Buffers are pooled in
+// power-of-two size classes, up to a total of max_pooled_bytes.
+// (thread safe)
+//
+class CacheReadBufferPool {
+ public:
+  explicit CacheReadBufferPool(const size_t max_pooled_bytes)
+      : max_pooled_bytes_(max_pooled_bytes) {}
+
+  virtual ~CacheReadBufferPool() {
+    MutexLock _(&lock_);
+    for (auto& bufs : free_bufs_) {
+      for (auto* buf : bufs) {
+        delete buf;
+      }
+      bufs.clear();
+    }
+    pooled_bytes_ = 0;
+  }
+
+  // Get a buffer that can hold at least size bytes
+  AlignedBuffer* Allocate(const size_t size) {
+    const size_t cls = SizeClass(size);
+    if (cls < kNumSizeClasses) {
+      MutexLock _(&lock_);
+      if (!free_bufs_[cls].empty()) {
+        AlignedBuffer* const buf = free_bufs_[cls].back();
+        free_bufs_[cls].pop_back();
+        pooled_bytes_ -= buf->Capacity();
+        return buf;
+      }
+    }
+
+    auto* buf = new AlignedBuffer();
+    buf->Alignment(CacheWriteBuffer::kAlignment);
+    buf->AllocateNewBuffer(cls < kNumSizeClasses ? ClassSize(cls) : size);
+    return buf;
+  }
+
+  // Return a buffer obtained from Allocate()
+  void Release(AlignedBuffer* const buf) {
+    assert(buf);
+    const size_t cls = SizeClass(buf->Capacity());
+    if (cls < kNumSizeClasses) {
+      assert(buf->Capacity() == ClassSize(cls));
+      MutexLock _(&lock_);
+      if (pooled_bytes_ + buf->Capacity() <= max_pooled_bytes_) {
+        buf->Clear();
+        free_bufs_[cls].push_back(buf);
+        pooled_bytes_ += buf->Capacity();
+        return;
+      }
+    }
+    delete buf;
+  }
+
+  // Bytes held by buffers waiting in the pool
+  size_t PooledBytes() const {
+    MutexLock _(&lock_);
+    return pooled_bytes_;
+  }
+
+ private:
+  // Size classes go from 4K to 8M. Larger buffers are not pooled.
+  static const size_t kNumSizeClasses = 12;
+
+  static size_t ClassSize(const size_t cls) {
+    return CacheWriteBuffer::kAlignment << cls;
+  }
+
+  static size_t SizeClass(const size_t size) {
+    size_t cls = 0;
+    while (cls < kNumSizeClasses && ClassSize(cls) < size) {
+      cls++;
+    }
+    return cls;
+  }
+
+  mutable port::Mutex lock_;                          // Sync lock
+  const size_t max_pooled_bytes_;                     // Max bytes to pool
+  size_t pooled_bytes_ = 0;                           // Bytes in the pool
+  std::vector<AlignedBuffer*> free_bufs_[kNumSizeClasses];  // Free buffers
+};
+
 }  // namespace rocksdb
@@ -33,6 +33,8 @@ DEFINE_int32(iosize, 4 * 1024, "Read IO size");
 DEFINE_int32(writer_iosize, 4 * 1024, "File writer IO size");
 DEFINE_int32(writer_qdepth, 1, "File writer qdepth");
 DEFINE_bool(enable_pipelined_writes, false, "Enable async writes");
+DEFINE_bool(enable_direct_writes, false, "Write cache files with direct IO");
+DEFINE_bool(pinned_lookup, false, "Lookup with LookupPinned()");
 DEFINE_string(cache_type, "block_cache",
               "Cache type. (block_cache, volatile, tiered)");
 DEFINE_bool(benchmark, false, "Benchmark mode");
@@ -58,6 +60,7 @@ std::unique_ptr<PersistentCacheTier> NewBlockCache() {
   opt.writer_dispatch_size = FLAGS_writer_iosize;
   opt.writer_qdepth = FLAGS_writer_qdepth;
   opt.pipeline_writes = FLAGS_enable_pipelined_writes;
+  opt.enable_direct_writes = FLAGS_enable_direct_writes;
   opt.max_write_pipeline_backlog_size = std::numeric_limits<uint64_t>::max();
   std::unique_ptr<PersistentCacheTier> cache(new BlockCacheTier(opt));
   Status status = cache->Open();
@@ -96,6 +99,7 @@ std::unique_ptr<PersistentTieredCache> NewTieredCache() {
   opt.writer_dispatch_size = FLAGS_writer_iosize;
   opt.writer_qdepth = FLAGS_writer_qdepth;
   opt.pipeline_writes = FLAGS_enable_pipelined_writes;
+  opt.enable_direct_writes = FLAGS_enable_direct_writes;
   opt.max_write_pipeline_backlog_size = std::numeric_limits<uint64_t>::max();
   return NewTieredCache(FLAGS_cache_size * pct, opt);
 }
@@ -224,8 +228,18 @@ class CacheTierBenchmark {
     // Lookup in cache
     StopWatchNano timer(Env::Default(), /*auto_start=*/true);
     std::unique_ptr<char[]> block;
-    size_t size;
-    Status status = cache_->Lookup(key, &block, &size);
+    PinnableSlice value;
+    Slice data;
+    size_t size = 0;
+    Status status;
+    if (FLAGS_pinned_lookup) {
+      status = cache_->LookupPinned(key, &value);
+      data = value;
+      size = value.size();
+    } else {
+      status = cache_->Lookup(key, &block, &size);
+      data = Slice(block.get(), size);
+    }
     if (!status.ok()) {
       fprintf(stderr, "%s\n", status.ToString().c_str());
     }
@@ -240,7 +254,7 @@ class CacheTierBenchmark {
     // verify content
     if (!FLAGS_benchmark) {
       auto expected_block = NewBlock(val);
-      assert(memcmp(block.get(), expected_block.get(), FLAGS_iosize) == 0);
+      assert(memcmp(data.data(), expected_block.get(), FLAGS_iosize) == 0);
     }
   }
 
@@ -318,6 +332,8 @@ int main(int argc, char** argv) {
       << "* writer_qdepth=" << FLAGS_writer_qdepth << std::endl
       << "* enable_pipelined_writes=" << FLAGS_enable_pipelined_writes
       << std::endl
+      << "* enable_direct_writes=" << FLAGS_enable_direct_writes << std::endl
+      << "* pinned_lookup=" << FLAGS_pinned_lookup << std::endl
       << "* cache_type=" << FLAGS_cache_type << std::endl
       << "* benchmark=" << FLAGS_benchmark << std::endl
       << "* volatile_cache_pct=" << FLAGS_volatile_cache_pct << std::endl;
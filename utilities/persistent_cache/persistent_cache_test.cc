@@ -103,13 +103,15 @@ std::unique_ptr<PersistentTieredCache> NewTieredCache(
 std::unique_ptr<PersistentCacheTier> NewBlockCache(
     Env* env, const std::string& path,
     const uint64_t max_size = std::numeric_limits<uint64_t>::max(),
-    const bool enable_direct_writes = false) {
+    const bool enable_direct_writes = false,
+    const uint32_t writer_qdepth = 1) {
   const uint32_t max_file_size = static_cast<uint32_t>(12 * 1024 * 1024 * kStressFactor);
   auto log = std::make_shared<ConsoleLogger>();
   PersistentCacheConfig opt(env, path, max_size, log);
   opt.cache_file_size = max_file_size;
   opt.max_write_pipeline_backlog_size = std::numeric_limits<uint64_t>::max();
   opt.enable_direct_writes = enable_direct_writes;
+  opt.writer_qdepth = writer_qdepth;
   std::unique_ptr<PersistentCacheTier> scache(new BlockCacheTier(opt));
   Status s = scache->Open();
   assert(s.ok());
@@ -211,6 +213,16 @@ TEST_F(PersistentCacheTierTest, BlockCacheInsert) {
   }
 }
 
+TEST_F(PersistentCacheTierTest, BlockCacheInsertWithParallelWriters) {
+  for (auto direct_writes : {true, false}) {
+    cache_ = NewBlockCache(Env::Default(), path_,
+                           /*size=*/std::numeric_limits<uint64_t>::max(),
+                           direct_writes, /*writer_qdepth=*/4);
+    RunInsertTest(/*nthreads=*/5,
+                  static_cast<size_t>(10 * 1024 * kStressFactor));
+  }
+}
+
 TEST_F(PersistentCacheTierTest, BlockCacheInsertWithEviction) {
   for (auto nthreads : {1, 5}) {
     for (auto max_keys : {1 * 1024 * 1024 * kStressFactor}) {
@@ -248,6 +260,57 @@ TEST_F(PersistentCacheTierTest, TieredCacheInsertWithEviction) {
 }
 #endif
 
+TEST_F(PersistentCacheTierTest, ReadBufferPool) {
+  CacheReadBufferPool pool(/*max_pooled_bytes=*/16 * 1024);
+
+  // buffers are aligned and rounded up to their size class
+  AlignedBuffer* buf = pool.Allocate(5000);
+  ASSERT_EQ(8 * 1024U, buf->Capacity());
+  ASSERT_EQ(0U, reinterpret_cast<uintptr_t>(buf->BufferStart()) %
+                    CacheWriteBuffer::kAlignment);
+  pool.Release(buf);
+  ASSERT_EQ(8 * 1024U, pool.PooledBytes());
+
+  // a released buffer is reused by the next read of its size class
+  AlignedBuffer* const reused = pool.Allocate(6000);
+  ASSERT_EQ(buf, reused);
+  ASSERT_EQ(0U, pool.PooledBytes());
+
+  // the pool does not grow past its limit
+  AlignedBuffer* const large = pool.Allocate(10 * 1024);
+  ASSERT_EQ(16 * 1024U, large->Capacity());
+  pool.Release(reused);
+  pool.Release(large);
+  ASSERT_EQ(8 * 1024U, pool.PooledBytes());
+
+  // buffers larger than the largest size class are not pooled
+  AlignedBuffer* const huge = pool.Allocate(9 * 1024 * 1024);
+  ASSERT_EQ(9 * 1024 * 1024U, huge->Capacity());
+  pool.Release(huge);
+  ASSERT_EQ(8 * 1024U, pool.PooledBytes());
+}
+
+TEST_F(PersistentCacheTierTest, BlockCacheLookupPinned) {
+  cache_ = NewBlockCache(Env::Default(), path_);
+  const std::string data(10 * 1024, 'x');
+  ASSERT_OK(cache_->Insert("key", data.data(), data.size()));
+  Flush();
+
+  // read from the buffers of the file being written
+  PinnableSlice value;
+  ASSERT_OK(cache_->LookupPinned("key", &value));
+  ASSERT_TRUE(value.IsPinned());
+  ASSERT_EQ(Slice(data), value);
+  value.Reset();
+
+  PinnableSlice missing;
+  ASSERT_TRUE(cache_->LookupPinned("missing", &missing).IsNotFound());
+  ASSERT_FALSE(missing.IsPinned());
+
+  ASSERT_OK(cache_->Close());
+  cache_.reset();
+}
+
 std::shared_ptr<PersistentCacheTier> MakeVolatileCache(
     const std::string& /*dbname*/) {
   return std::make_shared<VolatileCacheTier>();
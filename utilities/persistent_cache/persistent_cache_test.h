@@ -171,6 +171,10 @@ class PersistentCacheTierTest : public testing::Test {
       ASSERT_OK(cache_->Lookup(key, &block, &block_size));
       ASSERT_EQ(block_size, sizeof(edata));
       ASSERT_EQ(memcmp(edata, block.get(), sizeof(edata)), 0);
+
+      PinnableSlice value;
+      ASSERT_OK(cache_->LookupPinned(key, &value));
+      ASSERT_EQ(Slice(edata, sizeof(edata)), value);
       stats_verify_hits_++;
     }
   }
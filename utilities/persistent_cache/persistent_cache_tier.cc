@@ -52,6 +52,9 @@ std::string PersistentCacheConfig::ToString() const {
   snprintf(buffer, kBufferSize, "    writer_dispatch_size: %" PRIu64 "\n",
            writer_dispatch_size);
   ret.append(buffer);
+  snprintf(buffer, kBufferSize, "    read_buffer_pool_size: %" PRIu64 "\n",
+           read_buffer_pool_size);
+  ret.append(buffer);
   snprintf(buffer, kBufferSize, "    is_compressed: %d\n", is_compressed);
   ret.append(buffer);
 
@@ -151,6 +154,12 @@ Status PersistentTieredCache::Lookup(const Slice& page_key,
   return tiers_.front()->Lookup(page_key, data, size);
 }
 
+Status PersistentTieredCache::LookupPinned(const Slice& page_key,
+                                           PinnableSlice* value) {
+  assert(!tiers_.empty());
+  return tiers_.front()->LookupPinned(page_key, value);
+}
+
 void PersistentTieredCache::AddTier(const Tier& tier) {
   if (!tiers_.empty()) {
     tiers_.back()->set_next_tier(tier);
@@ -115,8 +115,10 @@ struct PersistentCacheConfig {
     // - Queue depth cannot be 0
     // - writer_dispatch_size cannot be greater than writer_buffer_size
     // - dispatch size and buffer size need to be aligned
+    // - direct writes need the dispatch size to be aligned to 4K
     if (!writer_qdepth || writer_dispatch_size > write_buffer_size ||
-        write_buffer_size % writer_dispatch_size) {
+        write_buffer_size % writer_dispatch_size ||
+        (enable_direct_writes && writer_dispatch_size % (4 * 1024))) {
       return Status::InvalidArgument("invalid writer settings");
     }
 
@@ -211,6 +213,15 @@ struct PersistentCacheConfig {
   // default: 1M
   uint64_t writer_dispatch_size = 1ULL * 1024 * 1024;
 
+  // read-buffer-pool-size
+  //
+  // Lookups read the records into aligned buffers, which are kept in a pool
+  // for reuse once the looked up data is released. This is the max size of
+  // the buffers kept in the pool.
+  //
+  // default: 16M
+  uint64_t read_buffer_pool_size = 16ULL * 1024 * 1024;
+
   // is_compressed
   //
   // This option determines if the cache will run in compressed mode or
@@ -303,6 +314,7 @@ class PersistentTieredCache : public PersistentCacheTier {
                 const size_t size) override;
   Status Lookup(const Slice& page_key, std::unique_ptr<char[]>* data,
                 size_t* size) override;
+  Status LookupPinned(const Slice& page_key, PinnableSlice* value) override;
   bool IsCompressed() override;
 
   std::string GetPrintableOptions() const override {
@@ -106,6 +106,31 @@ Status VolatileCacheTier::Lookup(const Slice& page_key,
   return Status::NotFound("key not found in volatile cache");
 }
 
+Status VolatileCacheTier::LookupPinned(const Slice& page_key,
+                                       PinnableSlice* value) {
+  CacheData key(std::move(page_key.ToString()));
+  CacheData* kv;
+  bool ok = index_.Find(&key, &kv);
+  if (ok) {
+    // copy the data out, since it can be evicted once the reference is
+    // dropped
+    value->PinSelf(kv->value);
+    // drop the reference on cache data
+    kv->refs_--;
+    // update stats
+    stats_.cache_hits_++;
+    return Status::OK();
+  }
+
+  stats_.cache_misses_++;
+
+  if (next_tier()) {
+    return next_tier()->LookupPinned(page_key, value);
+  }
+
+  return Status::NotFound("key not found in volatile cache");
+}
+
 bool VolatileCacheTier::Erase(const Slice& key) {
   assert(!"not supported");
   return true;
@@ -55,6 +55,7 @@ class VolatileCacheTier : public PersistentCacheTier {
   // lookup key in cache
   Status Lookup(const Slice& page_key, std::unique_ptr<char[]>* data,
                 size_t* size) override;
+  Status LookupPinned(const Slice& page_key, PinnableSlice* value) override;
 
   // is compressed cache ?
   bool IsCompressed() override { return is_compressed_; }
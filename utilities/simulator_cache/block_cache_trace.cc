@@ -0,0 +1,375 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "rocksdb/utilities/block_cache_trace.h"
+
+#include <deque>
+#include <unordered_map>
+
+#include "port/port.h"
+#include "util/coding.h"
+#include "util/mutexlock.h"
+
+namespace rocksdb {
+
+namespace {
+
+// File layout: magic (fixed64), version (fixed32), then records of
+//   op                          char
+//   timestamp delta             varint64, from the previous record
+//   cache key                   varint32 length, bytes
+//   block type, caller          char x 2
+//   level + 1                   varint32
+//   flags                       char, is_hit = 1, fill_cache = 2
+//   charge                      varint64
+const uint64_t kBlockCacheTraceMagic = 0x62637472616365ULL;  // "bctrace"
+const uint32_t kBlockCacheTraceVersion = 1;
+const size_t kBlockCacheTraceHeaderSize = 12;
+
+// Buffered records are written out once they take this many bytes.
+const size_t kTracerBufferSize = 64 << 10;
+const size_t kReaderBufferSize = 1 << 20;
+
+const char kIsHitFlag = 1;
+const char kFillCacheFlag = 2;
+
+class BlockCacheTracerImpl : public BlockCacheTracer {
+ public:
+  BlockCacheTracerImpl(Env* env, std::unique_ptr<WritableFile>&& file)
+      : env_(env),
+        written_(&mutex_),
+        file_(std::move(file)),
+        writing_(false),
+        closing_(false),
+        last_timestamp_(0) {
+    PutFixed64(&buffer_, kBlockCacheTraceMagic);
+    PutFixed32(&buffer_, kBlockCacheTraceVersion);
+  }
+
+  ~BlockCacheTracerImpl() { Close(); }
+
+  virtual void Record(const BlockCacheTraceRecord& record) override {
+    uint64_t timestamp = record.timestamp_micros != 0 ? record.timestamp_micros
+                                                      : env_->NowMicros();
+    MutexLock l(&mutex_);
+    if (file_ == nullptr || closing_) {
+      return;
+    }
+    // Keep deltas non-negative when threads race to record.
+    if (timestamp < last_timestamp_) {
+      timestamp = last_timestamp_;
+    }
+    buffer_.push_back(static_cast<char>(record.op));
+    PutVarint64(&buffer_, timestamp - last_timestamp_);
+    last_timestamp_ = timestamp;
+    PutLengthPrefixedSlice(&buffer_, record.cache_key);
+    buffer_.push_back(static_cast<char>(record.block_type));
+    buffer_.push_back(static_cast<char>(record.caller));
+    PutVarint32(&buffer_, static_cast<uint32_t>(record.level + 1));
+    buffer_.push_back(static_cast<char>((record.is_hit ? kIsHitFlag : 0) |
+                                        (record.fill_cache ? kFillCacheFlag
+                                                           : 0)));
+    PutVarint64(&buffer_, record.charge);
+    if (buffer_.size() >= kTracerBufferSize) {
+      Flush();
+    }
+  }
+
+  virtual Status Close() override {
+    MutexLock l(&mutex_);
+    closing_ = true;
+    while (writing_) {
+      written_.Wait();
+    }
+    if (file_ != nullptr && !buffer_.empty()) {
+      Flush();
+    }
+    if (file_ != nullptr) {
+      Status s = file_->Close();
+      if (status_.ok()) {
+        status_ = s;
+      }
+      file_.reset();
+    }
+    return status_;
+  }
+
+ private:
+  // Requires mutex_ held. Queues the buffered records to be written out.
+  // Only one thread writes at a time, in queue order, and it releases
+  // mutex_ while appending so other threads keep recording meanwhile.
+  // Stops tracing on a write error.
+  void Flush() {
+    full_buffers_.push_back(std::move(buffer_));
+    buffer_.clear();
+    if (writing_) {
+      return;
+    }
+    writing_ = true;
+    while (file_ != nullptr && !full_buffers_.empty()) {
+      std::string data = std::move(full_buffers_.front());
+      full_buffers_.pop_front();
+      mutex_.Unlock();
+      Status s = file_->Append(data);
+      mutex_.Lock();
+      if (!s.ok()) {
+        status_ = s;
+        file_->Close();
+        file_.reset();
+        full_buffers_.clear();
+      }
+    }
+    writing_ = false;
+    written_.SignalAll();
+  }
+
+  Env* env_;
+  port::Mutex mutex_;
+  // Signaled when a thread is done writing out full_buffers_.
+  port::CondVar written_;
+  std::unique_ptr<WritableFile> file_;
+  std::string buffer_;
+  std::deque<std::string> full_buffers_;
+  bool writing_;
+  bool closing_;
+  uint64_t last_timestamp_;
+  Status status_;
+};
+
+class BlockCacheTraceReaderImpl : public BlockCacheTraceReader {
+ public:
+  explicit BlockCacheTraceReaderImpl(std::unique_ptr<SequentialFile>&& file)
+      : file_(std::move(file)),
+        scratch_(new char[kReaderBufferSize]),
+        pos_(0),
+        eof_(false),
+        last_timestamp_(0) {
+    if (!Fill(kBlockCacheTraceHeaderSize) ||
+        buffer_.size() < kBlockCacheTraceHeaderSize) {
+      if (status_.ok()) {
+        status_ = Status::Corruption("block cache trace too short");
+      }
+      return;
+    }
+    if (DecodeFixed64(buffer_.data()) != kBlockCacheTraceMagic ||
+        DecodeFixed32(buffer_.data() + 8) != kBlockCacheTraceVersion) {
+      status_ = Status::Corruption("not a block cache trace");
+      return;
+    }
+    pos_ = kBlockCacheTraceHeaderSize;
+  }
+
+  virtual bool ReadRecord(BlockCacheTraceRecord* record) override {
+    if (!status_.ok()) {
+      return false;
+    }
+    while (true) {
+      Slice input(buffer_.data() + pos_, buffer_.size() - pos_);
+      if (input.empty() && eof_) {
+        return false;
+      }
+      if (Decode(&input, record)) {
+        pos_ = buffer_.size() - input.size();
+        return true;
+      }
+      // The record may go on past the buffer.
+      if (eof_) {
+        status_ = Status::Corruption("truncated block cache trace record");
+        return false;
+      }
+      if (!Fill(buffer_.size() - pos_ + 1)) {
+        return false;
+      }
+    }
+  }
+
+  virtual Status status() const override { return status_; }
+
+ private:
+  // Drops consumed bytes and reads until at least `n` bytes are buffered or
+  // the file ends. Returns false on a read error.
+  bool Fill(size_t n) {
+    buffer_.erase(0, pos_);
+    pos_ = 0;
+    while (buffer_.size() < n && !eof_) {
+      Slice chunk;
+      Status s = file_->Read(kReaderBufferSize, &chunk, scratch_.get());
+      if (!s.ok()) {
+        status_ = s;
+        return false;
+      }
+      if (chunk.empty()) {
+        eof_ = true;
+      }
+      buffer_.append(chunk.data(), chunk.size());
+    }
+    return true;
+  }
+
+  bool Decode(Slice* input, BlockCacheTraceRecord* record) {
+    uint64_t delta = 0;
+    Slice key;
+    uint32_t level = 0;
+    if (input->size() < 1) {
+      return false;
+    }
+    char op = (*input)[0];
+    input->remove_prefix(1);
+    if (!GetVarint64(input, &delta) || !GetLengthPrefixedSlice(input, &key) ||
+        input->size() < 2) {
+      return false;
+    }
+    char block_type = (*input)[0];
+    char caller = (*input)[1];
+    input->remove_prefix(2);
+    if (!GetVarint32(input, &level) || input->size() < 1) {
+      return false;
+    }
+    char flags = (*input)[0];
+    input->remove_prefix(1);
+    if (!GetVarint64(input, &record->charge)) {
+      return false;
+    }
+    last_timestamp_ += delta;
+    record->op = static_cast<BlockCacheTraceRecord::Op>(op);
+    record->timestamp_micros = last_timestamp_;
+    record->cache_key.assign(key.data(), key.size());
+    record->block_type = static_cast<BlockCacheTraceBlockType>(block_type);
+    record->caller = static_cast<BlockCacheTraceCaller>(caller);
+    record->level = static_cast<int>(level) - 1;
+    record->is_hit = (flags & kIsHitFlag) != 0;
+    record->fill_cache = (flags & kFillCacheFlag) != 0;
+    return true;
+  }
+
+  std::unique_ptr<SequentialFile> file_;
+  std::unique_ptr<char[]> scratch_;
+  std::string buffer_;
+  size_t pos_;
+  bool eof_;
+  uint64_t last_timestamp_;
+  Status status_;
+};
+
+void DeleteNothing(const Slice& /*key*/, void* /*value*/) {}
+
+// The insert of a missed block follows its lookup closely, so keys whose
+// insert did not show up within this many records are dropped, e.g. when
+// the traced insert failed.
+const uint64_t kPendingInsertRecords = 1 << 16;
+
+// Keys a simulated cache missed while the traced cache did too, so the
+// block is inserted once the trace shows its charge.
+class PendingInserts {
+ public:
+  // `seq` is the index of the missed lookup in the trace.
+  void Add(const std::string& key, uint64_t seq) {
+    seqs_[key] = seq;
+    order_.emplace_back(key, seq);
+  }
+
+  // Returns whether `key` was pending, and no longer keeps it.
+  bool Remove(const std::string& key) { return seqs_.erase(key) > 0; }
+
+  // Drops the keys added before record `seq` - kPendingInsertRecords.
+  void Expire(uint64_t seq) {
+    while (!order_.empty() &&
+           order_.front().second + kPendingInsertRecords <= seq) {
+      auto it = seqs_.find(order_.front().first);
+      // The key may have been removed, or added again since.
+      if (it != seqs_.end() && it->second == order_.front().second) {
+        seqs_.erase(it);
+      }
+      order_.pop_front();
+    }
+  }
+
+ private:
+  std::unordered_map<std::string, uint64_t> seqs_;
+  std::deque<std::pair<std::string, uint64_t>> order_;
+};
+
+}  // namespace
+
+Status NewBlockCacheTracer(Env* env, const std::string& trace_path,
+                           std::shared_ptr<BlockCacheTracer>* tracer) {
+  std::unique_ptr<WritableFile> file;
+  Status s = env->NewWritableFile(trace_path, &file, EnvOptions());
+  if (s.ok()) {
+    tracer->reset(new BlockCacheTracerImpl(env, std::move(file)));
+  }
+  return s;
+}
+
+Status NewBlockCacheTraceReader(
+    Env* env, const std::string& trace_path,
+    std::unique_ptr<BlockCacheTraceReader>* reader) {
+  std::unique_ptr<SequentialFile> file;
+  Status s = env->NewSequentialFile(trace_path, &file, EnvOptions());
+  if (!s.ok()) {
+    return s;
+  }
+  std::unique_ptr<BlockCacheTraceReader> result(
+      new BlockCacheTraceReaderImpl(std::move(file)));
+  s = result->status();
+  if (s.ok()) {
+    *reader = std::move(result);
+  }
+  return s;
+}
+
+Status SimulateBlockCacheTrace(
+    Env* env, const std::string& trace_path,
+    const std::vector<std::shared_ptr<Cache>>& caches,
+    std::vector<BlockCacheSimulationResult>* results) {
+  std::unique_ptr<BlockCacheTraceReader> reader;
+  Status s = NewBlockCacheTraceReader(env, trace_path, &reader);
+  if (!s.ok()) {
+    return s;
+  }
+  results->assign(caches.size(), BlockCacheSimulationResult());
+  std::vector<PendingInserts> pending(caches.size());
+  BlockCacheTraceRecord record;
+  for (uint64_t seq = 0; reader->ReadRecord(&record); seq++) {
+    for (size_t i = 0; i < caches.size(); i++) {
+      Cache* cache = caches[i].get();
+      pending[i].Expire(seq);
+      if (record.op == BlockCacheTraceRecord::kInsert) {
+        if (pending[i].Remove(record.cache_key)) {
+          cache->Insert(record.cache_key, nullptr, record.charge,
+                        &DeleteNothing);
+        }
+        continue;
+      }
+      BlockCacheSimulationResult& result = (*results)[i];
+      int caller = static_cast<int>(record.caller);
+      bool known_caller =
+          caller >= 0 &&
+          caller < static_cast<int>(BlockCacheTraceCaller::kNumCallers);
+      result.lookups++;
+      if (known_caller) {
+        result.caller_lookups[caller]++;
+      }
+      Cache::Handle* handle = cache->Lookup(record.cache_key);
+      if (handle != nullptr) {
+        cache->Release(handle);
+        result.hits++;
+        if (known_caller) {
+          result.caller_hits[caller]++;
+        }
+      } else if (record.fill_cache) {
+        if (record.is_hit) {
+          cache->Insert(record.cache_key, nullptr, record.charge,
+                        &DeleteNothing);
+        } else {
+          pending[i].Add(record.cache_key, seq);
+        }
+      }
+    }
+  }
+  return reader->status();
+}
+
+}  // namespace rocksdb
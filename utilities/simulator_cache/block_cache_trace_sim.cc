@@ -0,0 +1,146 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+#ifndef GFLAGS
+#include <cstdio>
+int main() {
+  fprintf(stderr, "Please install gflags to run rocksdb tools\n");
+  return 1;
+}
+#else
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <gflags/gflags.h>
+
+#include <string>
+#include <vector>
+
+#include "port/port.h"
+#include "rocksdb/cache.h"
+#include "rocksdb/env.h"
+#include "rocksdb/utilities/block_cache_trace.h"
+#include "util/string_util.h"
+
+using GFLAGS::ParseCommandLineFlags;
+using GFLAGS::SetUsageMessage;
+
+DEFINE_string(trace_path, "",
+              "Block cache trace to replay, as written by the tracer set in "
+              "BlockBasedTableOptions::block_cache_tracer.");
+DEFINE_string(cache_types, "lru,clock,tinylfu",
+              "Comma-separated cache policies to simulate: lru, clock, and "
+              "tinylfu (LRU with TinyLFU admission and a segmented LRU).");
+DEFINE_string(capacities, "64M,256M,1G",
+              "Comma-separated cache capacities to simulate, with optional "
+              "K, M, G or T suffixes.");
+DEFINE_string(num_shard_bits, "6",
+              "Comma-separated numbers of shard bits to simulate.");
+DEFINE_int64(frequency_sketch_size, 0,
+             "Counters in the frequency sketch of tinylfu caches. 0 uses four "
+             "per 4KB of capacity.");
+
+namespace rocksdb {
+
+namespace {
+
+const char* kCallerNames[] = {"get", "iterator", "compaction", "prefetch"};
+
+struct SimulatedCache {
+  std::string type;
+  size_t capacity;
+  int num_shard_bits;
+};
+
+std::shared_ptr<Cache> NewSimulatedCache(const SimulatedCache& sim) {
+  if (sim.type == "lru") {
+    return NewLRUCache(sim.capacity, sim.num_shard_bits);
+  } else if (sim.type == "clock") {
+    return NewClockCache(sim.capacity, sim.num_shard_bits);
+  } else if (sim.type == "tinylfu") {
+    size_t sketch_size = FLAGS_frequency_sketch_size > 0
+                             ? static_cast<size_t>(FLAGS_frequency_sketch_size)
+                             : sim.capacity / 1024;
+    return NewLRUCache(sim.capacity, sim.num_shard_bits,
+                       false /* strict_capacity_limit */,
+                       0.0 /* high_pri_pool_ratio */, sketch_size);
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+int BlockCacheTraceSim() {
+  if (FLAGS_trace_path.empty()) {
+    fprintf(stderr, "--trace_path is required\n");
+    return 1;
+  }
+  std::vector<SimulatedCache> sims;
+  std::vector<std::shared_ptr<Cache>> caches;
+  for (const auto& type : StringSplit(FLAGS_cache_types, ',')) {
+    for (const auto& capacity : StringSplit(FLAGS_capacities, ',')) {
+      for (const auto& bits : StringSplit(FLAGS_num_shard_bits, ',')) {
+        SimulatedCache sim;
+        sim.type = type;
+        sim.capacity = static_cast<size_t>(ParseUint64(capacity));
+        sim.num_shard_bits = ParseInt(bits);
+        std::shared_ptr<Cache> cache = NewSimulatedCache(sim);
+        if (cache == nullptr) {
+          fprintf(stderr, "Cannot create %s cache of %s bytes in %s bits\n",
+                  type.c_str(), capacity.c_str(), bits.c_str());
+          return 1;
+        }
+        sims.push_back(sim);
+        caches.push_back(cache);
+      }
+    }
+  }
+
+  std::vector<BlockCacheSimulationResult> results;
+  Status s = SimulateBlockCacheTrace(Env::Default(), FLAGS_trace_path, caches,
+                                     &results);
+  if (!s.ok()) {
+    fprintf(stderr, "%s\n", s.ToString().c_str());
+    return 1;
+  }
+
+  printf("%-8s %14s %5s %12s %9s", "type", "capacity", "bits", "lookups",
+         "hit%");
+  for (const char* caller : kCallerNames) {
+    printf(" %11s", caller);
+  }
+  printf("\n");
+  for (size_t i = 0; i < sims.size(); i++) {
+    const BlockCacheSimulationResult& result = results[i];
+    printf("%-8s %14" ROCKSDB_PRIszt " %5d %12" PRIu64 " %8.2f%%",
+           sims[i].type.c_str(), sims[i].capacity, sims[i].num_shard_bits,
+           result.lookups, 100.0 * result.hit_ratio());
+    for (size_t c = 0; c < sizeof(kCallerNames) / sizeof(kCallerNames[0]);
+         c++) {
+      if (result.caller_lookups[c] == 0) {
+        printf(" %11s", "-");
+      } else {
+        printf(" %10.2f%%",
+               100.0 * result.caller_hits[c] / result.caller_lookups[c]);
+      }
+    }
+    printf("\n");
+  }
+  return 0;
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  SetUsageMessage(std::string("\nUSAGE:\n") + std::string(argv[0]) +
+                  " --trace_path=<block cache trace> [OPTIONS]...");
+  ParseCommandLineFlags(&argc, &argv, true);
+  return rocksdb::BlockCacheTraceSim();
+}
+
+#endif  // GFLAGS
@@ -0,0 +1,259 @@
+//  Copyright (c) 2011-present, Facebook, Inc.  All rights reserved.
+//  This source code is licensed under both the GPLv2 (found in the
+//  COPYING file in the root directory) and Apache 2.0 License
+//  (found in the LICENSE.Apache file in the root directory).
+
+#include "rocksdb/utilities/block_cache_trace.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "port/stack_trace.h"
+#include "util/string_util.h"
+#include "util/testharness.h"
+
+namespace rocksdb {
+
+class BlockCacheTraceTest : public testing::Test {
+ public:
+  BlockCacheTraceTest()
+      : env_(Env::Default()),
+        trace_path_(test::TmpDir(env_) + "/block_cache_trace") {}
+
+  ~BlockCacheTraceTest() { env_->DeleteFile(trace_path_); }
+
+  // Writes a lookup of `key` by `caller`, followed by its insert if the
+  // traced cache missed and filled.
+  void WriteAccess(BlockCacheTracer* tracer, const std::string& key,
+                   BlockCacheTraceCaller caller, bool is_hit,
+                   bool fill_cache = true, uint64_t charge = 1) {
+    BlockCacheTraceRecord record;
+    record.cache_key = key;
+    record.caller = caller;
+    record.is_hit = is_hit;
+    record.fill_cache = fill_cache;
+    record.charge = is_hit ? charge : 0;
+    tracer->Record(record);
+    if (!is_hit && fill_cache) {
+      record.op = BlockCacheTraceRecord::kInsert;
+      record.charge = charge;
+      tracer->Record(record);
+    }
+  }
+
+  Env* env_;
+  std::string trace_path_;
+};
+
+TEST_F(BlockCacheTraceTest, WriteAndRead) {
+  std::shared_ptr<BlockCacheTracer> tracer;
+  ASSERT_OK(NewBlockCacheTracer(env_, trace_path_, &tracer));
+  // Enough records to be written out in several batches.
+  const int kNumRecords = 20000;
+  for (int i = 0; i < kNumRecords; i++) {
+    BlockCacheTraceRecord record;
+    record.op = i % 3 == 0 ? BlockCacheTraceRecord::kInsert
+                           : BlockCacheTraceRecord::kLookup;
+    record.timestamp_micros = 1000 + i * 7;
+    record.cache_key = "key" + ToString(i);
+    record.block_type = static_cast<BlockCacheTraceBlockType>(i % 4);
+    record.caller = static_cast<BlockCacheTraceCaller>(i % 4);
+    record.level = i % 8 - 1;
+    record.is_hit = i % 2 == 0;
+    record.fill_cache = i % 5 != 0;
+    record.charge = static_cast<uint64_t>(i) << 20;
+    tracer->Record(record);
+  }
+  ASSERT_OK(tracer->Close());
+  // Records after Close() are dropped.
+  tracer->Record(BlockCacheTraceRecord());
+
+  std::unique_ptr<BlockCacheTraceReader> reader;
+  ASSERT_OK(NewBlockCacheTraceReader(env_, trace_path_, &reader));
+  BlockCacheTraceRecord record;
+  for (int i = 0; i < kNumRecords; i++) {
+    ASSERT_TRUE(reader->ReadRecord(&record));
+    ASSERT_EQ(i % 3 == 0 ? BlockCacheTraceRecord::kInsert
+                         : BlockCacheTraceRecord::kLookup,
+              record.op);
+    ASSERT_EQ(static_cast<uint64_t>(1000 + i * 7), record.timestamp_micros);
+    ASSERT_EQ("key" + ToString(i), record.cache_key);
+    ASSERT_EQ(static_cast<BlockCacheTraceBlockType>(i % 4), record.block_type);
+    ASSERT_EQ(static_cast<BlockCacheTraceCaller>(i % 4), record.caller);
+    ASSERT_EQ(i % 8 - 1, record.level);
+    ASSERT_EQ(i % 2 == 0, record.is_hit);
+    ASSERT_EQ(i % 5 != 0, record.fill_cache);
+    ASSERT_EQ(static_cast<uint64_t>(i) << 20, record.charge);
+  }
+  ASSERT_FALSE(reader->ReadRecord(&record));
+  ASSERT_OK(reader->status());
+}
+
+TEST_F(BlockCacheTraceTest, ConcurrentRecords) {
+  std::shared_ptr<BlockCacheTracer> tracer;
+  ASSERT_OK(NewBlockCacheTracer(env_, trace_path_, &tracer));
+  // Each thread writes out several batches while the others record.
+  const int kNumThreads = 4;
+  const int kNumRecords = 20000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; t++) {
+    threads.emplace_back([&tracer, t]() {
+      for (int i = 0; i < kNumRecords; i++) {
+        BlockCacheTraceRecord record;
+        record.cache_key = ToString(t) + ":" + ToString(i);
+        tracer->Record(record);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_OK(tracer->Close());
+
+  // All records are there, and those of each thread in order.
+  std::unique_ptr<BlockCacheTraceReader> reader;
+  ASSERT_OK(NewBlockCacheTraceReader(env_, trace_path_, &reader));
+  std::vector<int> next(kNumThreads, 0);
+  BlockCacheTraceRecord record;
+  while (reader->ReadRecord(&record)) {
+    size_t colon = record.cache_key.find(':');
+    ASSERT_NE(std::string::npos, colon);
+    int t = std::stoi(record.cache_key.substr(0, colon));
+    ASSERT_EQ(ToString(next[t]), record.cache_key.substr(colon + 1));
+    next[t]++;
+  }
+  ASSERT_OK(reader->status());
+  for (int t = 0; t < kNumThreads; t++) {
+    ASSERT_EQ(kNumRecords, next[t]);
+  }
+}
+
+TEST_F(BlockCacheTraceTest, DetectsCorruption) {
+  std::shared_ptr<BlockCacheTracer> tracer;
+  ASSERT_OK(NewBlockCacheTracer(env_, trace_path_, &tracer));
+  WriteAccess(tracer.get(), "a", BlockCacheTraceCaller::kGet, false);
+  ASSERT_OK(tracer->Close());
+
+  std::string contents;
+  ASSERT_OK(ReadFileToString(env_, trace_path_, &contents));
+  // Cut the insert record short.
+  ASSERT_OK(WriteStringToFile(env_, contents.substr(0, contents.size() - 1),
+                              trace_path_));
+  std::unique_ptr<BlockCacheTraceReader> reader;
+  ASSERT_OK(NewBlockCacheTraceReader(env_, trace_path_, &reader));
+  BlockCacheTraceRecord record;
+  ASSERT_TRUE(reader->ReadRecord(&record));
+  ASSERT_EQ(BlockCacheTraceRecord::kLookup, record.op);
+  ASSERT_FALSE(reader->ReadRecord(&record));
+  ASSERT_TRUE(reader->status().IsCorruption());
+
+  ASSERT_OK(WriteStringToFile(env_, "not a trace file", trace_path_));
+  ASSERT_TRUE(
+      NewBlockCacheTraceReader(env_, trace_path_, &reader).IsCorruption());
+  ASSERT_OK(WriteStringToFile(env_, "", trace_path_));
+  ASSERT_TRUE(
+      NewBlockCacheTraceReader(env_, trace_path_, &reader).IsCorruption());
+}
+
+TEST_F(BlockCacheTraceTest, SimulateCapacities) {
+  std::shared_ptr<BlockCacheTracer> tracer;
+  ASSERT_OK(NewBlockCacheTracer(env_, trace_path_, &tracer));
+  // Ten rounds over ten blocks of charge 1, by gets and iterators in turn.
+  for (int round = 0; round < 10; round++) {
+    for (int i = 0; i < 10; i++) {
+      WriteAccess(tracer.get(), "block" + ToString(i),
+                  i % 2 == 0 ? BlockCacheTraceCaller::kGet
+                             : BlockCacheTraceCaller::kIterator,
+                  round > 0);
+    }
+  }
+  ASSERT_OK(tracer->Close());
+
+  std::vector<std::shared_ptr<Cache>> caches = {NewLRUCache(5, 0),
+                                                NewLRUCache(10, 0)};
+  std::vector<BlockCacheSimulationResult> results;
+  ASSERT_OK(SimulateBlockCacheTrace(env_, trace_path_, caches, &results));
+  ASSERT_EQ(2U, results.size());
+
+  // A cyclic scan larger than the cache always misses in LRU.
+  ASSERT_EQ(100U, results[0].lookups);
+  ASSERT_EQ(0U, results[0].hits);
+  ASSERT_EQ(0.0, results[0].hit_ratio());
+
+  // A cache holding all ten blocks only misses on the first round.
+  ASSERT_EQ(100U, results[1].lookups);
+  ASSERT_EQ(90U, results[1].hits);
+  ASSERT_EQ(0.9, results[1].hit_ratio());
+  int get = static_cast<int>(BlockCacheTraceCaller::kGet);
+  int iterator = static_cast<int>(BlockCacheTraceCaller::kIterator);
+  int compaction = static_cast<int>(BlockCacheTraceCaller::kCompaction);
+  ASSERT_EQ(50U, results[1].caller_lookups[get]);
+  ASSERT_EQ(45U, results[1].caller_hits[get]);
+  ASSERT_EQ(50U, results[1].caller_lookups[iterator]);
+  ASSERT_EQ(45U, results[1].caller_hits[iterator]);
+  ASSERT_EQ(0U, results[1].caller_lookups[compaction]);
+}
+
+TEST_F(BlockCacheTraceTest, SimulateFillCache) {
+  std::shared_ptr<BlockCacheTracer> tracer;
+  ASSERT_OK(NewBlockCacheTracer(env_, trace_path_, &tracer));
+  // Reads that do not fill the cache leave it unchanged.
+  WriteAccess(tracer.get(), "a", BlockCacheTraceCaller::kCompaction, false,
+              false /* fill_cache */);
+  WriteAccess(tracer.get(), "a", BlockCacheTraceCaller::kCompaction, false,
+              false /* fill_cache */);
+  // A block the traced cache already held is inserted on the first miss,
+  // with the charge of the hit.
+  WriteAccess(tracer.get(), "b", BlockCacheTraceCaller::kGet, true,
+              true /* fill_cache */, 3);
+  WriteAccess(tracer.get(), "b", BlockCacheTraceCaller::kGet, true,
+              true /* fill_cache */, 3);
+  ASSERT_OK(tracer->Close());
+
+  std::vector<std::shared_ptr<Cache>> caches = {NewLRUCache(10, 0)};
+  std::vector<BlockCacheSimulationResult> results;
+  ASSERT_OK(SimulateBlockCacheTrace(env_, trace_path_, caches, &results));
+  ASSERT_EQ(4U, results[0].lookups);
+  ASSERT_EQ(1U, results[0].hits);
+  ASSERT_EQ(3U, caches[0]->GetUsage());
+}
+
+TEST_F(BlockCacheTraceTest, SimulateDropsMissesWithoutInsert) {
+  std::shared_ptr<BlockCacheTracer> tracer;
+  ASSERT_OK(NewBlockCacheTracer(env_, trace_path_, &tracer));
+  // The traced cache missed "a" but its insert only shows up much later,
+  // after the simulator stopped waiting for it.
+  BlockCacheTraceRecord record;
+  record.cache_key = "a";
+  record.fill_cache = true;
+  tracer->Record(record);
+  const int kNumOthers = 1 << 17;
+  for (int i = 0; i < kNumOthers; i++) {
+    WriteAccess(tracer.get(), "other" + ToString(i),
+                BlockCacheTraceCaller::kCompaction, false,
+                false /* fill_cache */);
+  }
+  record.op = BlockCacheTraceRecord::kInsert;
+  record.charge = 1;
+  tracer->Record(record);
+  // "b" is inserted right after its miss, as usual.
+  WriteAccess(tracer.get(), "b", BlockCacheTraceCaller::kGet, false,
+              true /* fill_cache */, 2);
+  ASSERT_OK(tracer->Close());
+
+  std::vector<std::shared_ptr<Cache>> caches = {NewLRUCache(10, 0)};
+  std::vector<BlockCacheSimulationResult> results;
+  ASSERT_OK(SimulateBlockCacheTrace(env_, trace_path_, caches, &results));
+  ASSERT_EQ(static_cast<uint64_t>(kNumOthers + 2), results[0].lookups);
+  ASSERT_EQ(0U, results[0].hits);
+  ASSERT_EQ(2U, caches[0]->GetUsage());
+}
+
+}  // namespace rocksdb
+
+int main(int argc, char** argv) {
+  rocksdb::port::InstallStackTraceHandler();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -104,6 +104,12 @@ class SimCacheImpl : public SimCache {
     cache_->ApplyToAllCacheEntries(callback, thread_safe);
   }
 
+  virtual void ApplyToAllCacheEntriesWithKey(
+      const std::function<void(const Slice& key, void* value, size_t charge)>&
+          callback) override {
+    cache_->ApplyToAllCacheEntriesWithKey(callback);
+  }
+
   virtual void EraseUnRefEntries() override {
     cache_->EraseUnRefEntries();
     key_only_cache_->EraseUnRefEntries();
@@ -156,6 +162,23 @@ class SimCacheImpl : public SimCache {
     return ret;
   }
 
+  virtual void GetShardStats(
+      std::vector<CacheShardStats>* stats) const override {
+    cache_->GetShardStats(stats);
+  }
+
+  virtual void SetShardStatsTracking(bool track) override {
+    cache_->SetShardStatsTracking(track);
+  }
+
+  virtual void SetShardAutoTuning(bool auto_tune) override {
+    cache_->SetShardAutoTuning(auto_tune);
+  }
+
+  virtual int GetSuggestedNumShardBits() const override {
+    return cache_->GetSuggestedNumShardBits();
+  }
+
  private:
   std::shared_ptr<Cache> cache_;
   std::shared_ptr<Cache> key_only_cache_;